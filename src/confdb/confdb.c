@@ -25,6 +25,7 @@
 #include "util/util.h"
 #include "confdb/confdb.h"
 #include "confdb/confdb_private.h"
+#include "confdb/confdb_snapshot.h"
 #include "util/strtonum.h"
 #include "db/sysdb.h"
 
@@ -221,6 +222,8 @@ int confdb_add_param(struct confdb_ctx *cdb,
         }
     }
 
+    confdb_snapshot_refresh(cdb);
+
     ret = EOK;
 
 done:
@@ -263,6 +266,11 @@ int confdb_get_param(struct confdb_ctx *cdb,
         goto done;
     }
 
+    ret = confdb_snapshot_get_param(cdb, mem_ctx, dn, attribute, values);
+    if (ret != ENOENT) {
+        goto done;
+    }
+
     ret = ldb_search(cdb->ldb, tmp_ctx, &res,
                      dn, LDB_SCOPE_BASE, attrs, NULL);
     if (ret != LDB_SUCCESS) {
@@ -370,6 +378,8 @@ int confdb_set_string(struct confdb_ctx *cdb,
         goto done;
     }
 
+    confdb_snapshot_refresh(cdb);
+
     ret = EOK;
 
 done:
@@ -683,6 +693,15 @@ int confdb_init(TALLOC_CTX *mem_ctx,
         return EIO;
     }
 
+    cdb->snapshot_path = talloc_asprintf(cdb, "%s"CONFDB_SNAPSHOT_SUFFIX,
+                                         confdb_location);
+    if (cdb->snapshot_path == NULL) {
+        talloc_free(cdb);
+        return ENOMEM;
+    }
+
+    confdb_snapshot_load(cdb);
+
     *cdb_ctx = cdb;
 
     return EOK;
@@ -1149,6 +1168,15 @@ static int confdb_get_domain_internal(struct confdb_ctx *cdb,
         goto done;
     }
 
+    ret = get_entry_as_bool(res->msgs[0], &domain->cache_merged_overrides,
+                            CONFDB_DOMAIN_CACHE_MERGED_OVERRIDES, 0);
+    if(ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for %s\n",
+               CONFDB_DOMAIN_CACHE_MERGED_OVERRIDES);
+        goto done;
+    }
+
     ret = get_entry_as_uint32(res->msgs[0], &domain->id_min,
                               CONFDB_DOMAIN_MINID,
                               confdb_get_min_id(domain));
@@ -1567,6 +1595,27 @@ static int confdb_get_domain_internal(struct confdb_ctx *cdb,
         goto done;
     }
 
+    domain->cache_backend = SSS_CACHE_BACKEND_TDB;
+    tmp = ldb_msg_find_attr_as_string(res->msgs[0],
+                                      CONFDB_DOMAIN_CACHE_BACKEND,
+                                      CONFDB_DOMAIN_CACHE_BACKEND_TDB);
+    if (strcasecmp(tmp, CONFDB_DOMAIN_CACHE_BACKEND_LMDB) == 0) {
+        domain->cache_backend = SSS_CACHE_BACKEND_LMDB;
+    } else if (strcasecmp(tmp, CONFDB_DOMAIN_CACHE_BACKEND_TDB) != 0) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value %s for [%s]\n", tmp, CONFDB_DOMAIN_CACHE_BACKEND);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = get_entry_as_uint32(res->msgs[0], &domain->cache_lmdb_map_size,
+                              CONFDB_DOMAIN_CACHE_LMDB_MAP_SIZE, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for [%s]\n", CONFDB_DOMAIN_CACHE_LMDB_MAP_SIZE);
+        goto done;
+    }
+
     domain->hostname = confdb_get_domain_hostname(domain, res, domain->provider);
     if (domain->hostname == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to get domain hostname\n");
@@ -2304,6 +2353,7 @@ int confdb_expand_app_domains(struct confdb_ctx *cdb)
     char **domlist;
     TALLOC_CTX *tmp_ctx;
     struct ldb_result *app_domain = NULL;
+    bool modified = false;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -2345,6 +2395,8 @@ int confdb_expand_app_domains(struct confdb_ctx *cdb)
             goto done;
         }
 
+        modified = true;
+
         ret = confdb_add_app_domain(tmp_ctx, cdb, domlist[i]);
         if (ret != EOK) {
             DEBUG(SSSDBG_OP_FAILURE,
@@ -2364,6 +2416,9 @@ int confdb_expand_app_domains(struct confdb_ctx *cdb)
 
     ret = EOK;
 done:
+    if (modified) {
+        confdb_snapshot_refresh(cdb);
+    }
     talloc_free(tmp_ctx);
     return ret;
 }
@@ -118,7 +118,10 @@
 #define CONFDB_NSS_MEMCACHE_SIZE_PASSWD "memcache_size_passwd"
 #define CONFDB_NSS_MEMCACHE_SIZE_GROUP "memcache_size_group"
 #define CONFDB_NSS_MEMCACHE_SIZE_INITGROUPS "memcache_size_initgroups"
+#define CONFDB_NSS_MEMCACHE_WARM_START "memcache_warm_start"
 #define CONFDB_NSS_HOMEDIR_SUBSTRING "homedir_substring"
+#define CONFDB_NSS_REPLY_CACHE_TIMEOUT "reply_cache_timeout"
+#define CONFDB_NSS_REPLY_CACHE_SIZE "reply_cache_size"
 #define CONFDB_DEFAULT_HOMEDIR_SUBSTRING "/home"
 
 /* PAM */
@@ -175,6 +178,8 @@
 #define CONFDB_SSH_USE_CERT_KEYS "ssh_use_certificate_keys"
 #define CONFDB_DEFAULT_SSH_USE_CERT_KEYS true
 #define CONFDB_SSH_USE_CERT_RULES "ssh_use_certificate_matching_rules"
+#define CONFDB_SSH_CERT_CACHE_TIMEOUT "ssh_certificate_cache_timeout"
+#define CONFDB_DEFAULT_SSH_CERT_CACHE_TIMEOUT 300
 
 /* PAC */
 #define CONFDB_PAC_CONF_ENTRY "config/pac"
@@ -253,6 +258,11 @@
 #define CONFDB_DOMAIN_TYPE_POSIX "posix"
 #define CONFDB_DOMAIN_TYPE_APP "application"
 #define CONFDB_DOMAIN_INHERIT_FROM "inherit_from"
+#define CONFDB_DOMAIN_CACHE_BACKEND "cache_backend"
+#define CONFDB_DOMAIN_CACHE_BACKEND_TDB "tdb"
+#define CONFDB_DOMAIN_CACHE_BACKEND_LMDB "lmdb"
+#define CONFDB_DOMAIN_CACHE_LMDB_MAP_SIZE "cache_lmdb_map_size"
+#define CONFDB_DOMAIN_CACHE_MERGED_OVERRIDES "cache_merged_overrides"
 
 /* Local Provider */
 #define CONFDB_LOCAL_DEFAULT_SHELL   "default_shell"
@@ -270,6 +280,8 @@
 #define CONFDB_PROXY_PAM_TARGET "proxy_pam_target"
 #define CONFDB_PROXY_FAST_ALIAS "proxy_fast_alias"
 #define CONFDB_PROXY_MAX_CHILDREN "proxy_max_children"
+#define CONFDB_PROXY_MAX_ID_THREADS "proxy_max_id_threads"
+#define CONFDB_PROXY_ID_TIMEOUT "proxy_id_timeout"
 
 /* Files Provider */
 #define CONFDB_FILES_PASSWD "passwd_files"
@@ -289,6 +301,7 @@
 #define CONFDB_KCM_MAX_CCACHES "max_ccaches"
 #define CONFDB_KCM_MAX_UID_CCACHES "max_uid_ccaches"
 #define CONFDB_KCM_MAX_CCACHE_SIZE "max_ccache_size"
+#define CONFDB_KCM_CCACHE_CACHE_SIZE "ccache_cache_size"
 #define CONFDB_KCM_TGT_RENEWAL "tgt_renewal"
 #define CONFDB_KCM_TGT_RENEWAL_INHERIT "tgt_renewal_inherit"
 #define CONFDB_KCM_KRB5_LIFETIME "krb5_lifetime"
@@ -357,6 +370,12 @@ enum sss_domain_mpg_mode {
     MPG_DEFAULT, /* Use default value for given id mapping. */
 };
 
+/* ldb backend used to store the domain cache and the timestamp cache */
+enum sss_cache_backend {
+    SSS_CACHE_BACKEND_TDB,
+    SSS_CACHE_BACKEND_LMDB,
+};
+
 /**
  * Data structure storing all of the basic features
  * of a domain.
@@ -404,6 +423,9 @@ struct sss_domain_info {
     uint32_t subdomain_refresh_interval;
     uint32_t cached_auth_timeout;
 
+    enum sss_cache_backend cache_backend;
+    uint32_t cache_lmdb_map_size; /* MiB, 0 means computed automatically */
+
     int pwd_expiration_warning;
 
     struct sysdb_ctx *sysdb;
@@ -419,6 +441,8 @@ struct sss_domain_info {
 
     bool has_views;
     const char *view_name;
+    /* Store override values in the original objects as well */
+    bool cache_merged_overrides;
 
     struct sss_domain_info *prev;
     struct sss_domain_info *next;
@@ -26,6 +26,7 @@
 #include "confdb.h"
 #include "confdb_private.h"
 #include "confdb_setup.h"
+#include "confdb_snapshot.h"
 #include "util/sss_ini.h"
 
 static int confdb_test(struct confdb_ctx *cdb)
@@ -391,6 +392,14 @@ errno_t confdb_setup(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* The confdb is going to be rebuilt, the snapshot is published again
+     * by the monitor once it is ready. */
+    ret = confdb_snapshot_remove(cdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to remove configuration "
+              "snapshot [%d]: %s\n", ret, sss_strerror(ret));
+    }
+
     /* Initialize the CDB from the configuration file */
     ret = confdb_test(cdb);
     if (ret == ENOENT) {
@@ -0,0 +1,755 @@
+/*
+   SSSD
+
+   Configuration Database - memory-mapped snapshot
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "confdb/confdb.h"
+#include "confdb/confdb_private.h"
+#include "confdb/confdb_snapshot.h"
+
+#define CONFDB_SNAPSHOT_MAGIC 0x53424443 /* CDBS */
+#define CONFDB_SNAPSHOT_VERSION 1
+
+/* File layout: header, array of entries sorted by section and attribute,
+ * data area with NUL-terminated strings and arrays of value offsets.
+ * All offsets are relative to the start of the file. */
+
+struct confdb_snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    /* Sequence number of the confdb the snapshot was built from. */
+    uint64_t generation;
+    /* Set by the writer once the snapshot was replaced by a newer one. */
+    uint32_t stale;
+    uint32_t num_entries;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+struct confdb_snapshot_entry {
+    uint32_t section;       /* case-folded DN of the section */
+    uint32_t attribute;
+    uint32_t num_values;
+    uint32_t values;        /* array of num_values offsets */
+};
+
+struct confdb_snapshot {
+    uint8_t *base;
+    size_t size;
+    const struct confdb_snapshot_header *hdr;
+    const struct confdb_snapshot_entry *entries;
+};
+
+struct confdb_snapshot_item {
+    const char *section;
+    struct ldb_message_element *el;
+};
+
+struct confdb_snapshot_buf {
+    uint8_t *data;
+    size_t size;
+};
+
+static int confdb_snapshot_destructor(struct confdb_snapshot *snap)
+{
+    if (snap->base != NULL) {
+        munmap(snap->base, snap->size);
+    }
+
+    return 0;
+}
+
+static int confdb_snapshot_key_cmp(const char *section_a,
+                                   const char *attribute_a,
+                                   const char *section_b,
+                                   const char *attribute_b)
+{
+    int ret;
+
+    ret = strcmp(section_a, section_b);
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Attribute names are case insensitive in the confdb. */
+    return strcasecmp(attribute_a, attribute_b);
+}
+
+static int confdb_snapshot_item_cmp(const void *a, const void *b)
+{
+    const struct confdb_snapshot_item *item_a = a;
+    const struct confdb_snapshot_item *item_b = b;
+
+    return confdb_snapshot_key_cmp(item_a->section, item_a->el->name,
+                                   item_b->section, item_b->el->name);
+}
+
+static bool confdb_snapshot_is_stale(struct confdb_snapshot *snap)
+{
+    /* The flag is written by other processes through the shared mapping. */
+    return *(volatile const uint32_t *)&snap->hdr->stale != 0;
+}
+
+static bool confdb_snapshot_str_valid(uint8_t *base, size_t size, uint32_t off)
+{
+    return off < size && memchr(base + off, '\0', size - off) != NULL;
+}
+
+static errno_t confdb_snapshot_validate(uint8_t *base, size_t size)
+{
+    const struct confdb_snapshot_header *hdr;
+    const struct confdb_snapshot_entry *entries;
+    const uint32_t *values;
+    uint32_t i;
+    uint32_t j;
+
+    hdr = (const struct confdb_snapshot_header *)base;
+    if (hdr->magic != CONFDB_SNAPSHOT_MAGIC
+            || hdr->version != CONFDB_SNAPSHOT_VERSION
+            || hdr->size != size) {
+        return EINVAL;
+    }
+
+    if (hdr->num_entries > (size - sizeof(*hdr)) / sizeof(*entries)) {
+        return EINVAL;
+    }
+
+    entries = (const struct confdb_snapshot_entry *)(base + sizeof(*hdr));
+    for (i = 0; i < hdr->num_entries; i++) {
+        if (!confdb_snapshot_str_valid(base, size, entries[i].section)
+                || !confdb_snapshot_str_valid(base, size,
+                                              entries[i].attribute)) {
+            return EINVAL;
+        }
+
+        if (entries[i].values % sizeof(uint32_t) != 0
+                || entries[i].values > size
+                || entries[i].num_values
+                        > (size - entries[i].values) / sizeof(uint32_t)) {
+            return EINVAL;
+        }
+
+        values = (const uint32_t *)(base + entries[i].values);
+        for (j = 0; j < entries[i].num_values; j++) {
+            if (!confdb_snapshot_str_valid(base, size, values[j])) {
+                return EINVAL;
+            }
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t confdb_snapshot_open(TALLOC_CTX *mem_ctx,
+                                    const char *path,
+                                    struct confdb_snapshot **_snap)
+{
+    struct confdb_snapshot *snap;
+    struct stat st;
+    errno_t ret;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno;
+    }
+
+    ret = fstat(fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        close(fd);
+        return ret;
+    }
+
+    if (st.st_size < (off_t)sizeof(struct confdb_snapshot_header)
+            || st.st_size > UINT32_MAX) {
+        close(fd);
+        return EINVAL;
+    }
+
+    snap = talloc_zero(mem_ctx, struct confdb_snapshot);
+    if (snap == NULL) {
+        close(fd);
+        return ENOMEM;
+    }
+
+    snap->size = st.st_size;
+    snap->base = mmap(NULL, snap->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (snap->base == MAP_FAILED) {
+        ret = errno;
+        snap->base = NULL;
+        talloc_free(snap);
+        return ret;
+    }
+
+    talloc_set_destructor(snap, confdb_snapshot_destructor);
+
+    ret = confdb_snapshot_validate(snap->base, snap->size);
+    if (ret != EOK) {
+        talloc_free(snap);
+        return ret;
+    }
+
+    snap->hdr = (const struct confdb_snapshot_header *)snap->base;
+    snap->entries = (const struct confdb_snapshot_entry *)
+                                        (snap->base + sizeof(*snap->hdr));
+
+    *_snap = snap;
+
+    return EOK;
+}
+
+void confdb_snapshot_load(struct confdb_ctx *cdb)
+{
+    struct confdb_snapshot *snap;
+    errno_t ret;
+
+    talloc_zfree(cdb->snapshot);
+
+    if (cdb->snapshot_path == NULL) {
+        return;
+    }
+
+    ret = confdb_snapshot_open(cdb, cdb->snapshot_path, &snap);
+    if (ret == ENOENT || ret == EACCES) {
+        return;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to open configuration snapshot %s [%d]: %s\n",
+              cdb->snapshot_path, ret, sss_strerror(ret));
+        return;
+    }
+
+    if (confdb_snapshot_is_stale(snap)) {
+        talloc_free(snap);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Using configuration snapshot generation %"PRIu64"\n",
+          snap->hdr->generation);
+
+    cdb->snapshot = snap;
+}
+
+errno_t confdb_snapshot_get_param(struct confdb_ctx *cdb,
+                                  TALLOC_CTX *mem_ctx,
+                                  struct ldb_dn *dn,
+                                  const char *attribute,
+                                  char ***_values)
+{
+    struct confdb_snapshot *snap;
+    const struct confdb_snapshot_entry *entry = NULL;
+    const uint32_t *offsets;
+    const char *section;
+    char **values;
+    uint32_t low;
+    uint32_t high;
+    uint32_t mid;
+    uint32_t i;
+    int cmp;
+
+    if (cdb->snapshot != NULL && confdb_snapshot_is_stale(cdb->snapshot)) {
+        confdb_snapshot_load(cdb);
+    }
+
+    snap = cdb->snapshot;
+    if (snap == NULL) {
+        return ENOENT;
+    }
+
+    section = ldb_dn_get_casefold(dn);
+    if (section == NULL) {
+        return ENOENT;
+    }
+
+    low = 0;
+    high = snap->hdr->num_entries;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        cmp = confdb_snapshot_key_cmp(section, attribute,
+                        (const char *)(snap->base + snap->entries[mid].section),
+                        (const char *)(snap->base + snap->entries[mid].attribute));
+        if (cmp == 0) {
+            entry = &snap->entries[mid];
+            break;
+        } else if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    if (entry == NULL) {
+        values = talloc_zero(mem_ctx, char *);
+        if (values == NULL) {
+            return ENOMEM;
+        }
+
+        *_values = values;
+        return EOK;
+    }
+
+    values = talloc_zero_array(mem_ctx, char *, entry->num_values + 1);
+    if (values == NULL) {
+        return ENOMEM;
+    }
+
+    offsets = (const uint32_t *)(snap->base + entry->values);
+    for (i = 0; i < entry->num_values; i++) {
+        values[i] = talloc_strdup(values,
+                                  (const char *)(snap->base + offsets[i]));
+        if (values[i] == NULL) {
+            talloc_free(values);
+            return ENOMEM;
+        }
+    }
+
+    *_values = values;
+
+    return EOK;
+}
+
+static errno_t confdb_snapshot_append(struct confdb_snapshot_buf *buf,
+                                      const void *data,
+                                      size_t len,
+                                      size_t align,
+                                      uint32_t *_offset)
+{
+    uint8_t *tmp;
+    size_t offset;
+
+    offset = (buf->size + align - 1) / align * align;
+    if (offset + len > UINT32_MAX) {
+        return EFBIG;
+    }
+
+    tmp = talloc_realloc(NULL, buf->data, uint8_t, offset + len);
+    if (tmp == NULL) {
+        return ENOMEM;
+    }
+
+    memset(tmp + buf->size, 0, offset - buf->size);
+    if (data != NULL) {
+        memcpy(tmp + offset, data, len);
+    } else {
+        memset(tmp + offset, 0, len);
+    }
+
+    buf->data = tmp;
+    buf->size = offset + len;
+
+    if (_offset != NULL) {
+        *_offset = offset;
+    }
+
+    return EOK;
+}
+
+static errno_t confdb_snapshot_build(TALLOC_CTX *mem_ctx,
+                                     struct confdb_ctx *cdb,
+                                     struct confdb_snapshot_buf *_buf)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct confdb_snapshot_header hdr = { 0 };
+    struct confdb_snapshot_entry entry;
+    struct confdb_snapshot_item *items;
+    struct confdb_snapshot_buf buf = { 0 };
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    const char *section;
+    uint32_t *offsets;
+    uint32_t section_offset = 0;
+    uint32_t entries_offset;
+    uint64_t seq;
+    size_t count;
+    size_t i;
+    size_t j;
+    errno_t ret;
+    int lret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    lret = ldb_sequence_number(cdb->ldb, LDB_SEQ_HIGHEST_SEQ, &seq);
+    if (lret != LDB_SUCCESS) {
+        ret = sss_ldb_error_to_errno(lret);
+        goto done;
+    }
+
+    dn = ldb_dn_new(tmp_ctx, cdb->ldb, "cn=config");
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    lret = ldb_search(cdb->ldb, tmp_ctx, &res, dn, LDB_SCOPE_SUBTREE,
+                      NULL, NULL);
+    if (lret != LDB_SUCCESS) {
+        ret = sss_ldb_error_to_errno(lret);
+        goto done;
+    }
+
+    count = 0;
+    for (i = 0; i < res->count; i++) {
+        count += res->msgs[i]->num_elements;
+    }
+
+    items = talloc_zero_array(tmp_ctx, struct confdb_snapshot_item, count);
+    if (items == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    count = 0;
+    for (i = 0; i < res->count; i++) {
+        section = ldb_dn_get_casefold(res->msgs[i]->dn);
+        if (section == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        for (j = 0; j < res->msgs[i]->num_elements; j++) {
+            items[count].section = section;
+            items[count].el = &res->msgs[i]->elements[j];
+            count++;
+        }
+    }
+
+    qsort(items, count, sizeof(struct confdb_snapshot_item),
+          confdb_snapshot_item_cmp);
+
+    hdr.magic = CONFDB_SNAPSHOT_MAGIC;
+    hdr.version = CONFDB_SNAPSHOT_VERSION;
+    hdr.generation = seq;
+    hdr.num_entries = count;
+
+    ret = confdb_snapshot_append(&buf, &hdr, sizeof(hdr), 1, NULL);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = confdb_snapshot_append(&buf, NULL,
+                                 count * sizeof(struct confdb_snapshot_entry),
+                                 sizeof(uint32_t), &entries_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        memset(&entry, 0, sizeof(entry));
+
+        /* Items of the same section are adjacent, store its name once. */
+        if (i == 0 || strcmp(items[i].section, items[i - 1].section) != 0) {
+            ret = confdb_snapshot_append(&buf, items[i].section,
+                                         strlen(items[i].section) + 1, 1,
+                                         &section_offset);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+        entry.section = section_offset;
+
+        ret = confdb_snapshot_append(&buf, items[i].el->name,
+                                     strlen(items[i].el->name) + 1, 1,
+                                     &entry.attribute);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        offsets = talloc_zero_array(tmp_ctx, uint32_t,
+                                    items[i].el->num_values);
+        if (offsets == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (j = 0; j < items[i].el->num_values; j++) {
+            /* Values are strings, they are not NUL-terminated in ldb. */
+            ret = confdb_snapshot_append(&buf, items[i].el->values[j].data,
+                                         items[i].el->values[j].length, 1,
+                                         &offsets[j]);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            ret = confdb_snapshot_append(&buf, "", 1, 1, NULL);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        entry.num_values = items[i].el->num_values;
+        ret = confdb_snapshot_append(&buf, offsets,
+                                     entry.num_values * sizeof(uint32_t),
+                                     sizeof(uint32_t), &entry.values);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        memcpy(buf.data + entries_offset + i * sizeof(entry),
+               &entry, sizeof(entry));
+    }
+
+    ((struct confdb_snapshot_header *)buf.data)->size = buf.size;
+
+    _buf->data = talloc_steal(mem_ctx, buf.data);
+    _buf->size = buf.size;
+    buf.data = NULL;
+
+    ret = EOK;
+
+done:
+    talloc_free(buf.data);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t confdb_snapshot_mark_stale(int fd)
+{
+    uint32_t stale = 1;
+    ssize_t written;
+
+    written = pwrite(fd, &stale, sizeof(stale),
+                     offsetof(struct confdb_snapshot_header, stale));
+    if (written != sizeof(stale)) {
+        return written == -1 ? errno : EIO;
+    }
+
+    return EOK;
+}
+
+static errno_t confdb_snapshot_write(struct confdb_ctx *cdb,
+                                     bool refresh,
+                                     uid_t uid,
+                                     gid_t gid)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct confdb_snapshot_buf buf = { 0 };
+    struct stat st;
+    char *tmp_path = NULL;
+    ssize_t written;
+    bool in_transaction = false;
+    int old_fd = -1;
+    int fd = -1;
+    errno_t ret;
+    int lret;
+
+    if (cdb->snapshot_path == NULL) {
+        return EOK;
+    }
+
+    if (refresh) {
+        ret = access(cdb->snapshot_path, F_OK);
+        if (ret == -1 && errno == ENOENT) {
+            /* Nobody published a snapshot, nothing to refresh. */
+            return EOK;
+        }
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* The transaction serializes writers from different processes and
+     * gives a consistent view of the confdb. Nothing is written to it. */
+    lret = ldb_transaction_start(cdb->ldb);
+    if (lret != LDB_SUCCESS) {
+        ret = sss_ldb_error_to_errno(lret);
+        goto done;
+    }
+    in_transaction = true;
+
+    old_fd = open(cdb->snapshot_path, O_RDWR | O_CLOEXEC);
+    if (old_fd == -1) {
+        ret = errno;
+        if (ret != ENOENT) {
+            goto done;
+        }
+
+        if (refresh) {
+            /* Nobody published a snapshot, nothing to refresh. */
+            ret = EOK;
+            goto done;
+        }
+    }
+
+    if (refresh) {
+        ret = fstat(old_fd, &st);
+        if (ret == -1) {
+            ret = errno;
+            goto done;
+        }
+
+        uid = st.st_uid;
+        gid = st.st_gid;
+    }
+
+    ret = confdb_snapshot_build(tmp_ctx, cdb, &buf);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    tmp_path = talloc_asprintf(tmp_ctx, "%s.XXXXXX", cdb->snapshot_path);
+    if (tmp_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    fd = sss_unique_file(NULL, tmp_path, &ret);
+    if (fd == -1) {
+        talloc_zfree(tmp_path);
+        goto done;
+    }
+
+    errno = 0;
+    written = sss_atomic_write_s(fd, buf.data, buf.size);
+    if (written != buf.size) {
+        ret = written == -1 ? errno : EIO;
+        goto done;
+    }
+
+    if (geteuid() == 0) {
+        ret = fchown(fd, uid, gid);
+        if (ret == -1) {
+            ret = errno;
+            goto done;
+        }
+    }
+
+    ret = rename(tmp_path, cdb->snapshot_path);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+    talloc_zfree(tmp_path);
+
+    if (old_fd != -1) {
+        ret = confdb_snapshot_mark_stale(old_fd);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Unable to invalidate the old configuration snapshot "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Published configuration snapshot %s\n",
+          cdb->snapshot_path);
+
+    ret = EOK;
+
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    if (tmp_path != NULL) {
+        unlink(tmp_path);
+    }
+    if (old_fd != -1) {
+        close(old_fd);
+    }
+    if (in_transaction) {
+        lret = ldb_transaction_cancel(cdb->ldb);
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
+        }
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t confdb_snapshot_publish(struct confdb_ctx *cdb, uid_t uid, gid_t gid)
+{
+    errno_t ret;
+
+    ret = confdb_snapshot_write(cdb, false, uid, gid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unable to publish configuration snapshot [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    confdb_snapshot_load(cdb);
+
+    return EOK;
+}
+
+errno_t confdb_snapshot_remove(struct confdb_ctx *cdb)
+{
+    errno_t ret;
+    int fd;
+
+    talloc_zfree(cdb->snapshot);
+
+    if (cdb->snapshot_path == NULL) {
+        return EOK;
+    }
+
+    fd = open(cdb->snapshot_path, O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        return ret == ENOENT ? EOK : ret;
+    }
+
+    /* Processes that still map it must stop using it. */
+    ret = confdb_snapshot_mark_stale(fd);
+    close(fd);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = unlink(cdb->snapshot_path);
+    if (ret == -1 && errno != ENOENT) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+void confdb_snapshot_refresh(struct confdb_ctx *cdb)
+{
+    errno_t ret;
+
+    ret = confdb_snapshot_write(cdb, true, 0, 0);
+    if (ret == EOK) {
+        return;
+    }
+
+    DEBUG(SSSDBG_OP_FAILURE,
+          "Unable to refresh configuration snapshot [%d]: %s, removing it\n",
+          ret, sss_strerror(ret));
+
+    ret = confdb_snapshot_remove(cdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to remove configuration snapshot [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
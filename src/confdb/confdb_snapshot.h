@@ -0,0 +1,63 @@
+/*
+   SSSD
+
+   Configuration Database - memory-mapped snapshot
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFDB_SNAPSHOT_H_
+#define CONFDB_SNAPSHOT_H_
+
+#include <ldb.h>
+
+#include "util/util.h"
+#include "confdb/confdb.h"
+
+/* The snapshot is an immutable, sorted copy of all options stored in the
+ * confdb which is mapped by every process that opens the confdb, so that
+ * options can be read without searching the ldb file.
+ *
+ * The snapshot is published by the monitor once the confdb is set up.
+ * Any process that modifies the confdb through this module later writes
+ * a new snapshot and flags the old one as stale, processes that still map
+ * the old one notice it on the next read and switch to the new one. */
+
+#define CONFDB_SNAPSHOT_SUFFIX ".snapshot"
+
+/* Publish a new snapshot of @cdb owned by @uid and @gid. */
+errno_t confdb_snapshot_publish(struct confdb_ctx *cdb, uid_t uid, gid_t gid);
+
+/* Remove the snapshot of @cdb, readers fall back to the ldb file. */
+errno_t confdb_snapshot_remove(struct confdb_ctx *cdb);
+
+/* Map the snapshot of @cdb if there is any. Called from confdb_init(). */
+void confdb_snapshot_load(struct confdb_ctx *cdb);
+
+/* Publish a new snapshot after @cdb was modified if there is a published
+ * snapshot already, the snapshot is removed if that fails. */
+void confdb_snapshot_refresh(struct confdb_ctx *cdb);
+
+/* Read @attribute of the section @dn from the snapshot.
+ *
+ * @return ENOENT if there is no usable snapshot, EOK otherwise even if the
+ *         attribute is not set in which case @_values is an empty list.
+ */
+errno_t confdb_snapshot_get_param(struct confdb_ctx *cdb,
+                                  TALLOC_CTX *mem_ctx,
+                                  struct ldb_dn *dn,
+                                  const char *attribute,
+                                  char ***_values);
+
+#endif /* CONFDB_SNAPSHOT_H_ */
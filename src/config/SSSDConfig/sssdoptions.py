@@ -75,6 +75,9 @@ class SSSDOptions(object):
         'memcache_size_passwd': _('Size (in megabytes) of the data table allocated inside fast in-memory cache for passwd requests'),
         'memcache_size_group': _('Size (in megabytes) of the data table allocated inside fast in-memory cache for group requests'),
         'memcache_size_initgroups': _('Size (in megabytes) of the data table allocated inside fast in-memory cache for initgroups requests'),
+        'memcache_warm_start': _('Whether the NSS responder continues with the fast in-memory cache left by its previous instance'),
+        'reply_cache_timeout': _('How long the NSS responder keeps ready-made replies of recently requested objects'),
+        'reply_cache_size': _('Maximum number of replies kept in the NSS reply cache'),
         'homedir_substring': _('The value of this option will be used in the expansion of the override_homedir option '
                                'if the template contains the format string %H.'),
         'get_domains_timeout': _('Specifies time in seconds for which the list of subdomains will be considered '
@@ -127,6 +130,7 @@ class SSSDOptions(object):
         'ssh_use_certificate_keys': _('Allow to generate ssh-keys from certificates'),
         'ssh_use_certificate_matching_rules': _('Use the following matching rules to filter the certificates for '
                                                 'ssh-key generation'),
+        'ssh_certificate_cache_timeout': _('How many seconds to keep the result of a certificate validation'),
 
         # [pac]
         'allowed_uids': _('List of UIDs or user names allowed to access the PAC responder'),
@@ -200,6 +204,9 @@ class SSSDOptions(object):
         'dns_resolver_op_timeout': _('How long should keep trying to resolve single DNS query (seconds)'),
         'dns_resolver_timeout': _('How long to wait for replies from DNS when resolving servers (seconds)'),
         'dns_discovery_domain': _('The domain part of service discovery DNS query'),
+        'dns_resolver_cache_min_ttl': _('Minimal time to keep a resolved DNS answer cached (seconds)'),
+        'dns_resolver_cache_max_ttl': _('Maximal time to keep a resolved DNS answer cached (seconds)'),
+        'dns_resolver_cache_negative_ttl': _('How long to remember that a DNS name does not exist (seconds)'),
         'override_gid': _('Override GID value from the identity provider with this value'),
         'case_sensitive': _('Treat usernames as case sensitive'),
         'entry_cache_user_timeout': _('Entry cache timeout length (seconds)'),
@@ -223,6 +230,9 @@ class SSSDOptions(object):
         'subdomain_inherit': _('List of options that should be inherited into a subdomain'),
         'subdomain_homedir': _('Default subdomain homedir value'),
         'cached_auth_timeout': _('How long can cached credentials be used for cached authentication'),
+        'cache_backend': _('Database backend used for the domain cache'),
+        'cache_lmdb_map_size': _('Size of the LMDB memory map in MiB'),
+        'cache_merged_overrides': _('Store ID view override values in the cached objects'),
         'auto_private_groups': _('Whether to automatically create private groups for users'),
         'pwd_expiration_warning': _('Display a warning N days before the password expires.'),
         'realmd_tags': _('Various tags stored by the realmd configuration service for this domain.'),
@@ -580,6 +590,8 @@ class SSSDOptions(object):
         'proxy_lib_name': _('The name of the NSS library to use'),
         'proxy_resolver_lib_name' : _('The name of the NSS library to use for hosts and networks lookups'),
         'proxy_fast_alias': _('Whether to look up canonical group name from cache if possible'),
+        'proxy_max_id_threads': _('The number of threads calling the NSS library concurrently'),
+        'proxy_id_timeout': _('How long to wait for the NSS library to answer a lookup'),
 
         # [provider/proxy/auth]
         'proxy_pam_target': _('PAM stack to use'),
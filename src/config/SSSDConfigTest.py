@@ -619,6 +619,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'dns_resolver_op_timeout',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'dns_resolver_cache_min_ttl',
+            'dns_resolver_cache_max_ttl',
+            'dns_resolver_cache_negative_ttl',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -654,6 +657,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
+            'cache_backend',
+            'cache_lmdb_map_size',
+            'cache_merged_overrides',
             'auto_private_groups',
             'pam_gssapi_services',
             'pam_gssapi_check_upn',
@@ -1002,6 +1008,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'dns_resolver_op_timeout',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'dns_resolver_cache_min_ttl',
+            'dns_resolver_cache_max_ttl',
+            'dns_resolver_cache_negative_ttl',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -1037,6 +1046,9 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
+            'cache_backend',
+            'cache_lmdb_map_size',
+            'cache_merged_overrides',
             'auto_private_groups',
             'pam_gssapi_services',
             'pam_gssapi_check_upn',
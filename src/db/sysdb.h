@@ -190,6 +190,7 @@
 #define SYSDB_OVERRIDE_GROUP_CLASS "groupOverride"
 #define SYSDB_OVERRIDE_DN "overrideDN"
 #define SYSDB_OVERRIDE_OBJECT_DN "overrideObjectDN"
+#define SYSDB_OVERRIDE_MERGED_DN "overrideMergedDN"
 #define SYSDB_USE_DOMAIN_RESOLUTION_ORDER "useDomainResolutionOrder"
 #define SYSDB_DOMAIN_RESOLUTION_ORDER "domainResolutionOrder"
 #define SYSDB_SESSION_RECORDING "sessionRecording"
@@ -238,6 +239,21 @@
                             SYSDB_OBJECTCLASS, \
                             SYSDB_OBJECTCATEGORY
 
+/* Override values copied into the original object if the domain has
+ * cache_merged_overrides set, see sysdb_has_merged_overrides(). */
+#define SYSDB_MERGED_USER_OVERRIDE_ATTRS OVERRIDE_PREFIX SYSDB_UIDNUM, \
+                                         OVERRIDE_PREFIX SYSDB_GIDNUM, \
+                                         OVERRIDE_PREFIX SYSDB_GECOS, \
+                                         OVERRIDE_PREFIX SYSDB_HOMEDIR, \
+                                         OVERRIDE_PREFIX SYSDB_SHELL, \
+                                         OVERRIDE_PREFIX SYSDB_NAME, \
+                                         OVERRIDE_PREFIX SYSDB_USER_CERT, \
+                                         SYSDB_OVERRIDE_MERGED_DN
+
+#define SYSDB_MERGED_GROUP_OVERRIDE_ATTRS OVERRIDE_PREFIX SYSDB_GIDNUM, \
+                                          OVERRIDE_PREFIX SYSDB_NAME, \
+                                          SYSDB_OVERRIDE_MERGED_DN
+
 #define SYSDB_PW_ATTRS {SYSDB_NAME, SYSDB_UIDNUM, \
                         SYSDB_GIDNUM, SYSDB_GECOS, \
                         SYSDB_HOMEDIR, SYSDB_SHELL, \
@@ -253,6 +269,7 @@
                         SYSDB_SESSION_RECORDING, \
                         SYSDB_UUID, \
                         SYSDB_ORIG_DN, \
+                        SYSDB_MERGED_USER_OVERRIDE_ATTRS, \
                         NULL}
 
 #define SYSDB_GRSRC_ATTRS {SYSDB_NAME, SYSDB_GIDNUM, \
@@ -267,6 +284,7 @@
                            SYSDB_UUID, \
                            ORIGINALAD_PREFIX SYSDB_NAME, \
                            ORIGINALAD_PREFIX SYSDB_GIDNUM, \
+                           SYSDB_MERGED_GROUP_OVERRIDE_ATTRS, \
                            NULL}
 
 #define SYSDB_NETGR_ATTRS {SYSDB_NAME, SYSDB_NETGROUP_TRIPLE, \
@@ -281,8 +299,16 @@
                             SYSDB_SID_STR, \
                             SYSDB_NAME, \
                             SYSDB_OVERRIDE_DN, \
+                            SYSDB_MERGED_GROUP_OVERRIDE_ATTRS, \
                             NULL}
 
+/* Only what is needed to build the list of group IDs of a user. */
+#define SYSDB_INITGR_GIDS_ATTRS {SYSDB_GIDNUM, SYSDB_POSIX, \
+                                 SYSDB_NAME, \
+                                 SYSDB_OVERRIDE_DN, \
+                                 SYSDB_MERGED_GROUP_OVERRIDE_ATTRS, \
+                                 NULL}
+
 #define SYSDB_TMPL_USER SYSDB_NAME"=%s,"SYSDB_TMPL_USER_BASE
 #define SYSDB_TMPL_GROUP SYSDB_NAME"=%s,"SYSDB_TMPL_GROUP_BASE
 #define SYSDB_TMPL_NETGROUP SYSDB_NAME"=%s,"SYSDB_TMPL_NETGROUP_BASE
@@ -690,6 +716,13 @@ errno_t sysdb_search_user_override_by_uid(TALLOC_CTX *mem_ctx,
                                            struct ldb_result **override_obj,
                                            struct ldb_result **orig_obj);
 
+errno_t sysdb_search_user_override_attrs_by_uid(TALLOC_CTX *mem_ctx,
+                                            struct sss_domain_info *domain,
+                                            uid_t uid,
+                                            const char **attrs,
+                                            struct ldb_result **override_obj,
+                                            struct ldb_result **orig_obj);
+
 errno_t sysdb_search_group_override_by_gid(TALLOC_CTX *mem_ctx,
                                             struct sss_domain_info *domain,
                                             gid_t gid,
@@ -708,6 +741,11 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
                                       struct ldb_message *override_obj,
                                       const char **req_attrs);
 
+/* Returns true if the override values of the current view are already stored
+ * in @obj, in this case sysdb_add_overrides_to_object() does not have to read
+ * the override object. */
+bool sysdb_has_merged_overrides(struct ldb_message *obj);
+
 errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
                                          struct ldb_message *obj,
                                          bool expect_override_dn);
@@ -825,6 +863,40 @@ int sysdb_enumpwent_with_views(TALLOC_CTX *mem_ctx,
                                struct sss_domain_info *domain,
                                struct ldb_result **res);
 
+/* Return at most @limit users ordered by name whose name is greater than
+ * @after, or the first @limit users if @after is NULL. Memory use does not
+ * depend on the number of users in the cache. */
+int sysdb_enumpwent_paged_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *after,
+                                     size_t limit,
+                                     struct ldb_result **res);
+
+/* DN and name of all users of the domain ordered by name. The entries of
+ * a part of the list are read with sysdb_enumpwent_read_with_views(). */
+int sysdb_enumpwent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **names);
+
+/* Same as sysdb_enumpwent_names() for at most @limit users whose name
+ * matches @name_filter, which may contain wildcards, and is greater than
+ * @after. If less than @limit names are returned, there are no more users
+ * after the last one. */
+int sysdb_enumpwent_filter_names(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name_filter,
+                                 const char *after,
+                                 size_t limit,
+                                 struct ldb_result **names);
+
+/* Read @count users from @names returned by sysdb_enumpwent_names(). Users
+ * removed in the meantime are skipped. */
+int sysdb_enumpwent_read_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message **names,
+                                    size_t count,
+                                    struct ldb_result **res);
+
 int sysdb_enumpwent_filter_with_views(TALLOC_CTX *mem_ctx,
                                       struct sss_domain_info *domain,
                                       const char *name_filter,
@@ -861,6 +933,33 @@ int sysdb_enumgrent_with_views(TALLOC_CTX *mem_ctx,
                                struct sss_domain_info *domain,
                                struct ldb_result **res);
 
+/* Same as sysdb_enumpwent_paged_with_views() for groups. */
+int sysdb_enumgrent_paged_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *after,
+                                     size_t limit,
+                                     struct ldb_result **res);
+
+/* Same as sysdb_enumpwent_names() for groups. */
+int sysdb_enumgrent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **names);
+
+/* Same as sysdb_enumpwent_filter_names() for groups. */
+int sysdb_enumgrent_filter_names(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name_filter,
+                                 const char *after,
+                                 size_t limit,
+                                 struct ldb_result **names);
+
+/* Same as sysdb_enumpwent_read_with_views() for groups. */
+int sysdb_enumgrent_read_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message **names,
+                                    size_t count,
+                                    struct ldb_result **res);
+
 int sysdb_enumgrent_filter_with_views(TALLOC_CTX *mem_ctx,
                                       struct sss_domain_info *domain,
                                       const char *name_filter,
@@ -899,6 +998,14 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
                                 const char *name,
                                 struct ldb_result **res);
 
+/* Same as sysdb_initgroups_with_views() but the group entries carry only
+ * SYSDB_INITGR_GIDS_ATTRS and, if views are active, the overridden GID and
+ * name. The user entry is returned with all attributes. */
+int sysdb_initgroups_gids_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *name,
+                                     struct ldb_result **res);
+
 int sysdb_get_user_attr(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
                         const char *name,
@@ -911,6 +1018,18 @@ int sysdb_get_user_attr_with_views(TALLOC_CTX *mem_ctx,
                                    const char **attributes,
                                    struct ldb_result **res);
 
+int sysdb_get_user_attr_by_uid(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               uid_t uid,
+                               const char **attributes,
+                               struct ldb_result **res);
+
+int sysdb_get_user_attr_by_uid_with_views(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *domain,
+                                          uid_t uid,
+                                          const char **attributes,
+                                          struct ldb_result **res);
+
 int sysdb_search_user_by_cert_with_views(TALLOC_CTX *mem_ctx,
                                          struct sss_domain_info *domain,
                                          const char *cert,
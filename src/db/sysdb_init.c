@@ -46,14 +46,39 @@ const char *sysdb_ts_cache_attrs[] = {
     NULL,
 };
 
+const char *sysdb_backend_str(enum sss_cache_backend backend)
+{
+    switch (backend) {
+    case SSS_CACHE_BACKEND_TDB:
+        return CONFDB_DOMAIN_CACHE_BACKEND_TDB;
+    case SSS_CACHE_BACKEND_LMDB:
+        return CONFDB_DOMAIN_CACHE_BACKEND_LMDB;
+    }
+
+    return "unknown";
+}
+
 errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
                           const char *filename,
                           int flags,
                           struct ldb_context **_ldb)
+{
+    return sysdb_ldb_connect_ext(mem_ctx, filename, SSS_CACHE_BACKEND_TDB,
+                                 0, flags, _ldb);
+}
+
+errno_t sysdb_ldb_connect_ext(TALLOC_CTX *mem_ctx,
+                              const char *filename,
+                              enum sss_cache_backend backend,
+                              uint64_t lmdb_map_size,
+                              int flags,
+                              struct ldb_context **_ldb)
 {
     int ret;
     struct ldb_context *ldb;
     const char *mod_path;
+    const char *url = filename;
+    const char *options[] = { NULL, NULL };
 
     if (_ldb == NULL) {
         return EINVAL;
@@ -75,7 +100,22 @@ errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
         ldb_set_modules_dir(ldb, mod_path);
     }
 
-    ret = ldb_connect(ldb, filename, flags, NULL);
+    if (backend == SSS_CACHE_BACKEND_LMDB) {
+        url = talloc_asprintf(ldb, "mdb://%s", filename);
+        if (url == NULL) {
+            return ENOMEM;
+        }
+
+        if (lmdb_map_size != 0) {
+            options[0] = talloc_asprintf(ldb, "lmdb_env_size:%"PRIu64,
+                                         lmdb_map_size);
+            if (options[0] == NULL) {
+                return ENOMEM;
+            }
+        }
+    }
+
+    ret = ldb_connect(ldb, url, flags, options);
     if (ret != LDB_SUCCESS) {
         return EIO;
     }
@@ -85,7 +125,44 @@ errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static uint64_t sysdb_lmdb_map_size(struct sysdb_ctx *sysdb,
+                                    const char *ldb_file)
+{
+    struct stat st;
+    uint64_t map_size;
+
+    if (sysdb->backend != SSS_CACHE_BACKEND_LMDB) {
+        return 0;
+    }
+
+    if (sysdb->lmdb_map_size != 0) {
+        return sysdb->lmdb_map_size;
+    }
+
+    /* The map cannot grow while the database is open, leave room for the
+     * cache to grow several times its current size. */
+    map_size = SYSDB_LMDB_MIN_MAP_SIZE;
+    if (stat(ldb_file, &st) == 0) {
+        map_size = MAX(map_size,
+                       (uint64_t) st.st_size * SYSDB_LMDB_MAP_SIZE_FACTOR);
+    }
+
+    return map_size;
+}
+
+static errno_t sysdb_ldb_connect_db(TALLOC_CTX *mem_ctx,
+                                    struct sysdb_ctx *sysdb,
+                                    const char *ldb_file,
+                                    int flags,
+                                    struct ldb_context **_ldb)
+{
+    return sysdb_ldb_connect_ext(mem_ctx, ldb_file, sysdb->backend,
+                                 sysdb_lmdb_map_size(sysdb, ldb_file),
+                                 flags, _ldb);
+}
+
 static errno_t sysdb_ldb_reconnect(TALLOC_CTX *mem_ctx,
+                                   struct sysdb_ctx *sysdb,
                                    const char *ldb_file,
                                    int flags,
                                    struct ldb_context **ldb)
@@ -93,7 +170,7 @@ static errno_t sysdb_ldb_reconnect(TALLOC_CTX *mem_ctx,
     errno_t ret;
 
     talloc_zfree(*ldb);
-    ret = sysdb_ldb_connect(mem_ctx, ldb_file, flags, ldb);
+    ret = sysdb_ldb_connect_db(mem_ctx, sysdb, ldb_file, flags, ldb);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_ldb_connect failed.\n");
     }
@@ -101,6 +178,33 @@ static errno_t sysdb_ldb_reconnect(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+static errno_t sysdb_chown_lock_file(const char *ldb_file,
+                                     uid_t uid, gid_t gid)
+{
+    char *lock_file;
+    errno_t ret;
+
+    lock_file = talloc_asprintf(NULL, "%s"SYSDB_LMDB_LOCK_SUFFIX, ldb_file);
+    if (lock_file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = chown(lock_file, uid, gid);
+    if (ret != 0) {
+        ret = errno;
+        if (ret == ENOENT) {
+            ret = EOK;
+        } else {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot set sysdb ownership of %s to %"SPRIuid":%"SPRIgid"\n",
+                  lock_file, uid, gid);
+        }
+    }
+
+    talloc_free(lock_file);
+    return ret;
+}
+
 static errno_t sysdb_chown_db_files(struct sysdb_ctx *sysdb,
                                     uid_t uid, gid_t gid)
 {
@@ -115,6 +219,13 @@ static errno_t sysdb_chown_db_files(struct sysdb_ctx *sysdb,
         return ret;
     }
 
+    if (sysdb->backend == SSS_CACHE_BACKEND_LMDB) {
+        ret = sysdb_chown_lock_file(sysdb->ldb_file, uid, gid);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
     if (sysdb->ldb_ts_file != NULL) {
         ret = chown(sysdb->ldb_ts_file, uid, gid);
         if (ret != 0) {
@@ -124,6 +235,13 @@ static errno_t sysdb_chown_db_files(struct sysdb_ctx *sysdb,
                   sysdb->ldb_ts_file, uid, gid);
             return ret;
         }
+
+        if (sysdb->backend == SSS_CACHE_BACKEND_LMDB) {
+            ret = sysdb_chown_lock_file(sysdb->ldb_ts_file, uid, gid);
+            if (ret != EOK) {
+                return ret;
+            }
+        }
     }
 
     return EOK;
@@ -584,6 +702,7 @@ done:
 static errno_t remove_ts_cache(struct sysdb_ctx *sysdb)
 {
     errno_t ret;
+    char *lock_file;
 
     if (sysdb->ldb_ts_file == NULL) {
         return EOK;
@@ -594,10 +713,70 @@ static errno_t remove_ts_cache(struct sysdb_ctx *sysdb)
         return errno;
     }
 
+    /* A stale LMDB lock file would otherwise be reused by the new cache */
+    lock_file = talloc_asprintf(NULL, "%s"SYSDB_LMDB_LOCK_SUFFIX,
+                                sysdb->ldb_ts_file);
+    if (lock_file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = unlink(lock_file);
+    talloc_free(lock_file);
+    if (ret != EOK && errno != ENOENT) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+/* Convert the cache to the configured backend if it was created with the
+ * other one. A cache that does not exist yet is simply created with the
+ * configured backend. */
+static errno_t sysdb_cache_check_backend(struct sysdb_ctx *sysdb)
+{
+    enum sss_cache_backend on_disk;
+    errno_t ret;
+
+    ret = sysdb_get_db_backend(sysdb->ldb_file, &on_disk);
+    if (ret == ENOENT) {
+        return EOK;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot detect the format of %s [%d]: %s\n",
+              sysdb->ldb_file, ret, sss_strerror(ret));
+        return EOK;
+    }
+
+    if (on_disk == sysdb->backend) {
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_IMPORTANT_INFO, "Converting cache %s from %s to %s\n",
+          sysdb->ldb_file, sysdb_backend_str(on_disk),
+          sysdb_backend_str(sysdb->backend));
+
+    ret = sysdb_upgrade_backend(sysdb, sysdb->ldb_file, on_disk,
+                                sysdb_lmdb_map_size(sysdb, sysdb->ldb_file));
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Cannot convert cache %s [%d]: %s\n",
+              sysdb->ldb_file, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    /* The timestamps are cheap to refetch, do not bother converting them */
+    ret = remove_ts_cache(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Could not delete the timestamp ldb file (%d) (%s)\n",
+              ret, sss_strerror(ret));
+    }
+
     return EOK;
 }
 
 static errno_t sysdb_cache_connect_helper(TALLOC_CTX *mem_ctx,
+                                          struct sysdb_ctx *sysdb,
                                           struct sss_domain_info *domain,
                                           const char *ldb_file,
                                           int flags,
@@ -622,7 +801,7 @@ static errno_t sysdb_cache_connect_helper(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = sysdb_ldb_connect(tmp_ctx, ldb_file, flags, &ldb);
+    ret = sysdb_ldb_connect_db(tmp_ctx, sysdb, ldb_file, flags, &ldb);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_ldb_connect failed.\n");
         goto done;
@@ -687,7 +866,7 @@ static errno_t sysdb_cache_connect_helper(TALLOC_CTX *mem_ctx,
      * (such as enabling the memberOf plugin and
      * the various indexes).
      */
-    ret = sysdb_ldb_reconnect(tmp_ctx, ldb_file, flags, &ldb);
+    ret = sysdb_ldb_reconnect(tmp_ctx, sysdb, ldb_file, flags, &ldb);
     if (ret != EOK) {
         goto done;
     }
@@ -721,9 +900,14 @@ static errno_t sysdb_cache_connect(TALLOC_CTX *mem_ctx,
     bool ldb_file_exists;
     errno_t ret;
 
+    ret = sysdb_cache_check_backend(sysdb);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ldb_file_exists = !(access(sysdb->ldb_file, F_OK) == -1 && errno == ENOENT);
 
-    ret = sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_file,
+    ret = sysdb_cache_connect_helper(mem_ctx, sysdb, domain, sysdb->ldb_file,
                                       0, SYSDB_VERSION, SYSDB_BASE_LDIF,
                                       &newly_created, ldb, version);
 
@@ -746,7 +930,26 @@ static errno_t sysdb_ts_cache_connect(TALLOC_CTX *mem_ctx,
                                       struct ldb_context **ldb,
                                       const char **version)
 {
-    return sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_ts_file,
+    enum sss_cache_backend on_disk;
+    errno_t ret;
+
+    /* Start over rather than convert if the backend has been changed */
+    ret = sysdb_get_db_backend(sysdb->ldb_ts_file, &on_disk);
+    if (ret == EOK && on_disk != sysdb->backend) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Timestamp cache %s uses the %s backend, recreating it\n",
+              sysdb->ldb_ts_file, sysdb_backend_str(on_disk));
+        ret = remove_ts_cache(sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Could not delete the timestamp ldb file (%d) (%s)\n",
+                  ret, sss_strerror(ret));
+            return ret;
+        }
+    }
+
+    return sysdb_cache_connect_helper(mem_ctx, sysdb, domain,
+                                      sysdb->ldb_ts_file,
                                       LDB_FLG_NOSYNC, SYSDB_TS_VERSION,
                                       SYSDB_TS_BASE_LDIF, NULL,
                                       ldb, version);
@@ -806,7 +1009,7 @@ static int sysdb_domain_cache_connect(struct sysdb_ctx *sysdb,
              * We need to reopen the LDB to ensure that
              * any changes made above take effect.
              */
-            ret = sysdb_ldb_reconnect(tmp_ctx, sysdb->ldb_file, 0, &ldb);
+            ret = sysdb_ldb_reconnect(tmp_ctx, sysdb, sysdb->ldb_file, 0, &ldb);
             goto done;
         }
         break;
@@ -877,7 +1080,7 @@ static int sysdb_timestamp_cache_connect(struct sysdb_ctx *sysdb,
              * We need to reopen the LDB to ensure that
              * any changes made above take effect.
              */
-            ret = sysdb_ldb_reconnect(tmp_ctx,
+            ret = sysdb_ldb_reconnect(tmp_ctx, sysdb,
                                       sysdb->ldb_ts_file,
                                       LDB_FLG_NOSYNC,
                                       &ldb);
@@ -949,6 +1152,9 @@ int sysdb_domain_init_internal(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    sysdb->backend = domain->cache_backend;
+    sysdb->lmdb_map_size = (uint64_t) domain->cache_lmdb_map_size * 1024 * 1024;
+
     ret = sysdb_get_db_file(sysdb, domain->provider, domain->name, db_path,
                             &sysdb->ldb_file, &sysdb->ldb_ts_file);
     if (ret != EOK) {
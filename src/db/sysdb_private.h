@@ -119,6 +119,14 @@
      "description: base object\n" \
      "\n" \
 
+/* LMDB keeps its reader table in a lock file next to the database */
+#define SYSDB_LMDB_LOCK_SUFFIX "-lock"
+
+/* The LMDB map cannot grow once the database is opened, so reserve a
+ * generous amount of address space. Unused space costs no memory. */
+#define SYSDB_LMDB_MIN_MAP_SIZE (1024ULL * 1024 * 1024)
+#define SYSDB_LMDB_MAP_SIZE_FACTOR 4
+
 #include "db/sysdb.h"
 
 struct sysdb_ctx {
@@ -128,6 +136,11 @@ struct sysdb_ctx {
     struct ldb_context *ldb_ts;
     char *ldb_ts_file;
 
+    /* ldb backend of both databases and the configured LMDB map size
+     * in bytes, 0 means it is derived from the database size */
+    enum sss_cache_backend backend;
+    uint64_t lmdb_map_size;
+
     int transaction_nesting;
 };
 
@@ -142,6 +155,13 @@ errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
                           const char *filename,
                           int flags,
                           struct ldb_context **_ldb);
+errno_t sysdb_ldb_connect_ext(TALLOC_CTX *mem_ctx,
+                              const char *filename,
+                              enum sss_cache_backend backend,
+                              uint64_t lmdb_map_size,
+                              int flags,
+                              struct ldb_context **_ldb);
+const char *sysdb_backend_str(enum sss_cache_backend backend);
 
 struct sysdb_dom_upgrade_ctx {
     struct sss_names_ctx *names; /* upgrade to 0.18 needs to parse names */
@@ -183,6 +203,13 @@ int sysdb_upgrade_21(struct sysdb_ctx *sysdb, const char **ver);
 
 int sysdb_ts_upgrade_01(struct sysdb_ctx *sysdb, const char **ver);
 
+errno_t sysdb_get_db_backend(const char *ldb_file,
+                             enum sss_cache_backend *_backend);
+errno_t sysdb_upgrade_backend(struct sysdb_ctx *sysdb,
+                              const char *ldb_file,
+                              enum sss_cache_backend from,
+                              uint64_t lmdb_map_size);
+
 int sysdb_add_string(struct ldb_message *msg,
                      const char *attr, const char *value);
 int sysdb_replace_string(struct ldb_message *msg,
@@ -20,6 +20,7 @@
 */
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb_private.h"
 #include "confdb/confdb.h"
 #include <time.h>
@@ -416,10 +417,20 @@ int sysdb_getpwuid(TALLOC_CTX *mem_ctx,
                    struct sss_domain_info *domain,
                    uid_t uid,
                    struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_PW_ATTRS;
+
+    return sysdb_get_user_attr_by_uid(mem_ctx, domain, uid, attrs, _res);
+}
+
+int sysdb_get_user_attr_by_uid(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               uid_t uid,
+                               const char **attrs,
+                               struct ldb_result **_res)
 {
     TALLOC_CTX *tmp_ctx;
     unsigned long int ul_uid = uid;
-    static const char *attrs[] = SYSDB_PW_ATTRS;
     struct ldb_dn *base_dn;
     struct ldb_result *res;
     int ret;
@@ -826,6 +837,331 @@ done:
     return ret;
 }
 
+/* The smallest names greater than the cursor seen while the cache is
+ * searched. Entries are kept sorted by name and only their DN and name are
+ * held in memory. If limit is 0, all names are kept and sorted once the
+ * search is finished. */
+struct sysdb_enum_page {
+    const char *after;
+    size_t limit;
+    struct ldb_message **msgs;
+    size_t count;
+};
+
+static const char *sysdb_enum_page_name(struct ldb_message *msg)
+{
+    return ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+}
+
+static int sysdb_enum_page_cmp(const void *a, const void *b)
+{
+    struct ldb_message * const *m1 = a;
+    struct ldb_message * const *m2 = b;
+
+    return strcmp(sysdb_enum_page_name(*m1), sysdb_enum_page_name(*m2));
+}
+
+/* Make room for one more entry. The array grows with the number of
+ * matching entries, never beyond the limit. */
+static errno_t sysdb_enum_page_grow(struct sysdb_enum_page *page)
+{
+    struct ldb_message **msgs;
+    size_t size;
+
+    size = talloc_array_length(page->msgs);
+    if (page->count < size) {
+        return EOK;
+    }
+
+    size = size == 0 ? 64 : size * 2;
+    if (page->limit != 0) {
+        size = MIN(size, page->limit);
+    }
+
+    msgs = talloc_realloc(page, page->msgs, struct ldb_message *, size);
+    if (msgs == NULL) {
+        return ENOMEM;
+    }
+    page->msgs = msgs;
+
+    return EOK;
+}
+
+static errno_t sysdb_enum_page_add(struct sysdb_enum_page *page,
+                                   struct ldb_message *msg)
+{
+    const char *name;
+    size_t lo;
+    size_t hi;
+    size_t mid;
+    errno_t ret;
+
+    name = sysdb_enum_page_name(msg);
+    if (name == NULL) {
+        return EOK;
+    }
+
+    if (page->after != NULL && strcmp(name, page->after) <= 0) {
+        return EOK;
+    }
+
+    if (page->limit == 0) {
+        ret = sysdb_enum_page_grow(page);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        page->msgs[page->count] = talloc_steal(page->msgs, msg);
+        page->count++;
+        return EOK;
+    }
+
+    if (page->count == page->limit) {
+        if (strcmp(name, sysdb_enum_page_name(page->msgs[page->count - 1]))
+                >= 0) {
+            return EOK;
+        }
+
+        /* Drop the largest name to make room for this one. */
+        talloc_free(page->msgs[page->count - 1]);
+        page->count--;
+    } else {
+        ret = sysdb_enum_page_grow(page);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    lo = 0;
+    hi = page->count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp(sysdb_enum_page_name(page->msgs[mid]), name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    memmove(&page->msgs[lo + 1], &page->msgs[lo],
+            (page->count - lo) * sizeof(struct ldb_message *));
+    page->msgs[lo] = talloc_steal(page->msgs, msg);
+    page->count++;
+
+    return EOK;
+}
+
+static int sysdb_enum_page_callback(struct ldb_request *req,
+                                    struct ldb_reply *ares)
+{
+    struct sysdb_enum_page *page;
+    errno_t ret;
+
+    page = talloc_get_type(req->context, struct sysdb_enum_page);
+
+    if (ares == NULL) {
+        return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+    }
+
+    if (ares->error != LDB_SUCCESS) {
+        ret = ares->error;
+        talloc_free(ares);
+        return ldb_request_done(req, ret);
+    }
+
+    switch (ares->type) {
+    case LDB_REPLY_ENTRY:
+        ret = sysdb_enum_page_add(page, ares->message);
+        if (ret != EOK) {
+            talloc_free(ares);
+            return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+        }
+        break;
+    case LDB_REPLY_REFERRAL:
+        break;
+    case LDB_REPLY_DONE:
+        talloc_free(ares);
+        return ldb_request_done(req, LDB_SUCCESS);
+    }
+
+    talloc_free(ares);
+    return LDB_SUCCESS;
+}
+
+/* Scan the names of entries matching @filter under @base_dn and return
+ * the DN and name of at most @limit entries with names greater than @after
+ * ordered by name. All matching entries are returned if @limit is 0. */
+static errno_t sysdb_enum_scan(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_dn *base_dn,
+                               const char *filter,
+                               const char *after,
+                               size_t limit,
+                               struct ldb_result **_names)
+{
+    static const char *name_attrs[] = { SYSDB_NAME, NULL };
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_enum_page *page;
+    struct ldb_request *req;
+    struct ldb_result *names;
+    int lret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    page = talloc_zero(tmp_ctx, struct sysdb_enum_page);
+    if (page == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    page->after = after;
+    page->limit = limit;
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Searching cache with [%s] after [%s]\n",
+          filter, after == NULL ? "-" : after);
+
+    lret = ldb_build_search_req(&req, domain->sysdb->ldb, tmp_ctx,
+                                base_dn, LDB_SCOPE_SUBTREE, filter,
+                                name_attrs, NULL, page,
+                                sysdb_enum_page_callback, NULL);
+    if (lret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(lret);
+        goto done;
+    }
+
+    lret = ldb_request(domain->sysdb->ldb, req);
+    if (lret == LDB_SUCCESS) {
+        lret = ldb_wait(req->handle, LDB_WAIT_ALL);
+    }
+    if (lret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(lret);
+        goto done;
+    }
+
+    if (limit == 0 && page->count > 1) {
+        qsort(page->msgs, page->count, sizeof(struct ldb_message *),
+              sysdb_enum_page_cmp);
+    }
+
+    names = talloc_zero(tmp_ctx, struct ldb_result);
+    if (names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    names->count = page->count;
+    names->msgs = talloc_steal(names, page->msgs);
+
+    *_names = talloc_steal(mem_ctx, names);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Read @attrs of the entries in @names. Entries that were removed since
+ * the names were scanned are skipped. */
+static errno_t sysdb_enum_read(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_message **names,
+                               size_t count,
+                               const char **attrs,
+                               struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    struct ldb_result *entry;
+    size_t i;
+    int lret;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    res = talloc_zero(tmp_ctx, struct ldb_result);
+    if (res == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    res->msgs = talloc_zero_array(res, struct ldb_message *, count + 1);
+    if (res->msgs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        lret = ldb_search(domain->sysdb->ldb, tmp_ctx, &entry,
+                          names[i]->dn, LDB_SCOPE_BASE, attrs, NULL);
+        if (lret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+
+        if (entry->count != 1) {
+            /* The entry was removed in the meantime. */
+            continue;
+        }
+
+        res->msgs[res->count] = talloc_steal(res->msgs, entry->msgs[0]);
+        res->count++;
+        talloc_free(entry);
+    }
+
+    /* Merge in the timestamps from the fast ts db */
+    ret = sysdb_merge_res_ts_attrs(domain->sysdb, res, attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot merge timestamp cache values\n");
+        /* non-fatal */
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Search @filter under @base_dn and return at most @limit entries with
+ * names greater than @after ordered by name. The cache is scanned once
+ * for names only, full entries are read just for the returned page. */
+static errno_t sysdb_enum_page(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_dn *base_dn,
+                               const char *filter,
+                               const char **attrs,
+                               const char *after,
+                               size_t limit,
+                               struct ldb_result **_res)
+{
+    struct ldb_result *names;
+    errno_t ret;
+
+    if (limit == 0) {
+        return EINVAL;
+    }
+
+    ret = sysdb_enum_scan(NULL, domain, base_dn, filter, after, limit,
+                          &names);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sysdb_enum_read(mem_ctx, domain, names->msgs, names->count,
+                          attrs, _res);
+    talloc_free(names);
+
+    return ret;
+}
+
 int sysdb_enumpwent_filter(TALLOC_CTX *mem_ctx,
                            struct sss_domain_info *domain,
                            const char *name_filter,
@@ -977,91 +1313,238 @@ int sysdb_enumpwent_with_views(TALLOC_CTX *mem_ctx,
     return sysdb_enumpwent_filter_with_views(mem_ctx, domain, NULL, NULL, _res);
 }
 
-/* groups */
-
-static int mpg_convert(struct ldb_message *msg)
+static errno_t sysdb_enumpwent_base(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    struct ldb_dn **_base_dn,
+                                    char **_filter)
 {
-    struct ldb_message_element *el;
-    struct ldb_val *val = NULL;
-    int i;
-
-    el = ldb_msg_find_element(msg, SYSDB_OBJECTCATEGORY);
-    if (!el) return EINVAL;
-
-    /* see if this is a user to convert to a group */
-    for (i = 0; i < el->num_values; i++) {
-        val = &(el->values[i]);
-        if (strncasecmp(SYSDB_USER_CLASS,
-                        (char *)val->data, val->length) == 0) {
-            break;
-        }
+    *_base_dn = sysdb_user_base_dn(mem_ctx, domain);
+    if (*_base_dn == NULL) {
+        return ENOMEM;
     }
-    /* no, leave as is */
-    if (i == el->num_values) return EOK;
 
-    /* yes, convert */
-    val->data = (uint8_t *)talloc_strdup(msg, SYSDB_GROUP_CLASS);
-    if (val->data == NULL) return ENOMEM;
-    val->length = strlen(SYSDB_GROUP_CLASS);
+    *_filter = enum_filter(mem_ctx, SYSDB_PWENT_FILTER, name_filter, NULL);
+    if (*_filter == NULL) {
+        return ENOMEM;
+    }
 
     return EOK;
 }
 
-static int mpg_res_convert(struct ldb_result *res)
+static errno_t sysdb_enumpwent_add_views(struct sss_domain_info *domain,
+                                         struct ldb_result *res)
 {
-    int ret;
-    int i;
+    size_t c;
+    errno_t ret;
 
-    for (i = 0; i < res->count; i++) {
-        ret = mpg_convert(res->msgs[i]);
-        if (ret) {
+    if (!DOM_HAS_VIEWS(domain)) {
+        return EOK;
+    }
+
+    for (c = 0; c < res->count; c++) {
+        ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                            NULL);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
             return ret;
         }
     }
+
     return EOK;
 }
 
-int sysdb_getgrnam_with_views(TALLOC_CTX *mem_ctx,
-                              struct sss_domain_info *domain,
-                              const char *name,
-                              struct ldb_result **res)
+int sysdb_enumpwent_filter_names(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name_filter,
+                                 const char *after,
+                                 size_t limit,
+                                 struct ldb_result **_names)
 {
     TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *base_dn;
+    char *filter;
     int ret;
-    struct ldb_result *orig_obj = NULL;
-    struct ldb_result *override_obj = NULL;
-    struct ldb_message_element *el;
 
     tmp_ctx = talloc_new(NULL);
-    if (!tmp_ctx) {
+    if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    /* If there are views we first have to search the overrides for matches */
-    if (DOM_HAS_VIEWS(domain)) {
-        ret = sysdb_search_group_override_by_name(tmp_ctx, domain, name,
-                                                  &override_obj, &orig_obj);
-        if (ret != EOK && ret != ENOENT) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "sysdb_search_group_override_by_name failed.\n");
-            goto done;
-        }
+    ret = sysdb_enumpwent_base(tmp_ctx, domain, name_filter,
+                               &base_dn, &filter);
+    if (ret != EOK) {
+        goto done;
     }
 
-    /* If there are no views or nothing was found in the overrides the
-     * original objects are searched. */
-    if (orig_obj == NULL) {
-        ret = sysdb_getgrnam(tmp_ctx, domain, name, &orig_obj);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "sysdb_getgrnam failed.\n");
-            goto done;
-        }
-    }
+    ret = sysdb_enum_scan(mem_ctx, domain, base_dn, filter, after, limit,
+                          _names);
 
-    /* If there are views we have to check if override values must be added to
-     * the original object. */
-    if (orig_obj->count == 1) {
-        if (DOM_HAS_VIEWS(domain)) {
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+int sysdb_enumpwent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **_names)
+{
+    return sysdb_enumpwent_filter_names(mem_ctx, domain, NULL, NULL, 0,
+                                        _names);
+}
+
+int sysdb_enumpwent_read_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message **names,
+                                    size_t count,
+                                    struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_PW_ATTRS;
+    struct ldb_result *res;
+    int ret;
+
+    ret = sysdb_enum_read(mem_ctx, domain, names, count, attrs, &res);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sysdb_enumpwent_add_views(domain, res);
+    if (ret != EOK) {
+        talloc_free(res);
+        return ret;
+    }
+
+    *_res = res;
+
+    return EOK;
+}
+
+int sysdb_enumpwent_paged_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *after,
+                                     size_t limit,
+                                     struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = SYSDB_PW_ATTRS;
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    char *filter;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_enumpwent_base(tmp_ctx, domain, NULL, &base_dn, &filter);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_enum_page(tmp_ctx, domain, base_dn, filter,
+                          attrs, after, limit, &res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_enumpwent_add_views(domain, res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+/* groups */
+
+static int mpg_convert(struct ldb_message *msg)
+{
+    struct ldb_message_element *el;
+    struct ldb_val *val = NULL;
+    int i;
+
+    el = ldb_msg_find_element(msg, SYSDB_OBJECTCATEGORY);
+    if (!el) return EINVAL;
+
+    /* see if this is a user to convert to a group */
+    for (i = 0; i < el->num_values; i++) {
+        val = &(el->values[i]);
+        if (strncasecmp(SYSDB_USER_CLASS,
+                        (char *)val->data, val->length) == 0) {
+            break;
+        }
+    }
+    /* no, leave as is */
+    if (i == el->num_values) return EOK;
+
+    /* yes, convert */
+    val->data = (uint8_t *)talloc_strdup(msg, SYSDB_GROUP_CLASS);
+    if (val->data == NULL) return ENOMEM;
+    val->length = strlen(SYSDB_GROUP_CLASS);
+
+    return EOK;
+}
+
+static int mpg_res_convert(struct ldb_result *res)
+{
+    int ret;
+    int i;
+
+    for (i = 0; i < res->count; i++) {
+        ret = mpg_convert(res->msgs[i]);
+        if (ret) {
+            return ret;
+        }
+    }
+    return EOK;
+}
+
+int sysdb_getgrnam_with_views(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              const char *name,
+                              struct ldb_result **res)
+{
+    TALLOC_CTX *tmp_ctx;
+    int ret;
+    struct ldb_result *orig_obj = NULL;
+    struct ldb_result *override_obj = NULL;
+    struct ldb_message_element *el;
+
+    tmp_ctx = talloc_new(NULL);
+    if (!tmp_ctx) {
+        return ENOMEM;
+    }
+
+    /* If there are views we first have to search the overrides for matches */
+    if (DOM_HAS_VIEWS(domain)) {
+        ret = sysdb_search_group_override_by_name(tmp_ctx, domain, name,
+                                                  &override_obj, &orig_obj);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_search_group_override_by_name failed.\n");
+            goto done;
+        }
+    }
+
+    /* If there are no views or nothing was found in the overrides the
+     * original objects are searched. */
+    if (orig_obj == NULL) {
+        ret = sysdb_getgrnam(tmp_ctx, domain, name, &orig_obj);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_getgrnam failed.\n");
+            goto done;
+        }
+    }
+
+    /* If there are views we have to check if override values must be added to
+     * the original object. */
+    if (orig_obj->count == 1) {
+        if (DOM_HAS_VIEWS(domain)) {
             if (!is_local_view(domain->view_name)) {
                 el = ldb_msg_find_element(orig_obj->msgs[0], SYSDB_GHOST);
                 if (el != NULL && el->num_values != 0) {
@@ -1595,6 +2078,172 @@ int sysdb_enumgrent_with_views(TALLOC_CTX *mem_ctx,
     return sysdb_enumgrent_filter_with_views(mem_ctx, domain, NULL, NULL, _res);
 }
 
+static errno_t sysdb_enumgrent_base(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    const char *name_filter,
+                                    struct ldb_dn **_base_dn,
+                                    char **_filter)
+{
+    const char *base_filter;
+
+    if (sss_domain_is_mpg(domain)) {
+        base_filter = SYSDB_GRENT_MPG_FILTER;
+        *_base_dn = sysdb_domain_dn(mem_ctx, domain);
+    } else {
+        base_filter = SYSDB_GRENT_FILTER;
+        *_base_dn = sysdb_group_base_dn(mem_ctx, domain);
+    }
+    if (*_base_dn == NULL) {
+        return ENOMEM;
+    }
+
+    *_filter = enum_filter(mem_ctx, base_filter, name_filter, NULL);
+    if (*_filter == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static errno_t sysdb_enumgrent_add_views(struct sss_domain_info *domain,
+                                         struct ldb_result *res)
+{
+    size_t c;
+    errno_t ret;
+
+    ret = mpg_res_convert(res);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (c = 0; c < res->count; c++) {
+        if (DOM_HAS_VIEWS(domain)) {
+            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                NULL);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
+                return ret;
+            }
+        }
+
+        ret = sysdb_add_group_member_overrides(domain, res->msgs[c],
+                                               DOM_HAS_VIEWS(domain));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_add_group_member_overrides failed.\n");
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+int sysdb_enumgrent_filter_names(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name_filter,
+                                 const char *after,
+                                 size_t limit,
+                                 struct ldb_result **_names)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *base_dn;
+    char *filter;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_enumgrent_base(tmp_ctx, domain, name_filter,
+                               &base_dn, &filter);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_enum_scan(mem_ctx, domain, base_dn, filter, after, limit,
+                          _names);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+int sysdb_enumgrent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **_names)
+{
+    return sysdb_enumgrent_filter_names(mem_ctx, domain, NULL, NULL, 0,
+                                        _names);
+}
+
+int sysdb_enumgrent_read_with_views(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message **names,
+                                    size_t count,
+                                    struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_GRSRC_ATTRS;
+    struct ldb_result *res;
+    int ret;
+
+    ret = sysdb_enum_read(mem_ctx, domain, names, count, attrs, &res);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sysdb_enumgrent_add_views(domain, res);
+    if (ret != EOK) {
+        talloc_free(res);
+        return ret;
+    }
+
+    *_res = res;
+
+    return EOK;
+}
+
+int sysdb_enumgrent_paged_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *after,
+                                     size_t limit,
+                                     struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = SYSDB_GRSRC_ATTRS;
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    char *filter;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_enumgrent_base(tmp_ctx, domain, NULL, &base_dn, &filter);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_enum_page(tmp_ctx, domain, base_dn, filter,
+                          attrs, after, limit, &res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_enumgrent_add_views(domain, res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
 int sysdb_initgroups(TALLOC_CTX *mem_ctx,
                      struct sss_domain_info *domain,
                      const char *name,
@@ -1759,10 +2408,157 @@ done:
     return ret;
 }
 
-int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
-                                struct sss_domain_info *domain,
-                                const char *name,
-                                struct ldb_result **_res)
+/* Above this number of overridden groups it is cheaper to read all group
+ * overrides of the view at once than to look them up one by one. */
+#define SYSDB_INITGR_OVERRIDE_BATCH 32
+
+static errno_t sysdb_initgr_add_group_overrides(struct sss_domain_info *domain,
+                                                struct ldb_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = { SYSDB_GIDNUM, SYSDB_NAME, NULL };
+    struct ldb_result *overrides;
+    struct ldb_message *override_msg;
+    struct ldb_dn *base_dn;
+    struct ldb_dn *override_dn;
+    hash_table_t *table;
+    const char *override_dn_str;
+    const char *key;
+    size_t num_overridden = 0;
+    size_t c;
+    int ret;
+
+    /* Skip user entry because it already has override values added */
+    for (c = 1; c < res->count; c++) {
+        override_dn_str = ldb_msg_find_attr_as_string(res->msgs[c],
+                                                      SYSDB_OVERRIDE_DN, NULL);
+        if (override_dn_str != NULL
+                && !sysdb_has_merged_overrides(res->msgs[c])) {
+            num_overridden++;
+        }
+    }
+
+    if (num_overridden < SYSDB_INITGR_OVERRIDE_BATCH) {
+        for (c = 1; c < res->count; c++) {
+            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                attrs);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE,
+                      "sysdb_add_overrides_to_object failed.\n");
+                return ret;
+            }
+        }
+
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    base_dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb,
+                             SYSDB_TMPL_VIEW_SEARCH_BASE, domain->view_name);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &overrides, base_dn,
+                     LDB_SCOPE_SUBTREE, attrs, "(%s=%s)",
+                     SYSDB_OBJECTCLASS, SYSDB_OVERRIDE_GROUP_CLASS);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    table = sss_ptr_hash_create(tmp_ctx, NULL, NULL);
+    if (table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < overrides->count; c++) {
+        key = ldb_dn_get_casefold(overrides->msgs[c]->dn);
+        if (key == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        ret = sss_ptr_hash_add(table, key, overrides->msgs[c],
+                               struct ldb_message);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (c = 1; c < res->count; c++) {
+        if (sysdb_has_merged_overrides(res->msgs[c])) {
+            continue;
+        }
+
+        override_dn_str = ldb_msg_find_attr_as_string(res->msgs[c],
+                                                      SYSDB_OVERRIDE_DN, NULL);
+        if (override_dn_str == NULL) {
+            if (is_local_view(domain->view_name)) {
+                /* LOCAL view doesn't have to have overrideDN specified. */
+                continue;
+            }
+
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Missing override DN for object [%s].\n",
+                  ldb_dn_get_linearized(res->msgs[c]->dn));
+            ret = ENOENT;
+            goto done;
+        }
+
+        override_dn = ldb_dn_new(tmp_ctx, domain->sysdb->ldb, override_dn_str);
+        if (override_dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        if (ldb_dn_compare(res->msgs[c]->dn, override_dn) == 0) {
+            /* No override for this group */
+            continue;
+        }
+
+        key = ldb_dn_get_casefold(override_dn);
+        if (key == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        override_msg = sss_ptr_hash_lookup(table, key, struct ldb_message);
+        if (override_msg == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Override object [%s] does not exist.\n",
+                  override_dn_str);
+            ret = ENOENT;
+            goto done;
+        }
+
+        ret = sysdb_add_overrides_to_object(domain, res->msgs[c],
+                                            override_msg, attrs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_add_overrides_to_object failed.\n");
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static int sysdb_initgroups_with_views_int(TALLOC_CTX *mem_ctx,
+                                           struct sss_domain_info *domain,
+                                           const char *name,
+                                           const char **attrs,
+                                           bool gids_only,
+                                           struct ldb_result **_res)
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_result *res;
@@ -1770,7 +2566,6 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
     struct ldb_request *req;
     struct ldb_control **ctrl;
     struct ldb_asq_control *control;
-    static const char *attrs[] = SYSDB_INITGR_ATTRS;
     int ret;
     size_t c;
 
@@ -1854,15 +2649,22 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
     }
 
     if (DOM_HAS_VIEWS(domain)) {
-        /* Skip user entry because it already has override values added */
-        for (c = 1; c < res->count; c++) {
-            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
-                                                NULL);
+        if (gids_only) {
+            ret = sysdb_initgr_add_group_overrides(domain, res);
             if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "sysdb_add_overrides_to_object failed.\n");
                 goto done;
             }
+        } else {
+            /* Skip user entry because it already has override values added */
+            for (c = 1; c < res->count; c++) {
+                ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                    NULL);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_OP_FAILURE,
+                          "sysdb_add_overrides_to_object failed.\n");
+                    goto done;
+                }
+            }
         }
     }
 
@@ -1873,6 +2675,28 @@ done:
     return ret;
 }
 
+int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_INITGR_ATTRS;
+
+    return sysdb_initgroups_with_views_int(mem_ctx, domain, name, attrs,
+                                           false, _res);
+}
+
+int sysdb_initgroups_gids_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     const char *name,
+                                     struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_INITGR_GIDS_ATTRS;
+
+    return sysdb_initgroups_with_views_int(mem_ctx, domain, name, attrs,
+                                           true, _res);
+}
+
 int sysdb_get_user_attr(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
                         const char *name,
@@ -2010,6 +2834,90 @@ done:
 }
 
 
+int sysdb_get_user_attr_by_uid_with_views(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *domain,
+                                          uid_t uid,
+                                          const char **attributes,
+                                          struct ldb_result **_res)
+{
+    int ret;
+    struct ldb_result *orig_obj = NULL;
+    struct ldb_result *override_obj = NULL;
+    const char **attrs = NULL;
+    const char *mandatory_override_attrs[] = {SYSDB_OVERRIDE_DN,
+                                              SYSDB_OVERRIDE_OBJECT_DN,
+                                              NULL};
+    TALLOC_CTX *tmp_ctx;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    attrs = attributes;
+
+    /* If there are views we first have to search the overrides for matches */
+    if (DOM_HAS_VIEWS(domain)) {
+        ret = add_strings_lists(tmp_ctx, attributes, mandatory_override_attrs,
+                                false, discard_const(&attrs));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "add_strings_lists failed.\n");
+            goto done;
+        }
+
+        ret = sysdb_search_user_override_attrs_by_uid(tmp_ctx, domain, uid,
+                                            attrs, &override_obj, &orig_obj);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_search_user_override_attrs_by_uid failed.\n");
+            goto done;
+        }
+    }
+
+    /* If there are no views or nothing was found in the overrides the
+     * original objects are searched. */
+    if (orig_obj == NULL) {
+        ret = sysdb_get_user_attr_by_uid(tmp_ctx, domain, uid, attrs,
+                                         &orig_obj);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_get_user_attr_by_uid failed.\n");
+            goto done;
+        }
+    }
+
+    /* If there are views we have to check if override values must be added to
+     * the original object. */
+    if (DOM_HAS_VIEWS(domain) && orig_obj->count == 1) {
+        ret = sysdb_add_overrides_to_object(domain, orig_obj->msgs[0],
+                          override_obj == NULL ? NULL : override_obj->msgs[0],
+                          attrs);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
+            goto done;
+        }
+
+        if (ret == ENOENT) {
+            *_res = talloc_zero(mem_ctx, struct ldb_result);
+            if (*_res == NULL) {
+                DEBUG(SSSDBG_OP_FAILURE, "talloc_zero failed.\n");
+                ret = ENOMEM;
+            } else {
+                ret = EOK;
+            }
+            goto done;
+        }
+    }
+
+    *_res = talloc_steal(mem_ctx, orig_obj);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+
 /* Get string until the first delimiter and strip out
  * leading and trailing whitespaces.
  */
@@ -59,6 +59,7 @@ struct sss_domain_info *new_subdomain(TALLOC_CTX *mem_ctx,
 
     /* Sub-domains always have the same view as the parent */
     dom->has_views = parent->has_views;
+    dom->cache_merged_overrides = parent->cache_merged_overrides;
     if (parent->view_name != NULL) {
         dom->view_name = talloc_strdup(dom, parent->view_name);
         if (dom->view_name == NULL) {
@@ -22,6 +22,7 @@
 
 #include <talloc.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "db/sysdb.h"
 #include "db/sysdb_private.h"
@@ -537,9 +538,9 @@ done:
     return ret;
 }
 
-static errno_t sysdb_sudo_set_refresh_time(struct sss_domain_info *domain,
-                                           const char *attr_name,
-                                           time_t value)
+static errno_t sysdb_sudo_set_container_attr(struct sss_domain_info *domain,
+                                            const char *attr_name,
+                                            int64_t value)
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_dn *dn;
@@ -619,9 +620,9 @@ done:
     return ret;
 }
 
-static errno_t sysdb_sudo_get_refresh_time(struct sss_domain_info *domain,
-                                           const char *attr_name,
-                                           time_t *value)
+static errno_t sysdb_sudo_get_container_attr(struct sss_domain_info *domain,
+                                            const char *attr_name,
+                                            int64_t *value)
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_dn *dn;
@@ -665,7 +666,7 @@ static errno_t sysdb_sudo_get_refresh_time(struct sss_domain_info *domain,
         goto done;
     }
 
-    *value = ldb_msg_find_attr_as_int(res->msgs[0], attr_name, 0);
+    *value = ldb_msg_find_attr_as_int64(res->msgs[0], attr_name, 0);
 
     ret = EOK;
 
@@ -677,15 +678,58 @@ done:
 errno_t sysdb_sudo_set_last_full_refresh(struct sss_domain_info *domain,
                                          time_t value)
 {
-    return sysdb_sudo_set_refresh_time(domain,
-                                       SYSDB_SUDO_AT_LAST_FULL_REFRESH, value);
+    return sysdb_sudo_set_container_attr(domain,
+                                         SYSDB_SUDO_AT_LAST_FULL_REFRESH,
+                                         value);
 }
 
 errno_t sysdb_sudo_get_last_full_refresh(struct sss_domain_info *domain,
                                          time_t *value)
 {
-    return sysdb_sudo_get_refresh_time(domain,
-                                       SYSDB_SUDO_AT_LAST_FULL_REFRESH, value);
+    int64_t refresh;
+    errno_t ret;
+
+    ret = sysdb_sudo_get_container_attr(domain,
+                                        SYSDB_SUDO_AT_LAST_FULL_REFRESH,
+                                        &refresh);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *value = refresh;
+
+    return EOK;
+}
+
+/* The generation is a time stamp in microseconds rather than a counter
+ * so it does not repeat when the rules container is deleted. */
+static errno_t sysdb_sudo_bump_generation(struct sss_domain_info *domain)
+{
+    struct timeval tv;
+    int64_t generation;
+
+    gettimeofday(&tv, NULL);
+    generation = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    return sysdb_sudo_set_container_attr(domain, SYSDB_SUDO_AT_GENERATION,
+                                         generation);
+}
+
+errno_t sysdb_sudo_get_generation(struct sss_domain_info *domain,
+                                  uint64_t *_generation)
+{
+    int64_t generation;
+    errno_t ret;
+
+    ret = sysdb_sudo_get_container_attr(domain, SYSDB_SUDO_AT_GENERATION,
+                                        &generation);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *_generation = generation;
+
+    return EOK;
 }
 
 /* ====================  Purge functions ==================== */
@@ -852,6 +896,11 @@ errno_t sysdb_sudo_purge(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_sudo_bump_generation(domain);
+    if (ret != EOK) {
+        goto done;
+    }
+
     ret = sysdb_transaction_commit(domain->sysdb);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
@@ -1045,6 +1094,11 @@ sysdb_sudo_store(struct sss_domain_info *domain,
         }
     }
 
+    ret = sysdb_sudo_bump_generation(domain);
+    if (ret != EOK) {
+        goto done;
+    }
+
     ret = sysdb_transaction_commit(domain->sysdb);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
@@ -1159,6 +1213,11 @@ sysdb_set_sudo_rule_attr(struct sss_domain_info *domain,
     NULL_CHECK(dn, ret, done);
 
     ret = sysdb_set_entry_attr(domain->sysdb, dn, attrs, mod_op);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_sudo_bump_generation(domain);
 
 done:
     talloc_free(tmp_ctx);
@@ -22,7 +22,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <fcntl.h>
+
 #include "util/util.h"
+#include "util/atomic_io.h"
 #include "db/sysdb_private.h"
 #include "db/sysdb_autofs.h"
 #include "db/sysdb_iphosts.h"
@@ -2712,6 +2715,263 @@ done:
     return ret;
 }
 
+/* TDB files start with a text magic, LMDB files have a binary magic
+ * number in the meta page header. */
+#define SYSDB_TDB_MAGIC "TDB file"
+#define SYSDB_LMDB_MAGIC_OFFSET 16
+#define SYSDB_LMDB_MAGIC 0xBEEFC0DE
+
+errno_t sysdb_get_db_backend(const char *ldb_file,
+                             enum sss_cache_backend *_backend)
+{
+    uint8_t buf[SYSDB_LMDB_MAGIC_OFFSET + sizeof(uint32_t)];
+    uint32_t lmdb_magic;
+    ssize_t len;
+    errno_t ret;
+    int fd;
+
+    fd = open(ldb_file, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno;
+    }
+
+    len = sss_atomic_read_s(fd, buf, sizeof(buf));
+    ret = errno;
+    close(fd);
+    if (len == -1) {
+        return ret;
+    }
+
+    if ((size_t) len >= sizeof(SYSDB_TDB_MAGIC) - 1
+            && memcmp(buf, SYSDB_TDB_MAGIC, sizeof(SYSDB_TDB_MAGIC) - 1) == 0) {
+        *_backend = SSS_CACHE_BACKEND_TDB;
+        return EOK;
+    }
+
+    if ((size_t) len == sizeof(buf)) {
+        memcpy(&lmdb_magic, buf + SYSDB_LMDB_MAGIC_OFFSET, sizeof(uint32_t));
+        if (lmdb_magic == SYSDB_LMDB_MAGIC) {
+            *_backend = SSS_CACHE_BACKEND_LMDB;
+            return EOK;
+        }
+    }
+
+    return EINVAL;
+}
+
+static errno_t sysdb_unlink_lock_file(const char *ldb_file)
+{
+    char *lock_file;
+    errno_t ret;
+
+    lock_file = talloc_asprintf(NULL, "%s"SYSDB_LMDB_LOCK_SUFFIX, ldb_file);
+    if (lock_file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = unlink(lock_file);
+    talloc_free(lock_file);
+    if (ret != 0 && errno != ENOENT) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+static errno_t sysdb_unlink_db_files(const char *ldb_file)
+{
+    errno_t ret;
+
+    ret = unlink(ldb_file);
+    if (ret != 0 && errno != ENOENT) {
+        return errno;
+    }
+
+    return sysdb_unlink_lock_file(ldb_file);
+}
+
+static errno_t sysdb_copy_db_entry(struct ldb_context *dest,
+                                   struct ldb_message *src)
+{
+    struct ldb_message *msg;
+    int ret;
+
+    msg = ldb_msg_copy_shallow(src, src);
+    if (msg == NULL) {
+        return ENOMEM;
+    }
+
+    /* The DN must be parsed against the destination database */
+    msg->dn = ldb_dn_new(msg, dest, ldb_dn_get_linearized(src->dn));
+    if (msg->dn == NULL) {
+        talloc_free(msg);
+        return ENOMEM;
+    }
+
+    ret = ldb_add(dest, msg);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot copy [%s]: [%d]: %s\n",
+              ldb_dn_get_linearized(src->dn), ret, ldb_errstring(dest));
+        talloc_free(msg);
+        return sysdb_error_to_errno(ret);
+    }
+
+    talloc_free(msg);
+    return EOK;
+}
+
+/* Copy the whole database into a new file created with the configured
+ * backend and replace the old file with it. The special records are
+ * copied first so that the indexes are built while the entries are
+ * added; the memberof module is not loaded in the new database until
+ * it is reopened, so the member attributes are copied verbatim. */
+errno_t sysdb_upgrade_backend(struct sysdb_ctx *sysdb,
+                              const char *ldb_file,
+                              enum sss_cache_backend from,
+                              uint64_t lmdb_map_size)
+{
+    static const char *special_dns[] = { "@ATTRIBUTES",
+                                         "@INDEXLIST",
+                                         "@MODULES",
+                                         NULL };
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_context *old_ldb = NULL;
+    struct ldb_context *new_ldb = NULL;
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    char *new_file;
+    bool in_transaction = false;
+    unsigned int i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    new_file = talloc_asprintf(tmp_ctx, "%s.convert", ldb_file);
+    if (new_file == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Remove leftovers of an interrupted conversion */
+    ret = sysdb_unlink_db_files(new_file);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_ldb_connect_ext(tmp_ctx, ldb_file, from, 0, 0, &old_ldb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_ldb_connect failed.\n");
+        goto done;
+    }
+
+    ret = sysdb_ldb_connect_ext(tmp_ctx, new_file, sysdb->backend,
+                                lmdb_map_size, 0, &new_ldb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_ldb_connect failed.\n");
+        goto done;
+    }
+
+    ret = ldb_transaction_start(new_ldb);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+    in_transaction = true;
+
+    for (i = 0; special_dns[i] != NULL; i++) {
+        dn = ldb_dn_new(tmp_ctx, old_ldb, special_dns[i]);
+        if (dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = ldb_search(old_ldb, tmp_ctx, &res, dn, LDB_SCOPE_BASE,
+                         NULL, NULL);
+        if (ret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+
+        if (res->count == 1) {
+            ret = sysdb_copy_db_entry(new_ldb, res->msgs[0]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+        talloc_free(res);
+    }
+
+    ret = ldb_search(old_ldb, tmp_ctx, &res, NULL, LDB_SCOPE_SUBTREE,
+                     NULL, "(distinguishedName=*)");
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        if (ldb_dn_is_special(res->msgs[i]->dn)) {
+            continue;
+        }
+
+        ret = sysdb_copy_db_entry(new_ldb, res->msgs[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Copied %u entries from %s\n",
+          res->count, ldb_file);
+    talloc_free(res);
+
+    ret = ldb_transaction_commit(new_ldb);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+    in_transaction = false;
+
+    talloc_zfree(new_ldb);
+    talloc_zfree(old_ldb);
+
+    ret = backup_file(ldb_file, SSSDBG_FATAL_FAILURE);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* Replace the old file atomically so that either the old or the new
+     * database exists if the conversion is interrupted. */
+    ret = rename(new_file, ldb_file);
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot rename %s to %s [%d]: %s\n",
+              new_file, ldb_file, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* The lock files belong to the old files, LMDB recreates them on the
+     * next open */
+    ret = sysdb_unlink_lock_file(ldb_file);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_unlink_lock_file(new_file);
+
+done:
+    if (in_transaction) {
+        ldb_transaction_cancel(new_ldb);
+    }
+    if (ret != EOK) {
+        talloc_zfree(new_ldb);
+        sysdb_unlink_db_files(new_file);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 /*
  * Example template for future upgrades.
  * Copy and change version numbers as appropriate.
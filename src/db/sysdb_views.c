@@ -26,6 +26,23 @@
 
 #define SYSDB_VIEWS_BASE "cn=views,cn=sysdb"
 
+/* Override attributes and the names under which their values are added to
+ * the original object. */
+static const struct override_attr_map {
+    const char *attr;
+    const char *new_attr;
+} override_attr_map[] = {
+    {SYSDB_UIDNUM, OVERRIDE_PREFIX SYSDB_UIDNUM},
+    {SYSDB_GIDNUM, OVERRIDE_PREFIX SYSDB_GIDNUM},
+    {SYSDB_GECOS, OVERRIDE_PREFIX SYSDB_GECOS},
+    {SYSDB_HOMEDIR, OVERRIDE_PREFIX SYSDB_HOMEDIR},
+    {SYSDB_SHELL, OVERRIDE_PREFIX SYSDB_SHELL},
+    {SYSDB_NAME, OVERRIDE_PREFIX SYSDB_NAME},
+    {SYSDB_SSH_PUBKEY, OVERRIDE_PREFIX SYSDB_SSH_PUBKEY},
+    {SYSDB_USER_CERT, OVERRIDE_PREFIX SYSDB_USER_CERT},
+    {NULL, NULL}
+};
+
 /* In general is should not be possible that there is a view container without
  * a view name set. But to be on the safe side we return both information
  * separately. */
@@ -282,13 +299,26 @@ done:
 static errno_t invalidate_entry_override(struct sysdb_ctx *sysdb,
                                          struct ldb_dn *dn,
                                          struct ldb_message *msg_del,
-                                         struct ldb_message *msg_repl)
+                                         struct ldb_message *msg_repl,
+                                         struct ldb_message *msg_merged)
 {
     int ret;
 
     msg_del->dn = dn;
     msg_repl->dn = dn;
 
+    if (msg_merged != NULL) {
+        msg_merged->dn = dn;
+
+        ret = ldb_modify(sysdb->ldb, msg_merged);
+        if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_ATTRIBUTE) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "ldb_modify failed: [%s](%d)[%s]\n",
+                  ldb_strerror(ret), ret, ldb_errstring(sysdb->ldb));
+            return sysdb_error_to_errno(ret);
+        }
+    }
+
     ret = ldb_modify(sysdb->ldb, msg_del);
     if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_ATTRIBUTE) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -328,6 +358,8 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
     size_t c;
     struct ldb_message *msg_del;
     struct ldb_message *msg_repl;
+    struct ldb_message *msg_merged;
+    struct ldb_message_element *merged;
     struct ldb_dn *base_dn;
 
     if (sysdb->ldb_ts == NULL) {
@@ -384,6 +416,30 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
         goto done;
     }
 
+    /* Override values copied into the objects belong to the old view. */
+    msg_merged = ldb_msg_new(tmp_ctx);
+    if (msg_merged == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_new failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+    for (c = 0; override_attr_map[c].attr != NULL; c++) {
+        ret = ldb_msg_add_empty(msg_merged, override_attr_map[c].new_attr,
+                                LDB_FLAG_MOD_REPLACE, NULL);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_empty failed.\n");
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+    }
+    ret = ldb_msg_add_empty(msg_merged, SYSDB_OVERRIDE_MERGED_DN,
+                            LDB_FLAG_MOD_REPLACE, NULL);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_empty failed.\n");
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
     ret = sysdb_transaction_start(sysdb);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_start failed.\n");
@@ -400,8 +456,10 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
     }
 
     for (c = 0; c < res->count; c++) {
+        merged = ldb_msg_find_element(res->msgs[c], SYSDB_OVERRIDE_MERGED_DN);
         ret = invalidate_entry_override(sysdb, res->msgs[c]->dn, msg_del,
-                                                                 msg_repl);
+                                        msg_repl,
+                                        merged != NULL ? msg_merged : NULL);
         if (ret != EOK) {
             DEBUG(SSSDBG_OP_FAILURE,
                   "invalidate_entry_override failed [%d][%s].\n",
@@ -421,8 +479,10 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
     }
 
     for (c = 0; c < res->count; c++) {
+        merged = ldb_msg_find_element(res->msgs[c], SYSDB_OVERRIDE_MERGED_DN);
         ret = invalidate_entry_override(sysdb, res->msgs[c]->dn, msg_del,
-                                                                 msg_repl);
+                                        msg_repl,
+                                        merged != NULL ? msg_merged : NULL);
         if (ret != EOK) {
             DEBUG(SSSDBG_OP_FAILURE,
                   "invalidate_entry_override failed [%d][%s].\n",
@@ -486,6 +546,90 @@ add_name_and_aliases_for_name_override(struct sss_domain_info *domain,
     return EOK;
 }
 
+/* Copy the override values into the original object so that readers get the
+ * effective values with a single search. If @attrs is NULL a copy stored
+ * earlier is removed. */
+static errno_t store_merged_overrides(struct sss_domain_info *domain,
+                                      struct ldb_dn *obj_dn,
+                                      struct sysdb_attrs *attrs,
+                                      const char *override_dn_str)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message *msg;
+    struct ldb_message_element *el;
+    struct ldb_message_element *override_el;
+    size_t c;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    msg = ldb_msg_new(tmp_ctx);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    msg->dn = obj_dn;
+
+    for (c = 0; override_attr_map[c].attr != NULL; c++) {
+        ret = ldb_msg_add_empty(msg, override_attr_map[c].new_attr,
+                                LDB_FLAG_MOD_REPLACE, &el);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_empty failed.\n");
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+
+        if (attrs == NULL) {
+            continue;
+        }
+
+        ret = sysdb_attrs_get_el_ext(attrs, override_attr_map[c].attr, false,
+                                     &override_el);
+        if (ret == EOK) {
+            el->values = override_el->values;
+            el->num_values = override_el->num_values;
+        } else if (ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_attrs_get_el_ext failed.\n");
+            goto done;
+        }
+    }
+
+    ret = ldb_msg_add_empty(msg, SYSDB_OVERRIDE_MERGED_DN,
+                            LDB_FLAG_MOD_REPLACE, NULL);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_empty failed.\n");
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    if (attrs != NULL) {
+        ret = ldb_msg_add_string(msg, SYSDB_OVERRIDE_MERGED_DN,
+                                 override_dn_str);
+        if (ret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+    }
+
+    ret = ldb_modify(domain->sysdb->ldb, msg);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to store merged override values: %s(%d)[%s]\n",
+              ldb_strerror(ret), ret, ldb_errstring(domain->sysdb->ldb));
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sysdb_store_override(struct sss_domain_info *domain,
                              const char *view_name,
                              enum sysdb_member_type type,
@@ -499,11 +643,13 @@ errno_t sysdb_store_override(struct sss_domain_info *domain,
     const char *obj_dn_str;
     const char *obj_attrs[] = { SYSDB_OBJECTCLASS,
                                 SYSDB_OVERRIDE_DN,
+                                SYSDB_OVERRIDE_MERGED_DN,
                                 NULL};
     size_t count = 0;
     struct ldb_message **msgs;
     struct ldb_message *msg = NULL;
     const char *obj_override_dn;
+    const char *obj_merged_dn;
     bool add_ref = true;
     size_t c;
     bool in_transaction = false;
@@ -568,6 +714,8 @@ errno_t sysdb_store_override(struct sss_domain_info *domain,
 
     obj_override_dn = ldb_msg_find_attr_as_string(msgs[0], SYSDB_OVERRIDE_DN,
                                                   NULL);
+    obj_merged_dn = ldb_msg_find_attr_as_string(msgs[0],
+                                                SYSDB_OVERRIDE_MERGED_DN, NULL);
     if (obj_override_dn != NULL) {
         /* obj_override_dn can either point to the object itself, i.e there is
          * no override, or to a override object. This means it can change from
@@ -729,6 +877,18 @@ errno_t sysdb_store_override(struct sss_domain_info *domain,
         }
     }
 
+    if (domain->cache_merged_overrides && has_override) {
+        ret = store_merged_overrides(domain, obj_dn, attrs, override_dn_str);
+        if (ret != EOK) {
+            goto done;
+        }
+    } else if (obj_merged_dn != NULL) {
+        ret = store_merged_overrides(domain, obj_dn, NULL, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     ret = EOK;
 
 done:
@@ -1248,6 +1408,7 @@ static errno_t sysdb_search_override_by_id(TALLOC_CTX *mem_ctx,
                                            struct sss_domain_info *domain,
                                            unsigned long int id,
                                            enum override_object_type type,
+                                           const char **req_attrs,
                                            struct ldb_result **override_obj,
                                            struct ldb_result **orig_obj)
 {
@@ -1292,6 +1453,10 @@ static errno_t sysdb_search_override_by_id(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    if (req_attrs != NULL) {
+        attrs = req_attrs;
+    }
+
     ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &override_res, base_dn,
                      LDB_SCOPE_SUBTREE, attrs, filter, id);
     if (ret != LDB_SUCCESS) {
@@ -1375,7 +1540,18 @@ errno_t sysdb_search_user_override_by_uid(TALLOC_CTX *mem_ctx,
                                            struct ldb_result **orig_obj)
 {
     return sysdb_search_override_by_id(mem_ctx, domain, uid, OO_TYPE_USER,
-                                       override_obj, orig_obj);
+                                       NULL, override_obj, orig_obj);
+}
+
+errno_t sysdb_search_user_override_attrs_by_uid(TALLOC_CTX *mem_ctx,
+                                            struct sss_domain_info *domain,
+                                            uid_t uid,
+                                            const char **attrs,
+                                            struct ldb_result **override_obj,
+                                            struct ldb_result **orig_obj)
+{
+    return sysdb_search_override_by_id(mem_ctx, domain, uid, OO_TYPE_USER,
+                                       attrs, override_obj, orig_obj);
 }
 
 errno_t sysdb_search_group_override_by_gid(TALLOC_CTX *mem_ctx,
@@ -1385,12 +1561,15 @@ errno_t sysdb_search_group_override_by_gid(TALLOC_CTX *mem_ctx,
                                             struct ldb_result **orig_obj)
 {
     return sysdb_search_override_by_id(mem_ctx, domain, gid, OO_TYPE_GROUP,
-                                       override_obj, orig_obj);
+                                       NULL, override_obj, orig_obj);
 }
 
 /**
  * @brief Add override data to the original object
  *
+ * If the override values were already copied into the original object, see
+ * the cache_merged_overrides option, the override object is not read.
+ *
  * @param[in] domain Domain struct, needed to access the cache
  * @oaram[in] obj The original object
  * @param[in] override_obj The object with the override data, may be NULL
@@ -1419,20 +1598,6 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
     static const char *user_attrs[] = SYSDB_PW_ATTRS;
     static const char *group_attrs[] = SYSDB_GRSRC_ATTRS;
     const char **attrs;
-    struct attr_map {
-        const char *attr;
-        const char *new_attr;
-    } attr_map[] = {
-        {SYSDB_UIDNUM, OVERRIDE_PREFIX SYSDB_UIDNUM},
-        {SYSDB_GIDNUM, OVERRIDE_PREFIX SYSDB_GIDNUM},
-        {SYSDB_GECOS, OVERRIDE_PREFIX SYSDB_GECOS},
-        {SYSDB_HOMEDIR, OVERRIDE_PREFIX SYSDB_HOMEDIR},
-        {SYSDB_SHELL, OVERRIDE_PREFIX SYSDB_SHELL},
-        {SYSDB_NAME, OVERRIDE_PREFIX SYSDB_NAME},
-        {SYSDB_SSH_PUBKEY, OVERRIDE_PREFIX SYSDB_SSH_PUBKEY},
-        {SYSDB_USER_CERT, OVERRIDE_PREFIX SYSDB_USER_CERT},
-        {NULL, NULL}
-    };
     size_t c;
     size_t d;
     struct ldb_message_element *tmp_el;
@@ -1443,6 +1608,21 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
+    if (ldb_msg_find_element(obj, SYSDB_OVERRIDE_MERGED_DN) != NULL) {
+        if (sysdb_has_merged_overrides(obj)) {
+            DEBUG(SSSDBG_TRACE_ALL, "Override values of [%s] are cached.\n",
+                                    ldb_dn_get_linearized(obj->dn));
+            ret = EOK;
+            goto done;
+        }
+
+        /* The copy is outdated, use the override object. */
+        for (c = 0; override_attr_map[c].attr != NULL; c++) {
+            ldb_msg_remove_attr(obj, override_attr_map[c].new_attr);
+        }
+        ldb_msg_remove_attr(obj, SYSDB_OVERRIDE_MERGED_DN);
+    }
+
     if (override_obj == NULL) {
         override_dn_str = ldb_msg_find_attr_as_string(obj,
                                                       SYSDB_OVERRIDE_DN, NULL);
@@ -1511,11 +1691,11 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
         override = override_obj;
     }
 
-    for (c = 0; attr_map[c].attr != NULL; c++) {
-        tmp_el = ldb_msg_find_element(override, attr_map[c].attr);
+    for (c = 0; override_attr_map[c].attr != NULL; c++) {
+        tmp_el = ldb_msg_find_element(override, override_attr_map[c].attr);
         if (tmp_el != NULL) {
             for (d = 0; d < tmp_el->num_values; d++) {
-                ret = ldb_msg_add_steal_value(obj, attr_map[c].new_attr,
+                ret = ldb_msg_add_steal_value(obj, override_attr_map[c].new_attr,
                                               &tmp_el->values[d]);
                 if (ret != LDB_SUCCESS) {
                     DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_value failed.\n");
@@ -1533,6 +1713,25 @@ done:
     return ret;
 }
 
+bool sysdb_has_merged_overrides(struct ldb_message *obj)
+{
+    const char *merged_dn_str;
+    const char *override_dn_str;
+
+    merged_dn_str = ldb_msg_find_attr_as_string(obj, SYSDB_OVERRIDE_MERGED_DN,
+                                                NULL);
+    if (merged_dn_str == NULL) {
+        return false;
+    }
+
+    override_dn_str = ldb_msg_find_attr_as_string(obj, SYSDB_OVERRIDE_DN, NULL);
+    if (override_dn_str == NULL) {
+        return false;
+    }
+
+    return strcmp(merged_dn_str, override_dn_str) == 0;
+}
+
 errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
                                          struct ldb_message *obj,
                                          bool expect_override_dn)
@@ -1623,7 +1822,12 @@ errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
                                                 NULL);
 
         /* If there is an override object, check if the name is overridden */
-        if (ldb_dn_compare(res_members->msgs[c]->dn, override_dn) != 0) {
+        if (expect_override_dn
+                && sysdb_has_merged_overrides(res_members->msgs[c])) {
+            memberuid = ldb_msg_find_attr_as_string(res_members->msgs[c],
+                                                    OVERRIDE_PREFIX SYSDB_NAME,
+                                                    memberuid);
+        } else if (ldb_dn_compare(res_members->msgs[c]->dn, override_dn) != 0) {
             DEBUG(SSSDBG_TRACE_ALL, "Checking override for object [%s].\n",
                   ldb_dn_get_linearized(res_members->msgs[c]->dn));
 
@@ -776,7 +776,9 @@ int sss_certmap_match_cert(struct sss_certmap_ctx *ctx,
     struct priority_list *p;
     struct sss_cert_content *cert_content = NULL;
 
-    ret = sss_cert_get_content(ctx, der_cert, der_size, &cert_content);
+    /* Do not allocate on ctx, so that the same context can be used to match
+     * certificates in several threads. */
+    ret = sss_cert_get_content(NULL, der_cert, der_size, &cert_content);
     if (ret != 0) {
         CM_DEBUG(ctx, "Failed to get certificate content.");
         return ret;
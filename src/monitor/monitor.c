@@ -44,6 +44,7 @@
 
 #include "confdb/confdb.h"
 #include "confdb/confdb_setup.h"
+#include "confdb/confdb_snapshot.h"
 #include "db/sysdb.h"
 #include "monitor/monitor.h"
 #include "util/inotify.h"
@@ -117,6 +118,10 @@ struct mt_svc {
     int restarts;
     time_t last_restart;
 
+    /* Startup timing of the current instance of the service. */
+    struct timeval launched;
+    struct timeval ready;
+
     int debug_level;
 
     struct sss_child_ctx *child_ctx;
@@ -167,6 +172,7 @@ struct mt_ctx {
     bool pid_file_created;
     bool is_daemon;
     pid_t parent_pid;
+    struct timeval start_time;
 
     struct sbus_server *sbus_server;
     struct sbus_connection *sbus_conn;
@@ -270,6 +276,16 @@ errno_t socket_activated_service_not_found(struct mt_ctx *mt_ctx,
 }
 #endif
 
+static uint32_t timeval_diff_ms(const struct timeval *from,
+                                const struct timeval *to)
+{
+    struct timeval diff;
+
+    diff = tevent_timeval_until(from, to);
+
+    return diff.tv_sec * 1000 + diff.tv_usec / 1000;
+}
+
 static errno_t
 get_service_in_the_list(struct mt_ctx *mt_ctx,
                         const char *svc_name,
@@ -343,6 +359,66 @@ monitor_sbus_RegisterService(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static errno_t
+monitor_sbus_GetStartupTimes(TALLOC_CTX *mem_ctx,
+                             struct sbus_request *sbus_req,
+                             struct mt_ctx *mt_ctx,
+                             const char ***_names,
+                             uint32_t **_pids,
+                             uint32_t **_launched,
+                             uint32_t **_ready)
+{
+    struct mt_svc *svc;
+    const char **names;
+    uint32_t *pids;
+    uint32_t *launched;
+    uint32_t *ready;
+    size_t count;
+    size_t i;
+
+    count = 0;
+    DLIST_FOR_EACH(svc, mt_ctx->svc_list) {
+        count++;
+    }
+
+    names = talloc_zero_array(mem_ctx, const char *, count + 1);
+    pids = talloc_zero_array(mem_ctx, uint32_t, count);
+    launched = talloc_zero_array(mem_ctx, uint32_t, count);
+    ready = talloc_zero_array(mem_ctx, uint32_t, count);
+    if (names == NULL || pids == NULL || launched == NULL || ready == NULL) {
+        return ENOMEM;
+    }
+
+    /* Launch time is relative to the start of the monitor, ready time is
+     * relative to the launch time and SSS_STARTUP_NOT_READY if the service
+     * has not registered yet. A service may register within a millisecond
+     * so zero is a valid ready time. */
+    i = 0;
+    DLIST_FOR_EACH(svc, mt_ctx->svc_list) {
+        names[i] = svc->identity;
+        pids[i] = svc->pid;
+
+        if (!tevent_timeval_is_zero(&svc->launched)) {
+            launched[i] = timeval_diff_ms(&mt_ctx->start_time, &svc->launched);
+        }
+
+        ready[i] = SSS_STARTUP_NOT_READY;
+        if (svc->svc_started && !tevent_timeval_is_zero(&svc->launched)) {
+            ready[i] = MIN(timeval_diff_ms(&svc->launched, &svc->ready),
+                           SSS_STARTUP_NOT_READY - 1);
+        }
+
+        i++;
+    }
+
+    *_names = names;
+    *_pids = pids;
+    *_launched = launched;
+    *_ready = ready;
+
+    return EOK;
+}
+
 struct svc_spy {
     struct mt_svc *svc;
 };
@@ -462,16 +538,38 @@ static int notify_startup(void)
     return EOK;
 }
 
+static void start_services(struct mt_ctx *ctx)
+{
+    int i;
+
+    if (ctx->services == NULL || ctx->services_started) {
+        return;
+    }
+
+    ctx->services_started = true;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Now starting services!\n");
+    for (i = 0; ctx->services[i]; i++) {
+        add_new_service(ctx, ctx->services[i], 0);
+    }
+}
+
 static int mark_service_as_started(struct mt_svc *svc)
 {
     struct mt_ctx *ctx = svc->mt_ctx;
     struct mt_svc *iter;
     int ret;
-    int i;
 
     DEBUG(SSSDBG_FUNC_DATA, "Marking %s as started.\n", svc->name);
     svc->svc_started = true;
 
+    svc->ready = tevent_timeval_current();
+    if (!tevent_timeval_is_zero(&svc->launched)) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Service %s registered %"PRIu32" ms after it was launched\n",
+              svc->name, timeval_diff_ms(&svc->launched, &svc->ready));
+    }
+
     /* We need to attach a spy to the connection structure so that if some code
      * frees it we can zero it out in the service structure. Otherwise we may
      * try to access or even free, freed memory. */
@@ -497,15 +595,13 @@ static int mark_service_as_started(struct mt_svc *svc)
             goto done;
         }
 
-        if (ctx->services != NULL) {
-            ctx->services_started = true;
+        DEBUG(SSSDBG_CONF_SETTINGS, "All providers registered after "
+              "%"PRIu32" ms\n", timeval_diff_ms(&ctx->start_time, &svc->ready));
 
-            DEBUG(SSSDBG_CONF_SETTINGS, "Now starting services!\n");
-            /* then start all services */
-            for (i = 0; ctx->services[i]; i++) {
-                add_new_service(ctx, ctx->services[i], 0);
-            }
-        }
+        /* Every responder connects to the backends of all configured
+         * domains during its initialization, so all of them can be started
+         * at once now. */
+        start_services(ctx);
     }
 
     if (svc->type == MT_SVC_SERVICE) {
@@ -566,7 +662,6 @@ static void services_startup_timeout(struct tevent_context *ev,
                                      struct timeval t, void *ptr)
 {
     struct mt_ctx *ctx = talloc_get_type(ptr, struct mt_ctx);
-    int i;
 
     if (ctx->services == NULL) {
         return;
@@ -579,13 +674,7 @@ static void services_startup_timeout(struct tevent_context *ev,
         DEBUG(SSSDBG_CRIT_FAILURE, "Providers did not start in time, "
                   "forcing services startup!\n");
 
-        ctx->services_started = true;
-
-        DEBUG(SSSDBG_CONF_SETTINGS, "Now starting services!\n");
-        /* then start all services */
-        for (i = 0; ctx->services[i]; i++) {
-            add_new_service(ctx, ctx->services[i], 0);
-        }
+        start_services(ctx);
     }
 }
 
@@ -1625,6 +1714,7 @@ errno_t load_configuration(TALLOC_CTX *mem_ctx,
     }
 
     ctx->pid_file_created = false;
+    ctx->start_time = tevent_timeval_current();
     talloc_set_destructor((TALLOC_CTX *)ctx, monitor_ctx_destructor);
 
     cdb_file = talloc_asprintf(ctx, "%s/%s", DB_PATH, CONFDB_FILE);
@@ -1660,6 +1750,14 @@ errno_t load_configuration(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Let the services read their options without searching the confdb,
+     * they fall back to it if there is no snapshot. */
+    ret = confdb_snapshot_publish(ctx->cdb, ctx->uid, ctx->gid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Services will read the configuration from the confdb\n");
+    }
+
     *monitor = ctx;
 
     ret = EOK;
@@ -2078,7 +2176,8 @@ static void monitor_sbus_connected(struct tevent_req *req)
     SBUS_INTERFACE(iface,
         sssd_monitor,
         SBUS_METHODS(
-            SBUS_SYNC(METHOD, sssd_monitor, RegisterService, monitor_sbus_RegisterService, ctx)
+            SBUS_SYNC(METHOD, sssd_monitor, RegisterService, monitor_sbus_RegisterService, ctx),
+            SBUS_SYNC(METHOD, sssd_monitor, GetStartupTimes, monitor_sbus_GetStartupTimes, ctx)
         ),
         SBUS_SIGNALS(SBUS_NO_SIGNALS),
         SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
@@ -2242,6 +2341,7 @@ static void service_startup_handler(struct tevent_context *ev,
 
         /* Parent */
         mt_svc->mt_ctx->check_children = true;
+        mt_svc->launched = tevent_timeval_current();
 
         /* Handle process exit */
         ret = sss_child_register(mt_svc,
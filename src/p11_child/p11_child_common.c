@@ -88,7 +88,7 @@ static int do_work(TALLOC_CTX *mem_ctx, enum op_mode mode, const char *ca_db,
             ret = 0;
         } else {
             DEBUG(SSSDBG_TRACE_FUNC, "Certificate is NOT valid.\n");
-            ret = EINVAL;
+            ret = ERR_INVALID_CERT;
         }
     } else {
         ret = do_card(mem_ctx, p11_ctx, mode, pin,
@@ -367,7 +367,10 @@ int main(int argc, const char *argv[])
     ret = do_work(main_ctx, mode, ca_db, cert_verify_opts, wait_for_card,
                   cert_b64, pin, module_name, token_name, key_id, label, uri,
                   &multi);
-    if (ret != 0) {
+    if (ret == ERR_INVALID_CERT) {
+        talloc_free(main_ctx);
+        return P11_CHILD_EXIT_CERT_INVALID;
+    } else if (ret != 0) {
         DEBUG(SSSDBG_OP_FAILURE, "do_work failed.\n");
         goto fail;
     }
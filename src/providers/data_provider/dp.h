@@ -76,6 +76,7 @@ enum dp_targets {
 enum dp_methods {
     DPM_CHECK_ONLINE,
     DPM_ACCOUNT_HANDLER,
+    DPM_ACCOUNT_LIST_HANDLER,
     DPM_AUTH_HANDLER,
     DPM_ACCESS_HANDLER,
     DPM_SELINUX_HANDLER,
@@ -197,6 +198,22 @@ void dp_sbus_reset_groups_memcache(struct data_provider *provider);
 void dp_sbus_reset_initgr_memcache(struct data_provider *provider);
 void dp_sbus_invalidate_group_memcache(struct data_provider *provider,
                                        gid_t gid);
+void dp_sbus_invalidate_user_memcache(struct data_provider *provider,
+                                      const char *fqname);
+
+/* Invalidate all objects in one message. @users and @groups are NULL
+ * terminated lists of fully qualified names, @gids is a talloc array.
+ * Any of them may be NULL. */
+void dp_sbus_invalidate_memcache(struct data_provider *provider,
+                                 const char **users,
+                                 const char **groups,
+                                 uint32_t *gids);
+
+/* Invalidate all records of the selected maps without recreating them. */
+void dp_sbus_new_memcache_generation(struct data_provider *provider,
+                                     bool users,
+                                     bool groups,
+                                     bool initgroups);
 
 /*
  * A dummy handler for DPM_ACCT_DOMAIN_HANDLER.
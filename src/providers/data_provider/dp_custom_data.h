@@ -58,6 +58,16 @@ struct dp_id_data {
     const char *domain;
 };
 
+/* Entries of a single type selected by filter values of a single type,
+ * see DPM_ACCOUNT_LIST_HANDLER. @filter_values is NULL-terminated. */
+struct dp_id_list_data {
+    uint32_t entry_type;
+    uint32_t filter_type;
+    const char **filter_values;
+    const char *extra_value;
+    const char *domain;
+};
+
 struct dp_resolver_data {
     uint32_t filter_type;
     const char *filter_value;
@@ -71,6 +81,13 @@ struct dp_reply_std {
     const char *message;
 };
 
+/* Reply of DPM_ACCOUNT_LIST_HANDLER. @errors contains result of each
+ * filter value in the same order, EOK if the cache is up to date. */
+struct dp_reply_list {
+    struct dp_reply_std std;
+    uint32_t *errors;
+};
+
 void dp_reply_std_set(struct dp_reply_std *reply,
                       int dp_error,
                       int error,
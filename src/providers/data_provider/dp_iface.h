@@ -44,6 +44,26 @@ dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
                          uint32_t *_error,
                          const char **_err_msg);
 
+struct tevent_req *
+dp_get_account_info_list_send(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              struct sbus_request *sbus_req,
+                              struct data_provider *provider,
+                              uint32_t dp_flags,
+                              uint32_t entry_type,
+                              const char **filters,
+                              const char *domain,
+                              const char *extra,
+                              uint32_t cli_id);
+
+errno_t
+dp_get_account_info_list_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              uint16_t *_dp_error,
+                              uint32_t *_error,
+                              const char **_err_msg,
+                              uint32_t **_errors);
+
 struct tevent_req *
 dp_pam_handler_send(TALLOC_CTX *mem_ctx,
                     struct tevent_context *ev,
@@ -273,3 +273,84 @@ void dp_sbus_invalidate_group_memcache(struct data_provider *provider,
 
     return;
 }
+
+void dp_sbus_invalidate_user_memcache(struct data_provider *provider,
+                                      const char *fqname)
+{
+    struct tevent_req *subreq;
+
+    if (provider == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Ordering NSS responder to invalidate the user %s\n", fqname);
+
+    subreq = sbus_call_nss_memcache_InvalidateUserByName_send(provider,
+                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH, fqname);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+
+    return;
+}
+
+void dp_sbus_invalidate_memcache(struct data_provider *provider,
+                                 const char **users,
+                                 const char **groups,
+                                 uint32_t *gids)
+{
+    struct tevent_req *subreq;
+
+    if (provider == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Ordering NSS responder to invalidate a batch of objects\n");
+
+    subreq = sbus_call_nss_memcache_InvalidateObjects_send(provider,
+                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH,
+                 users, groups, gids);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+
+    return;
+}
+
+void dp_sbus_new_memcache_generation(struct data_provider *provider,
+                                     bool users,
+                                     bool groups,
+                                     bool initgroups)
+{
+    struct tevent_req *subreq;
+
+    if (provider == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Ordering NSS responder to start a new memory cache generation\n");
+
+    subreq = sbus_call_nss_memcache_NewGeneration_send(provider,
+                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH,
+                 users, groups, initgroups);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+
+    return;
+}
@@ -644,6 +644,315 @@ dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+/* Maximum number of single account requests that run at the same time when
+ * the module does not implement DPM_ACCOUNT_LIST_HANDLER. */
+#define DP_ACCOUNT_LIST_PARALLEL 8
+
+struct dp_get_account_info_list_state {
+    const char *request_name;
+    const char *sender_name;
+    uint32_t dp_flags;
+    uint32_t cli_id;
+
+    struct data_provider *provider;
+    struct dp_id_list_data *data;
+    size_t num_values;
+    size_t next;
+    size_t active;
+
+    struct dp_reply_std reply;
+    uint32_t *errors;
+};
+
+struct dp_get_account_info_list_item {
+    struct tevent_req *req;
+    struct dp_id_data *data;
+    size_t index;
+};
+
+static void dp_get_account_info_list_done(struct tevent_req *subreq);
+static errno_t dp_get_account_info_list_step(struct tevent_req *req);
+static void dp_get_account_info_list_item_done(struct tevent_req *subreq);
+
+struct tevent_req *
+dp_get_account_info_list_send(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              struct sbus_request *sbus_req,
+                              struct data_provider *provider,
+                              uint32_t dp_flags,
+                              uint32_t entry_type,
+                              const char **filters,
+                              const char *domain,
+                              const char *extra,
+                              uint32_t cli_id)
+{
+    struct dp_get_account_info_list_state *state;
+    struct dp_id_data item;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct dp_get_account_info_list_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    for (count = 0; filters != NULL && filters[count] != NULL; count++);
+
+    state->data = talloc_zero(state, struct dp_id_list_data);
+    state->errors = talloc_zero_array(state, uint32_t, count);
+    state->sender_name = talloc_strdup(state, sbus_req->sender->name);
+    if (state->data == NULL || state->errors == NULL
+            || state->sender_name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->data->filter_values = talloc_zero_array(state->data, const char *,
+                                                   count + 1);
+    if (state->data->filter_values == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->provider = provider;
+    state->request_name = "Account list";
+    state->dp_flags = dp_flags;
+    state->cli_id = cli_id;
+    state->num_values = count;
+    state->data->entry_type = entry_type;
+    state->data->domain = domain;
+
+    /* Initgroups need post-processing of each user and enumerations
+     * and wildcards are not lists of entries. */
+    switch (entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+    case BE_REQ_BY_SECID:
+    case BE_REQ_USER_AND_GROUP:
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unsupported entry type [%s]\n",
+              be_req2str(entry_type));
+        ret = EINVAL;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!check_and_parse_filter(&item, filters[i], extra)
+                || item.filter_value == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        switch (item.filter_type) {
+        case BE_FILTER_NAME:
+        case BE_FILTER_IDNUM:
+        case BE_FILTER_SECID:
+            break;
+        default:
+            ret = EINVAL;
+            goto done;
+        }
+
+        if (i > 0 && item.filter_type != state->data->filter_type) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "All filters must be of the same "
+                  "type, [%s] is not\n", filters[i]);
+            ret = EINVAL;
+            goto done;
+        }
+
+        state->data->filter_type = item.filter_type;
+        state->data->filter_values[i] = item.filter_value;
+        state->data->extra_value = item.extra_value;
+    }
+
+    dp_reply_std_set(&state->reply, DP_ERR_OK, EOK, NULL);
+
+    if (count == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_FUNC_DATA,
+          "Got request for [%#"PRIx32"][%s] with %zu filters\n",
+          entry_type, be_req2str(entry_type), count);
+
+    if (!dp_method_enabled(provider, DPT_ID, DPM_ACCOUNT_LIST_HANDLER)) {
+        /* Fall back to one request per entry. */
+        ret = dp_get_account_info_list_step(req);
+        goto done;
+    }
+
+    subreq = dp_req_send(state, provider, domain, state->request_name,
+                         cli_id, state->sender_name, DPT_ID,
+                         DPM_ACCOUNT_LIST_HANDLER, dp_flags, state->data,
+                         &state->request_name);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, dp_get_account_info_list_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void dp_get_account_info_list_done(struct tevent_req *subreq)
+{
+    struct dp_get_account_info_list_state *state;
+    struct dp_reply_list reply;
+    struct tevent_req *req;
+    errno_t ret;
+    size_t i;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct dp_get_account_info_list_state);
+
+    ret = dp_req_recv(state, subreq, struct dp_reply_list, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    state->reply = reply.std;
+
+    if (reply.errors != NULL
+            && talloc_array_length(reply.errors) == state->num_values) {
+        talloc_free(state->errors);
+        state->errors = talloc_steal(state, reply.errors);
+    } else {
+        for (i = 0; i < state->num_values; i++) {
+            state->errors[i] = dp_error_to_ret(reply.std.error,
+                                               reply.std.dp_error);
+        }
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t dp_get_account_info_list_step(struct tevent_req *req)
+{
+    struct dp_get_account_info_list_state *state;
+    struct dp_get_account_info_list_item *item;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct dp_get_account_info_list_state);
+
+    while (state->active < DP_ACCOUNT_LIST_PARALLEL
+            && state->next < state->num_values) {
+        item = talloc_zero(state, struct dp_get_account_info_list_item);
+        if (item == NULL) {
+            return ENOMEM;
+        }
+
+        item->data = talloc_zero(item, struct dp_id_data);
+        if (item->data == NULL) {
+            talloc_free(item);
+            return ENOMEM;
+        }
+
+        item->req = req;
+        item->index = state->next;
+        item->data->entry_type = state->data->entry_type;
+        item->data->filter_type = state->data->filter_type;
+        item->data->filter_value = state->data->filter_values[state->next];
+        item->data->extra_value = state->data->extra_value;
+        item->data->domain = state->data->domain;
+
+        subreq = dp_req_send(item, state->provider, state->data->domain,
+                             "Account", state->cli_id, state->sender_name,
+                             DPT_ID, DPM_ACCOUNT_HANDLER, state->dp_flags,
+                             item->data, NULL);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            talloc_free(item);
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, dp_get_account_info_list_item_done,
+                                item);
+
+        state->next++;
+        state->active++;
+    }
+
+    return state->active == 0 ? EOK : EAGAIN;
+}
+
+static void dp_get_account_info_list_item_done(struct tevent_req *subreq)
+{
+    struct dp_get_account_info_list_state *state;
+    struct dp_get_account_info_list_item *item;
+    struct dp_reply_std reply;
+    struct tevent_req *req;
+    errno_t ret;
+
+    item = tevent_req_callback_data(subreq,
+                                    struct dp_get_account_info_list_item);
+    req = item->req;
+    state = tevent_req_data(req, struct dp_get_account_info_list_state);
+
+    ret = dp_req_recv(state, subreq, struct dp_reply_std, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        dp_reply_std_set(&reply, DP_ERR_DECIDE, ret, NULL);
+    }
+
+    state->errors[item->index] = dp_error_to_ret(reply.error, reply.dp_error);
+    if (reply.dp_error != DP_ERR_OK) {
+        /* Report the last failure as the result of the whole request. */
+        state->reply = reply;
+    }
+
+    talloc_free(item);
+    state->active--;
+
+    ret = dp_get_account_info_list_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+errno_t
+dp_get_account_info_list_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              uint16_t *_dp_error,
+                              uint32_t *_error,
+                              const char **_err_msg,
+                              uint32_t **_errors)
+{
+    struct dp_get_account_info_list_state *state;
+    state = tevent_req_data(req, struct dp_get_account_info_list_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    dp_req_reply_std(state->request_name, &state->reply,
+                     _dp_error, _error, _err_msg);
+    *_errors = talloc_steal(mem_ctx, state->errors);
+
+    return EOK;
+}
+
 static bool
 check_and_parse_acct_domain_filter(struct dp_get_acct_domain_data *data,
                                    const char *filter)
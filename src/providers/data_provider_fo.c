@@ -842,6 +842,9 @@ static struct dp_option dp_res_default_opts[] = {
     { "dns_resolver_op_timeout", DP_OPT_NUMBER, { .number = 3 }, NULL_NUMBER },
     { "dns_resolver_server_timeout", DP_OPT_NUMBER, { .number = 1000 }, NULL_NUMBER },
     { "dns_discovery_domain", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "dns_resolver_cache_min_ttl", DP_OPT_NUMBER, { .number = RESOLV_DEFAULT_CACHE_MIN_TTL }, NULL_NUMBER },
+    { "dns_resolver_cache_max_ttl", DP_OPT_NUMBER, { .number = RESOLV_DEFAULT_CACHE_MAX_TTL }, NULL_NUMBER },
+    { "dns_resolver_cache_negative_ttl", DP_OPT_NUMBER, { .number = RESOLV_DEFAULT_CACHE_NEG_TTL }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
@@ -910,5 +913,17 @@ errno_t be_res_init(struct be_ctx *ctx)
         return ret;
     }
 
+    ret = resolv_cache_init(ctx->be_res->resolv,
+                            dp_opt_get_int(ctx->be_res->opts,
+                                           DP_RES_OPT_CACHE_MIN_TTL),
+                            dp_opt_get_int(ctx->be_res->opts,
+                                           DP_RES_OPT_CACHE_MAX_TTL),
+                            dp_opt_get_int(ctx->be_res->opts,
+                                           DP_RES_OPT_CACHE_NEG_TTL));
+    if (ret != EOK) {
+        talloc_zfree(ctx->be_res);
+        return ret;
+    }
+
     return EOK;
 }
@@ -19,6 +19,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include "config.h"
 
@@ -26,13 +28,10 @@
 #include "db/sysdb.h"
 #include "util/inotify.h"
 #include "util/util.h"
+#include "util/strtonum.h"
+#include "util/sss_ptr_hash.h"
 #include "providers/data_provider/dp_iface.h"
 
-/* When changing this constant, make sure to also adjust the files integration
- * test for reallocation branch
- */
-#define FILES_REALLOC_CHUNK 64
-
 #define PWD_MAXSIZE         1024
 #define GRP_MAXSIZE         2048
 
@@ -40,207 +39,346 @@
 #define SF_UPDATE_GROUP     1<<1
 #define SF_UPDATE_BOTH      (SF_UPDATE_PASSWD | SF_UPDATE_GROUP)
 
+/* Past this number of changed objects the memory cache is reset as a whole
+ * instead of invalidating the objects. All objects are sent to the NSS
+ * responder in a single message. */
+#define SF_INVALIDATE_MAX   4096
+
+/* Entries of all passwd or group files keyed by their name. */
+struct sf_snapshot {
+    hash_table_t *table;
+};
+
+/* Objects that must be invalidated in the memory cache of the responders
+ * once an update is written to the cache. */
+struct sf_changes {
+    /* Too many or unknown changes, the memory cache is reset. */
+    bool reset;
+
+    /* NULL terminated, passed to the NSS responder as is. */
+    const char **users;
+    size_t num_users;
+    uint32_t *gids;
+    size_t num_gids;
+};
+
 struct files_ctx {
     struct files_ops_ctx *ops;
+
+    /* Content of the files as it was written to the cache by the last
+     * update, only the entries that differ from it are written and
+     * invalidated on the next one. NULL until the first update. */
+    struct sf_snapshot *users;
+    struct sf_snapshot *groups;
 };
 
+/* Reads the whole file into a single buffer which is then parsed in place,
+ * the parsed entries point into the buffer and are allocated on it. */
+static errno_t sf_read_file(TALLOC_CTX *mem_ctx,
+                            const char *path,
+                            char **_buf,
+                            size_t *_len)
+{
+    struct stat st;
+    char *buf = NULL;
+    ssize_t len;
+    errno_t ret;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot open file %s [%d]\n", path, ret);
+        return ret;
+    }
+
+    if (fstat(fd, &st) == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot stat file %s [%d]\n", path, ret);
+        goto done;
+    }
+
+    buf = talloc_size(mem_ctx, st.st_size + 1);
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* The file may be shrinking while it is read, the trailing part of
+     * a concurrent write is picked up by the next update. */
+    len = sss_atomic_read_s(fd, buf, st.st_size);
+    if (len == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot read file %s [%d]\n", path, ret);
+        goto done;
+    }
+    buf[len] = '\0';
+
+    *_buf = buf;
+    *_len = len;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(buf);
+    }
+    close(fd);
+    return ret;
+}
+
+/* Counts the lines to size the array of entries in advance. */
+static size_t sf_count_lines(const char *buf, size_t len)
+{
+    const char *pos = buf;
+    const char *end = buf + len;
+    size_t count = 1;
+
+    while ((pos = memchr(pos, '\n', end - pos)) != NULL) {
+        count++;
+        pos++;
+    }
+
+    return count;
+}
+
+/* Terminates the next line which is not empty nor a comment. */
+static char *sf_next_line(char **_pos, char *end)
+{
+    char *line;
+    char *nl;
+
+    while (*_pos < end) {
+        line = *_pos;
+
+        nl = memchr(line, '\n', end - line);
+        if (nl == NULL) {
+            nl = end;
+        }
+        *nl = '\0';
+        *_pos = nl + 1;
+
+        if (line[0] != '\0' && line[0] != '#') {
+            return line;
+        }
+    }
+
+    return NULL;
+}
+
+/* Splits the line in place at colons, the last field holds the rest. */
+static bool sf_split_fields(char *line, char **fields, size_t num)
+{
+    char *sep;
+
+    for (size_t i = 0; i < num - 1; i++) {
+        fields[i] = line;
+
+        sep = strchr(line, ':');
+        if (sep == NULL) {
+            return false;
+        }
+        *sep = '\0';
+        line = sep + 1;
+    }
+    fields[num - 1] = line;
+
+    return fields[0][0] != '\0';
+}
+
+static bool sf_parse_id(const char *str, uint32_t *_id)
+{
+    char *endptr;
+    uint32_t id;
+
+    if (str[0] == '\0') {
+        return false;
+    }
+
+    id = strtouint32(str, &endptr, 10);
+    if (errno != 0 || *endptr != '\0') {
+        return false;
+    }
+
+    *_id = id;
+    return true;
+}
+
+/* Splits the comma separated member list in place. */
+static char **sf_split_members(TALLOC_CTX *mem_ctx, char *list)
+{
+    char **members;
+    size_t count = 1;
+    size_t n = 0;
+    char *member;
+    char *sep;
+
+    for (sep = list; (sep = strchr(sep, ',')) != NULL; sep++) {
+        count++;
+    }
+
+    members = talloc_array(mem_ctx, char *, count + 1);
+    if (members == NULL) {
+        return NULL;
+    }
+
+    for (member = list; member != NULL; member = sep) {
+        sep = strchr(member, ',');
+        if (sep != NULL) {
+            *sep = '\0';
+            sep++;
+        }
+
+        if (member[0] != '\0') {
+            members[n] = member;
+            n++;
+        }
+    }
+    members[n] = NULL;
+
+    return members;
+}
+
+/* The entries, the strings they point to and the returned array are all
+ * allocated on one buffer owned by mem_ctx. */
 static errno_t enum_files_users(TALLOC_CTX *mem_ctx,
                                 const char *passwd_file,
                                 struct passwd ***_users)
 {
-    errno_t ret, close_ret;
-    struct passwd *pwd_iter = NULL;
-    struct passwd *pwd = NULL;
-    struct passwd **users = NULL;
-    FILE *pwd_handle = NULL;
+    struct passwd **users;
+    struct passwd *pwd;
+    char *fields[7];
     size_t n_users = 0;
+    char *line;
+    char *pos;
+    char *buf;
+    size_t len;
+    uint32_t uid;
+    uint32_t gid;
+    errno_t ret;
 
-    pwd_handle = fopen(passwd_file, "r");
-    if (pwd_handle == NULL) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot open passwd file %s [%d]\n",
-              passwd_file, ret);
-        goto done;
+    ret = sf_read_file(mem_ctx, passwd_file, &buf, &len);
+    if (ret != EOK) {
+        return ret;
     }
 
-    users = talloc_zero_array(mem_ctx, struct passwd *,
-                              FILES_REALLOC_CHUNK);
+    users = talloc_array(buf, struct passwd *, sf_count_lines(buf, len) + 1);
     if (users == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    while ((pwd_iter = fgetpwent(pwd_handle)) != NULL) {
-        /* FIXME - we might want to support paging of sorts to avoid allocating
-         * all users atop a memory context or only return users that differ from
-         * the local storage as a diff to minimize memory spikes
-         */
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "User found (%s, %s, %"SPRIuid", %"SPRIgid", %s, %s, %s)\n",
-              pwd_iter->pw_name, pwd_iter->pw_passwd,
-              pwd_iter->pw_uid, pwd_iter->pw_gid,
-              pwd_iter->pw_gecos, pwd_iter->pw_dir,
-              pwd_iter->pw_shell);
+    pos = buf;
+    while ((line = sf_next_line(&pos, buf + len)) != NULL) {
+        if (!sf_split_fields(line, fields, 7)
+                || !sf_parse_id(fields[2], &uid)
+                || !sf_parse_id(fields[3], &gid)) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Skipping malformed entry in %s\n", passwd_file);
+            continue;
+        }
 
-        pwd = talloc_zero(users, struct passwd);
+        pwd = talloc_zero(buf, struct passwd);
         if (pwd == NULL) {
             ret = ENOMEM;
             goto done;
         }
 
-        pwd->pw_uid = pwd_iter->pw_uid;
-        pwd->pw_gid = pwd_iter->pw_gid;
-
-        pwd->pw_name = talloc_strdup(pwd, pwd_iter->pw_name);
-        if (pwd->pw_name == NULL) {
-            /* We only check pw_name here on purpose to allow broken
-             * records to be optionally rejected when saving them
-             * or fallback values to be used.
-             */
-            ret = ENOMEM;
-            goto done;
-        }
+        pwd->pw_name = fields[0];
+        pwd->pw_passwd = fields[1];
+        pwd->pw_uid = uid;
+        pwd->pw_gid = gid;
+        pwd->pw_gecos = fields[4];
+        pwd->pw_dir = fields[5];
+        pwd->pw_shell = fields[6];
 
-        pwd->pw_dir = talloc_strdup(pwd, pwd_iter->pw_dir);
-        pwd->pw_gecos = talloc_strdup(pwd, pwd_iter->pw_gecos);
-        pwd->pw_shell = talloc_strdup(pwd, pwd_iter->pw_shell);
-        pwd->pw_passwd = talloc_strdup(pwd, pwd_iter->pw_passwd);
+        DEBUG(SSSDBG_TRACE_LIBS,
+              "User found (%s, %s, %"SPRIuid", %"SPRIgid", %s, %s, %s)\n",
+              pwd->pw_name, pwd->pw_passwd,
+              pwd->pw_uid, pwd->pw_gid,
+              pwd->pw_gecos, pwd->pw_dir,
+              pwd->pw_shell);
 
         users[n_users] = pwd;
         n_users++;
-        if (n_users % FILES_REALLOC_CHUNK == 0) {
-            users = talloc_realloc(mem_ctx,
-                                   users,
-                                   struct passwd *,
-                                   talloc_array_length(users) + FILES_REALLOC_CHUNK);
-            if (users == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-        }
     }
 
-    ret = EOK;
     users[n_users] = NULL;
     *_users = users;
+    ret = EOK;
+
 done:
     if (ret != EOK) {
-        talloc_free(users);
-    }
-
-    if (pwd_handle) {
-        close_ret = fclose(pwd_handle);
-        if (close_ret != 0) {
-            close_ret = errno;
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot close passwd file %s [%d]\n",
-                  passwd_file, close_ret);
-        }
+        talloc_free(buf);
     }
     return ret;
 }
 
+/* See enum_files_users() for the memory layout. */
 static errno_t enum_files_groups(TALLOC_CTX *mem_ctx,
                                  const char *group_file,
                                  struct group ***_groups)
 {
-    errno_t ret, close_ret;
-    struct group *grp_iter = NULL;
-    struct group *grp = NULL;
-    struct group **groups = NULL;
+    struct group **groups;
+    struct group *grp;
+    char *fields[4];
     size_t n_groups = 0;
-    FILE *grp_handle = NULL;
+    char *line;
+    char *pos;
+    char *buf;
+    size_t len;
+    uint32_t gid;
+    errno_t ret;
 
-    grp_handle = fopen(group_file, "r");
-    if (grp_handle == NULL) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot open group file %s [%d]\n",
-              group_file, ret);
-        goto done;
+    ret = sf_read_file(mem_ctx, group_file, &buf, &len);
+    if (ret != EOK) {
+        return ret;
     }
 
-    groups = talloc_zero_array(mem_ctx, struct group *,
-                               FILES_REALLOC_CHUNK);
+    groups = talloc_array(buf, struct group *, sf_count_lines(buf, len) + 1);
     if (groups == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    while ((grp_iter = fgetgrent(grp_handle)) != NULL) {
+    pos = buf;
+    while ((line = sf_next_line(&pos, buf + len)) != NULL) {
+        if (!sf_split_fields(line, fields, 4)
+                || !sf_parse_id(fields[2], &gid)) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Skipping malformed entry in %s\n", group_file);
+            continue;
+        }
+
         DEBUG(SSSDBG_TRACE_LIBS,
-              "Group found (%s, %"SPRIgid")\n",
-              grp_iter->gr_name, grp_iter->gr_gid);
+              "Group found (%s, %"SPRIgid")\n", fields[0], gid);
 
-        grp = talloc_zero(groups, struct group);
+        grp = talloc_zero(buf, struct group);
         if (grp == NULL) {
             ret = ENOMEM;
             goto done;
         }
 
-        grp->gr_gid = grp_iter->gr_gid;
-        grp->gr_name = talloc_strdup(grp, grp_iter->gr_name);
-        if (grp->gr_name == NULL) {
-            /* We only check gr_name here on purpose to allow broken
-             * records to be optionally rejected when saving them
-             * or fallback values to be used.
-             */
+        grp->gr_name = fields[0];
+        grp->gr_passwd = fields[1];
+        grp->gr_gid = gid;
+
+        grp->gr_mem = sf_split_members(grp, fields[3]);
+        if (grp->gr_mem == NULL) {
             ret = ENOMEM;
             goto done;
         }
-        grp->gr_passwd = talloc_strdup(grp, grp_iter->gr_passwd);
-
-        if (grp_iter->gr_mem != NULL) {
-            size_t nmem;
-
-            for (nmem = 0; grp_iter->gr_mem[nmem] != NULL; nmem++);
-
-            grp->gr_mem = talloc_zero_array(grp, char *, nmem + 1);
-            if (grp->gr_mem == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-
-            for (nmem = 0; grp_iter->gr_mem[nmem] != NULL; nmem++) {
-                grp->gr_mem[nmem] = talloc_strdup(grp, grp_iter->gr_mem[nmem]);
-                if (grp->gr_mem[nmem] == NULL) {
-                    ret = ENOMEM;
-                    goto done;
-                }
-            }
-        }
 
         groups[n_groups] = grp;
         n_groups++;
-        if (n_groups % FILES_REALLOC_CHUNK == 0) {
-            groups = talloc_realloc(mem_ctx,
-                                    groups,
-                                    struct group *,
-                                    talloc_array_length(groups) + FILES_REALLOC_CHUNK);
-            if (groups == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-        }
     }
 
-    ret = EOK;
     groups[n_groups] = NULL;
     *_groups = groups;
+    ret = EOK;
+
 done:
     if (ret != EOK) {
-        talloc_free(groups);
-    }
-
-    if (grp_handle) {
-        close_ret = fclose(grp_handle);
-        if (close_ret != 0) {
-            close_ret = errno;
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot close group file %s [%d]\n",
-                  group_file, close_ret);
-        }
+        talloc_free(buf);
     }
     return ret;
 }
@@ -279,6 +417,13 @@ done:
     return ret;
 }
 
+static bool sf_skip_user(struct passwd *pw)
+{
+    return strcmp(pw->pw_name, "root") == 0
+            || pw->pw_uid == 0
+            || pw->pw_gid == 0;
+}
+
 static errno_t save_file_user(struct files_id_ctx *id_ctx,
                               struct passwd *pw)
 {
@@ -288,10 +433,10 @@ static errno_t save_file_user(struct files_id_ctx *id_ctx,
     const char *shell;
     const char *gecos;
     struct sysdb_attrs *attrs = NULL;
+    char *remove_attrs[3] = { NULL, NULL, NULL };
+    size_t ri = 0;
 
-    if (strcmp(pw->pw_name, "root") == 0
-            || pw->pw_uid == 0
-            || pw->pw_gid == 0) {
+    if (sf_skip_user(pw)) {
         DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", pw->pw_name);
         return EOK;
     }
@@ -314,19 +459,21 @@ static errno_t save_file_user(struct files_id_ctx *id_ctx,
         goto done;
     }
 
+    /* The user may already be cached if it was modified in the file. */
     if (pw->pw_shell && pw->pw_shell[0] != '\0') {
         shell = pw->pw_shell;
     } else {
         shell = NULL;
+        remove_attrs[ri++] = discard_const(SYSDB_SHELL);
     }
 
     if (pw->pw_gecos && pw->pw_gecos[0] != '\0') {
         gecos = pw->pw_gecos;
     } else {
         gecos = NULL;
+        remove_attrs[ri++] = discard_const(SYSDB_GECOS);
     }
 
-    /* FIXME - optimize later */
     ret = sysdb_store_user(id_ctx->domain,
                            fqname,
                            pw->pw_passwd,
@@ -336,7 +483,7 @@ static errno_t save_file_user(struct files_id_ctx *id_ctx,
                            pw->pw_dir,
                            shell,
                            NULL, attrs,
-                           NULL, 0, 0);
+                           ri > 0 ? remove_attrs : NULL, 0, 0);
     if (ret != EOK) {
         goto done;
     }
@@ -448,34 +595,261 @@ done:
     return ret;
 }
 
-static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
-                              const char *group_file);
+static errno_t sf_snapshot_new(TALLOC_CTX *mem_ctx,
+                               struct sf_snapshot **_snapshot)
+{
+    struct sf_snapshot *snapshot;
+
+    snapshot = talloc_zero(mem_ctx, struct sf_snapshot);
+    if (snapshot == NULL) {
+        return ENOMEM;
+    }
+
+    snapshot->table = sss_ptr_hash_create(snapshot, NULL, NULL);
+    if (snapshot->table == NULL) {
+        talloc_free(snapshot);
+        return ENOMEM;
+    }
+
+    *_snapshot = snapshot;
+    return EOK;
+}
+
+static bool sf_str_equal(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+
+    return strcmp(a, b) == 0;
+}
+
+static void sf_changes_add_user(struct sf_changes *changes,
+                                struct sss_domain_info *dom,
+                                const char *name)
+{
+    const char **users;
+
+    if (changes->reset) {
+        return;
+    }
+
+    if (changes->num_users + changes->num_gids >= SF_INVALIDATE_MAX) {
+        changes->reset = true;
+        return;
+    }
+
+    users = talloc_realloc(changes, changes->users, const char *,
+                           changes->num_users + 2);
+    if (users == NULL) {
+        changes->reset = true;
+        return;
+    }
+    changes->users = users;
+
+    users[changes->num_users] = sss_create_internal_fqname(users, name,
+                                                           dom->name);
+    if (users[changes->num_users] == NULL) {
+        changes->reset = true;
+        return;
+    }
+    changes->num_users++;
+    users[changes->num_users] = NULL;
+}
+
+static void sf_changes_add_group(struct sf_changes *changes,
+                                 struct sss_domain_info *dom,
+                                 struct group *grp)
+{
+    uint32_t *gids;
+
+    if (changes->reset) {
+        return;
+    }
+
+    if (changes->num_users + changes->num_gids >= SF_INVALIDATE_MAX) {
+        changes->reset = true;
+        return;
+    }
+
+    gids = talloc_realloc(changes, changes->gids, uint32_t,
+                          changes->num_gids + 1);
+    if (gids == NULL) {
+        changes->reset = true;
+        return;
+    }
+    changes->gids = gids;
+    changes->gids[changes->num_gids] = grp->gr_gid;
+    changes->num_gids++;
+
+    /* Initgroups of the members has changed as well. */
+    for (size_t i = 0; grp->gr_mem != NULL && grp->gr_mem[i] != NULL; i++) {
+        sf_changes_add_user(changes, dom, grp->gr_mem[i]);
+    }
+}
 
-errno_t sf_enum_users(struct files_id_ctx *id_ctx,
-                      const char *passwd_file)
+static errno_t sf_read_users(TALLOC_CTX *mem_ctx,
+                             struct files_id_ctx *id_ctx,
+                             struct sf_snapshot **_users)
 {
+    TALLOC_CTX *tmp_ctx;
+    struct sf_snapshot *snapshot;
+    struct passwd **users;
+    struct passwd *old;
     errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct passwd **users = NULL;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = enum_files_users(tmp_ctx, passwd_file, &users);
+    ret = sf_snapshot_new(tmp_ctx, &snapshot);
     if (ret != EOK) {
         goto done;
     }
 
-    for (size_t i = 0; users[i]; i++) {
-        ret = save_file_user(id_ctx, users[i]);
+    for (size_t i = 0; id_ctx->passwd_files[i] != NULL; i++) {
+        ret = enum_files_users(snapshot, id_ctx->passwd_files[i], &users);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->passwd_files[i]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate users from %s, aborting\n",
+                  id_ctx->passwd_files[i]);
+            goto done;
+        }
+
+        for (size_t j = 0; users[j] != NULL; j++) {
+            if (sf_skip_user(users[j])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", users[j]->pw_name);
+                talloc_free(users[j]);
+                continue;
+            }
+
+            /* The last entry wins as it would overwrite the former one
+             * in the cache. */
+            old = sss_ptr_hash_lookup(snapshot->table, users[j]->pw_name,
+                                      struct passwd);
+            talloc_free(old);
+
+            ret = sss_ptr_hash_add(snapshot->table, users[j]->pw_name,
+                                   users[j], struct passwd);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        talloc_free(users);
+    }
+
+    *_users = talloc_steal(mem_ctx, snapshot);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static bool sf_user_equal(struct passwd *a, struct passwd *b)
+{
+    return a->pw_uid == b->pw_uid
+            && a->pw_gid == b->pw_gid
+            && sf_str_equal(a->pw_passwd, b->pw_passwd)
+            && sf_str_equal(a->pw_gecos, b->pw_gecos)
+            && sf_str_equal(a->pw_dir, b->pw_dir)
+            && sf_str_equal(a->pw_shell, b->pw_shell);
+}
+
+static errno_t sf_store_users(struct files_id_ctx *id_ctx,
+                              struct sf_snapshot *old_users,
+                              struct sf_snapshot *users,
+                              struct sf_changes *changes)
+{
+    hash_value_t *values = NULL;
+    unsigned long count;
+    struct passwd *pw;
+    struct passwd *old;
+    char *fqname;
+    errno_t ret;
+    int hret;
+
+    if (old_users == NULL) {
+        /* Nothing is known about the cache content, start from scratch. */
+        changes->reset = true;
+
+        ret = delete_all_users(id_ctx->domain);
+        if (ret != EOK) {
+            return ret;
+        }
+    } else {
+        hret = hash_values(old_users->table, &count, &values);
+        if (hret != HASH_SUCCESS) {
+            return ENOMEM;
+        }
+
+        for (unsigned long i = 0; i < count; i++) {
+            old = sss_ptr_get_value(&values[i], struct passwd);
+            if (sss_ptr_hash_has_key(users->table, old->pw_name)) {
+                continue;
+            }
+
+            DEBUG(SSSDBG_TRACE_FUNC, "User %s was removed\n", old->pw_name);
+
+            fqname = sss_create_internal_fqname(NULL, old->pw_name,
+                                                id_ctx->domain->name);
+            if (fqname == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sysdb_delete_user(id_ctx->domain, fqname, 0);
+            talloc_free(fqname);
+            if (ret != EOK && ret != ENOENT) {
+                DEBUG(SSSDBG_OP_FAILURE, "Cannot delete user %s [%d]: %s\n",
+                      old->pw_name, ret, sss_strerror(ret));
+                goto done;
+            }
+
+            sf_changes_add_user(changes, id_ctx->domain, old->pw_name);
+        }
+
+        talloc_zfree(values);
+    }
+
+    hret = hash_values(users->table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    for (unsigned long i = 0; i < count; i++) {
+        pw = sss_ptr_get_value(&values[i], struct passwd);
+
+        old = NULL;
+        if (old_users != NULL) {
+            old = sss_ptr_hash_lookup(old_users->table, pw->pw_name,
+                                      struct passwd);
+            if (old != NULL && sf_user_equal(old, pw)) {
+                continue;
+            }
+        }
+
+        ret = save_file_user(id_ctx, pw);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "Cannot save user %s: [%d]: %s\n",
-                  users[i]->pw_name, ret, sss_strerror(ret));
+                  pw->pw_name, ret, sss_strerror(ret));
+            /* Drop it from the snapshot so it is retried next time. */
+            talloc_free(pw);
             continue;
         }
+
+        /* New users were not in the memory cache. */
+        if (old != NULL) {
+            sf_changes_add_user(changes, id_ctx->domain, pw->pw_name);
+        }
     }
 
     ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_USER);
@@ -486,42 +860,59 @@ errno_t sf_enum_users(struct files_id_ctx *id_ctx,
     }
 
     ret = EOK;
+
 done:
-    talloc_free(tmp_ctx);
+    talloc_free(values);
     return ret;
 }
 
-static const char **get_cached_user_names(TALLOC_CTX *mem_ctx,
-                                          struct sss_domain_info *dom)
+/* Cached users keyed by their short name. Only needed if the passwd files
+ * were not read yet, the users snapshot matches the cache otherwise. */
+static errno_t get_cached_users(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *dom,
+                                hash_table_t **_users)
 {
+    struct ldb_result *res;
+    hash_table_t *users;
+    const char *fqname;
+    char *name;
     errno_t ret;
-    struct ldb_result *res = NULL;
-    const char **user_names = NULL;
-    unsigned c = 0;
 
-    ret = sysdb_enumpwent(mem_ctx, dom, &res);
-    if (ret != EOK) {
-        goto done;
+    users = sss_ptr_hash_create(mem_ctx, NULL, NULL);
+    if (users == NULL) {
+        return ENOMEM;
     }
 
-    user_names = talloc_zero_array(mem_ctx, const char *, res->count + 1);
-    if (user_names == NULL) {
+    ret = sysdb_enumpwent(users, dom, &res);
+    if (ret != EOK) {
         goto done;
     }
 
     for (unsigned i = 0; i < res->count; i++) {
-        user_names[c] = ldb_msg_find_attr_as_string(res->msgs[i],
-                                                    SYSDB_NAME,
-                                                    NULL);
-        if (user_names[c] == NULL) {
+        fqname = ldb_msg_find_attr_as_string(res->msgs[i], SYSDB_NAME, NULL);
+        if (fqname == NULL) {
             continue;
         }
-        c++;
+
+        ret = sss_parse_internal_fqname(res, fqname, &name, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sss_ptr_hash_add(users, name, res->msgs[i], struct ldb_message);
+        if (ret != EOK) {
+            goto done;
+        }
     }
 
+    *_users = users;
+    ret = EOK;
+
 done:
-    /* Don't free res and keep it around to avoid duplicating the names */
-    return user_names;
+    if (ret != EOK) {
+        talloc_free(users);
+    }
+    return ret;
 }
 
 static errno_t delete_all_groups(struct sss_domain_info *dom)
@@ -558,9 +949,14 @@ done:
     return ret;
 }
 
+static bool sf_skip_group(struct group *grp)
+{
+    return strcmp(grp->gr_name, "root") == 0 || grp->gr_gid == 0;
+}
+
 static errno_t save_file_group(struct files_id_ctx *id_ctx,
                                struct group *grp,
-                               const char **cached_users)
+                               hash_table_t *cached_users)
 {
     errno_t ret;
     char *fqname;
@@ -570,8 +966,7 @@ static errno_t save_file_group(struct files_id_ctx *id_ctx,
     const char **fq_gr_mem;
     unsigned mi = 0;
 
-    if (strcmp(grp->gr_name, "root") == 0
-            || grp->gr_gid == 0) {
+    if (sf_skip_group(grp)) {
         DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", grp->gr_name);
         return EOK;
     }
@@ -613,9 +1008,7 @@ static errno_t save_file_group(struct files_id_ctx *id_ctx,
         }
 
         for (unsigned i=0; fq_gr_files_mem[i] != NULL; i++) {
-            if (string_in_list(fq_gr_files_mem[i],
-                               discard_const(cached_users),
-                               true)) {
+            if (sss_ptr_hash_has_key(cached_users, grp->gr_mem[i])) {
                 fq_gr_mem[mi] = fq_gr_files_mem[i];
                 mi++;
 
@@ -664,36 +1057,238 @@ done:
     return ret;
 }
 
-static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
-                              const char *group_file)
+static errno_t sf_read_groups(TALLOC_CTX *mem_ctx,
+                              struct files_id_ctx *id_ctx,
+                              struct sf_snapshot **_groups)
 {
+    TALLOC_CTX *tmp_ctx;
+    struct sf_snapshot *snapshot;
+    struct group **groups;
+    struct group *old;
     errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct group **groups = NULL;
-    const char **cached_users = NULL;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = enum_files_groups(tmp_ctx, group_file, &groups);
+    ret = sf_snapshot_new(tmp_ctx, &snapshot);
     if (ret != EOK) {
         goto done;
     }
 
-    cached_users = get_cached_user_names(tmp_ctx, id_ctx->domain);
-    if (cached_users == NULL) {
+    for (size_t i = 0; id_ctx->group_files[i] != NULL; i++) {
+        ret = enum_files_groups(snapshot, id_ctx->group_files[i], &groups);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->group_files[i]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate groups from %s, aborting\n",
+                  id_ctx->group_files[i]);
+            goto done;
+        }
+
+        for (size_t j = 0; groups[j] != NULL; j++) {
+            if (sf_skip_group(groups[j])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", groups[j]->gr_name);
+                talloc_free(groups[j]);
+                continue;
+            }
+
+            old = sss_ptr_hash_lookup(snapshot->table, groups[j]->gr_name,
+                                      struct group);
+            talloc_free(old);
+
+            ret = sss_ptr_hash_add(snapshot->table, groups[j]->gr_name,
+                                   groups[j], struct group);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        talloc_free(groups);
+    }
+
+    *_groups = talloc_steal(mem_ctx, snapshot);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static bool sf_group_equal(struct group *a, struct group *b)
+{
+    size_t i;
+
+    if (a->gr_gid != b->gr_gid) {
+        return false;
+    }
+
+    if (a->gr_mem == NULL || b->gr_mem == NULL) {
+        return (a->gr_mem == NULL || a->gr_mem[0] == NULL)
+                && (b->gr_mem == NULL || b->gr_mem[0] == NULL);
+    }
+
+    for (i = 0; a->gr_mem[i] != NULL && b->gr_mem[i] != NULL; i++) {
+        if (strcmp(a->gr_mem[i], b->gr_mem[i]) != 0) {
+            return false;
+        }
+    }
+
+    return a->gr_mem[i] == b->gr_mem[i];
+}
+
+/* Deleting a user removes it from its groups, while a full reload would
+ * have kept it there as a ghost member. */
+static bool sf_group_lost_member(struct group *grp,
+                                 struct sf_snapshot *old_users,
+                                 struct sf_snapshot *users)
+{
+    if (old_users == NULL || old_users == users || grp->gr_mem == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; grp->gr_mem[i] != NULL; i++) {
+        if (sss_ptr_hash_has_key(old_users->table, grp->gr_mem[i])
+                && !sss_ptr_hash_has_key(users->table, grp->gr_mem[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static errno_t sf_delete_group(struct files_id_ctx *id_ctx,
+                               struct group *grp)
+{
+    char *fqname;
+    errno_t ret;
+
+    fqname = sss_create_internal_fqname(NULL, grp->gr_name,
+                                        id_ctx->domain->name);
+    if (fqname == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_delete_group(id_ctx->domain, fqname, 0);
+    talloc_free(fqname);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot delete group %s [%d]: %s\n",
+              grp->gr_name, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+static errno_t sf_store_groups(struct files_id_ctx *id_ctx,
+                               struct sf_snapshot *old_users,
+                               struct sf_snapshot *users,
+                               struct sf_snapshot *old_groups,
+                               struct sf_snapshot *groups,
+                               struct sf_changes *changes)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_value_t *values;
+    unsigned long count;
+    hash_table_t *cached_users = NULL;
+    struct group *grp;
+    struct group *old;
+    errno_t ret;
+    int hret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (old_groups == NULL) {
+        changes->reset = true;
+
+        ret = delete_all_groups(id_ctx->domain);
+        if (ret != EOK) {
+            goto done;
+        }
+    } else {
+        hret = hash_values(old_groups->table, &count, &values);
+        if (hret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+        talloc_steal(tmp_ctx, values);
+
+        for (unsigned long i = 0; i < count; i++) {
+            old = sss_ptr_get_value(&values[i], struct group);
+            if (sss_ptr_hash_has_key(groups->table, old->gr_name)) {
+                continue;
+            }
+
+            DEBUG(SSSDBG_TRACE_FUNC, "Group %s was removed\n", old->gr_name);
+
+            ret = sf_delete_group(id_ctx, old);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            sf_changes_add_group(changes, id_ctx->domain, old);
+        }
+    }
+
+    hret = hash_values(groups->table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
         goto done;
     }
+    talloc_steal(tmp_ctx, values);
+
+    for (unsigned long i = 0; i < count; i++) {
+        grp = sss_ptr_get_value(&values[i], struct group);
+
+        old = NULL;
+        if (old_groups != NULL) {
+            old = sss_ptr_hash_lookup(old_groups->table, grp->gr_name,
+                                      struct group);
+            if (old != NULL && sf_group_equal(old, grp)
+                    && !sf_group_lost_member(grp, old_users, users)) {
+                continue;
+            }
+
+            /* Start from scratch so that no stale member is left. */
+            if (old != NULL) {
+                ret = sf_delete_group(id_ctx, old);
+                if (ret != EOK) {
+                    goto done;
+                }
+
+                sf_changes_add_group(changes, id_ctx->domain, old);
+            }
+        }
 
-    for (size_t i = 0; groups[i]; i++) {
-        ret = save_file_group(id_ctx, groups[i], cached_users);
+        if (cached_users == NULL) {
+            if (users != NULL) {
+                cached_users = users->table;
+            } else {
+                ret = get_cached_users(tmp_ctx, id_ctx->domain,
+                                       &cached_users);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+
+        ret = save_file_group(id_ctx, grp, cached_users);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Cannot save group %s\n", groups[i]->gr_name);
+                  "Cannot save group %s\n", grp->gr_name);
+            talloc_free(grp);
             continue;
         }
+
+        sf_changes_add_group(changes, id_ctx->domain, grp);
     }
 
     ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_GROUP);
@@ -704,18 +1299,45 @@ static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
     }
 
     ret = EOK;
+
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
 static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
-                             uint8_t flags)
+                             uint8_t flags,
+                             struct sf_changes *changes)
 {
+    struct files_ctx *fctx = id_ctx->fctx;
+    TALLOC_CTX *tmp_ctx;
+    struct sf_snapshot *users = NULL;
+    struct sf_snapshot *groups = NULL;
+    struct sf_snapshot *old_groups;
     errno_t ret;
     errno_t tret;
     bool in_transaction = false;
 
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* Parse the files before the transaction is started to keep it short. */
+    if (flags & SF_UPDATE_PASSWD) {
+        ret = sf_read_users(tmp_ctx, id_ctx, &users);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (flags & SF_UPDATE_GROUP) {
+        ret = sf_read_groups(tmp_ctx, id_ctx, &groups);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     ret = sysdb_transaction_start(id_ctx->domain->sysdb);
     if (ret != EOK) {
         goto done;
@@ -723,48 +1345,24 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
     in_transaction = true;
 
     if (flags & SF_UPDATE_PASSWD) {
-        ret = delete_all_users(id_ctx->domain);
+        ret = sf_store_users(id_ctx, fctx->users, users, changes);
         if (ret != EOK) {
             goto done;
         }
-
-        /* All users were deleted, therefore we need to enumerate each file again */
-        for (size_t i = 0; id_ctx->passwd_files[i] != NULL; i++) {
-            ret = sf_enum_users(id_ctx, id_ctx->passwd_files[i]);
-            if (ret == ENOENT) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "The file %s does not exist (yet), skipping\n",
-                      id_ctx->passwd_files[i]);
-                continue;
-            } else if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Cannot enumerate users from %s, aborting\n",
-                      id_ctx->passwd_files[i]);
-                goto done;
-            }
-        }
     }
 
     if (flags & SF_UPDATE_GROUP) {
-        ret = delete_all_groups(id_ctx->domain);
-        if (ret != EOK) {
-            goto done;
+        /* Deleting all users also dropped all group memberships. */
+        old_groups = fctx->groups;
+        if ((flags & SF_UPDATE_PASSWD) && fctx->users == NULL) {
+            old_groups = NULL;
         }
 
-        /* All groups were deleted, therefore we need to enumerate each file again */
-        for (size_t i = 0; id_ctx->group_files[i] != NULL; i++) {
-            ret = sf_enum_groups(id_ctx, id_ctx->group_files[i]);
-            if (ret == ENOENT) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "The file %s does not exist (yet), skipping\n",
-                      id_ctx->group_files[i]);
-                continue;
-            } else if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Cannot enumerate groups from %s, aborting\n",
-                      id_ctx->group_files[i]);
-                goto done;
-            }
+        ret = sf_store_groups(id_ctx, fctx->users,
+                              users != NULL ? users : fctx->users,
+                              old_groups, groups, changes);
+        if (ret != EOK) {
+            goto done;
         }
     }
 
@@ -780,6 +1378,16 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
     }
     in_transaction = false;
 
+    if (users != NULL) {
+        talloc_free(fctx->users);
+        fctx->users = talloc_steal(fctx, users);
+    }
+
+    if (groups != NULL) {
+        talloc_free(fctx->groups);
+        fctx->groups = talloc_steal(fctx, groups);
+    }
+
     ret = EOK;
 done:
     if (in_transaction) {
@@ -790,9 +1398,42 @@ done:
         }
     }
 
+    if (ret != EOK) {
+        /* The cache was left intact and still matches the snapshots but
+         * the memory cache may already contain newer entries. */
+        changes->reset = true;
+    }
+
+    talloc_free(tmp_ctx);
     return ret;
 }
 
+static void sf_invalidate_memcache(struct files_id_ctx *id_ctx,
+                                   uint8_t flags,
+                                   struct sf_changes *changes)
+{
+    struct data_provider *provider = id_ctx->be->provider;
+
+    if (changes == NULL || changes->reset) {
+        dp_sbus_new_memcache_generation(provider,
+                                        flags & SF_UPDATE_PASSWD,
+                                        flags & SF_UPDATE_GROUP,
+                                        true);
+        return;
+    }
+
+    if (changes->num_users == 0 && changes->num_gids == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Invalidating %zu users and %zu groups in memory cache\n",
+          changes->num_users, changes->num_gids);
+
+    dp_sbus_invalidate_memcache(provider, changes->users, NULL,
+                                changes->gids);
+}
+
 static void sf_cb_done(struct files_id_ctx *id_ctx)
 {
     /* Only activate a domain when both callbacks are done */
@@ -806,6 +1447,7 @@ static void sf_cb_done(struct files_id_ctx *id_ctx)
 static int sf_passwd_cb(const char *filename, uint32_t flags, void *pvt)
 {
     struct files_id_ctx *id_ctx;
+    struct sf_changes *changes = NULL;
     errno_t ret;
 
     id_ctx = talloc_get_type(pvt, struct files_id_ctx);
@@ -819,14 +1461,18 @@ static int sf_passwd_cb(const char *filename, uint32_t flags, void *pvt)
     dp_sbus_domain_inconsistent(id_ctx->be->provider, id_ctx->domain);
 
     dp_sbus_reset_users_ncache(id_ctx->be->provider, id_ctx->domain);
-    dp_sbus_reset_users_memcache(id_ctx->be->provider);
-    dp_sbus_reset_initgr_memcache(id_ctx->be->provider);
+
+    changes = talloc_zero(id_ctx, struct sf_changes);
+    if (changes == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
 
     /* Using SF_UDPATE_BOTH here the case when someone edits /etc/group, adds a group member and
      * only then edits passwd and adds the user. The reverse is not needed,
      * because member/memberof links are established when groups are saved.
      */
-    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH);
+    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH, changes);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files: [%d]: %s\n",
@@ -836,6 +1482,8 @@ static int sf_passwd_cb(const char *filename, uint32_t flags, void *pvt)
 
     ret = EOK;
 done:
+    sf_invalidate_memcache(id_ctx, SF_UPDATE_BOTH, changes);
+    talloc_free(changes);
     id_ctx->updating_passwd = false;
     sf_cb_done(id_ctx);
     files_account_info_finished(id_ctx, BE_REQ_USER, ret);
@@ -845,6 +1493,7 @@ done:
 static int sf_group_cb(const char *filename, uint32_t flags, void *pvt)
 {
     struct files_id_ctx *id_ctx;
+    struct sf_changes *changes = NULL;
     errno_t ret;
 
     id_ctx = talloc_get_type(pvt, struct files_id_ctx);
@@ -858,10 +1507,14 @@ static int sf_group_cb(const char *filename, uint32_t flags, void *pvt)
     dp_sbus_domain_inconsistent(id_ctx->be->provider, id_ctx->domain);
 
     dp_sbus_reset_groups_ncache(id_ctx->be->provider, id_ctx->domain);
-    dp_sbus_reset_groups_memcache(id_ctx->be->provider);
-    dp_sbus_reset_initgr_memcache(id_ctx->be->provider);
 
-    ret = sf_enum_files(id_ctx, SF_UPDATE_GROUP);
+    changes = talloc_zero(id_ctx, struct sf_changes);
+    if (changes == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sf_enum_files(id_ctx, SF_UPDATE_GROUP, changes);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files: [%d]: %s\n",
@@ -871,6 +1524,8 @@ static int sf_group_cb(const char *filename, uint32_t flags, void *pvt)
 
     ret = EOK;
 done:
+    sf_invalidate_memcache(id_ctx, SF_UPDATE_GROUP, changes);
+    talloc_free(changes);
     id_ctx->updating_groups = false;
     sf_cb_done(id_ctx);
     files_account_info_finished(id_ctx, BE_REQ_GROUP, ret);
@@ -882,16 +1537,27 @@ static void startup_enum_files(struct tevent_context *ev,
                                void *pvt)
 {
     struct files_id_ctx *id_ctx = talloc_get_type(pvt, struct files_id_ctx);
+    struct sf_changes *changes;
     errno_t ret;
 
     talloc_zfree(imm);
 
-    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH);
+    changes = talloc_zero(id_ctx, struct sf_changes);
+    if (changes == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Out of memory!\n");
+        return;
+    }
+
+    /* The responders start with an empty memory cache, the NSS responder
+     * does not continue with the previous one if a files domain exists. */
+    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH, changes);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files after startup: [%d]: %s\n",
               ret, sss_strerror(ret));
     }
+
+    talloc_free(changes);
 }
 
 static struct snotify_ctx *sf_setup_watch(TALLOC_CTX *mem_ctx,
@@ -918,7 +1584,7 @@ struct files_ctx *sf_init(TALLOC_CTX *mem_ctx,
     int i;
     struct snotify_ctx *snctx;
 
-    fctx = talloc(mem_ctx, struct files_ctx);
+    fctx = talloc_zero(mem_ctx, struct files_ctx);
     if (fctx == NULL) {
         return NULL;
     }
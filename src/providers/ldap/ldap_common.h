@@ -128,6 +128,16 @@ errno_t sdap_account_info_handler_recv(TALLOC_CTX *mem_ctx,
                                        struct tevent_req *req,
                                        struct dp_reply_std *data);
 
+struct tevent_req *
+sdap_account_list_handler_send(TALLOC_CTX *mem_ctx,
+                               struct sdap_id_ctx *id_ctx,
+                               struct dp_id_list_data *data,
+                               struct dp_req_params *params);
+
+errno_t sdap_account_list_handler_recv(TALLOC_CTX *mem_ctx,
+                                       struct tevent_req *req,
+                                       struct dp_reply_list *data);
+
 /* Set up enumeration and/or cleanup */
 errno_t ldap_id_setup_tasks(struct sdap_id_ctx *ctx);
 errno_t sdap_id_setup_tasks(struct be_ctx *be_ctx,
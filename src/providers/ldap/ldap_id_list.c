@@ -0,0 +1,591 @@
+/*
+    SSSD
+
+    LDAP Identity Backend Module - lists of entries
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+
+#include "util/util.h"
+#include "util/strtonum.h"
+#include "db/sysdb.h"
+#include "providers/ldap/ldap_common.h"
+#include "providers/ldap/sdap_async.h"
+#include "providers/ldap/sdap_async_private.h"
+#include "providers/ldap/sdap_idmap.h"
+
+/* Maximum number of values that are combined into a single search filter. */
+#define SDAP_ACCOUNT_LIST_CHUNK 50
+
+struct sdap_account_list_handler_state {
+    struct tevent_context *ev;
+    struct be_ctx *be_ctx;
+    struct sdap_id_ctx *id_ctx;
+    struct sdap_domain *sdom;
+    struct sss_domain_info *domain;
+    struct dp_id_list_data *data;
+
+    size_t num_values;
+    size_t index;
+    struct dp_id_data *ar;
+
+    /* Users looked up with a single search. */
+    bool batch;
+    bool use_id_mapping;
+    struct sdap_id_op *op;
+    const char **attrs;
+    char *filter;
+    size_t chunk;
+
+    struct dp_reply_list reply;
+};
+
+static bool
+sdap_account_list_can_batch(struct sdap_account_list_handler_state *state);
+static errno_t sdap_account_list_next(struct tevent_req *req);
+static void sdap_account_list_single_done(struct tevent_req *subreq);
+static errno_t sdap_account_list_retry(struct tevent_req *req);
+static void sdap_account_list_connect_done(struct tevent_req *subreq);
+static void sdap_account_list_search_done(struct tevent_req *subreq);
+
+struct tevent_req *
+sdap_account_list_handler_send(TALLOC_CTX *mem_ctx,
+                               struct sdap_id_ctx *id_ctx,
+                               struct dp_id_list_data *data,
+                               struct dp_req_params *params)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sdap_account_list_handler_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    for (state->num_values = 0;
+         data->filter_values[state->num_values] != NULL;
+         state->num_values++);
+
+    state->reply.errors = talloc_zero_array(state, uint32_t,
+                                            state->num_values);
+    if (state->reply.errors == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    state->ev = params->ev;
+    state->be_ctx = params->be_ctx;
+    state->id_ctx = id_ctx;
+    state->sdom = id_ctx->opts->sdom;
+    state->domain = state->sdom->dom;
+    state->data = data;
+    state->use_id_mapping = sdap_idmap_domain_has_algorithmic_mapping(
+                                                     id_ctx->opts->idmap_ctx,
+                                                     state->domain->name,
+                                                     state->domain->domain_id);
+
+    dp_reply_std_set(&state->reply.std, DP_ERR_OK, EOK, NULL);
+
+    state->batch = sdap_account_list_can_batch(state);
+    if (state->batch) {
+        state->op = sdap_id_op_create(state, id_ctx->conn->conn_cache);
+        if (state->op == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed\n");
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        ret = build_attrs_from_map(state, id_ctx->opts->user_map,
+                                   id_ctx->opts->user_map_cnt,
+                                   NULL, &state->attrs, NULL);
+        if (ret != EOK) {
+            goto immediately;
+        }
+    }
+
+    ret = sdap_account_list_next(req);
+    if (ret == EAGAIN) {
+        return req;
+    }
+
+immediately:
+    if (ret != EOK) {
+        dp_reply_std_set(&state->reply.std, DP_ERR_DECIDE, ret, NULL);
+    }
+
+    /* TODO For backward compatibility we always return EOK to DP now. */
+    tevent_req_done(req);
+    tevent_req_post(req, params->ev);
+
+    return req;
+}
+
+/* Only plain user lookups are searched together, anything else needs
+ * additional processing of each entry that is done by the single
+ * account request. */
+static bool
+sdap_account_list_can_batch(struct sdap_account_list_handler_state *state)
+{
+    struct sdap_options *opts = state->id_ctx->opts;
+
+    if ((state->data->entry_type & BE_REQ_TYPE_MASK) != BE_REQ_USER) {
+        return false;
+    }
+
+    switch (state->data->filter_type) {
+    case BE_FILTER_NAME:
+        if (state->data->extra_value != NULL
+                && strcmp(state->data->extra_value, EXTRA_NAME_IS_UPN) == 0) {
+            return false;
+        }
+        break;
+    case BE_FILTER_IDNUM:
+        if (state->use_id_mapping) {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    if (opts->schema_type == SDAP_SCHEMA_RFC2307
+            && dp_opt_get_bool(opts->basic,
+                               SDAP_RFC2307_FALLBACK_TO_LOCAL_USERS)) {
+        return false;
+    }
+
+    return true;
+}
+
+static errno_t
+sdap_account_list_filter(struct sdap_account_list_handler_state *state)
+{
+    struct sdap_options *opts = state->id_ctx->opts;
+    TALLOC_CTX *tmp_ctx;
+    const char *attr_name;
+    const char *value;
+    char *values_filter;
+    char *shortname;
+    char *clean_value;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (state->data->filter_type == BE_FILTER_NAME) {
+        attr_name = opts->user_map[SDAP_AT_USER_NAME].name;
+    } else {
+        attr_name = opts->user_map[SDAP_AT_USER_UID].name;
+    }
+
+    values_filter = talloc_strdup(tmp_ctx, "(|");
+    if (values_filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = state->index; i < state->index + state->chunk; i++) {
+        value = state->data->filter_values[i];
+
+        if (state->data->filter_type == BE_FILTER_NAME) {
+            ret = sss_parse_internal_fqname(tmp_ctx, value, &shortname, NULL);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Cannot parse %s\n", value);
+                goto done;
+            }
+            value = shortname;
+        }
+
+        ret = sss_filter_sanitize(tmp_ctx, value, &clean_value);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        values_filter = talloc_asprintf_append_buffer(values_filter,
+                                                      "(%s=%s)", attr_name,
+                                                      clean_value);
+        if (values_filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    values_filter = talloc_strdup_append_buffer(values_filter, ")");
+    if (values_filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    talloc_zfree(state->filter);
+    if (state->domain->type == DOM_TYPE_APPLICATION) {
+        state->filter = talloc_asprintf(state,
+                                        "(&%s(objectclass=%s)(%s=*))",
+                                        values_filter,
+                                        opts->user_map[SDAP_OC_USER].name,
+                                        opts->user_map[SDAP_AT_USER_NAME].name);
+    } else if (state->use_id_mapping) {
+        state->filter = talloc_asprintf(state,
+                                        "(&%s(objectclass=%s)(%s=*)(%s=*))",
+                                        values_filter,
+                                        opts->user_map[SDAP_OC_USER].name,
+                                        opts->user_map[SDAP_AT_USER_NAME].name,
+                                        opts->user_map[SDAP_AT_USER_OBJECTSID].name);
+    } else {
+        state->filter = talloc_asprintf(state,
+                                        "(&%s(objectclass=%s)(%s=*)(&(%s=*)(!(%s=0))))",
+                                        values_filter,
+                                        opts->user_map[SDAP_OC_USER].name,
+                                        opts->user_map[SDAP_AT_USER_NAME].name,
+                                        opts->user_map[SDAP_AT_USER_UID].name,
+                                        opts->user_map[SDAP_AT_USER_UID].name);
+    }
+
+    if (state->filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sdap_account_list_next(struct tevent_req *req)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    if (state->index >= state->num_values) {
+        return EOK;
+    }
+
+    if (state->batch) {
+        state->chunk = MIN(state->num_values - state->index,
+                           SDAP_ACCOUNT_LIST_CHUNK);
+
+        ret = sdap_account_list_filter(state);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Looking up %zu users at once\n",
+              state->chunk);
+
+        ret = sdap_account_list_retry(req);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        return EAGAIN;
+    }
+
+    state->ar = talloc_zero(state, struct dp_id_data);
+    if (state->ar == NULL) {
+        return ENOMEM;
+    }
+
+    state->ar->entry_type = state->data->entry_type;
+    state->ar->filter_type = state->data->filter_type;
+    state->ar->filter_value = state->data->filter_values[state->index];
+    state->ar->extra_value = state->data->extra_value;
+    state->ar->domain = state->data->domain;
+
+    subreq = sdap_handle_acct_req_send(state, state->be_ctx, state->ar,
+                                       state->id_ctx, state->sdom,
+                                       state->id_ctx->conn, true);
+    if (subreq == NULL) {
+        talloc_zfree(state->ar);
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, sdap_account_list_single_done, req);
+
+    return EAGAIN;
+}
+
+static void sdap_account_list_single_done(struct tevent_req *subreq)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *req;
+    const char *error_msg;
+    int dp_error;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    ret = sdap_handle_acct_req_recv(subreq, &dp_error, &error_msg, NULL);
+    if (dp_error != DP_ERR_OK) {
+        /* Report the last failure as the result of the whole request. */
+        dp_reply_std_set(&state->reply.std, dp_error, ret, error_msg);
+    }
+
+    talloc_zfree(subreq);
+    talloc_zfree(state->ar);
+
+    state->reply.errors[state->index] = dp_error_to_ret(ret, dp_error);
+    state->index++;
+
+    ret = sdap_account_list_next(req);
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        dp_reply_std_set(&state->reply.std, DP_ERR_DECIDE, ret, NULL);
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t sdap_account_list_retry(struct tevent_req *req)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    subreq = sdap_id_op_connect_send(state->op, state, &ret);
+    if (subreq == NULL) {
+        return ret;
+    }
+
+    tevent_req_set_callback(subreq, sdap_account_list_connect_done, req);
+    return EOK;
+}
+
+static void sdap_account_list_finish(struct tevent_req *req,
+                                     int dp_error,
+                                     errno_t ret)
+{
+    struct sdap_account_list_handler_state *state;
+    size_t i;
+
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    /* Remaining values would fail the same way. */
+    for (i = state->index; i < state->num_values; i++) {
+        state->reply.errors[i] = dp_error_to_ret(ret, dp_error);
+    }
+
+    dp_reply_std_set(&state->reply.std, dp_error, ret, NULL);
+    tevent_req_done(req);
+}
+
+static void sdap_account_list_connect_done(struct tevent_req *subreq)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *req;
+    int dp_error = DP_ERR_FATAL;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    ret = sdap_id_op_connect_recv(subreq, &dp_error);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        sdap_account_list_finish(req, dp_error, ret);
+        return;
+    }
+
+    subreq = sdap_search_user_send(state, state->ev, state->domain,
+                                   state->id_ctx->opts,
+                                   state->sdom->user_search_bases,
+                                   sdap_id_op_handle(state->op),
+                                   state->attrs, state->filter,
+                                   dp_opt_get_int(state->id_ctx->opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   SDAP_LOOKUP_ENUMERATE);
+    if (subreq == NULL) {
+        sdap_account_list_finish(req, DP_ERR_FATAL, ENOMEM);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_account_list_search_done, req);
+}
+
+/* The value was requested by the filter and matches one of the entries
+ * returned by the search. The server matches names without regard to case,
+ * so they are compared the same way. */
+static bool
+sdap_account_list_found(struct sdap_account_list_handler_state *state,
+                        const char *value,
+                        struct sysdb_attrs **users,
+                        size_t count)
+{
+    struct sdap_options *opts = state->id_ctx->opts;
+    struct ldb_message_element *el;
+    char *shortname;
+    char *endptr;
+    uint32_t uid;
+    uint32_t entry_uid;
+    bool found = false;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    if (state->data->filter_type == BE_FILTER_NAME) {
+        ret = sss_parse_internal_fqname(NULL, value, &shortname, NULL);
+        if (ret != EOK) {
+            return false;
+        }
+
+        for (i = 0; i < count && !found; i++) {
+            ret = sysdb_attrs_get_el_ext(users[i],
+                                opts->user_map[SDAP_AT_USER_NAME].sys_name,
+                                false, &el);
+            if (ret != EOK) {
+                continue;
+            }
+
+            for (j = 0; j < el->num_values; j++) {
+                if (strcasecmp(shortname,
+                               (const char *) el->values[j].data) == 0) {
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        talloc_free(shortname);
+        return found;
+    }
+
+    uid = strtouint32(value, &endptr, 10);
+    if (errno || *endptr || (value == endptr)) {
+        return false;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = sysdb_attrs_get_uint32_t(users[i],
+                                opts->user_map[SDAP_AT_USER_UID].sys_name,
+                                &entry_uid);
+        if (ret == EOK && entry_uid == uid) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void sdap_account_list_search_done(struct tevent_req *subreq)
+{
+    struct sdap_account_list_handler_state *state;
+    struct tevent_req *req;
+    struct sysdb_attrs **users = NULL;
+    const char *value;
+    size_t count = 0;
+    int dp_error = DP_ERR_FATAL;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    ret = sdap_search_user_recv(state, subreq, NULL, &users, &count);
+    talloc_zfree(subreq);
+
+    ret = sdap_id_op_done(state->op, ret, &dp_error);
+    if (dp_error == DP_ERR_OK && ret != EOK) {
+        /* retry */
+        talloc_free(users);
+        ret = sdap_account_list_retry(req);
+        if (ret != EOK) {
+            sdap_account_list_finish(req, DP_ERR_FATAL, ret);
+        }
+        return;
+    }
+
+    if (ret == ENOENT) {
+        count = 0;
+    } else if (ret != EOK) {
+        talloc_free(users);
+        sdap_account_list_finish(req, dp_error, ret);
+        return;
+    }
+
+    if (count > 0) {
+        ret = sdap_save_users(state, state->domain->sysdb, state->domain,
+                              state->id_ctx->opts, users, count, NULL, NULL);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to store users [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            talloc_free(users);
+            sdap_account_list_finish(req, DP_ERR_FATAL, ret);
+            return;
+        }
+    }
+
+    /* Values that did not match any of the entries do not exist. */
+    for (i = state->index; i < state->index + state->chunk; i++) {
+        value = state->data->filter_values[i];
+
+        ret = EOK;
+        if (!sdap_account_list_found(state, value, users, count)) {
+            ret = users_get_handle_no_user(state, state->domain,
+                                           state->data->filter_type,
+                                           value, false);
+        }
+
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to update [%s] [%d]: %s\n",
+                  value, ret, sss_strerror(ret));
+            dp_reply_std_set(&state->reply.std, DP_ERR_FATAL, ret, NULL);
+        }
+
+        state->reply.errors[i] = ret;
+    }
+
+    talloc_free(users);
+    state->index += state->chunk;
+
+    ret = sdap_account_list_next(req);
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        sdap_account_list_finish(req, DP_ERR_FATAL, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+errno_t sdap_account_list_handler_recv(TALLOC_CTX *mem_ctx,
+                                       struct tevent_req *req,
+                                       struct dp_reply_list *data)
+{
+    struct sdap_account_list_handler_state *state = NULL;
+
+    state = tevent_req_data(req, struct sdap_account_list_handler_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *data = state->reply;
+    talloc_steal(mem_ctx, state->reply.errors);
+
+    return EOK;
+}
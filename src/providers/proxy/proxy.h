@@ -34,6 +34,7 @@
 
 #include "util/util.h"
 #include "util/nss_dl_load.h"
+#include "util/sss_thread_pool.h"
 #include "providers/backend.h"
 #include "db/sysdb.h"
 #include <dhash.h>
@@ -52,6 +53,10 @@ struct proxy_id_ctx {
     struct be_ctx *be;
     bool fast_alias;
     struct sss_nss_ops ops;
+
+    /* NULL if the NSS module is called in the main thread. */
+    struct sss_thread_pool *thread_pool;
+    int timeout;
 };
 
 struct proxy_auth_ctx {
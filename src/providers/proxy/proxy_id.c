@@ -29,6 +29,209 @@
 #include "util/strtonum.h"
 #include "providers/proxy/proxy.h"
 
+/* =NSS-calls-in-worker-threads===========================================*/
+
+enum proxy_nss_call {
+    PROXY_NSS_GETPWNAM,
+    PROXY_NSS_GETPWUID,
+    PROXY_NSS_GETGRNAM,
+    PROXY_NSS_GETGRGID,
+};
+
+struct proxy_nss_job {
+    /* The operations are owned by proxy_id_ctx which outlives the pool. */
+    struct sss_nss_ops *ops;
+    enum proxy_nss_call call;
+    char *name;
+    uint32_t id;
+
+    enum nss_status status;
+    struct passwd pwd;
+    struct group grp;
+    char *buffer;
+};
+
+/* Runs in a worker thread, see sss_thread_pool_fn. */
+static errno_t proxy_nss_job_run(void *pvt)
+{
+    struct proxy_nss_job *job = pvt;
+    size_t buflen = DEFAULT_BUFSIZE;
+    char *newbuf;
+    int err;
+
+    while (true) {
+        newbuf = talloc_realloc_size(job, job->buffer, buflen);
+        if (newbuf == NULL) {
+            return ENOMEM;
+        }
+        job->buffer = newbuf;
+
+        memset(&job->pwd, 0, sizeof(struct passwd));
+        memset(&job->grp, 0, sizeof(struct group));
+
+        switch (job->call) {
+        case PROXY_NSS_GETPWNAM:
+            job->status = job->ops->getpwnam_r(job->name, &job->pwd,
+                                               job->buffer, buflen, &err);
+            break;
+        case PROXY_NSS_GETPWUID:
+            job->status = job->ops->getpwuid_r(job->id, &job->pwd,
+                                               job->buffer, buflen, &err);
+            break;
+        case PROXY_NSS_GETGRNAM:
+            job->status = job->ops->getgrnam_r(job->name, &job->grp,
+                                               job->buffer, buflen, &err);
+            break;
+        case PROXY_NSS_GETGRGID:
+            job->status = job->ops->getgrgid_r(job->id, &job->grp,
+                                               job->buffer, buflen, &err);
+            break;
+        default:
+            return EINVAL;
+        }
+
+        /* Retry with a bigger buffer, the caller handles the TRYAGAIN status
+         * if even the biggest one is too small. */
+        if (job->status != NSS_STATUS_TRYAGAIN || buflen >= MAX_BUF_SIZE) {
+            break;
+        }
+
+        buflen *= 2;
+        if (buflen > MAX_BUF_SIZE) {
+            buflen = MAX_BUF_SIZE;
+        }
+    }
+
+    return EOK;
+}
+
+struct proxy_nss_call_state {
+    struct proxy_nss_job *job;
+};
+
+static void proxy_nss_call_done(struct tevent_req *subreq);
+
+/* Calls the NSS module in a worker thread if there is a thread pool or
+ * directly otherwise. A call that is already running cannot be interrupted
+ * when the request times out or is freed, the result is thrown away and the
+ * thread is free again once the module returns. */
+static struct tevent_req *
+proxy_nss_call_send(TALLOC_CTX *mem_ctx,
+                    struct tevent_context *ev,
+                    struct proxy_id_ctx *ctx,
+                    enum proxy_nss_call call,
+                    const char *name,
+                    uint32_t id)
+{
+    struct proxy_nss_call_state *state;
+    struct proxy_nss_job *job;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct proxy_nss_call_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    job = talloc_zero(state, struct proxy_nss_job);
+    if (job == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    job->ops = &ctx->ops;
+    job->call = call;
+    job->id = id;
+
+    if (name != NULL) {
+        job->name = talloc_strdup(job, name);
+        if (job->name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    if (ctx->thread_pool == NULL) {
+        ret = proxy_nss_job_run(job);
+        state->job = job;
+        goto done;
+    }
+
+    subreq = sss_thread_pool_job_send(state, ev, ctx->thread_pool,
+                                      proxy_nss_job_run, job);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, proxy_nss_call_done, req);
+
+    if (ctx->timeout > 0) {
+        if (!tevent_req_set_endtime(req, ev,
+                                    tevent_timeval_current_ofs(ctx->timeout,
+                                                               0))) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    return req;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void proxy_nss_call_done(struct tevent_req *subreq)
+{
+    struct proxy_nss_call_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_nss_call_state);
+
+    ret = sss_thread_pool_job_recv(state, subreq, (void **) &state->job);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t proxy_nss_call_recv(TALLOC_CTX *mem_ctx,
+                                   struct tevent_req *req,
+                                   struct proxy_nss_job **_job)
+{
+    struct proxy_nss_call_state *state;
+
+    state = tevent_req_data(req, struct proxy_nss_call_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_job = talloc_steal(mem_ctx, state->job);
+
+    return EOK;
+}
+
+/* Both proxy_get_pw_send() and proxy_get_gr_send() have no output. */
+static errno_t proxy_id_lookup_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
 /* =Getpwnam-wrapper======================================================*/
 
 static int save_user(struct sss_domain_info *domain,
@@ -43,51 +246,144 @@ static int
 delete_user(struct sss_domain_info *domain,
             const char *name, uid_t uid);
 
-static int get_pw_name(struct proxy_id_ctx *ctx,
-                       struct sss_domain_info *dom,
-                       const char *i_name)
+/* Look up the canonical name of a user found by an alias in the cache. */
+static const char *proxy_cached_user_name(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *dom,
+                                          uid_t uid)
 {
-    TALLOC_CTX *tmpctx;
-    struct passwd *pwd;
-    enum nss_status status;
-    char *buffer;
-    size_t buflen;
-    int ret;
-    uid_t uid;
-    bool del_user;
     struct ldb_result *cached_pwd = NULL;
-    const char *real_name = NULL;
+    const char *real_name;
+    errno_t ret;
+
+    ret = sysdb_getpwuid(mem_ctx, dom, uid, &cached_pwd);
+    if (ret != EOK) {
+        /* Non-fatal, attempt to canonicalize online */
+        DEBUG(SSSDBG_TRACE_FUNC, "Request to cache failed [%d]: %s\n",
+              ret, strerror(ret));
+        return NULL;
+    }
+
+    if (cached_pwd->count != 1) {
+        return NULL;
+    }
+
+    real_name = ldb_msg_find_attr_as_string(cached_pwd->msgs[0],
+                                            SYSDB_NAME, NULL);
+    if (!real_name) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cached user has no name?\n");
+    }
+
+    return real_name;
+}
+
+struct proxy_get_pw_state {
+    struct tevent_context *ev;
+    struct proxy_id_ctx *ctx;
+    struct sss_domain_info *dom;
+    const char *i_name;
+    uid_t uid;
+};
+
+static void proxy_get_pw_name_done(struct tevent_req *subreq);
+static void proxy_get_pw_uid_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+proxy_get_pw_send(TALLOC_CTX *mem_ctx,
+                  struct tevent_context *ev,
+                  struct proxy_id_ctx *ctx,
+                  struct sss_domain_info *dom,
+                  int filter_type,
+                  const char *filter_value)
+{
+    struct proxy_get_pw_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
     char *shortname_or_alias;
+    char *endptr;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct proxy_get_pw_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
 
-    DEBUG(SSSDBG_TRACE_FUNC, "Searching user by name (%s)\n", i_name);
+    state->ev = ev;
+    state->ctx = ctx;
+    state->dom = dom;
 
-    tmpctx = talloc_new(NULL);
-    if (!tmpctx) {
-        return ENOMEM;
+    if (filter_type == BE_FILTER_NAME) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Searching user by name (%s)\n",
+              filter_value);
+
+        state->i_name = talloc_strdup(state, filter_value);
+        if (state->i_name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sss_parse_internal_fqname(state, state->i_name,
+                                        &shortname_or_alias, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        subreq = proxy_nss_call_send(state, ev, ctx, PROXY_NSS_GETPWNAM,
+                                     shortname_or_alias, 0);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, proxy_get_pw_name_done, req);
+        return req;
     }
 
-    ret = sss_parse_internal_fqname(tmpctx, i_name, &shortname_or_alias, NULL);
-    if (ret != EOK) {
+    state->uid = (uid_t) strtouint32(filter_value, &endptr, 10);
+    if (errno || *endptr || (filter_value == endptr)) {
+        ret = EINVAL;
         goto done;
     }
 
-    pwd = talloc_zero(tmpctx, struct passwd);
-    if (!pwd) {
+    DEBUG(SSSDBG_TRACE_FUNC, "Searching user by uid (%"SPRIuid")\n",
+          state->uid);
+
+    subreq = proxy_nss_call_send(state, ev, ctx, PROXY_NSS_GETPWUID,
+                                 NULL, state->uid);
+    if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    buflen = DEFAULT_BUFSIZE;
-    buffer = talloc_size(tmpctx, buflen);
-    if (!buffer) {
-        ret = ENOMEM;
+    tevent_req_set_callback(subreq, proxy_get_pw_uid_done, req);
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void proxy_get_pw_name_done(struct tevent_req *subreq)
+{
+    struct proxy_get_pw_state *state;
+    struct proxy_nss_job *job = NULL;
+    struct tevent_req *req;
+    const char *real_name = NULL;
+    bool del_user;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_get_pw_state);
+
+    ret = proxy_nss_call_recv(state, subreq, &job);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
         goto done;
     }
 
-    /* FIXME: should we move this call outside the transaction to keep the
-     * transaction as short as possible? */
-    status = ctx->ops.getpwnam_r(shortname_or_alias, pwd, buffer, buflen, &ret);
-    ret = handle_getpw_result(status, pwd, dom, &del_user);
+    ret = handle_getpw_result(job->status, &job->pwd, state->dom, &del_user);
     if (ret) {
         DEBUG(SSSDBG_OP_FAILURE,
               "getpwnam failed [%d]: %s\n", ret, strerror(ret));
@@ -95,65 +391,101 @@ static int get_pw_name(struct proxy_id_ctx *ctx,
     }
 
     if (del_user) {
-        ret = delete_user(dom, i_name, 0);
+        ret = delete_user(state->dom, state->i_name, 0);
         goto done;
     }
 
-    uid = pwd->pw_uid;
+    state->uid = job->pwd.pw_uid;
 
     /* Canonicalize the username in case it was actually an alias */
+    if (state->ctx->fast_alias == true) {
+        real_name = proxy_cached_user_name(job, state->dom, state->uid);
+    }
 
-    if (ctx->fast_alias == true) {
-        ret = sysdb_getpwuid(tmpctx, dom, uid, &cached_pwd);
-        if (ret != EOK) {
-            /* Non-fatal, attempt to canonicalize online */
-            DEBUG(SSSDBG_TRACE_FUNC, "Request to cache failed [%d]: %s\n",
-                  ret, strerror(ret));
-        }
+    if (real_name != NULL) {
+        ret = save_user(state->dom, &job->pwd, real_name, state->i_name);
+        goto done;
+    }
 
-        if (ret == EOK && cached_pwd->count == 1) {
-            real_name = ldb_msg_find_attr_as_string(cached_pwd->msgs[0],
-                                                    SYSDB_NAME, NULL);
-            if (!real_name) {
-                DEBUG(SSSDBG_MINOR_FAILURE, "Cached user has no name?\n");
-            }
-        }
+    subreq = proxy_nss_call_send(state, state->ev, state->ctx,
+                                 PROXY_NSS_GETPWUID, NULL, state->uid);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
     }
 
-    if (real_name == NULL) {
-        memset(buffer, 0, buflen);
+    tevent_req_set_callback(subreq, proxy_get_pw_uid_done, req);
+    talloc_free(job);
+    return;
 
-        status = ctx->ops.getpwuid_r(uid, pwd, buffer, buflen, &ret);
-        ret = handle_getpw_result(status, pwd, dom, &del_user);
-        if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                "getpwuid failed [%d]: %s\n", ret, strerror(ret));
-            goto done;
-        }
+done:
+    talloc_free(job);
 
-        real_name = sss_create_internal_fqname(tmpctx, pwd->pw_name, dom->name);
-        if (real_name == NULL) {
-            ret = ENOMEM;
-            goto done;
-        }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "proxy -> getpwnam_r failed for '%s' <%d>: %s\n",
+              state->i_name, ret, strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void proxy_get_pw_uid_done(struct tevent_req *subreq)
+{
+    struct proxy_get_pw_state *state;
+    struct proxy_nss_job *job = NULL;
+    struct tevent_req *req;
+    const char *real_name;
+    bool del_user;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_get_pw_state);
+
+    ret = proxy_nss_call_recv(state, subreq, &job);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = handle_getpw_result(job->status, &job->pwd, state->dom, &del_user);
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "getpwuid failed [%d]: %s\n", ret, strerror(ret));
+        goto done;
     }
 
     if (del_user) {
-        ret = delete_user(dom, i_name, uid);
+        ret = delete_user(state->dom, state->i_name, state->uid);
+        goto done;
+    }
+
+    real_name = sss_create_internal_fqname(job, job->pwd.pw_name,
+                                           state->dom->name);
+    if (real_name == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "failed to qualify name '%s'\n",
+              job->pwd.pw_name);
+        ret = ENOMEM;
         goto done;
     }
 
     /* Both lookups went fine, we can save the user now */
-    ret = save_user(dom, pwd, real_name, i_name);
+    ret = save_user(state->dom, &job->pwd, real_name, state->i_name);
 
 done:
-    talloc_zfree(tmpctx);
-    if (ret) {
+    talloc_free(job);
+
+    if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
-              "proxy -> getpwnam_r failed for '%s' <%d>: %s\n",
-               i_name, ret, strerror(ret));
+              "proxy -> getpwuid_r failed for '%"SPRIuid"' <%d>: %s\n",
+              state->uid, ret, strerror(ret));
+        tevent_req_error(req, ret);
+        return;
     }
-    return ret;
+
+    tevent_req_done(req);
 }
 
 static int
@@ -327,85 +659,19 @@ static int save_user(struct sss_domain_info *domain,
                            pwd->pw_gid,
                            gecos,
                            pwd->pw_dir,
-                           shell,
-                           NULL,
-                           attrs,
-                           NULL,
-                           domain->user_timeout,
-                           0);
-    if (ret) {
-        DEBUG(SSSDBG_OP_FAILURE, "Could not add user to cache\n");
-        goto done;
-    }
-
-done:
-    talloc_zfree(attrs);
-    return ret;
-}
-
-/* =Getpwuid-wrapper======================================================*/
-
-static int get_pw_uid(struct proxy_id_ctx *ctx,
-                      struct sss_domain_info *dom,
-                      uid_t uid)
-{
-    TALLOC_CTX *tmpctx;
-    struct passwd *pwd;
-    enum nss_status status;
-    char *buffer;
-    size_t buflen;
-    bool del_user = false;
-    int ret;
-    char *name;
-
-    DEBUG(SSSDBG_TRACE_FUNC, "Searching user by uid (%"SPRIuid")\n", uid);
-
-    tmpctx = talloc_new(NULL);
-    if (!tmpctx) {
-        return ENOMEM;
-    }
-
-    pwd = talloc_zero(tmpctx, struct passwd);
-    if (!pwd) {
-        ret = ENOMEM;
-        goto done;
-    }
-
-    buflen = DEFAULT_BUFSIZE;
-    buffer = talloc_size(tmpctx, buflen);
-    if (!buffer) {
-        ret = ENOMEM;
-        goto done;
-    }
-
-    status = ctx->ops.getpwuid_r(uid, pwd, buffer, buflen, &ret);
-    ret = handle_getpw_result(status, pwd, dom, &del_user);
-    if (ret) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "getpwuid failed [%d]: %s\n", ret, strerror(ret));
-        goto done;
-    }
-
-    if (del_user) {
-        ret = delete_user(dom, NULL, uid);
-        goto done;
-    }
-
-    name = sss_create_internal_fqname(tmpctx, pwd->pw_name, dom->name);
-    if (name == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "failed to qualify name '%s'\n",
-              pwd->pw_name);
+                           shell,
+                           NULL,
+                           attrs,
+                           NULL,
+                           domain->user_timeout,
+                           0);
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not add user to cache\n");
         goto done;
     }
-    ret = save_user(dom, pwd, name, NULL);
 
 done:
-    talloc_zfree(tmpctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "proxy -> getpwuid_r failed for '%"SPRIuid"' <%d>: %s\n",
-               uid, ret, strerror(ret));
-    }
+    talloc_zfree(attrs);
     return ret;
 }
 
@@ -945,56 +1211,169 @@ handle_getgr_result(enum nss_status status, struct group *grp,
     return EOK;
 }
 
-static int get_gr_name(struct proxy_id_ctx *ctx,
-                       struct sysdb_ctx *sysdb,
-                       struct sss_domain_info *dom,
-                       const char *i_name)
+static int
+proxy_delete_group(struct sss_domain_info *domain,
+                   const char *name, gid_t gid)
 {
-    TALLOC_CTX *tmpctx;
-    struct group *grp;
-    enum nss_status status;
-    char *buffer = 0;
-    size_t buflen = 0;
-    bool delete_group = false;
     int ret;
-    gid_t gid;
+
+    if (name != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Group %s does not exist (or is invalid) on remote server,"
+              " deleting!\n", name);
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Group %"SPRIgid" does not exist (or is invalid) on remote "
+              "server, deleting!\n", gid);
+    }
+
+    ret = sysdb_delete_group(domain, name, gid);
+    if (ret == ENOENT) {
+        ret = EOK;
+    }
+
+    return ret;
+}
+
+/* Look up the canonical name of a group found by an alias in the cache. */
+static const char *proxy_cached_group_name(TALLOC_CTX *mem_ctx,
+                                           struct sss_domain_info *dom,
+                                           gid_t gid)
+{
     struct ldb_result *cached_grp = NULL;
-    const char *real_name = NULL;
+    const char *real_name;
+    errno_t ret;
+
+    ret = sysdb_getgrgid(mem_ctx, dom, gid, &cached_grp);
+    if (ret != EOK) {
+        /* Non-fatal, attempt to canonicalize online */
+        DEBUG(SSSDBG_TRACE_FUNC, "Request to cache failed [%d]: %s\n",
+              ret, strerror(ret));
+        return NULL;
+    }
+
+    if (cached_grp->count != 1) {
+        return NULL;
+    }
+
+    real_name = ldb_msg_find_attr_as_string(cached_grp->msgs[0],
+                                            SYSDB_NAME, NULL);
+    if (!real_name) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cached group has no name?\n");
+    }
+
+    return real_name;
+}
+
+struct proxy_get_gr_state {
+    struct tevent_context *ev;
+    struct proxy_id_ctx *ctx;
+    struct sss_domain_info *dom;
+    const char *i_name;
+    gid_t gid;
+};
+
+static void proxy_get_gr_name_done(struct tevent_req *subreq);
+static void proxy_get_gr_gid_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+proxy_get_gr_send(TALLOC_CTX *mem_ctx,
+                  struct tevent_context *ev,
+                  struct proxy_id_ctx *ctx,
+                  struct sss_domain_info *dom,
+                  int filter_type,
+                  const char *filter_value)
+{
+    struct proxy_get_gr_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
     char *shortname_or_alias;
+    char *endptr;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct proxy_get_gr_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
 
-    DEBUG(SSSDBG_FUNC_DATA, "Searching group by name (%s)\n", i_name);
+    state->ev = ev;
+    state->ctx = ctx;
+    state->dom = dom;
 
-    tmpctx = talloc_new(NULL);
-    if (!tmpctx) {
-        return ENOMEM;
+    if (filter_type == BE_FILTER_NAME) {
+        DEBUG(SSSDBG_FUNC_DATA, "Searching group by name (%s)\n",
+              filter_value);
+
+        state->i_name = talloc_strdup(state, filter_value);
+        if (state->i_name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sss_parse_internal_fqname(state, state->i_name,
+                                        &shortname_or_alias, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        subreq = proxy_nss_call_send(state, ev, ctx, PROXY_NSS_GETGRNAM,
+                                     shortname_or_alias, 0);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, proxy_get_gr_name_done, req);
+        return req;
     }
 
-    ret = sss_parse_internal_fqname(tmpctx, i_name, &shortname_or_alias, NULL);
-    if (ret != EOK) {
+    state->gid = (gid_t) strtouint32(filter_value, &endptr, 10);
+    if (errno || *endptr || (filter_value == endptr)) {
+        ret = EINVAL;
         goto done;
     }
 
-    grp = talloc(tmpctx, struct group);
-    if (!grp) {
+    DEBUG(SSSDBG_TRACE_FUNC, "Searching group by gid (%"SPRIgid")\n",
+          state->gid);
+
+    subreq = proxy_nss_call_send(state, ev, ctx, PROXY_NSS_GETGRGID,
+                                 NULL, state->gid);
+    if (subreq == NULL) {
         ret = ENOMEM;
-        DEBUG(SSSDBG_CRIT_FAILURE, "talloc() failed\n");
         goto done;
     }
 
-    do {
-        /* always zero out the grp structure */
-        memset(grp, 0, sizeof(struct group));
-        buffer = grow_group_buffer(tmpctx, &buffer, &buflen);
-        if (!buffer) {
-            ret = ENOMEM;
-            goto done;
-        }
+    tevent_req_set_callback(subreq, proxy_get_gr_gid_done, req);
+    return req;
 
-        status = ctx->ops.getgrnam_r(shortname_or_alias, grp, buffer,
-                                     buflen, &ret);
-        ret = handle_getgr_result(status, grp, dom, &delete_group);
-    } while (ret == EAGAIN);
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void proxy_get_gr_name_done(struct tevent_req *subreq)
+{
+    struct proxy_get_gr_state *state;
+    struct proxy_nss_job *job = NULL;
+    struct tevent_req *req;
+    const char *real_name = NULL;
+    bool delete_group = false;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_get_gr_state);
+
+    ret = proxy_nss_call_recv(state, subreq, &job);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        goto done;
+    }
 
+    ret = handle_getgr_result(job->status, &job->grp, state->dom,
+                              &delete_group);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "getgrnam failed [%d]: %s\n", ret, strerror(ret));
@@ -1002,96 +1381,107 @@ static int get_gr_name(struct proxy_id_ctx *ctx,
     }
 
     if (delete_group) {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "Group %s does not exist (or is invalid) on remote server,"
-               " deleting!\n", i_name);
-
-        ret = sysdb_delete_group(dom, i_name, 0);
-        if (ret == ENOENT) {
-            ret = EOK;
-        }
+        ret = proxy_delete_group(state->dom, state->i_name, 0);
         goto done;
     }
 
-    gid = grp->gr_gid;
+    state->gid = job->grp.gr_gid;
 
     /* Canonicalize the group name in case it was actually an alias */
-    if (ctx->fast_alias == true) {
-        ret = sysdb_getgrgid(tmpctx, dom, gid, &cached_grp);
-        if (ret != EOK) {
-            /* Non-fatal, attempt to canonicalize online */
-            DEBUG(SSSDBG_TRACE_FUNC, "Request to cache failed [%d]: %s\n",
-                  ret, strerror(ret));
-        }
+    if (state->ctx->fast_alias == true) {
+        real_name = proxy_cached_group_name(job, state->dom, state->gid);
+    }
 
-        if (ret == EOK && cached_grp->count == 1) {
-            real_name = ldb_msg_find_attr_as_string(cached_grp->msgs[0],
-                                                    SYSDB_NAME, NULL);
-            if (!real_name) {
-                DEBUG(SSSDBG_MINOR_FAILURE, "Cached group has no name?\n");
-            }
-        }
+    if (real_name != NULL) {
+        ret = save_group(state->dom->sysdb, state->dom, &job->grp,
+                         real_name, state->i_name);
+        goto done;
     }
 
-    if (real_name == NULL) {
-        talloc_zfree(buffer);
-        buflen = 0;
+    subreq = proxy_nss_call_send(state, state->ev, state->ctx,
+                                 PROXY_NSS_GETGRGID, NULL, state->gid);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
 
-        do {
-            memset(grp, 0, sizeof(struct group));
-            buffer = grow_group_buffer(tmpctx, &buffer, &buflen);
-            if (!buffer) {
-                ret = ENOMEM;
-                goto done;
-            }
+    tevent_req_set_callback(subreq, proxy_get_gr_gid_done, req);
+    talloc_free(job);
+    return;
 
-            status = ctx->ops.getgrgid_r(gid, grp, buffer, buflen, &ret);
+done:
+    talloc_free(job);
 
-            ret = handle_getgr_result(status, grp, dom, &delete_group);
-        } while (ret == EAGAIN);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "proxy -> getgrnam_r failed for '%s' <%d>: %s\n",
+              state->i_name, ret, strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
 
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                "getgrgid failed [%d]: %s\n", ret, strerror(ret));
-            goto done;
-        }
+    tevent_req_done(req);
+}
 
-        real_name = sss_create_internal_fqname(tmpctx, grp->gr_name, dom->name);
-        if (real_name == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to create fqdn '%s'\n",
-                  grp->gr_name);
-            ret = ENOMEM;
-            goto done;
-        }
+static void proxy_get_gr_gid_done(struct tevent_req *subreq)
+{
+    struct proxy_get_gr_state *state;
+    struct proxy_nss_job *job = NULL;
+    struct tevent_req *req;
+    const char *real_name;
+    bool delete_group = false;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_get_gr_state);
+
+    ret = proxy_nss_call_recv(state, subreq, &job);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = handle_getgr_result(job->status, &job->grp, state->dom,
+                              &delete_group);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "getgrgid failed [%d]: %s\n", ret, strerror(ret));
+        goto done;
     }
 
     if (delete_group) {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "Group %s does not exist (or is invalid) on remote server,"
-               " deleting!\n", i_name);
+        ret = proxy_delete_group(state->dom, state->i_name, state->gid);
+        goto done;
+    }
 
-        ret = sysdb_delete_group(dom, i_name, gid);
-        if (ret == ENOENT) {
-            ret = EOK;
-        }
+    real_name = sss_create_internal_fqname(job, job->grp.gr_name,
+                                           state->dom->name);
+    if (real_name == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to create fqdn '%s'\n",
+              job->grp.gr_name);
+        ret = ENOMEM;
         goto done;
     }
 
-    ret = save_group(sysdb, dom, grp, real_name, i_name);
-    if (ret) {
+    ret = save_group(state->dom->sysdb, state->dom, &job->grp,
+                     real_name, state->i_name);
+    if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot save group [%d]: %s\n", ret, strerror(ret));
-        goto done;
     }
 
 done:
-    talloc_zfree(tmpctx);
-    if (ret) {
+    talloc_free(job);
+
+    if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
-              "proxy -> getgrnam_r failed for '%s' <%d>: %s\n",
-              i_name, ret, strerror(ret));
+              "proxy -> getgrgid_r failed for '%"SPRIgid"' <%d>: %s\n",
+              state->gid, ret, strerror(ret));
+        tevent_req_error(req, ret);
+        return;
     }
-    return ret;
+
+    tevent_req_done(req);
 }
 
 /* =Getgrgid-wrapper======================================================*/
@@ -1355,7 +1745,6 @@ static int get_initgr(TALLOC_CTX *mem_ctx,
     errno_t sret;
     bool del_user;
     uid_t uid;
-    struct ldb_result *cached_pwd = NULL;
     const char *real_name = NULL;
     char *shortname_or_alias;
 
@@ -1414,20 +1803,7 @@ static int get_initgr(TALLOC_CTX *mem_ctx,
 
     /* Canonicalize the username in case it was actually an alias */
     if (ctx->fast_alias == true) {
-        ret = sysdb_getpwuid(tmpctx, dom, uid, &cached_pwd);
-        if (ret != EOK) {
-            /* Non-fatal, attempt to canonicalize online */
-            DEBUG(SSSDBG_TRACE_FUNC, "Request to cache failed [%d]: %s\n",
-                  ret, strerror(ret));
-        }
-
-        if (ret == EOK && cached_pwd->count == 1) {
-            real_name = ldb_msg_find_attr_as_string(cached_pwd->msgs[0],
-                                                    SYSDB_NAME, NULL);
-            if (!real_name) {
-                DEBUG(SSSDBG_MINOR_FAILURE, "Cached user has no name?\n");
-            }
-        }
+        real_name = proxy_cached_user_name(tmpctx, dom, uid);
     }
 
     if (real_name == NULL) {
@@ -1576,6 +1952,24 @@ static int get_initgr_groups_process(TALLOC_CTX *memctx,
 
 /* =Proxy_Id-Functions====================================================*/
 
+static void proxy_account_info_set_reply(struct dp_reply_std *reply,
+                                         struct be_ctx *be_ctx,
+                                         errno_t ret)
+{
+    if (ret) {
+        if (ret == ENXIO) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "proxy returned UNAVAIL error, going offline!\n");
+            be_mark_offline(be_ctx);
+        }
+
+        dp_reply_std_set(reply, DP_ERR_FATAL, ret, NULL);
+        return;
+    }
+
+    dp_reply_std_set(reply, DP_ERR_OK, EOK, NULL);
+}
+
 static struct dp_reply_std
 proxy_account_info(TALLOC_CTX *mem_ctx,
                    struct proxy_id_ctx *ctx,
@@ -1585,10 +1979,7 @@ proxy_account_info(TALLOC_CTX *mem_ctx,
 {
     struct dp_reply_std reply;
     struct sysdb_ctx *sysdb;
-    uid_t uid;
-    gid_t gid;
     errno_t ret;
-    char *endptr;
 
     sysdb = domain->sysdb;
 
@@ -1606,19 +1997,7 @@ proxy_account_info(TALLOC_CTX *mem_ctx,
             ret = enum_users(mem_ctx, ctx, sysdb, domain);
             break;
 
-        case BE_FILTER_NAME:
-            ret = get_pw_name(ctx, domain, data->filter_value);
-            break;
-
-        case BE_FILTER_IDNUM:
-            uid = (uid_t) strtouint32(data->filter_value, &endptr, 10);
-            if (errno || *endptr || (data->filter_value == endptr)) {
-                dp_reply_std_set(&reply, DP_ERR_FATAL, EINVAL,
-                                 "Invalid attr type");
-                return reply;
-            }
-            ret = get_pw_uid(ctx, domain, uid);
-            break;
+        /* Lookups by name and ID are handled by proxy_get_pw_send(). */
         default:
             dp_reply_std_set(&reply, DP_ERR_FATAL, EINVAL,
                              "Invalid filter type");
@@ -1631,18 +2010,7 @@ proxy_account_info(TALLOC_CTX *mem_ctx,
         case BE_FILTER_ENUM:
             ret = enum_groups(mem_ctx, ctx, sysdb, domain);
             break;
-        case BE_FILTER_NAME:
-            ret = get_gr_name(ctx, sysdb, domain, data->filter_value);
-            break;
-        case BE_FILTER_IDNUM:
-            gid = (gid_t) strtouint32(data->filter_value, &endptr, 10);
-            if (errno || *endptr || (data->filter_value == endptr)) {
-                dp_reply_std_set(&reply, DP_ERR_FATAL, EINVAL,
-                                 "Invalid attr type");
-                return reply;
-            }
-            ret = get_gr_gid(mem_ctx, ctx, sysdb, domain, gid, 0);
-            break;
+        /* Lookups by name and ID are handled by proxy_get_gr_send(). */
         default:
             dp_reply_std_set(&reply, DP_ERR_FATAL, EINVAL,
                              "Invalid filter type");
@@ -1725,25 +2093,17 @@ proxy_account_info(TALLOC_CTX *mem_ctx,
         return reply;
     }
 
-    if (ret) {
-        if (ret == ENXIO) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "proxy returned UNAVAIL error, going offline!\n");
-            be_mark_offline(be_ctx);
-        }
-
-        dp_reply_std_set(&reply, DP_ERR_FATAL, ret, NULL);
-        return reply;
-    }
-
-    dp_reply_std_set(&reply, DP_ERR_OK, EOK, NULL);
+    proxy_account_info_set_reply(&reply, be_ctx, ret);
     return reply;
 }
 
 struct proxy_account_info_handler_state {
     struct dp_reply_std reply;
+    struct be_ctx *be_ctx;
 };
 
+static void proxy_account_info_handler_done(struct tevent_req *subreq);
+
 struct tevent_req *
 proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
                                struct proxy_id_ctx *id_ctx,
@@ -1751,7 +2111,9 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
                                struct dp_req_params *params)
 {
     struct proxy_account_info_handler_state *state;
+    struct tevent_req *subreq;
     struct tevent_req *req;
+    bool async = false;
 
     req = tevent_req_create(mem_ctx, &state,
                             struct proxy_account_info_handler_state);
@@ -1760,6 +2122,42 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->be_ctx = params->be_ctx;
+
+    /* Lookups of single users and groups may take long, the NSS module is
+     * called in a worker thread for them so that the back end stays
+     * responsive. Everything else is handled in one go. */
+    if (data->filter_type == BE_FILTER_NAME
+            || data->filter_type == BE_FILTER_IDNUM) {
+        switch (data->entry_type & BE_REQ_TYPE_MASK) {
+        case BE_REQ_USER:
+            subreq = proxy_get_pw_send(state, params->ev, id_ctx,
+                                       params->be_ctx->domain,
+                                       data->filter_type, data->filter_value);
+            async = true;
+            break;
+        case BE_REQ_GROUP:
+            subreq = proxy_get_gr_send(state, params->ev, id_ctx,
+                                       params->be_ctx->domain,
+                                       data->filter_type, data->filter_value);
+            async = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (async) {
+        if (subreq == NULL) {
+            tevent_req_error(req, ENOMEM);
+            tevent_req_post(req, params->ev);
+            return req;
+        }
+
+        tevent_req_set_callback(subreq, proxy_account_info_handler_done, req);
+        return req;
+    }
+
     state->reply = proxy_account_info(state, id_ctx, data, params->be_ctx,
                                       params->be_ctx->domain);
 
@@ -1770,6 +2168,24 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
     return req;
 }
 
+static void proxy_account_info_handler_done(struct tevent_req *subreq)
+{
+    struct proxy_account_info_handler_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_account_info_handler_state);
+
+    ret = proxy_id_lookup_recv(subreq);
+    talloc_zfree(subreq);
+
+    proxy_account_info_set_reply(&state->reply, state->be_ctx, ret);
+
+    /* TODO For backward compatibility we always return EOK to DP now. */
+    tevent_req_done(req);
+}
+
 errno_t proxy_account_info_handler_recv(TALLOC_CTX *mem_ctx,
                                        struct tevent_req *req,
                                        struct dp_reply_std *data)
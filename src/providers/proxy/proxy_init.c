@@ -28,15 +28,21 @@
 #include "providers/proxy/proxy.h"
 
 #define OPT_MAX_CHILDREN_DEFAULT 10
+#define OPT_MAX_ID_THREADS_DEFAULT 4
+#define OPT_ID_TIMEOUT_DEFAULT 30
 
 static errno_t proxy_id_conf(TALLOC_CTX *mem_ctx,
                              struct be_ctx *be_ctx,
                              char **_libname,
-                             bool *_fast_alias)
+                             bool *_fast_alias,
+                             int *_max_threads,
+                             int *_timeout)
 {
     TALLOC_CTX *tmp_ctx;
     char *libname;
     bool fast_alias;
+    int max_threads;
+    int timeout;
     errno_t ret;
 
     tmp_ctx = talloc_new(NULL);
@@ -65,8 +71,35 @@ static errno_t proxy_id_conf(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_PROXY_MAX_ID_THREADS,
+                         OPT_MAX_ID_THREADS_DEFAULT, &max_threads);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (max_threads < 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Option " CONFDB_PROXY_MAX_ID_THREADS " must not be negative\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_PROXY_ID_TIMEOUT,
+                         OPT_ID_TIMEOUT_DEFAULT, &timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
     *_libname = talloc_steal(mem_ctx, libname);
     *_fast_alias = fast_alias;
+    *_max_threads = max_threads;
+    *_timeout = timeout;
 
     ret = EOK;
 
@@ -324,6 +357,7 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
 {
     struct proxy_module_ctx *module_ctx;
     char *libname;
+    int max_threads;
     errno_t ret;
 
     module_ctx = talloc_get_type(module_data, struct proxy_module_ctx);
@@ -335,7 +369,8 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
     module_ctx->id_ctx->be = be_ctx;
 
     ret = proxy_id_conf(module_ctx->id_ctx, be_ctx, &libname,
-                        &module_ctx->id_ctx->fast_alias);
+                        &module_ctx->id_ctx->fast_alias, &max_threads,
+                        &module_ctx->id_ctx->timeout);
     if (ret != EOK) {
         goto done;
     }
@@ -347,6 +382,18 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    if (max_threads > 0) {
+        ret = sss_thread_pool_create(module_ctx->id_ctx, be_ctx->ev,
+                                     max_threads,
+                                     &module_ctx->id_ctx->thread_pool);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to start worker threads, "
+                  "the NSS module will be called in the main thread "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            module_ctx->id_ctx->thread_pool = NULL;
+        }
+    }
+
     dp_set_method(dp_methods, DPM_ACCOUNT_HANDLER,
                   proxy_account_info_handler_send, proxy_account_info_handler_recv,
                   module_ctx->id_ctx, struct proxy_id_ctx, struct dp_id_data,
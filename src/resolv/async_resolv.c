@@ -41,6 +41,7 @@
 #include "config.h"
 #include "resolv/async_resolv.h"
 #include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "util/util.h"
 
 #define DNS__16BIT(p)                   (((p)[0] << 8) | (p)[1])
@@ -88,6 +89,12 @@ struct resolv_ctx {
      * if our pending requests didn't timeout. */
     int pending_requests;
     struct tevent_timer *timeout_watcher;
+
+    /* Cache of DNS answers, NULL if the cache is disabled. */
+    hash_table_t *cache;
+    uint32_t cache_min_ttl;
+    uint32_t cache_max_ttl;
+    uint32_t cache_neg_ttl;
 };
 
 struct request_watch {
@@ -489,6 +496,9 @@ void
 resolv_reread_configuration(struct resolv_ctx *ctx)
 {
     recreate_ares_channel(ctx);
+
+    /* The new configuration may point to different name servers */
+    resolv_cache_flush(ctx);
 }
 
 static errno_t
@@ -663,6 +673,367 @@ fail:
     return NULL;
 }
 
+static struct resolv_hostent *
+resolv_dup_hostent(TALLOC_CTX *mem_ctx, struct resolv_hostent *src, int ttl)
+{
+    struct resolv_hostent *ret;
+    size_t addrlen;
+    int len;
+    int i;
+
+    switch (src->family) {
+    case AF_INET:
+        addrlen = sizeof(struct in_addr);
+        break;
+    case AF_INET6:
+        addrlen = sizeof(struct in6_addr);
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unknown address family %d\n", src->family);
+        return NULL;
+    }
+
+    ret = talloc_zero(mem_ctx, struct resolv_hostent);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    ret->family = src->family;
+
+    if (src->name != NULL) {
+        ret->name = talloc_strdup(ret, src->name);
+        if (ret->name == NULL) {
+            goto fail;
+        }
+    }
+
+    if (src->aliases != NULL) {
+        ret->aliases = discard_const_p(char *,
+                            dup_string_list(ret, (const char **)src->aliases));
+        if (ret->aliases == NULL) {
+            goto fail;
+        }
+    }
+
+    if (src->addr_list != NULL) {
+        for (len = 0; src->addr_list[len] != NULL; len++);
+
+        ret->addr_list = talloc_array(ret, struct resolv_addr *, len + 1);
+        if (ret->addr_list == NULL) {
+            goto fail;
+        }
+
+        for (i = 0; i < len; i++) {
+            ret->addr_list[i] = talloc_zero(ret->addr_list,
+                                            struct resolv_addr);
+            if (ret->addr_list[i] == NULL) {
+                goto fail;
+            }
+
+            ret->addr_list[i]->ipaddr = talloc_memdup(ret->addr_list[i],
+                                                      src->addr_list[i]->ipaddr,
+                                                      addrlen);
+            if (ret->addr_list[i]->ipaddr == NULL) {
+                goto fail;
+            }
+            ret->addr_list[i]->ttl = ttl < 0 ? src->addr_list[i]->ttl : ttl;
+        }
+        ret->addr_list[len] = NULL;
+    }
+
+    return ret;
+
+fail:
+    talloc_free(ret);
+    return NULL;
+}
+
+static struct ares_srv_reply *
+resolv_dup_srv_reply(TALLOC_CTX *mem_ctx, struct ares_srv_reply *src)
+{
+    struct ares_srv_reply *new_list = NULL;
+    struct ares_srv_reply *ptr = NULL;
+
+    for (; src != NULL; src = src->next) {
+        if (new_list == NULL) {
+            new_list = talloc_zero(mem_ctx, struct ares_srv_reply);
+            ptr = new_list;
+        } else {
+            ptr->next = talloc_zero(new_list, struct ares_srv_reply);
+            ptr = ptr->next;
+        }
+
+        if (ptr == NULL) {
+            goto fail;
+        }
+
+        ptr->weight = src->weight;
+        ptr->priority = src->priority;
+        ptr->port = src->port;
+        ptr->host = talloc_strdup(ptr, src->host);
+        if (ptr->host == NULL) {
+            goto fail;
+        }
+    }
+
+    return new_list;
+
+fail:
+    talloc_free(new_list);
+    return NULL;
+}
+
+/* ========================= DNS answer cache ============================*/
+struct resolv_cache_entry {
+    time_t expire;
+
+    /* ARES_SUCCESS for positive answers, ARES_ENOTFOUND or ARES_ENODATA
+     * for names that are known not to exist. */
+    int status;
+
+    /* Exactly one of these is set for positive answers. */
+    struct resolv_hostent *rhostent;
+    struct ares_srv_reply *reply_list;
+};
+
+errno_t
+resolv_cache_init(struct resolv_ctx *ctx,
+                  uint32_t min_ttl,
+                  uint32_t max_ttl,
+                  uint32_t neg_ttl)
+{
+    if (max_ttl == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "DNS answer cache is disabled\n");
+        talloc_zfree(ctx->cache);
+        ctx->cache_min_ttl = 0;
+        ctx->cache_max_ttl = 0;
+        ctx->cache_neg_ttl = 0;
+        return EOK;
+    }
+
+    if (min_ttl > max_ttl) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Minimal cache TTL [%"PRIu32"] is greater than maximal cache "
+              "TTL [%"PRIu32"], using the maximum\n", min_ttl, max_ttl);
+        min_ttl = max_ttl;
+    }
+
+    if (ctx->cache == NULL) {
+        ctx->cache = sss_ptr_hash_create(ctx, NULL, NULL);
+        if (ctx->cache == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    ctx->cache_min_ttl = min_ttl;
+    ctx->cache_max_ttl = max_ttl;
+    ctx->cache_neg_ttl = neg_ttl;
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "DNS answer cache enabled, TTL clamped to [%"PRIu32", %"PRIu32"], "
+          "negative TTL [%"PRIu32"]\n", min_ttl, max_ttl, neg_ttl);
+
+    return EOK;
+}
+
+void
+resolv_cache_flush(struct resolv_ctx *ctx)
+{
+    if (ctx->cache == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing the DNS answer cache\n");
+    sss_ptr_hash_delete_all(ctx->cache, true);
+}
+
+static char *
+resolv_cache_key(TALLOC_CTX *mem_ctx, int type, const char *name)
+{
+    switch (type) {
+    case ns_t_a:
+        return talloc_asprintf(mem_ctx, "A:%s", name);
+    case ns_t_aaaa:
+        return talloc_asprintf(mem_ctx, "AAAA:%s", name);
+    case ns_t_srv:
+        return talloc_asprintf(mem_ctx, "SRV:%s", name);
+    }
+
+    DEBUG(SSSDBG_CRIT_FAILURE, "Unsupported record type %d\n", type);
+    return NULL;
+}
+
+/* Returns a valid cache entry or NULL. The entry is owned by the cache and
+ * must be copied before the caller returns to the main loop. */
+static struct resolv_cache_entry *
+resolv_cache_lookup(struct resolv_ctx *ctx,
+                    int type,
+                    const char *name,
+                    uint32_t *_remaining)
+{
+    struct resolv_cache_entry *entry;
+    time_t now;
+    char *key;
+
+    if (ctx->cache == NULL) {
+        return NULL;
+    }
+
+    key = resolv_cache_key(NULL, type, name);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(ctx->cache, key, struct resolv_cache_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    now = time(NULL);
+    if (entry->expire <= now) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Cached answer for [%s] expired\n", key);
+        /* Freeing the entry removes it from the table as well */
+        talloc_zfree(entry);
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Using cached %s answer for [%s]\n",
+          entry->status == ARES_SUCCESS ? "positive" : "negative", key);
+    *_remaining = entry->expire - now;
+
+done:
+    talloc_free(key);
+    return entry;
+}
+
+static void
+resolv_cache_add(struct resolv_ctx *ctx,
+                 int type,
+                 const char *name,
+                 struct resolv_cache_entry *entry,
+                 uint32_t ttl)
+{
+    char *key;
+    errno_t ret;
+
+    key = resolv_cache_key(NULL, type, name);
+    if (key == NULL) {
+        talloc_free(entry);
+        return;
+    }
+
+    if (sss_ptr_hash_has_key(ctx->cache, key)) {
+        sss_ptr_hash_delete(ctx->cache, key, true);
+    }
+
+    entry->expire = time(NULL) + ttl;
+    ret = sss_ptr_hash_add(ctx->cache, key, entry, struct resolv_cache_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache answer for [%s] "
+              "[%d]: %s\n", key, ret, sss_strerror(ret));
+        talloc_free(entry);
+    } else {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Cached %s answer for [%s] for "
+              "%"PRIu32" seconds\n",
+              entry->status == ARES_SUCCESS ? "positive" : "negative",
+              key, ttl);
+    }
+
+    talloc_free(key);
+}
+
+static uint32_t
+resolv_cache_clamp_ttl(struct resolv_ctx *ctx, uint32_t ttl)
+{
+    return MIN(MAX(ttl, ctx->cache_min_ttl), ctx->cache_max_ttl);
+}
+
+static void
+resolv_cache_store_negative(struct resolv_ctx *ctx,
+                            int type,
+                            const char *name,
+                            int status)
+{
+    struct resolv_cache_entry *entry;
+
+    if (ctx->cache == NULL || ctx->cache_neg_ttl == 0) {
+        return;
+    }
+
+    entry = talloc_zero(ctx->cache, struct resolv_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->status = status;
+    resolv_cache_add(ctx, type, name, entry, ctx->cache_neg_ttl);
+}
+
+static void
+resolv_cache_store_hostent(struct resolv_ctx *ctx,
+                           int type,
+                           const char *name,
+                           struct resolv_hostent *rhostent)
+{
+    struct resolv_cache_entry *entry;
+    int ttl = 0;
+    int i;
+
+    if (ctx->cache == NULL || rhostent->addr_list == NULL) {
+        return;
+    }
+
+    /* Use the lowest TTL of the RRSet, see RFC 2181, section 5.2 */
+    for (i = 0; rhostent->addr_list[i] != NULL; i++) {
+        if (i == 0 || rhostent->addr_list[i]->ttl < ttl) {
+            ttl = rhostent->addr_list[i]->ttl;
+        }
+    }
+
+    entry = talloc_zero(ctx->cache, struct resolv_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->status = ARES_SUCCESS;
+    entry->rhostent = resolv_dup_hostent(entry, rhostent, -1);
+    if (entry->rhostent == NULL) {
+        talloc_free(entry);
+        return;
+    }
+
+    resolv_cache_add(ctx, type, name, entry,
+                     resolv_cache_clamp_ttl(ctx, MAX(ttl, 0)));
+}
+
+static void
+resolv_cache_store_srv(struct resolv_ctx *ctx,
+                       const char *query,
+                       struct ares_srv_reply *reply_list,
+                       uint32_t ttl)
+{
+    struct resolv_cache_entry *entry;
+
+    if (ctx->cache == NULL || reply_list == NULL) {
+        return;
+    }
+
+    entry = talloc_zero(ctx->cache, struct resolv_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->status = ARES_SUCCESS;
+    entry->reply_list = resolv_dup_srv_reply(entry, reply_list);
+    if (entry->reply_list == NULL) {
+        talloc_free(entry);
+        return;
+    }
+
+    resolv_cache_add(ctx, ns_t_srv, query, entry,
+                     resolv_cache_clamp_ttl(ctx, ttl));
+}
+
 /* =================== Resolve host name in files =========================*/
 struct gethostbyname_files_state {
     struct resolv_ctx *resolv_ctx;
@@ -784,6 +1155,9 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
 static int
 resolv_gethostbyname_dns_parse(struct gethostbyname_dns_state *state,
                                int status, unsigned char *abuf, int alen);
+static bool
+resolv_gethostbyname_dns_cached(struct tevent_req *req,
+                                struct gethostbyname_dns_state *state);
 
 static struct tevent_req *
 resolv_gethostbyname_dns_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
@@ -814,6 +1188,11 @@ resolv_gethostbyname_dns_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
     state->retrying = 0;
     state->family = family;
 
+    if (resolv_gethostbyname_dns_cached(req, state)) {
+        tevent_req_post(req, ev);
+        return req;
+    }
+
     /* We need to have a wrapper around ares async calls, because
      * they can in some cases call it's callback immediately.
      * This would not let our caller to set a callback for req. */
@@ -829,6 +1208,38 @@ resolv_gethostbyname_dns_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
     return req;
 }
 
+static bool
+resolv_gethostbyname_dns_cached(struct tevent_req *req,
+                                struct gethostbyname_dns_state *state)
+{
+    struct resolv_cache_entry *entry;
+    uint32_t remaining;
+
+    entry = resolv_cache_lookup(state->resolv_ctx,
+                                (state->family == AF_INET) ? ns_t_a : ns_t_aaaa,
+                                state->name, &remaining);
+    if (entry == NULL) {
+        return false;
+    }
+
+    state->status = entry->status;
+    if (entry->status != ARES_SUCCESS) {
+        tevent_req_error(req, ENOENT);
+        return true;
+    }
+
+    /* Report the remaining lifetime so that fail over expires the
+     * address at the same time as the cache does */
+    state->rhostent = resolv_dup_hostent(state, entry->rhostent, remaining);
+    if (state->rhostent == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return true;
+    }
+
+    tevent_req_done(req);
+    return true;
+}
+
 static void
 resolv_gethostbyname_dns_wakeup(struct tevent_req *subreq)
 {
@@ -910,6 +1321,11 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
     }
 
     if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        resolv_cache_store_negative(state->resolv_ctx,
+                                    (state->family == AF_INET) ? ns_t_a
+                                                               : ns_t_aaaa,
+                                    state->name, status);
+
         /* Just say we didn't find anything and let the caller decide
          * about retrying */
         tevent_req_error(req, ENOENT);
@@ -930,6 +1346,10 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
         return;
     }
 
+    resolv_cache_store_hostent(state->resolv_ctx,
+                               (state->family == AF_INET) ? ns_t_a : ns_t_aaaa,
+                               state->name, state->rhostent);
+
     tevent_req_done(req);
 }
 
@@ -1579,6 +1999,9 @@ ares_getsrv_wakeup(struct tevent_req *subreq);
 static void
 resolv_getsrv_query(struct tevent_req *req,
                     struct getsrv_state *state);
+static bool
+resolv_getsrv_cached(struct tevent_req *req,
+                     struct getsrv_state *state);
 
 struct tevent_req *
 resolv_getsrv_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
@@ -1610,6 +2033,11 @@ resolv_getsrv_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
     state->retrying = 0;
     state->ev = ev;
 
+    if (resolv_getsrv_cached(req, state)) {
+        tevent_req_post(req, ev);
+        return req;
+    }
+
     subreq = tevent_wakeup_send(req, ev, tv);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1622,6 +2050,37 @@ resolv_getsrv_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
     return req;
 }
 
+static bool
+resolv_getsrv_cached(struct tevent_req *req,
+                     struct getsrv_state *state)
+{
+    struct resolv_cache_entry *entry;
+    uint32_t remaining;
+
+    entry = resolv_cache_lookup(state->resolv_ctx, ns_t_srv,
+                                state->query, &remaining);
+    if (entry == NULL) {
+        return false;
+    }
+
+    state->status = entry->status;
+    if (entry->status != ARES_SUCCESS) {
+        tevent_req_error(req, return_code(entry->status));
+        return true;
+    }
+
+    /* Callers sort the list in place, hand out a private copy */
+    state->reply_list = resolv_dup_srv_reply(state, entry->reply_list);
+    if (state->reply_list == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return true;
+    }
+    state->ttl = remaining;
+
+    tevent_req_done(req);
+    return true;
+}
+
 /*
  * Implemented based on http://tools.ietf.org/html/rfc2181#section-5
  *
@@ -1739,6 +2198,11 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     state->status = status;
     state->timeouts = timeouts;
 
+    if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        resolv_cache_store_negative(state->resolv_ctx, ns_t_srv,
+                                    state->query, status);
+    }
+
     if (status != ARES_SUCCESS) {
         ret = return_code(status);
         goto fail;
@@ -1763,6 +2227,9 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     }
     DEBUG(SSSDBG_TRACE_LIBS, "Using TTL [%"PRIu32"]\n", state->ttl);
 
+    resolv_cache_store_srv(state->resolv_ctx, state->query,
+                           state->reply_list, state->ttl);
+
     tevent_req_done(req);
     return;
 
@@ -40,6 +40,18 @@
 #define RESOLV_DEFAULT_SRV_TTL 14400
 #endif  /* RESOLV_DEFAULT_SRV_TTL */
 
+#ifndef RESOLV_DEFAULT_CACHE_MIN_TTL
+#define RESOLV_DEFAULT_CACHE_MIN_TTL 5
+#endif  /* RESOLV_DEFAULT_CACHE_MIN_TTL */
+
+#ifndef RESOLV_DEFAULT_CACHE_MAX_TTL
+#define RESOLV_DEFAULT_CACHE_MAX_TTL 300
+#endif  /* RESOLV_DEFAULT_CACHE_MAX_TTL */
+
+#ifndef RESOLV_DEFAULT_CACHE_NEG_TTL
+#define RESOLV_DEFAULT_CACHE_NEG_TTL 30
+#endif  /* RESOLV_DEFAULT_CACHE_NEG_TTL */
+
 #include "util/util.h"
 
 /*
@@ -56,6 +68,23 @@ int resolv_init(TALLOC_CTX *mem_ctx, struct tevent_context *ev_ctx,
 
 void resolv_reread_configuration(struct resolv_ctx *ctx);
 
+/*
+ * Enable the answer cache for A, AAAA and SRV lookups done through DNS.
+ *
+ * Positive answers are kept for the lowest TTL of the answer, clamped to
+ * the <min_ttl, max_ttl> interval. Names that do not exist (NXDOMAIN or no
+ * data) are kept for neg_ttl seconds, a neg_ttl of 0 disables negative
+ * caching. A max_ttl of 0 disables the cache entirely, which is also the
+ * default after resolv_init().
+ */
+errno_t resolv_cache_init(struct resolv_ctx *ctx,
+                          uint32_t min_ttl,
+                          uint32_t max_ttl,
+                          uint32_t neg_ttl);
+
+/* Drop all cached answers, e.g. when the network configuration changes. */
+void resolv_cache_flush(struct resolv_ctx *ctx);
+
 const char *resolv_strerror(int ares_code);
 
 struct resolv_hostent *
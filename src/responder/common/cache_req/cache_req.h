@@ -179,6 +179,14 @@ void
 cache_req_data_set_hybrid_lookup(struct cache_req_data *data,
                                  bool hybrid_lookup);
 
+void
+cache_req_data_set_initgr_gids_only(struct cache_req_data *data,
+                                    bool initgr_gids_only);
+
+void
+cache_req_data_set_enum_page_size(struct cache_req_data *data,
+                                  uint32_t enum_page_size);
+
 enum cache_req_type
 cache_req_data_get_type(struct cache_req_data *data);
 
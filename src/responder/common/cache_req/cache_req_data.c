@@ -479,6 +479,30 @@ cache_req_data_set_hybrid_lookup(struct cache_req_data *data,
     data->hybrid_lookup = hybrid_lookup;
 }
 
+void
+cache_req_data_set_initgr_gids_only(struct cache_req_data *data,
+                                    bool initgr_gids_only)
+{
+    if (data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "cache_req_data should never be NULL\n");
+        return;
+    }
+
+    data->initgr_gids_only = initgr_gids_only;
+}
+
+void
+cache_req_data_set_enum_page_size(struct cache_req_data *data,
+                                  uint32_t enum_page_size)
+{
+    if (data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "cache_req_data should never be NULL\n");
+        return;
+    }
+
+    data->enum_page_size = enum_page_size;
+}
+
 
 enum cache_req_type
 cache_req_data_get_type(struct cache_req_data *data)
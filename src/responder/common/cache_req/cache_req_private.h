@@ -113,6 +113,12 @@ struct cache_req_data {
 
     /* if set, only domains with MPG_HYBRID are searched */
     bool hybrid_lookup;
+
+    /* if set, initgroups returns only the attributes needed to list GIDs */
+    bool initgr_gids_only;
+
+    /* if set, enumeration returns only the first page of each domain */
+    uint32_t enum_page_size;
 };
 
 struct tevent_req *
@@ -41,6 +41,11 @@ cache_req_enum_groups_lookup(TALLOC_CTX *mem_ctx,
                              struct sss_domain_info *domain,
                              struct ldb_result **_result)
 {
+    if (data->enum_page_size > 0) {
+        return sysdb_enumgrent_paged_with_views(mem_ctx, domain, NULL,
+                                                data->enum_page_size, _result);
+    }
+
     return sysdb_enumgrent_with_views(mem_ctx, domain, _result);
 }
 
@@ -41,6 +41,11 @@ cache_req_enum_users_lookup(TALLOC_CTX *mem_ctx,
                             struct sss_domain_info *domain,
                             struct ldb_result **_result)
 {
+    if (data->enum_page_size > 0) {
+        return sysdb_enumpwent_paged_with_views(mem_ctx, domain, NULL,
+                                                data->enum_page_size, _result);
+    }
+
     return sysdb_enumpwent_with_views(mem_ctx, domain, _result);
 }
 
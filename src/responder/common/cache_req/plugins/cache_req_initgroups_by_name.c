@@ -105,6 +105,11 @@ cache_req_initgroups_by_name_lookup(TALLOC_CTX *mem_ctx,
                                     struct sss_domain_info *domain,
                                     struct ldb_result **_result)
 {
+    if (data->initgr_gids_only) {
+        return sysdb_initgroups_gids_with_views(mem_ctx, domain,
+                                                data->name.lookup, _result);
+    }
+
     return sysdb_initgroups_with_views(mem_ctx, domain, data->name.lookup,
                                        _result);
 }
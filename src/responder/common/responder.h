@@ -298,6 +298,21 @@ sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
                         uint32_t *_error,
                         const char **_error_message);
 
+struct tevent_req *
+sss_dp_get_account_list_send(TALLOC_CTX *mem_ctx,
+                             struct resp_ctx *rctx,
+                             struct sss_domain_info *dom,
+                             bool fast_reply,
+                             enum sss_dp_acct_type type,
+                             const char **names);
+errno_t
+sss_dp_get_account_list_recv(TALLOC_CTX *mem_ctx,
+                             struct tevent_req *req,
+                             uint16_t *_dp_error,
+                             uint32_t *_error,
+                             const char **_error_message,
+                             uint32_t **_errors);
+
 struct tevent_req *
 sss_dp_resolver_get_send(TALLOC_CTX *mem_ctx,
                          struct resp_ctx *rctx,
@@ -329,6 +329,184 @@ sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct sss_dp_get_account_list_state {
+    uint16_t dp_error;
+    uint32_t error;
+    const char *error_message;
+    uint32_t *errors;
+};
+
+static void sss_dp_get_account_list_done(struct tevent_req *subreq);
+
+/* Refresh several entries of the same type by name with a single request.
+ * Domains that do not check the Data Provider are left to the per entry
+ * requests which know how to handle them. */
+struct tevent_req *
+sss_dp_get_account_list_send(TALLOC_CTX *mem_ctx,
+                             struct resp_ctx *rctx,
+                             struct sss_domain_info *dom,
+                             bool fast_reply,
+                             enum sss_dp_acct_type type,
+                             const char **names)
+{
+    struct sss_dp_get_account_list_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    struct be_conn *be_conn;
+    const char **filters;
+    uint32_t entry_type;
+    uint32_t dp_flags;
+    char *filter;
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sss_dp_get_account_list_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    if (dom == NULL || names == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    switch (type) {
+    case SSS_DP_USER:
+    case SSS_DP_GROUP:
+    case SSS_DP_USER_AND_GROUP:
+        break;
+    default:
+        ret = EINVAL;
+        goto done;
+    }
+
+    for (count = 0; names[count] != NULL; count++);
+
+    state->errors = talloc_zero_array(state, uint32_t, count);
+    if (state->errors == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (count == 0 || NEED_CHECK_PROVIDER(dom->provider) == false) {
+        state->dp_error = DP_ERR_OK;
+        state->error = EOK;
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sss_dp_get_domain_conn(rctx, dom->conn_name, &be_conn);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "BUG: The Data Provider connection for %s is not available!\n",
+              dom->name);
+        ret = EIO;
+        goto done;
+    }
+
+    filters = talloc_zero_array(state, const char *, count + 1);
+    if (filters == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = sss_dp_get_account_filter(filters, type, fast_reply, names[i],
+                                        0, &dp_flags, &entry_type, &filter);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        filters[i] = filter;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Creating request for [%s][%#x][%s] with %zu names\n",
+          dom->name, entry_type, be_req2str(entry_type), count);
+
+    subreq = sbus_call_dp_dp_getAccountInfoList_send(state, be_conn->conn,
+                 be_conn->bus_name, SSS_BUS_PATH, dp_flags,
+                 entry_type, filters, dom->name, NULL,
+                 rctx->client_id_num);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sss_dp_get_account_list_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, rctx->ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, rctx->ev);
+    }
+
+    return req;
+}
+
+static void sss_dp_get_account_list_done(struct tevent_req *subreq)
+{
+    struct sss_dp_get_account_list_state *state;
+    struct tevent_req *req;
+    uint32_t *errors;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_dp_get_account_list_state);
+
+    ret = sbus_call_dp_dp_getAccountInfoList_recv(state, subreq,
+                                                  &state->dp_error,
+                                                  &state->error,
+                                                  &state->error_message,
+                                                  &errors);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    if (talloc_array_length(errors) != talloc_array_length(state->errors)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid reply from the Data Provider\n");
+        tevent_req_error(req, EINVAL);
+        return;
+    }
+
+    talloc_free(state->errors);
+    state->errors = errors;
+
+    tevent_req_done(req);
+}
+
+errno_t
+sss_dp_get_account_list_recv(TALLOC_CTX *mem_ctx,
+                             struct tevent_req *req,
+                             uint16_t *_dp_error,
+                             uint32_t *_error,
+                             const char **_error_message,
+                             uint32_t **_errors)
+{
+    struct sss_dp_get_account_list_state *state;
+    state = tevent_req_data(req, struct sss_dp_get_account_list_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_dp_error = state->dp_error;
+    *_error = state->error;
+    *_error_message = talloc_steal(mem_ctx, state->error_message);
+    *_errors = talloc_steal(mem_ctx, state->errors);
+
+    return EOK;
+}
+
 struct sss_dp_resolver_get_state {
     uint16_t dp_error;
     uint32_t error;
@@ -29,6 +29,7 @@
 #include "responder/ifp/ifp_groups.h"
 #include "responder/ifp/ifp_users.h"
 #include "responder/ifp/ifp_cache.h"
+#include "responder/ifp/ifp_paged.h"
 #include "responder/ifp/ifp_iface/ifp_iface_async.h"
 
 char * ifp_groups_build_path_from_msg(TALLOC_CTX *mem_ctx,
@@ -521,6 +522,51 @@ ifp_groups_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct tevent_req *
+ifp_groups_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sbus_request *sbus_req,
+                                   struct ifp_ctx *ctx,
+                                   const char *filter,
+                                   const char *cursor,
+                                   uint32_t limit)
+{
+    return ifp_paged_list_send(mem_ctx, ev, ctx, IFP_PAGED_GROUP, NULL,
+                               filter, cursor, limit);
+}
+
+errno_t
+ifp_groups_list_by_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                   struct tevent_req *req,
+                                   const char ***_paths,
+                                   const char **_next_cursor)
+{
+    return ifp_paged_list_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
+struct tevent_req *
+ifp_groups_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                              struct tevent_context *ev,
+                                              struct sbus_request *sbus_req,
+                                              struct ifp_ctx *ctx,
+                                              const char *domain,
+                                              const char *filter,
+                                              const char *cursor,
+                                              uint32_t limit)
+{
+    return ifp_paged_list_send(mem_ctx, ev, ctx, IFP_PAGED_GROUP, domain,
+                               filter, cursor, limit);
+}
+
+errno_t
+ifp_groups_list_by_domain_and_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                              struct tevent_req *req,
+                                              const char ***_paths,
+                                              const char **_next_cursor)
+{
+    return ifp_paged_list_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
 static errno_t
 ifp_groups_get_from_cache(TALLOC_CTX *mem_ctx,
                           struct sss_domain_info *domain,
@@ -581,21 +627,21 @@ done:
 }
 
 static errno_t
-ifp_groups_group_get(TALLOC_CTX *mem_ctx,
-                     struct sbus_request *sbus_req,
-                     struct ifp_ctx *ctx,
-                     struct sss_domain_info **_domain,
-                     struct ldb_message **_group)
+ifp_groups_group_get_by_path(TALLOC_CTX *mem_ctx,
+                             struct ifp_ctx *ctx,
+                             const char *path,
+                             struct sss_domain_info **_domain,
+                             struct ldb_message **_group)
 {
     struct sss_domain_info *domain;
     char *key;
     errno_t ret;
 
-    ret = ifp_groups_decompose_path(NULL, ctx->rctx->domains, sbus_req->path,
+    ret = ifp_groups_decompose_path(NULL, ctx->rctx->domains, path,
                                     &domain, &key);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to decompose object path"
-              "[%s] [%d]: %s\n", sbus_req->path, ret, sss_strerror(ret));
+              "[%s] [%d]: %s\n", path, ret, sss_strerror(ret));
         return ret;
     }
 
@@ -616,6 +662,98 @@ ifp_groups_group_get(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+static errno_t
+ifp_groups_group_get(TALLOC_CTX *mem_ctx,
+                     struct sbus_request *sbus_req,
+                     struct ifp_ctx *ctx,
+                     struct sss_domain_info **_domain,
+                     struct ldb_message **_group)
+{
+    return ifp_groups_group_get_by_path(mem_ctx, ctx, sbus_req->path,
+                                        _domain, _group);
+}
+
+static errno_t
+ifp_groups_get_attrs_by_path(TALLOC_CTX *mem_ctx,
+                             struct ifp_ctx *ifp_ctx,
+                             const char *path,
+                             const char **attrs,
+                             struct sss_domain_info **_domain,
+                             struct ldb_message **_group)
+{
+    const char *override_attrs[] = {SYSDB_OVERRIDE_DN, NULL};
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_message *group;
+    struct ldb_message *msg;
+    const char *name;
+    char **search_attrs;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = ifp_groups_group_get_by_path(tmp_ctx, ifp_ctx, path, &domain,
+                                       &group);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    name = ldb_msg_find_attr_as_string(group, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "A group with no name\n");
+        ret = ERR_INTERNAL;
+        goto done;
+    }
+
+    /* Read only the requested attributes. */
+    ret = add_strings_lists(tmp_ctx, attrs, override_attrs, false,
+                            &search_attrs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_search_group_by_name(tmp_ctx, domain, name,
+                                     discard_const(search_attrs), &msg);
+    if (ret == ENOENT && sss_domain_is_mpg(domain)) {
+        ret = sysdb_search_user_by_name(tmp_ctx, domain, name,
+                                        discard_const(search_attrs), &msg);
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (DOM_HAS_VIEWS(domain)) {
+        ret = sysdb_add_overrides_to_object(domain, msg, NULL, attrs);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    *_domain = domain;
+    *_group = talloc_steal(mem_ctx, msg);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t
+ifp_groups_get_attributes(TALLOC_CTX *mem_ctx,
+                          struct sbus_request *sbus_req,
+                          struct ifp_ctx *ctx,
+                          const char **objects,
+                          const char **attrs,
+                          DBusMessageIter *write_iter)
+{
+    return ifp_write_objects_attrs(ctx, objects, attrs,
+                                   ifp_groups_get_attrs_by_path, write_iter);
+}
+
 struct resolv_ghosts_state {
     struct tevent_context *ev;
     struct sbus_request *sbus_req;
@@ -627,6 +765,7 @@ struct resolv_ghosts_state {
 };
 
 static void resolv_ghosts_group_done(struct tevent_req *subreq);
+static void resolv_ghosts_prefetch_done(struct tevent_req *subreq);
 static errno_t resolv_ghosts_step(struct tevent_req *req);
 static void resolv_ghosts_done(struct tevent_req *subreq);
 
@@ -719,8 +858,19 @@ static void resolv_ghosts_group_done(struct tevent_req *subreq)
         goto done;
     }
 
-    state->index = 0;
-    ret = resolv_ghosts_step(req);
+    /* Refresh all members with a single Data Provider request first so the
+     * lookups of each member below are answered from the cache. */
+    subreq = sss_dp_get_account_list_send(state, state->ctx->rctx,
+                                          state->domain, false, SSS_DP_USER,
+                                          state->ghosts);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, resolv_ghosts_prefetch_done, req);
+
+    ret = EAGAIN;
 
 done:
     if (ret == EOK) {
@@ -730,6 +880,37 @@ done:
     }
 }
 
+static void resolv_ghosts_prefetch_done(struct tevent_req *subreq)
+{
+    struct resolv_ghosts_state *state;
+    struct tevent_req *req;
+    const char *err_msg;
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct resolv_ghosts_state);
+
+    ret = sss_dp_get_account_list_recv(state, subreq, &dp_error, &error,
+                                       &err_msg, &errors);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        /* Not fatal, members are looked up one by one. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to refresh group members "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+
+    state->index = 0;
+    ret = resolv_ghosts_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
 errno_t resolv_ghosts_step(struct tevent_req *req)
 {
     struct resolv_ghosts_state *state;
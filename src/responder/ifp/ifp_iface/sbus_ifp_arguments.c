@@ -56,6 +56,84 @@ errno_t _sbus_ifp_invoker_write_ao
     return EOK;
 }
 
+errno_t _sbus_ifp_invoker_read_aoas
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aoas *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_read_ao(mem_ctx, iter, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_as(mem_ctx, iter, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_write_aoas
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aoas *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_write_ao(iter, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_as(iter, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_read_aos
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_read_ao(mem_ctx, iter, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_write_aos
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aos *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_write_ao(iter, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
 errno_t _sbus_ifp_invoker_read_as
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
@@ -279,6 +357,65 @@ errno_t _sbus_ifp_invoker_write_ss
     return EOK;
 }
 
+errno_t _sbus_ifp_invoker_read_sssu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_s(mem_ctx, iter, &args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_read_u(iter, &args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t _sbus_ifp_invoker_write_sssu
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_sssu *args)
+{
+    errno_t ret;
+
+    ret = sbus_iterator_write_s(iter, args->arg0);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg1);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_s(iter, args->arg2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sbus_iterator_write_u(iter, args->arg3);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
 errno_t _sbus_ifp_invoker_read_ssu
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
@@ -265,6 +265,64 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_aoas_out_raw
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char ** arg0,
+     const char ** arg1,
+     DBusMessage **_reply)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_aoas in;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_aoas,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* Bounded reference cannot be unreferenced with dbus_message_unref.
+     * For that reason we do not allow NULL memory context as it would
+     * result in leaking the message memory. */
+    if (mem_ctx == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = sbus_message_bound_steal(mem_ctx, reply);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to steal message [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    *_reply = reply;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_s_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -600,6 +658,69 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_sssu_out_aos
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     const char * arg1,
+     const char * arg2,
+     uint32_t arg3,
+     const char *** _arg0,
+     const char ** _arg1)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_sssu in;
+    struct _sbus_ifp_invoker_args_aos *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_aos);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+    in.arg3 = arg3;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_sssu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_aos, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_ssu_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -659,6 +780,67 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_ssu_out_aos
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     const char * arg1,
+     uint32_t arg2,
+     const char *** _arg0,
+     const char ** _arg1)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_ssu in;
+    struct _sbus_ifp_invoker_args_aos *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_aos);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_ssu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_aos, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_su_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -1063,6 +1245,21 @@ sbus_call_ifp_groups_FindByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_GetAttributes
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_objects,
+     const char ** arg_attrs,
+     DBusMessage **_reply)
+{
+     return sbus_method_in_aoas_out_raw(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "GetAttributes", arg_objects, arg_attrs,
+          _reply);
+}
+
 errno_t
 sbus_call_ifp_groups_ListByDomainAndName
     (TALLOC_CTX *mem_ctx,
@@ -1079,6 +1276,25 @@ sbus_call_ifp_groups_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_limit,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_sssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_cursor, arg_limit,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_groups_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1094,6 +1310,24 @@ sbus_call_ifp_groups_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_limit,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_ssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByNamePaged", arg_name_filter, arg_cursor, arg_limit,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_group_UpdateMemberList
     (struct sbus_sync_connection *conn,
@@ -1161,6 +1395,21 @@ sbus_call_ifp_users_FindByNameAndCertificate
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_GetAttributes
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_objects,
+     const char ** arg_attrs,
+     DBusMessage **_reply)
+{
+     return sbus_method_in_aoas_out_raw(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "GetAttributes", arg_objects, arg_attrs,
+          _reply);
+}
+
 errno_t
 sbus_call_ifp_users_ListByCertificate
     (TALLOC_CTX *mem_ctx,
@@ -1192,6 +1441,25 @@ sbus_call_ifp_users_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_limit,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_sssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_cursor, arg_limit,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_users_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1207,6 +1475,24 @@ sbus_call_ifp_users_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     const char * arg_cursor,
+     uint32_t arg_limit,
+     const char *** _arg_result,
+     const char ** _arg_next_cursor)
+{
+     return sbus_method_in_ssu_out_aos(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByNamePaged", arg_name_filter, arg_cursor, arg_limit,
+          _arg_result,
+          _arg_next_cursor);
+}
+
 errno_t
 sbus_call_ifp_user_UpdateGroupsList
     (struct sbus_sync_connection *conn,
@@ -273,6 +273,19 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_FindByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_GetAttributes = {
+    .input = (const struct sbus_argument[]){
+        {.type = "ao", .name = "objects"},
+        {.type = "as", .name = "attrs"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "aa{sv}", .name = "values"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndName = {
     .input = (const struct sbus_argument[]){
@@ -287,6 +300,22 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -300,6 +329,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_Group_UpdateMemberList = {
     .input = (const struct sbus_argument[]){
@@ -359,6 +403,19 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_FindByNameAndCertificate = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_GetAttributes = {
+    .input = (const struct sbus_argument[]){
+        {.type = "ao", .name = "objects"},
+        {.type = "as", .name = "attrs"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "aa{sv}", .name = "values"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByCertificate = {
     .input = (const struct sbus_argument[]){
@@ -386,6 +443,22 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -399,6 +472,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "s", .name = "cursor"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {.type = "s", .name = "next_cursor"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_User_UpdateGroupsList = {
     .input = (const struct sbus_argument[]){
@@ -0,0 +1,438 @@
+/*
+    SSSD
+
+    InfoPipe - paged lists of users and groups
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <string.h>
+
+#include "db/sysdb.h"
+#include "util/util.h"
+#include "providers/data_provider.h"
+#include "responder/common/responder.h"
+#include "responder/ifp/ifp_paged.h"
+#include "responder/ifp/ifp_users.h"
+#include "responder/ifp/ifp_groups.h"
+
+/* Page size used when neither the caller nor wildcard_limit sets one. It
+ * is also the largest page returned, the limit comes from the caller. */
+#define IFP_PAGED_DEFAULT_LIMIT 1000
+
+/* The cursor is "<domain>:<name>" where name is the name of the last
+ * object returned from the domain in the internal format. An empty name
+ * means that the domain was not searched yet. */
+#define IFP_PAGED_CURSOR_SEP ':'
+
+static uint32_t ifp_paged_limit(struct ifp_ctx *ctx, uint32_t limit)
+{
+    if (limit == 0) {
+        limit = ctx->wildcard_limit;
+    } else if (ctx->wildcard_limit) {
+        limit = MIN(ctx->wildcard_limit, limit);
+    }
+
+    if (limit == 0 || limit > IFP_PAGED_DEFAULT_LIMIT) {
+        limit = IFP_PAGED_DEFAULT_LIMIT;
+    }
+
+    return limit;
+}
+
+static errno_t ifp_paged_parse_cursor(TALLOC_CTX *mem_ctx,
+                                      struct sss_domain_info *domains,
+                                      const char *cursor,
+                                      struct sss_domain_info **_dom,
+                                      const char **_after)
+{
+    struct sss_domain_info *dom;
+    const char *sep;
+    char *name;
+
+    sep = strchr(cursor, IFP_PAGED_CURSOR_SEP);
+    if (sep == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Invalid cursor [%s]\n", cursor);
+        return EINVAL;
+    }
+
+    name = talloc_strndup(mem_ctx, cursor, sep - cursor);
+    if (name == NULL) {
+        return ENOMEM;
+    }
+
+    dom = find_domain_by_name(domains, name, true);
+    talloc_free(name);
+    if (dom == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unknown domain in cursor [%s]\n", cursor);
+        return ERR_DOMAIN_NOT_FOUND;
+    }
+
+    *_dom = dom;
+    *_after = sep[1] == '\0' ? NULL : sep + 1;
+
+    return EOK;
+}
+
+static const char *ifp_paged_lookup_name(TALLOC_CTX *mem_ctx,
+                                         struct resp_ctx *rctx,
+                                         struct sss_domain_info *dom,
+                                         const char *filter)
+{
+    const char *name;
+
+    name = sss_get_cased_name(mem_ctx, filter, dom->case_sensitive);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    return sss_reverse_replace_space(mem_ctx, name, rctx->override_space);
+}
+
+struct ifp_paged_list_state {
+    struct tevent_context *ev;
+    struct ifp_ctx *ifp_ctx;
+    enum ifp_paged_type type;
+    const char *filter;
+    uint32_t limit;
+    bool single_domain;
+
+    struct sss_domain_info *dom;
+    const char *after;
+    bool refreshed;
+
+    const char **paths;
+    uint32_t count;
+    const char *next_cursor;
+};
+
+static errno_t ifp_paged_list_step(struct tevent_req *req);
+static void ifp_paged_list_dp_done(struct tevent_req *subreq);
+
+struct tevent_req *
+ifp_paged_list_send(TALLOC_CTX *mem_ctx,
+                    struct tevent_context *ev,
+                    struct ifp_ctx *ctx,
+                    enum ifp_paged_type type,
+                    const char *domain,
+                    const char *filter,
+                    const char *cursor,
+                    uint32_t limit)
+{
+    struct ifp_paged_list_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct ifp_paged_list_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->ifp_ctx = ctx;
+    state->type = type;
+    state->filter = filter;
+    state->limit = ifp_paged_limit(ctx, limit);
+    state->single_domain = domain != NULL;
+
+    if (cursor != NULL && cursor[0] != '\0') {
+        ret = ifp_paged_parse_cursor(state, ctx->rctx->domains, cursor,
+                                     &state->dom, &state->after);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (domain != NULL && strcasecmp(state->dom->name, domain) != 0) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cursor [%s] does not belong to "
+                  "domain %s\n", cursor, domain);
+            ret = EINVAL;
+            goto done;
+        }
+    } else if (domain != NULL) {
+        state->dom = find_domain_by_name(ctx->rctx->domains, domain, true);
+        if (state->dom == NULL) {
+            ret = ERR_DOMAIN_NOT_FOUND;
+            goto done;
+        }
+    } else {
+        state->dom = ctx->rctx->domains;
+    }
+
+    state->paths = talloc_zero_array(state, const char *, 1);
+    if (state->paths == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ifp_paged_list_step(req);
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static errno_t ifp_paged_list_read(struct ifp_paged_list_state *state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *names;
+    struct ldb_result *res;
+    const char **paths;
+    const char *lookup_name;
+    const char *name;
+    uint32_t limit;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    lookup_name = ifp_paged_lookup_name(tmp_ctx, state->ifp_ctx->rctx,
+                                        state->dom, state->filter);
+    if (lookup_name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    limit = state->limit - state->count;
+
+    switch (state->type) {
+    case IFP_PAGED_USER:
+        ret = sysdb_enumpwent_filter_names(tmp_ctx, state->dom, lookup_name,
+                                           state->after, limit, &names);
+        if (ret == EOK) {
+            ret = sysdb_enumpwent_read_with_views(tmp_ctx, state->dom,
+                                                  names->msgs, names->count,
+                                                  &res);
+        }
+        break;
+    case IFP_PAGED_GROUP:
+        ret = sysdb_enumgrent_filter_names(tmp_ctx, state->dom, lookup_name,
+                                           state->after, limit, &names);
+        if (ret == EOK) {
+            ret = sysdb_enumgrent_read_with_views(tmp_ctx, state->dom,
+                                                  names->msgs, names->count,
+                                                  &res);
+        }
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to list objects of domain %s "
+              "[%d]: %s\n", state->dom->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    paths = talloc_realloc(state, state->paths, const char *,
+                           state->count + res->count + 1);
+    if (paths == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    state->paths = paths;
+
+    for (i = 0; i < res->count; i++) {
+        /* Filter out entries in the negative cache. */
+        name = sss_get_name_from_msg(state->dom, res->msgs[i]);
+        if (name == NULL) {
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        if (state->type == IFP_PAGED_USER) {
+            ret = sss_ncache_check_user(state->ifp_ctx->rctx->ncache,
+                                        state->dom, name);
+        } else {
+            ret = sss_ncache_check_group(state->ifp_ctx->rctx->ncache,
+                                         state->dom, name);
+        }
+
+        if (ret == EEXIST) {
+            DEBUG(SSSDBG_TRACE_FUNC, "[%s] filtered out! (negative cache)\n",
+                  name);
+            continue;
+        } else if (ret != EOK && ret != ENOENT) {
+            goto done;
+        }
+
+        switch (state->type) {
+        case IFP_PAGED_USER:
+            state->paths[state->count] = ifp_users_build_path_from_msg(
+                                   state->paths, state->dom, res->msgs[i]);
+            break;
+        case IFP_PAGED_GROUP:
+            state->paths[state->count] = ifp_groups_build_path_from_msg(
+                                   state->paths, state->dom, res->msgs[i]);
+            break;
+        }
+        if (state->paths[state->count] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        state->count++;
+    }
+    state->paths[state->count] = NULL;
+
+    if (names->count < limit) {
+        /* This domain is exhausted, continue with the next one. Objects
+         * removed since the names were read do not end the domain early. */
+        state->dom = state->single_domain
+                        ? NULL
+                        : get_next_domain(state->dom, SSS_GND_DESCEND);
+        state->after = NULL;
+        state->refreshed = false;
+        ret = EOK;
+        goto done;
+    }
+
+    name = ldb_msg_find_attr_as_string(names->msgs[names->count - 1],
+                                       SYSDB_NAME, NULL);
+    if (name == NULL) {
+        ret = ERR_INTERNAL;
+        goto done;
+    }
+
+    state->next_cursor = talloc_asprintf(state, "%s%c%s", state->dom->name,
+                                         IFP_PAGED_CURSOR_SEP, name);
+    if (state->next_cursor == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t ifp_paged_list_step(struct tevent_req *req)
+{
+    struct ifp_paged_list_state *state;
+    struct tevent_req *subreq;
+    enum sss_dp_acct_type dp_type;
+    const char *lookup_name;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct ifp_paged_list_state);
+
+    while (state->dom != NULL) {
+        if (state->after == NULL && !state->refreshed
+                && NEED_CHECK_PROVIDER(state->dom->provider)) {
+            /* First page of this domain, refresh the cache. */
+            lookup_name = ifp_paged_lookup_name(state, state->ifp_ctx->rctx,
+                                                state->dom, state->filter);
+            if (lookup_name == NULL) {
+                return ENOMEM;
+            }
+
+            dp_type = state->type == IFP_PAGED_USER ? SSS_DP_WILDCARD_USER
+                                                    : SSS_DP_WILDCARD_GROUP;
+
+            subreq = sss_dp_get_account_send(state, state->ifp_ctx->rctx,
+                                             state->dom, true, dp_type,
+                                             lookup_name, 0, NULL);
+            if (subreq == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+                return ENOMEM;
+            }
+
+            tevent_req_set_callback(subreq, ifp_paged_list_dp_done, req);
+            return EAGAIN;
+        }
+
+        ret = ifp_paged_list_read(state);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (state->next_cursor != NULL) {
+            /* The page is full. */
+            return EOK;
+        }
+    }
+
+    state->next_cursor = talloc_strdup(state, "");
+    if (state->next_cursor == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static void ifp_paged_list_dp_done(struct tevent_req *subreq)
+{
+    struct ifp_paged_list_state *state;
+    struct tevent_req *req;
+    const char *err_msg;
+    uint16_t err_maj;
+    uint32_t err_min;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ifp_paged_list_state);
+
+    ret = sss_dp_get_account_recv(state, subreq, &err_maj, &err_min, &err_msg);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        /* Return what we have in the cache. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to refresh domain %s, "
+              "returning cached data [%d]: %s\n", state->dom->name,
+              ret, sss_strerror(ret));
+    } else if (err_maj != DP_ERR_OK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to refresh domain %s, "
+              "returning cached data [%u]: %s\n", state->dom->name,
+              err_min, err_msg == NULL ? "-" : err_msg);
+    }
+
+    state->refreshed = true;
+
+    ret = ifp_paged_list_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+errno_t
+ifp_paged_list_recv(TALLOC_CTX *mem_ctx,
+                    struct tevent_req *req,
+                    const char ***_paths,
+                    const char **_next_cursor)
+{
+    struct ifp_paged_list_state *state;
+    state = tevent_req_data(req, struct ifp_paged_list_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_paths = talloc_steal(mem_ctx, state->paths);
+    *_next_cursor = talloc_steal(mem_ctx, state->next_cursor);
+
+    return EOK;
+}
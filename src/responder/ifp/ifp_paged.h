@@ -0,0 +1,55 @@
+/*
+    SSSD
+
+    InfoPipe - paged lists of users and groups
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IFP_PAGED_H_
+#define IFP_PAGED_H_
+
+#include "responder/common/responder.h"
+#include "responder/ifp/ifp_private.h"
+
+enum ifp_paged_type {
+    IFP_PAGED_USER,
+    IFP_PAGED_GROUP
+};
+
+/* Return at most @limit objects whose name matches @filter starting at
+ * @cursor. An empty @cursor starts at the first domain, or at @domain if
+ * it is set in which case only this domain is searched.
+ *
+ * The cursor of the next page is returned in @_next_cursor, it is an empty
+ * string when there are no more objects. The data provider is asked to
+ * refresh the matching objects once per domain when the first page of the
+ * domain is requested, all pages are then read from the cache. */
+struct tevent_req *
+ifp_paged_list_send(TALLOC_CTX *mem_ctx,
+                    struct tevent_context *ev,
+                    struct ifp_ctx *ctx,
+                    enum ifp_paged_type type,
+                    const char *domain,
+                    const char *filter,
+                    const char *cursor,
+                    uint32_t limit);
+
+errno_t
+ifp_paged_list_recv(TALLOC_CTX *mem_ctx,
+                    struct tevent_req *req,
+                    const char ***_paths,
+                    const char **_next_cursor);
+
+#endif /* IFP_PAGED_H_ */
@@ -93,6 +93,30 @@ errno_t ifp_add_value_to_dict(DBusMessageIter *iter_dict,
 
 errno_t ifp_add_ldb_el_to_dict(DBusMessageIter *iter_dict,
                                struct ldb_message_element *el);
+
+/* Write @attrs of @msg as a{sv} dictionary, the dictionary is empty if
+ * @msg is NULL. */
+errno_t ifp_write_attrs_dict(DBusMessageIter *iter,
+                             const char **attrs,
+                             struct resp_ctx *rctx,
+                             struct sss_domain_info *domain,
+                             struct ldb_message *msg);
+
+typedef errno_t
+(*ifp_attrs_lookup_fn)(TALLOC_CTX *mem_ctx,
+                       struct ifp_ctx *ifp_ctx,
+                       const char *path,
+                       const char **attrs,
+                       struct sss_domain_info **_domain,
+                       struct ldb_message **_msg);
+
+/* Write @attrs of each object in @paths as aa{sv}, objects that are not
+ * found are represented by an empty dictionary. */
+errno_t ifp_write_objects_attrs(struct ifp_ctx *ifp_ctx,
+                                const char **paths,
+                                const char **attrs,
+                                ifp_attrs_lookup_fn lookup_fn,
+                                DBusMessageIter *iter);
 const char **
 ifp_parse_user_attr_list(TALLOC_CTX *mem_ctx, const char *conf_str);
 
@@ -31,6 +31,7 @@
 #include "responder/ifp/ifp_users.h"
 #include "responder/ifp/ifp_groups.h"
 #include "responder/ifp/ifp_cache.h"
+#include "responder/ifp/ifp_paged.h"
 #include "responder/ifp/ifp_iface/ifp_iface_async.h"
 
 char * ifp_users_build_path_from_msg(TALLOC_CTX *mem_ctx,
@@ -1029,6 +1030,51 @@ ifp_users_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct tevent_req *
+ifp_users_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                  struct tevent_context *ev,
+                                  struct sbus_request *sbus_req,
+                                  struct ifp_ctx *ctx,
+                                  const char *filter,
+                                  const char *cursor,
+                                  uint32_t limit)
+{
+    return ifp_paged_list_send(mem_ctx, ev, ctx, IFP_PAGED_USER, NULL,
+                               filter, cursor, limit);
+}
+
+errno_t
+ifp_users_list_by_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                  struct tevent_req *req,
+                                  const char ***_paths,
+                                  const char **_next_cursor)
+{
+    return ifp_paged_list_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
+struct tevent_req *
+ifp_users_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                             struct tevent_context *ev,
+                                             struct sbus_request *sbus_req,
+                                             struct ifp_ctx *ctx,
+                                             const char *domain,
+                                             const char *filter,
+                                             const char *cursor,
+                                             uint32_t limit)
+{
+    return ifp_paged_list_send(mem_ctx, ev, ctx, IFP_PAGED_USER, domain,
+                               filter, cursor, limit);
+}
+
+errno_t
+ifp_users_list_by_domain_and_name_paged_recv(TALLOC_CTX *mem_ctx,
+                                             struct tevent_req *req,
+                                             const char ***_paths,
+                                             const char **_next_cursor)
+{
+    return ifp_paged_list_recv(mem_ctx, req, _paths, _next_cursor);
+}
+
 static errno_t
 ifp_users_get_from_cache(TALLOC_CTX *mem_ctx,
                          struct sss_domain_info *domain,
@@ -1090,22 +1136,21 @@ done:
 }
 
 static errno_t
-ifp_users_user_get(TALLOC_CTX *mem_ctx,
-                   struct sbus_request *sbus_req,
-                   struct ifp_ctx *ifp_ctx,
-                   struct sss_domain_info **_domain,
-                   struct ldb_message **_user)
+ifp_users_user_get_by_path(TALLOC_CTX *mem_ctx,
+                           struct ifp_ctx *ifp_ctx,
+                           const char *path,
+                           struct sss_domain_info **_domain,
+                           struct ldb_message **_user)
 {
     struct sss_domain_info *domain;
     char *key;
     errno_t ret;
 
-    ret = ifp_users_decompose_path(NULL,
-                                   ifp_ctx->rctx->domains, sbus_req->path,
+    ret = ifp_users_decompose_path(NULL, ifp_ctx->rctx->domains, path,
                                    &domain, &key);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to decompose object path"
-              "[%s] [%d]: %s\n", sbus_req->path, ret, sss_strerror(ret));
+              "[%s] [%d]: %s\n", path, ret, sss_strerror(ret));
         return ret;
     }
 
@@ -1126,6 +1171,128 @@ ifp_users_user_get(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+static errno_t
+ifp_users_user_get(TALLOC_CTX *mem_ctx,
+                   struct sbus_request *sbus_req,
+                   struct ifp_ctx *ifp_ctx,
+                   struct sss_domain_info **_domain,
+                   struct ldb_message **_user)
+{
+    return ifp_users_user_get_by_path(mem_ctx, ifp_ctx, sbus_req->path,
+                                      _domain, _user);
+}
+
+static errno_t
+ifp_users_get_attrs_by_path(TALLOC_CTX *mem_ctx,
+                            struct ifp_ctx *ifp_ctx,
+                            const char *path,
+                            const char **attrs,
+                            struct sss_domain_info **_domain,
+                            struct ldb_message **_user)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_result *res = NULL;
+    char *key;
+    uid_t uid;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = ifp_users_decompose_path(tmp_ctx, ifp_ctx->rctx->domains, path,
+                                   &domain, &key);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to decompose object path"
+              "[%s] [%d]: %s\n", path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* Read only the requested attributes of the object the path points to,
+     * the same key as in ifp_users_get_from_cache() is used. */
+    switch (domain->type) {
+    case DOM_TYPE_POSIX:
+        uid = strtouint32(key, NULL, 10);
+        ret = errno;
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Invalid UID value\n");
+            goto done;
+        }
+
+        ret = sysdb_get_user_attr_by_uid_with_views(tmp_ctx, domain, uid,
+                                                    attrs, &res);
+        break;
+    case DOM_TYPE_APPLICATION:
+        ret = sysdb_get_user_attr_with_views(tmp_ctx, domain, key,
+                                             attrs, &res);
+        break;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to lookup user %s@%s [%d]: %s\n",
+              key, domain->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (res->count == 0) {
+        ret = ENOENT;
+        goto done;
+    } else if (res->count > 1) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "More users matched by the single key\n");
+        ret = EIO;
+        goto done;
+    }
+
+    *_domain = domain;
+    *_user = talloc_steal(mem_ctx, res->msgs[0]);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t
+ifp_users_get_attributes(TALLOC_CTX *mem_ctx,
+                         struct sbus_request *sbus_req,
+                         struct ifp_ctx *ctx,
+                         const char **objects,
+                         const char **attrs,
+                         DBusMessageIter *write_iter)
+{
+    const char **allowed;
+    errno_t ret;
+    int count;
+    int i;
+
+    for (count = 0; attrs != NULL && attrs[count] != NULL; count++);
+
+    allowed = talloc_zero_array(NULL, const char *, count + 1);
+    if (allowed == NULL) {
+        return ENOMEM;
+    }
+
+    /* Apply the same restrictions as to the User object properties. */
+    for (i = 0, count = 0; attrs != NULL && attrs[i] != NULL; i++) {
+        if (!ifp_is_user_attr_allowed(ctx, attrs[i])) {
+            DEBUG(SSSDBG_TRACE_ALL, "Attribute %s is not allowed\n",
+                  attrs[i]);
+            continue;
+        }
+
+        allowed[count] = attrs[i];
+        count++;
+    }
+
+    ret = ifp_write_objects_attrs(ctx, objects, allowed,
+                                  ifp_users_get_attrs_by_path, write_iter);
+    talloc_free(allowed);
+
+    return ret;
+}
+
 static errno_t
 ifp_users_get_as_string(TALLOC_CTX *mem_ctx,
                         struct sbus_request *sbus_req,
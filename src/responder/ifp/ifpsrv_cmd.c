@@ -182,91 +182,6 @@ ifp_user_get_attr_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
-static errno_t
-ifp_get_user_attr_write_reply(DBusMessageIter *iter,
-                              const char **attrs,
-                              struct resp_ctx *rctx,
-                              struct sss_domain_info *domain,
-                              struct ldb_result *res)
-{
-    struct ldb_message_element *el;
-    DBusMessageIter iter_dict;
-    dbus_bool_t dbret;
-    errno_t ret;
-    int ai;
-
-    dbret = dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
-                                      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
-                                      DBUS_TYPE_STRING_AS_STRING
-                                      DBUS_TYPE_VARIANT_AS_STRING
-                                      DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
-                                      &iter_dict);
-    if (!dbret) {
-        return EIO;
-    }
-
-    if (res->count > 0) {
-        ret = ifp_ldb_el_output_name(rctx, res->msgs[0], SYSDB_NAME, domain);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot convert SYSDB_NAME to output format [%d]: %s\n",
-                  ret, sss_strerror(ret));
-            goto done;
-        }
-
-        ret = ifp_ldb_el_output_name(rctx, res->msgs[0], SYSDB_NAME_ALIAS, domain);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot convert SYSDB_NAME_ALIAS to output format [%d]: %s\n",
-                  ret, sss_strerror(ret));
-            goto done;
-        }
-
-        for (ai = 0; attrs != NULL && attrs[ai] != NULL; ai++) {
-            if (strcmp(attrs[ai], "domainname") == 0) {
-                ret = ifp_add_value_to_dict(&iter_dict, "domainname",
-                                            domain->name);
-                if (ret != EOK) {
-                    DEBUG(SSSDBG_MINOR_FAILURE,
-                          "Cannot add attribute domainname to message\n");
-                    continue;
-                }
-            }
-
-            el = sss_view_ldb_msg_find_element(domain, res->msgs[0], attrs[ai]);
-            if (el == NULL || el->num_values == 0) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "Attribute %s not present or has no values\n",
-                      attrs[ai]);
-                continue;
-            }
-
-            ret = ifp_add_ldb_el_to_dict(&iter_dict, el);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "Cannot add attribute %s to message\n",
-                      attrs[ai]);
-                continue;
-            }
-        }
-    }
-
-    dbret = dbus_message_iter_close_container(iter, &iter_dict);
-    if (!dbret) {
-        ret = EIO;
-        goto done;
-    }
-
-    ret = EOK;
-
-done:
-    if (ret != EOK) {
-        dbus_message_iter_abandon_container(iter, &iter_dict);
-    }
-
-    return ret;
-}
-
 struct ifp_get_user_attr_state {
     const char *name;
     const char **attrs;
@@ -350,8 +265,8 @@ static void ifp_get_user_attr_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = ifp_get_user_attr_write_reply(state->write_iter, state->attrs,
-                                        state->rctx, dom, res);
+    ret = ifp_write_attrs_dict(state->write_iter, state->attrs, state->rctx,
+                               dom, res->count > 0 ? res->msgs[0] : NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Unable to construct reply [%d]: %s\n",
               ret, sss_strerror(ret));
@@ -183,6 +183,161 @@ errno_t ifp_add_ldb_el_to_dict(DBusMessageIter *iter_dict,
 }
 
 
+errno_t ifp_write_attrs_dict(DBusMessageIter *iter,
+                             const char **attrs,
+                             struct resp_ctx *rctx,
+                             struct sss_domain_info *domain,
+                             struct ldb_message *msg)
+{
+    struct ldb_message_element *el;
+    DBusMessageIter iter_dict;
+    dbus_bool_t dbret;
+    errno_t ret;
+    int ai;
+
+    dbret = dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+                                      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                      DBUS_TYPE_STRING_AS_STRING
+                                      DBUS_TYPE_VARIANT_AS_STRING
+                                      DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+                                      &iter_dict);
+    if (!dbret) {
+        return EIO;
+    }
+
+    if (msg != NULL) {
+        ret = ifp_ldb_el_output_name(rctx, msg, SYSDB_NAME, domain);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot convert SYSDB_NAME to output format [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+
+        ret = ifp_ldb_el_output_name(rctx, msg, SYSDB_NAME_ALIAS, domain);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot convert SYSDB_NAME_ALIAS to output format [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+
+        for (ai = 0; attrs != NULL && attrs[ai] != NULL; ai++) {
+            if (strcmp(attrs[ai], "domainname") == 0) {
+                ret = ifp_add_value_to_dict(&iter_dict, "domainname",
+                                            domain->name);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_MINOR_FAILURE,
+                          "Cannot add attribute domainname to message\n");
+                    continue;
+                }
+            }
+
+            el = sss_view_ldb_msg_find_element(domain, msg, attrs[ai]);
+            if (el == NULL || el->num_values == 0) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Attribute %s not present or has no values\n",
+                      attrs[ai]);
+                continue;
+            }
+
+            ret = ifp_add_ldb_el_to_dict(&iter_dict, el);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot add attribute %s to message\n",
+                      attrs[ai]);
+                continue;
+            }
+        }
+    }
+
+    dbret = dbus_message_iter_close_container(iter, &iter_dict);
+    if (!dbret) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        dbus_message_iter_abandon_container(iter, &iter_dict);
+    }
+
+    return ret;
+}
+
+errno_t ifp_write_objects_attrs(struct ifp_ctx *ifp_ctx,
+                                const char **paths,
+                                const char **attrs,
+                                ifp_attrs_lookup_fn lookup_fn,
+                                DBusMessageIter *iter)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_message *msg;
+    DBusMessageIter iter_array;
+    dbus_bool_t dbret;
+    errno_t ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dbret = dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+                                      DBUS_TYPE_ARRAY_AS_STRING
+                                      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                      DBUS_TYPE_STRING_AS_STRING
+                                      DBUS_TYPE_VARIANT_AS_STRING
+                                      DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+                                      &iter_array);
+    if (!dbret) {
+        talloc_free(tmp_ctx);
+        return EIO;
+    }
+
+    for (i = 0; paths != NULL && paths[i] != NULL; i++) {
+        domain = NULL;
+        msg = NULL;
+
+        ret = lookup_fn(tmp_ctx, ifp_ctx, paths[i], attrs, &domain, &msg);
+        if (ret == ENOMEM) {
+            goto done;
+        } else if (ret != EOK) {
+            /* Keep the position of the object in the reply. */
+            DEBUG(SSSDBG_TRACE_FUNC, "Unable to get attributes of %s "
+                  "[%d]: %s\n", paths[i], ret, sss_strerror(ret));
+            msg = NULL;
+        }
+
+        ret = ifp_write_attrs_dict(&iter_array, attrs, ifp_ctx->rctx,
+                                   domain, msg);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        talloc_free_children(tmp_ctx);
+    }
+
+    dbret = dbus_message_iter_close_container(iter, &iter_array);
+    if (!dbret) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        dbus_message_iter_abandon_container(iter, &iter_array);
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 bool
 ifp_attr_allowed(const char *whitelist[], const char *attr)
 {
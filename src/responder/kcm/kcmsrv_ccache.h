@@ -389,6 +389,26 @@ errno_t kcm_ccache_to_sec_input_binary(TALLOC_CTX *mem_ctx,
                                        struct kcm_ccache *cc,
                                        struct sss_iobuf **_payload);
 
+/*
+ * Binary representation of the ccache without the credentials, only their
+ * UUIDs are stored. The credentials are stored separately, each in its own
+ * secret, so that adding a credential does not rewrite the whole ccache.
+ */
+errno_t kcm_ccache_to_sec_header_binary(TALLOC_CTX *mem_ctx,
+                                        struct kcm_ccache *cc,
+                                        struct sss_iobuf **_payload);
+
+/*
+ * sec_value is the header created by kcm_ccache_to_sec_header_binary(). The
+ * credentials of the returned ccache contain only UUIDs, their blobs are
+ * NULL and must be filled in by the caller.
+ */
+errno_t sec_header_to_ccache_binary(TALLOC_CTX *mem_ctx,
+                                    const char *sec_key,
+                                    struct sss_iobuf *sec_value,
+                                    struct cli_creds *client,
+                                    struct kcm_ccache **_cc);
+
 errno_t bin_to_krb_data(TALLOC_CTX *mem_ctx,
                         struct sss_iobuf *buf,
                         krb5_data *out);
@@ -141,6 +141,71 @@ done:
     return ret;
 }
 
+static errno_t cred_uuids_to_bin(struct kcm_cred *creds,
+                                 struct sss_iobuf *buf)
+{
+    struct kcm_cred *crd;
+    uint32_t count = 0;
+    errno_t ret;
+
+    DLIST_FOR_EACH(crd, creds) {
+        count++;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    DLIST_FOR_EACH(crd, creds) {
+        ret = sss_iobuf_write_len(buf, (uint8_t *)crd->uuid, sizeof(uuid_t));
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+errno_t kcm_ccache_to_sec_header_binary(TALLOC_CTX *mem_ctx,
+                                        struct kcm_ccache *cc,
+                                        struct sss_iobuf **_payload)
+{
+    struct sss_iobuf *buf;
+    errno_t ret;
+
+    buf = sss_iobuf_init_empty(mem_ctx, sizeof(krb5_principal_data), 0);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_write_int32(buf, cc->kdc_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = princ_to_bin(cc->client, buf);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = cred_uuids_to_bin(cc->creds, buf);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_payload = buf;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(buf);
+    }
+
+    return ret;
+}
+
 errno_t bin_to_krb_data(TALLOC_CTX *mem_ctx,
                         struct sss_iobuf *buf,
                         krb5_data *out)
@@ -223,6 +288,7 @@ static errno_t bin_to_creds(TALLOC_CTX *mem_ctx,
                             struct kcm_cred **_creds)
 {
     struct kcm_cred *creds = NULL;
+    struct kcm_cred *last = NULL;
     struct kcm_cred *crd;
     struct sss_iobuf *cred_blob;
     uint32_t count;
@@ -251,7 +317,9 @@ static errno_t bin_to_creds(TALLOC_CTX *mem_ctx,
             return ENOMEM;
         }
 
-        DLIST_ADD(creds, crd);
+        /* Keep the stored order. */
+        DLIST_ADD_AFTER(creds, crd, last);
+        last = crd;
     }
 
     *_creds = creds;
@@ -306,3 +374,87 @@ done:
 
     return ret;
 }
+
+static errno_t bin_to_cred_uuids(TALLOC_CTX *mem_ctx,
+                                 struct sss_iobuf *buf,
+                                 struct kcm_cred **_creds)
+{
+    struct kcm_cred *creds = NULL;
+    struct kcm_cred *last = NULL;
+    struct kcm_cred *crd;
+    uint32_t count;
+    uuid_t uuid;
+    errno_t ret;
+
+    ret = sss_iobuf_read_uint32(buf, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ret = sss_iobuf_read_len(buf, sizeof(uuid_t), (uint8_t*)uuid);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        crd = kcm_cred_new(mem_ctx, uuid, NULL);
+        if (crd == NULL) {
+            return ENOMEM;
+        }
+
+        DLIST_ADD_AFTER(creds, crd, last);
+        last = crd;
+    }
+
+    *_creds = creds;
+
+    return EOK;
+}
+
+errno_t sec_header_to_ccache_binary(TALLOC_CTX *mem_ctx,
+                                    const char *sec_key,
+                                    struct sss_iobuf *sec_value,
+                                    struct cli_creds *client,
+                                    struct kcm_ccache **_cc)
+{
+    struct kcm_ccache *cc;
+    errno_t ret;
+
+    cc = talloc_zero(mem_ctx, struct kcm_ccache);
+    if (cc == NULL) {
+        return ENOMEM;
+    }
+
+    ret = kcm_cc_set_header(cc, sec_key, client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot store ccache header [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = sss_iobuf_read_int32(sec_value, &cc->kdc_offset);
+    if  (ret != EOK) {
+        goto done;
+    }
+
+    ret = bin_to_princ(cc, sec_value, &cc->client);
+    if  (ret != EOK) {
+        goto done;
+    }
+
+    ret = bin_to_cred_uuids(cc, sec_value, &cc->creds);
+    if  (ret != EOK) {
+        goto done;
+    }
+
+    *_cc = cc;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(cc);
+    }
+
+    return ret;
+}
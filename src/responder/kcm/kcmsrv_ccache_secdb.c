@@ -25,6 +25,8 @@
 #include <stdio.h>
 
 #include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "util/secrets/secrets.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/sss_krb5.h"
@@ -38,6 +40,10 @@
 #define KCM_SECDB_BASE_FMT    KCM_SECDB_URL"/%"SPRIuid"/"
 #define KCM_SECDB_CCACHE_FMT  KCM_SECDB_BASE_FMT"ccache/"
 #define KCM_SECDB_DFL_FMT     KCM_SECDB_BASE_FMT"default"
+#define KCM_SECDB_CREDS_FMT   KCM_SECDB_BASE_FMT"creds/"
+
+/* In KiB */
+#define KCM_SECDB_DFL_CACHE_SIZE 4096
 
 static errno_t sec_get(TALLOC_CTX *mem_ctx,
                        struct sss_sec_req *req,
@@ -94,12 +100,13 @@ done:
 
 static errno_t sec_put(TALLOC_CTX *mem_ctx,
                        struct sss_sec_req *req,
-                       struct sss_iobuf *buf)
+                       struct sss_iobuf *buf,
+                       const char *datatype)
 {
     errno_t ret;
 
     ret = sss_sec_put(req, sss_iobuf_get_data(buf), sss_iobuf_get_size(buf),
-                      SSS_SEC_PLAINTEXT, "binary");
+                      SSS_SEC_PLAINTEXT, datatype);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot write the secret [%d]: %s\n", ret, sss_strerror(ret));
@@ -110,12 +117,13 @@ static errno_t sec_put(TALLOC_CTX *mem_ctx,
 
 static errno_t sec_update(TALLOC_CTX *mem_ctx,
                           struct sss_sec_req *req,
-                          struct sss_iobuf *buf)
+                          struct sss_iobuf *buf,
+                          const char *datatype)
 {
     errno_t ret;
 
     ret = sss_sec_update(req, sss_iobuf_get_data(buf), sss_iobuf_get_size(buf),
-                         SSS_SEC_PLAINTEXT, "binary");
+                         SSS_SEC_PLAINTEXT, datatype);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot write the secret [%d]: %s\n", ret, sss_strerror(ret));
@@ -181,7 +189,7 @@ static errno_t kcm_ccache_to_secdb_kv(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = kcm_ccache_to_sec_input_binary(mem_ctx, cc, &payload);
+    ret = kcm_ccache_to_sec_header_binary(mem_ctx, cc, &payload);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Cannot convert ccache to a secret [%d][%s]\n", ret, sss_strerror(ret));
@@ -197,8 +205,284 @@ done:
     return ret;
 }
 
+/* Recently used ccaches are kept decrypted in memory, together with the list
+ * of ccache keys of their owners, so that clients which iterate over their
+ * credentials do not search and decrypt the secrets on every request.
+ *
+ * The cache is write-through: the database is always written first and the
+ * cache is only updated once the write succeeded. Payloads contain the
+ * credentials, they are wiped from memory whenever they are dropped. */
+
+struct secdb_cache_entry {
+    struct secdb_cache_entry *prev;
+    struct secdb_cache_entry *next;
+    struct secdb_cache *cache;
+
+    char *key;
+    size_t size;
+
+    /* Either the list of ccache keys of a single UID... */
+    char **keys;
+    size_t nkeys;
+
+    /* ...or the decrypted binary payload of a single ccache. */
+    uint8_t *data;
+    size_t len;
+    bool split;
+};
+
+struct secdb_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct secdb_cache_entry *lru;
+    size_t size;
+    size_t max_size;
+};
+
+static int secdb_cache_entry_destructor(struct secdb_cache_entry *entry)
+{
+    DLIST_REMOVE(entry->cache->lru, entry);
+    entry->cache->size -= entry->size;
+
+    if (entry->data != NULL) {
+        sss_erase_mem_securely(entry->data, entry->len);
+    }
+
+    return 0;
+}
+
+static errno_t secdb_cache_init(TALLOC_CTX *mem_ctx,
+                                size_t max_size,
+                                struct secdb_cache **_cache)
+{
+    struct secdb_cache *cache;
+
+    if (max_size == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "KCM ccache cache is disabled\n");
+        *_cache = NULL;
+        return EOK;
+    }
+
+    cache = talloc_zero(mem_ctx, struct secdb_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->max_size = max_size;
+
+    *_cache = cache;
+    return EOK;
+}
+
+/* Key list of a UID is stored under the UID alone, ccache payloads under
+ * the UID and the secdb key of the ccache. */
+static char *secdb_cache_key(TALLOC_CTX *mem_ctx,
+                             uid_t uid,
+                             const char *secdb_key)
+{
+    if (secdb_key == NULL) {
+        return talloc_asprintf(mem_ctx, "%"SPRIuid, uid);
+    }
+
+    return talloc_asprintf(mem_ctx, "%"SPRIuid"/%s", uid, secdb_key);
+}
+
+static struct secdb_cache_entry *secdb_cache_get(struct secdb_cache *cache,
+                                                 uid_t uid,
+                                                 const char *secdb_key)
+{
+    struct secdb_cache_entry *entry;
+    char *key;
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    key = secdb_cache_key(NULL, uid, secdb_key);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key, struct secdb_cache_entry);
+    talloc_free(key);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    DLIST_PROMOTE(cache->lru, entry);
+
+    return entry;
+}
+
+static void secdb_cache_drop(struct secdb_cache *cache,
+                             uid_t uid,
+                             const char *secdb_key)
+{
+    char *key;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    key = secdb_cache_key(NULL, uid, secdb_key);
+    if (key == NULL) {
+        /* We can't tell which entry to drop, so drop everything rather than
+         * serve stale data. */
+        while (cache->lru != NULL) {
+            talloc_free(cache->lru);
+        }
+        return;
+    }
+
+    sss_ptr_hash_delete(cache->table, key, true);
+    talloc_free(key);
+}
+
+static void secdb_cache_add(struct secdb_cache *cache,
+                            struct secdb_cache_entry *entry)
+{
+    struct secdb_cache_entry *last;
+    errno_t ret;
+
+    /* Replace an older entry, if any. */
+    sss_ptr_hash_delete(cache->table, entry->key, true);
+
+    if (entry->size > cache->max_size) {
+        DEBUG(SSSDBG_TRACE_INTERNAL,
+              "[%s] does not fit into the cache\n", entry->key);
+        goto fail;
+    }
+
+    while (cache->size + entry->size > cache->max_size) {
+        for (last = cache->lru; last->next != NULL; last = last->next);
+        talloc_free(last);
+    }
+
+    ret = sss_ptr_hash_add(cache->table, entry->key, entry,
+                           struct secdb_cache_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache [%s] [%d]: %s\n",
+              entry->key, ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    DLIST_ADD(cache->lru, entry);
+    cache->size += entry->size;
+    talloc_set_destructor(entry, secdb_cache_entry_destructor);
+
+    return;
+
+fail:
+    if (entry->data != NULL) {
+        sss_erase_mem_securely(entry->data, entry->len);
+    }
+    talloc_free(entry);
+}
+
+static void secdb_cache_store_keys(struct secdb_cache *cache,
+                                   uid_t uid,
+                                   char **keys,
+                                   size_t nkeys)
+{
+    struct secdb_cache_entry *entry;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    entry = talloc_zero(cache, struct secdb_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->cache = cache;
+    entry->key = secdb_cache_key(entry, uid, NULL);
+    if (entry->key == NULL) {
+        goto fail;
+    }
+
+    entry->keys = talloc_zero_array(entry, char *, nkeys + 1);
+    if (entry->keys == NULL) {
+        goto fail;
+    }
+
+    entry->size = sizeof(struct secdb_cache_entry) + strlen(entry->key) + 1
+                  + (nkeys + 1) * sizeof(char *);
+    for (size_t i = 0; i < nkeys; i++) {
+        entry->keys[i] = talloc_strdup(entry->keys, keys[i]);
+        if (entry->keys[i] == NULL) {
+            goto fail;
+        }
+        entry->size += strlen(keys[i]) + 1;
+    }
+    entry->nkeys = nkeys;
+
+    secdb_cache_add(cache, entry);
+    return;
+
+fail:
+    /* The old list, if any, may be stale now. */
+    talloc_free(entry);
+    secdb_cache_drop(cache, uid, NULL);
+}
+
+static void secdb_cache_store_cc(struct secdb_cache *cache,
+                                 uid_t uid,
+                                 const char *secdb_key,
+                                 struct sss_iobuf *payload,
+                                 bool split)
+{
+    struct secdb_cache_entry *entry;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    entry = talloc_zero(cache, struct secdb_cache_entry);
+    if (entry == NULL) {
+        goto fail;
+    }
+
+    entry->cache = cache;
+    entry->key = secdb_cache_key(entry, uid, secdb_key);
+    if (entry->key == NULL) {
+        goto fail;
+    }
+
+    entry->split = split;
+    entry->len = sss_iobuf_get_size(payload);
+    entry->data = talloc_memdup(entry, sss_iobuf_get_data(payload),
+                                entry->len);
+    if (entry->data == NULL) {
+        goto fail;
+    }
+
+    entry->size = sizeof(struct secdb_cache_entry) + strlen(entry->key) + 1
+                  + entry->len;
+
+    secdb_cache_add(cache, entry);
+    return;
+
+fail:
+    /* The old payload, if any, is stale now. */
+    talloc_free(entry);
+    secdb_cache_drop(cache, uid, secdb_key);
+}
+
 struct ccdb_secdb {
     struct sss_sec_ctx *sctx;
+    struct secdb_cache *cache;
+
+    /* Limit of all credentials of a ccache in bytes, 0 is unlimited. The
+     * secrets quota checks each credential on its own. */
+    size_t max_ccache_size;
 };
 
 /* Since with the synchronous database, the database operations are just
@@ -340,30 +624,472 @@ done:
     return ret;
 }
 
-static errno_t key_by_uuid(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
-                           struct cli_creds *client,
-                           uuid_t uuid,
-                           char **_key)
+/* Credentials of a ccache are stored as separate parts at
+ * KCM_SECDB_CREDS_FMT/<ccache UUID>/<credential UUID> while the ccache secret
+ * itself holds only the header with the list of credential UUIDs. Storing
+ * a credential then writes only the new credential and the small header
+ * instead of the whole ccache. The header is always written last, so
+ * credentials of an interrupted write are never referenced.
+ *
+ * Ccaches stored by older versions as a single secret are converted to this
+ * format the next time they are modified. */
+
+static const char *secdb_creds_url_create(TALLOC_CTX *mem_ctx,
+                                          struct cli_creds *client,
+                                          uuid_t cc_uuid)
+{
+    char uuid_str[UUID_STR_SIZE];
+
+    uuid_unparse(cc_uuid, uuid_str);
+    return talloc_asprintf(mem_ctx, KCM_SECDB_CREDS_FMT"%s/",
+                           cli_creds_get_uid(client), uuid_str);
+}
+
+static const char *secdb_cred_url_create(TALLOC_CTX *mem_ctx,
+                                         struct cli_creds *client,
+                                         uuid_t cc_uuid,
+                                         uuid_t cred_uuid)
+{
+    char cc_uuid_str[UUID_STR_SIZE];
+    char cred_uuid_str[UUID_STR_SIZE];
+
+    uuid_unparse(cc_uuid, cc_uuid_str);
+    uuid_unparse(cred_uuid, cred_uuid_str);
+    return talloc_asprintf(mem_ctx, KCM_SECDB_CREDS_FMT"%s/%s",
+                           cli_creds_get_uid(client),
+                           cc_uuid_str, cred_uuid_str);
+}
+
+static errno_t secdb_creds_container_create(TALLOC_CTX *mem_ctx,
+                                            struct ccdb_secdb *secdb,
+                                            struct cli_creds *client,
+                                            uuid_t cc_uuid)
 {
     TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    const char *urls[3];
     errno_t ret;
-    char *key_match = NULL;
-    char **keys = NULL;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    urls[0] = talloc_asprintf(tmp_ctx, KCM_SECDB_CREDS_FMT,
+                              cli_creds_get_uid(client));
+    urls[1] = secdb_creds_url_create(tmp_ctx, client, cc_uuid);
+    urls[2] = NULL;
+    if (urls[0] == NULL || urls[1] == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (int i = 0; urls[i] != NULL; i++) {
+        ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, urls[i], &sreq);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sss_sec_create_container(sreq);
+        if (ret != EOK && ret != EEXIST) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to create the credentials container [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t secdb_put_cred(TALLOC_CTX *mem_ctx,
+                              struct ccdb_secdb *secdb,
+                              struct cli_creds *client,
+                              uuid_t cc_uuid,
+                              struct kcm_cred *crd)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    const char *url;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    url = secdb_cred_url_create(tmp_ctx, client, cc_uuid, crd->uuid);
+    if (url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, url, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_sec_put(sreq, sss_iobuf_get_data(crd->cred_blob),
+                      sss_iobuf_get_size(crd->cred_blob),
+                      SSS_SEC_PLAINTEXT, SSS_SEC_TYPE_PART);
+    if (ret == EEXIST) {
+        /* Left behind by an interrupted conversion. */
+        ret = sss_sec_update(sreq, sss_iobuf_get_data(crd->cred_blob),
+                             sss_iobuf_get_size(crd->cred_blob),
+                             SSS_SEC_PLAINTEXT, SSS_SEC_TYPE_PART);
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot write the credential [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t secdb_put_creds(TALLOC_CTX *mem_ctx,
+                               struct ccdb_secdb *secdb,
+                               struct cli_creds *client,
+                               struct kcm_ccache *cc)
+{
+    struct kcm_cred *crd;
+    errno_t ret;
+
+    ret = secdb_creds_container_create(mem_ctx, secdb, client, cc->uuid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        ret = secdb_put_cred(mem_ctx, secdb, client, cc->uuid, crd);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t secdb_get_creds(struct ccdb_secdb *secdb,
+                               struct cli_creds *client,
+                               struct kcm_ccache *cc)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    struct kcm_cred *crd;
+    const char *url;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        url = secdb_cred_url_create(tmp_ctx, client, cc->uuid, crd->uuid);
+        if (url == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, url, &sreq);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sec_get(crd, sreq, &crd->cred_blob, NULL);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Credential %s is missing\n", url);
+            ret = EIO;
+            goto done;
+        } else if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t secdb_delete_creds(TALLOC_CTX *mem_ctx,
+                                  struct ccdb_secdb *secdb,
+                                  struct cli_creds *client,
+                                  uuid_t cc_uuid)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *container_req;
+    struct sss_sec_req *sreq;
+    const char *container_url;
+    const char *url;
+    char **keys;
     size_t nkeys;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    container_url = secdb_creds_url_create(tmp_ctx, client, cc_uuid);
+    if (container_url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, container_url,
+                           &container_req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* Delete all parts, including the ones that were never referenced. */
+    ret = sss_sec_list(tmp_ctx, container_req, &keys, &nkeys);
+    if (ret == ENOENT) {
+        nkeys = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    for (size_t i = 0; i < nkeys; i++) {
+        url = talloc_asprintf(tmp_ctx, "%s%s", container_url, keys[i]);
+        if (url == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, url, &sreq);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sss_sec_delete(sreq);
+        if (ret != EOK && ret != ENOENT) {
+            goto done;
+        }
+    }
+
+    ret = sss_sec_delete(container_req);
+    if (ret == ENOENT) {
+        /* The ccache was never converted. */
+        ret = EOK;
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Removes the credentials container of the user once the last ccache is
+ * gone, ENOENT and EEXIST (leftovers of other ccaches) are not errors. */
+static errno_t secdb_creds_container_delete(TALLOC_CTX *mem_ctx,
+                                            struct ccdb_secdb *secdb,
+                                            struct cli_creds *client)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_sec_req *sreq;
+    const char *url;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    url = talloc_asprintf(tmp_ctx, KCM_SECDB_CREDS_FMT,
+                          cli_creds_get_uid(client));
+    if (url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = secdb_cc_url_req(tmp_ctx, secdb->sctx, client, url, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_sec_delete(sreq);
+    if (ret == ENOENT || ret == EEXIST) {
+        ret = EOK;
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static size_t secdb_creds_size(struct kcm_ccache *cc)
+{
+    struct kcm_cred *crd;
+    size_t size = 0;
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        size += sss_iobuf_get_size(crd->cred_blob);
+    }
+
+    return size;
+}
+
+/* Writes @new_cred, or all credentials if the ccache is not stored in the
+ * split format yet, followed by the header. */
+static errno_t secdb_write_cc(TALLOC_CTX *mem_ctx,
+                              struct ccdb_secdb *secdb,
+                              struct cli_creds *client,
+                              const char *secdb_key,
+                              struct kcm_ccache *cc,
+                              bool split,
+                              struct kcm_cred *new_cred)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_iobuf *header;
+    struct sss_iobuf *payload;
+    struct sss_sec_req *sreq;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = kcm_ccache_to_sec_header_binary(tmp_ctx, cc, &header);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (!split) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Converting ccache %s to the split format\n", cc->name);
+        ret = secdb_put_creds(tmp_ctx, secdb, client, cc);
+    } else if (new_cred != NULL) {
+        ret = secdb_put_cred(tmp_ctx, secdb, client, cc->uuid, new_cred);
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = secdb_cc_key_req(tmp_ctx, secdb->sctx, client, secdb_key, &sreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sec_update(tmp_ctx, sreq, header, SSS_SEC_TYPE_HEADER);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = kcm_ccache_to_sec_input_binary(tmp_ctx, cc, &payload);
+    if (ret != EOK) {
+        /* The stored ccache is fine, only the cached copy is stale. */
+        secdb_cache_drop(secdb->cache, cli_creds_get_uid(client), secdb_key);
+        ret = EOK;
+        goto done;
+    }
+
+    secdb_cache_store_cc(secdb->cache, cli_creds_get_uid(client),
+                         secdb_key, payload, true);
+    sss_erase_mem_securely(sss_iobuf_get_data(payload),
+                           sss_iobuf_get_size(payload));
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Returns ENOENT if the container of the user does not exist. */
+static errno_t secdb_list_keys(TALLOC_CTX *mem_ctx,
+                               struct ccdb_secdb *secdb,
+                               struct cli_creds *client,
+                               char ***_keys,
+                               size_t *_nkeys)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct secdb_cache_entry *entry;
     struct sss_sec_req *sreq = NULL;
+    char **keys = NULL;
+    size_t nkeys;
+    errno_t ret;
 
     tmp_ctx = talloc_new(mem_ctx);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
+    entry = secdb_cache_get(secdb->cache, cli_creds_get_uid(client), NULL);
+    if (entry != NULL) {
+        keys = talloc_zero_array(tmp_ctx, char *, entry->nkeys + 1);
+        if (keys == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (nkeys = 0; nkeys < entry->nkeys; nkeys++) {
+            keys[nkeys] = talloc_strdup(keys, entry->keys[nkeys]);
+            if (keys[nkeys] == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Using cached list of keys\n");
+        ret = EOK;
+        goto done;
+    }
+
+    ret = secdb_container_url_req(tmp_ctx, secdb->sctx, client, &sreq);
     if (ret != EOK) {
         goto done;
     }
 
     ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    secdb_cache_store_keys(secdb->cache, cli_creds_get_uid(client),
+                           keys, nkeys);
+
+    ret = EOK;
+
+done:
+    if (ret == EOK) {
+        *_keys = talloc_steal(mem_ctx, keys);
+        *_nkeys = nkeys;
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t key_by_uuid(TALLOC_CTX *mem_ctx,
+                           struct ccdb_secdb *secdb,
+                           struct cli_creds *client,
+                           uuid_t uuid,
+                           char **_key)
+{
+    TALLOC_CTX *tmp_ctx;
+    errno_t ret;
+    char *key_match = NULL;
+    char **keys = NULL;
+    size_t nkeys;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = secdb_list_keys(tmp_ctx, secdb, client, &keys, &nkeys);
     if (ret == ENOENT) {
         DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
         goto done;
@@ -393,7 +1119,7 @@ done:
 }
 
 static errno_t key_by_name(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
+                           struct ccdb_secdb *secdb,
                            struct cli_creds *client,
                            const char *name,
                            char **_key)
@@ -403,19 +1129,13 @@ static errno_t key_by_name(TALLOC_CTX *mem_ctx,
     char *key_match = NULL;
     char **keys = NULL;
     size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
 
     tmp_ctx = talloc_new(mem_ctx);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
-    if (ret != EOK) {
-        goto done;
-    }
-
-    ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
+    ret = secdb_list_keys(tmp_ctx, secdb, client, &keys, &nkeys);
     if (ret == ENOENT) {
         DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
         goto done;
@@ -444,25 +1164,53 @@ done:
     return ret;
 }
 
+/* _split is set to false if the ccache is still stored as a single secret. */
 static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
-                            struct sss_sec_ctx *sctx,
+                            struct ccdb_secdb *secdb,
                             const char *secdb_key,
                             struct cli_creds *client,
-                            struct kcm_ccache **_cc)
+                            struct kcm_ccache **_cc,
+                            bool *_split)
 {
     errno_t ret;
     TALLOC_CTX *tmp_ctx = NULL;
     struct kcm_ccache *cc = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct secdb_cache_entry *entry;
     struct sss_iobuf *ccbuf;
+    struct sss_iobuf *payload;
     char *datatype;
+    bool split;
 
     tmp_ctx = talloc_new(mem_ctx);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_cc_key_req(tmp_ctx, sctx, client, secdb_key, &sreq);
+    entry = secdb_cache_get(secdb->cache, cli_creds_get_uid(client),
+                            secdb_key);
+    if (entry != NULL) {
+        ccbuf = sss_iobuf_init_readonly(tmp_ctx, entry->data, entry->len);
+        if (ccbuf == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sec_kv_to_ccache_binary(tmp_ctx, secdb_key, ccbuf, client, &cc);
+        sss_erase_mem_securely(sss_iobuf_get_data(ccbuf),
+                               sss_iobuf_get_size(ccbuf));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot convert cached data to ccache "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            goto done;
+        }
+
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache from cache\n");
+        split = entry->split;
+        goto fetched;
+    }
+
+    ret = secdb_cc_key_req(tmp_ctx, secdb->sctx, client, secdb_key, &sreq);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot create secdb request [%d][%s]\n", ret, sss_strerror(ret));
@@ -476,7 +1224,15 @@ static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    if (strcmp(datatype, "binary") == 0) {
+    split = false;
+    if (strcmp(datatype, SSS_SEC_TYPE_HEADER) == 0) {
+        split = true;
+        ret = sec_header_to_ccache_binary(tmp_ctx, secdb_key, ccbuf,
+                                          client, &cc);
+        if (ret == EOK) {
+            ret = secdb_get_creds(secdb, client, cc);
+        }
+    } else if (strcmp(datatype, "binary") == 0) {
         ret = sec_kv_to_ccache_binary(tmp_ctx, secdb_key, ccbuf, client, &cc);
     } else {
         ret = sec_kv_to_ccache_json(tmp_ctx, secdb_key,
@@ -489,9 +1245,33 @@ static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = EOK;
+    /* The cache always holds the whole ccache in the binary format. Ccaches
+     * in the old JSON format are cached once they are converted. */
+    payload = NULL;
+    if (secdb->cache != NULL && split) {
+        ret = kcm_ccache_to_sec_input_binary(tmp_ctx, cc, &payload);
+        if (ret != EOK) {
+            payload = NULL;
+        }
+    } else if (secdb->cache != NULL && strcmp(datatype, "binary") == 0) {
+        payload = ccbuf;
+    }
+
+    if (payload != NULL) {
+        secdb_cache_store_cc(secdb->cache, cli_creds_get_uid(client),
+                             secdb_key, payload, split);
+        sss_erase_mem_securely(sss_iobuf_get_data(payload),
+                               sss_iobuf_get_size(payload));
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache\n");
+
+fetched:
+    ret = EOK;
     *_cc = talloc_steal(mem_ctx, cc);
+    if (_split != NULL) {
+        *_split = split;
+    }
 done:
     talloc_free(tmp_ctx);
     return ret;
@@ -503,6 +1283,7 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
 {
     struct ccdb_secdb *secdb = NULL;
     errno_t ret;
+    int cache_size;
     struct sss_sec_hive_config **kcm_section_quota;
     struct sss_sec_quota_opt dfl_kcm_nest_level = {
         .opt_name = CONFDB_SEC_CONTAINERS_NEST_LEVEL,
@@ -576,6 +1357,30 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
         return ret;
     }
 
+    if (kcm_section_quota[0]->quota.max_payload_size > 0) {
+        secdb->max_ccache_size =
+                (size_t) kcm_section_quota[0]->quota.max_payload_size * 1024;
+    }
+
+    ret = confdb_get_int(cdb, confdb_service_path, CONFDB_KCM_CCACHE_CACHE_SIZE,
+                         KCM_SECDB_DFL_CACHE_SIZE, &cache_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get the ccache cache size [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(secdb);
+        return ret;
+    }
+
+    ret = secdb_cache_init(secdb,
+                           cache_size > 0 ? (size_t) cache_size * 1024 : 0,
+                           &secdb->cache);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot initialize the ccache cache\n");
+        talloc_free(secdb);
+        return ret;
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "secdb initialized\n");
     db->db_handle = secdb;
     return EOK;
@@ -607,7 +1412,6 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
     const int maxtries = 3;
     int numtry;
     errno_t ret;
-    struct sss_sec_req *sreq = NULL;
     char **keys = NULL;
     size_t nkeys;
     char *nextid_name = NULL;
@@ -625,12 +1429,7 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
+    ret = secdb_list_keys(state, secdb, client, &keys, &nkeys);
     if (ret == ENOENT) {
         keys = NULL;
         nkeys = 0;
@@ -725,9 +1524,9 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
 
     ret = sss_sec_get(state, sreq, (uint8_t**)&cur_default, NULL, NULL);
     if (ret == ENOENT) {
-        ret = sec_put(state, sreq, iobuf);
+        ret = sec_put(state, sreq, iobuf, "binary");
     } else if (ret == EOK) {
-        ret = sec_update(state, sreq, iobuf);
+        ret = sec_update(state, sreq, iobuf, "binary");
     }
 
     if (ret != EOK) {
@@ -900,7 +1699,7 @@ static errno_t ccdb_secdb_get_cc_for_uuid(TALLOC_CTX *mem_ctx,
         cli_cred.ucred.uid = pwd->pw_uid;
         cli_cred.ucred.gid = pwd->pw_gid;
 
-        ret = key_by_uuid(tmp_ctx, secdb->sctx, &cli_cred, uuid, &secdb_key);
+        ret = key_by_uuid(tmp_ctx, secdb, &cli_cred, uuid, &secdb_key);
         if (ret == ENOENT) {
             ret = EOK;
             goto done;
@@ -908,8 +1707,8 @@ static errno_t ccdb_secdb_get_cc_for_uuid(TALLOC_CTX *mem_ctx,
             goto done;
         }
 
-        ret = secdb_get_cc(cc_list, secdb->sctx, secdb_key, &cli_cred,
-                           &cc_list[real_count]);
+        ret = secdb_get_cc(cc_list, secdb, secdb_key, &cli_cred,
+                           &cc_list[real_count], NULL);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Failed to get ccache [%d]: %s\n",
                                        ret, sss_strerror(ret));
@@ -1007,7 +1806,6 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     char **keys = NULL;
     size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Listing all ccaches\n");
 
@@ -1016,12 +1814,7 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
+    ret = secdb_list_keys(state, secdb, client, &keys, &nkeys);
     if (ret == ENOENT) {
         nkeys = 0;
         /* Fall through and return an empty list */
@@ -1093,7 +1886,7 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -1102,7 +1895,7 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
+    ret = secdb_get_cc(state, secdb, secdb_key, client, &state->cc, NULL);
     if (ret != EOK) {
         goto immediate;
     }
@@ -1154,7 +1947,7 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &secdb_key);
+    ret = key_by_name(state, secdb, client, name, &secdb_key);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -1163,7 +1956,7 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
+    ret = secdb_get_cc(state, secdb, secdb_key, client, &state->cc, NULL);
     if (ret != EOK) {
         goto immediate;
     }
@@ -1217,7 +2010,7 @@ struct tevent_req *ccdb_secdb_name_by_uuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &key);
+    ret = key_by_uuid(state, secdb, client, uuid, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1284,7 +2077,7 @@ struct tevent_req *ccdb_secdb_uuid_by_name_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &key);
+    ret = key_by_name(state, secdb, client, name, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1370,18 +2163,32 @@ static struct tevent_req *ccdb_secdb_create_send(TALLOC_CTX *mem_ctx,
     }
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "ccache container created\n");
-    DEBUG(SSSDBG_TRACE_INTERNAL, "creating empty ccache payload\n");
+
+    /* This also creates the credentials container, so storing a credential
+     * later needs only a single write. */
+    ret = secdb_put_creds(state, secdb, client, cc);
+    if (ret != EOK) {
+        goto immediate;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "creating ccache header\n");
 
     ret = secdb_cc_url_req(state, secdb->sctx, client, url, &ccache_req);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = sec_put(state, ccache_req, ccache_payload);
+    ret = sec_put(state, ccache_req, ccache_payload, SSS_SEC_TYPE_HEADER);
     if (ret != EOK) {
+        /* Do not leave unreferenced credentials behind. */
+        secdb_delete_creds(state, secdb, client, cc->uuid);
         goto immediate;
     }
 
+    /* The list of keys changed, the payload itself is cached once it is
+     * read for the first time. */
+    secdb_cache_drop(secdb->cache, cli_creds_get_uid(client), NULL);
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "payload created\n");
     ret = EOK;
 immediate:
@@ -1413,8 +2220,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     char *secdb_key = NULL;
     struct kcm_ccache *cc = NULL;
-    struct sss_iobuf *payload = NULL;
-    struct sss_sec_req *sreq = NULL;
+    bool split;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Modifying ccache\n");
 
@@ -1423,7 +2229,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1431,7 +2237,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
+    ret = secdb_get_cc(state, secdb, secdb_key, client, &cc, &split);
     if (ret != EOK) {
         goto immediate;
     }
@@ -1444,17 +2250,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_ccache_to_sec_input_binary(state, cc, &payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sec_update(state, sreq, payload);
+    ret = secdb_write_cc(state, secdb, client, secdb_key, cc, split, NULL);
     if (ret != EOK) {
         goto immediate;
     }
@@ -1488,8 +2284,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb_state *state = NULL;
     char *secdb_key = NULL;
     struct kcm_ccache *cc = NULL;
-    struct sss_iobuf *payload = NULL;
-    struct sss_sec_req *sreq = NULL;
+    bool split;
     errno_t ret;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Storing creds in ccache\n");
@@ -1499,7 +2294,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1507,30 +2302,32 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
+    ret = secdb_get_cc(state, secdb, secdb_key, client, &cc, &split);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = kcm_cc_store_cred_blob(cc, cred_blob);
-    if (ret != EOK) {
+    if (secdb->max_ccache_size > 0
+            && secdb_creds_size(cc) + sss_iobuf_get_size(cred_blob)
+                    > secdb->max_ccache_size) {
         DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot store credentials to ccache [%d]: %s\n",
-              ret, sss_strerror(ret));
+              "Storing the credential would exceed the maximum ccache size "
+              "of %zu bytes\n", secdb->max_ccache_size);
+        ret = ERR_SEC_PAYLOAD_SIZE_IS_TOO_LARGE;
         goto immediate;
     }
 
-    ret = kcm_ccache_to_sec_input_binary(state, cc, &payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
+    ret = kcm_cc_store_cred_blob(cc, cred_blob);
     if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot store credentials to ccache [%d]: %s\n",
+              ret, sss_strerror(ret));
         goto immediate;
     }
 
-    ret = sec_update(state, sreq, payload);
+    /* kcm_cc_store_cred_blob() adds the new credential to the head. */
+    ret = secdb_write_cc(state, secdb, client, secdb_key, cc, split,
+                         kcm_cc_get_cred(cc));
     if (ret != EOK) {
         goto immediate;
     }
@@ -1580,7 +2377,7 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = sss_sec_list(state, container_req, &keys, &nkeys);
+    ret = secdb_list_keys(state, secdb, client, &keys, &nkeys);
     if (ret != EOK) {
         DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
         goto immediate;
@@ -1592,7 +2389,7 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1610,6 +2407,18 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    secdb_cache_drop(secdb->cache, cli_creds_get_uid(client), secdb_key);
+    secdb_cache_drop(secdb->cache, cli_creds_get_uid(client), NULL);
+
+    /* The header is gone so the credentials are not reachable anymore,
+     * failing to remove them only wastes space. */
+    ret = secdb_delete_creds(state, secdb, client, uuid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot remove credentials of the ccache [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
     if (nkeys > 1) {
         DEBUG(SSSDBG_TRACE_INTERNAL, "There are other ccaches, done\n");
         ret = EOK;
@@ -1622,6 +2431,13 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    ret = secdb_creds_container_delete(state, secdb, client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot remove the credentials container [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
     ret = EOK;
 immediate:
     if (ret == EOK) {
@@ -27,6 +27,8 @@ struct kcm_ops_queue_entry {
     struct tevent_req *req;
 
     struct kcm_ops_queue *queue;
+    bool readonly;
+    bool running;
 
     struct kcm_ops_queue_entry *next;
     struct kcm_ops_queue_entry *prev;
@@ -38,6 +40,8 @@ struct kcm_ops_queue {
     struct kcm_ops_queue_ctx *qctx;
 
     struct kcm_ops_queue_entry *head;
+    /* Number of queued or running operations that modify the ccaches. */
+    unsigned int num_writers;
 };
 
 struct kcm_ops_queue_ctx {
@@ -54,6 +58,11 @@ struct kcm_ops_queue_ctx {
  * hash table entry is kcm_ops_queue structure which in turn contains a
  * linked list of kcm_ops_queue_entry structures * which primarily hold the
  * tevent request being queued.
+ *
+ * Read-only operations at the head of the queue run concurrently. An
+ * operation that modifies the ccaches waits until all operations queued
+ * before it are finished and blocks all operations queued after it, so
+ * the writes are exclusive and ordered with respect to the reads.
  */
 struct kcm_ops_queue_ctx *kcm_ops_queue_create(TALLOC_CTX *mem_ctx,
                                                struct kcm_ctx *kctx)
@@ -116,9 +125,36 @@ void queue_removal_cb(struct tevent_context *ctx,
     talloc_free(kq);
 }
 
+static void kcm_op_queue_dispatch(struct kcm_ops_queue *kq)
+{
+    struct kcm_ops_queue_entry *entry;
+
+    DLIST_FOR_EACH(entry, kq->head) {
+        if (!entry->readonly && entry != kq->head) {
+            /* Wait for the operations in front of the writer. */
+            break;
+        }
+
+        if (!entry->running) {
+            DEBUG(SSSDBG_TRACE_LIBS, "Running the next %s request\n",
+                  entry->readonly ? "read-only" : "read-write");
+
+            /* Mark the request as done to run it. The callback is deferred
+             * because it may free other entries of the queue. */
+            entry->running = true;
+            tevent_req_defer_callback(entry->req, kq->ev);
+            tevent_req_done(entry->req);
+        }
+
+        if (!entry->readonly) {
+            /* A writer runs alone. */
+            break;
+        }
+    }
+}
+
 static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
 {
-    struct kcm_ops_queue_entry *next_entry;
     struct tevent_immediate *imm;
 
     if (entry == NULL) {
@@ -128,13 +164,14 @@ static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
         return 0;
     }
 
-    /* Take the next entry from the queue */
-    next_entry = entry->next;
+    if (!entry->readonly) {
+        entry->queue->num_writers--;
+    }
 
     /* Remove the current entry from the queue */
     DLIST_REMOVE(entry->queue->head, entry);
 
-    if (next_entry == NULL) {
+    if (entry->queue->head == NULL) {
         /* If there was no other entry, schedule removal of the queue. Do it
          * in another tevent tick to avoid issues with callbacks invoking
          * the destructor while another request is touching the queue
@@ -148,8 +185,8 @@ static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
         return 0;
     }
 
-    /* Otherwise, mark the current head as done to run the next request */
-    tevent_req_done(next_entry->req);
+    /* Otherwise, run the requests that are not blocked anymore */
+    kcm_op_queue_dispatch(entry->queue);
     return 0;
 }
 
@@ -220,22 +257,33 @@ struct kcm_op_queue_state {
 };
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req);
+                                    struct tevent_req *req,
+                                    bool readonly);
+
+static int kcm_op_queue_state_destructor(struct kcm_op_queue_state *state)
+{
+    /* The request was freed before the caller received the entry, remove
+     * the entry from the queue so it does not block the others. */
+    talloc_zfree(state->entry);
+    return 0;
+}
 
 /*
  * Enqueue a request.
  *
- * If the request queue /for the given ID/ is empty, that is, if this
- * request is the first one in the queue, run the request immediately.
+ * If the request queue /for the given ID/ is empty or if the request is
+ * read-only and there are only read-only requests in the queue, run the
+ * request immediately.
  *
- * Otherwise just add it to the queue and wait until the previous request
- * finishes and only at that point mark the current request as done, which
+ * Otherwise just add it to the queue and wait until the requests that block
+ * it finish and only at that point mark the current request as done, which
  * will trigger calling the recv function and allow the request to continue.
  */
 struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
                                      struct tevent_context *ev,
                                      struct kcm_ops_queue_ctx *qctx,
-                                     struct cli_creds *client)
+                                     struct cli_creds *client,
+                                     bool readonly)
 {
     errno_t ret;
     struct tevent_req *req;
@@ -261,10 +309,10 @@ struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_op_queue_add_req(kq, req);
+    ret = kcm_op_queue_add_req(kq, req, readonly);
     if (ret == EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
-              "Queue was empty, running the request immediately\n");
+              "Nothing blocks the request, running it immediately\n");
         goto immediate;
     } else if (ret != EAGAIN) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -286,7 +334,8 @@ immediate:
 }
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req)
+                                    struct tevent_req *req,
+                                    bool readonly)
 {
     errno_t ret;
     struct kcm_op_queue_state *state = tevent_req_data(req,
@@ -298,16 +347,23 @@ static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
     }
     state->entry->req = req;
     state->entry->queue = kq;
+    state->entry->readonly = readonly;
     talloc_set_destructor(state->entry, kcm_op_queue_entry_destructor);
+    talloc_set_destructor(state, kcm_op_queue_state_destructor);
 
-    if (kq->head == NULL) {
-        /* First entry, will run callback at once */
+    if (kq->head == NULL || (readonly && kq->num_writers == 0)) {
+        /* Nothing to wait for, will run callback at once */
+        state->entry->running = true;
         ret = EOK;
     } else {
         /* Will wait for the previous callbacks to finish */
         ret = EAGAIN;
     }
 
+    if (!readonly) {
+        kq->num_writers++;
+    }
+
     DLIST_ADD_END(kq->head, state->entry, struct kcm_ops_queue_entry *);
     return ret;
 }
@@ -328,5 +384,6 @@ errno_t kcm_op_queue_recv(struct tevent_req *req,
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
     *_entry = talloc_steal(mem_ctx, state->entry);
+    state->entry = NULL;
     return EOK;
 }
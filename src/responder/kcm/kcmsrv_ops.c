@@ -68,6 +68,9 @@ struct kcm_op {
     const char *name;
     kcm_srv_send_method fn_send;
     kcm_srv_recv_method fn_recv;
+    /* The operation does not modify any ccache and can run concurrently
+     * with other read-only operations of the same user. */
+    bool readonly;
 };
 
 struct kcm_cmd_state {
@@ -166,7 +169,7 @@ struct tevent_req *kcm_cmd_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    subreq = kcm_op_queue_send(state, ev, qctx, client);
+    subreq = kcm_op_queue_send(state, ev, qctx, client, op->readonly);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto immediate;
@@ -2383,45 +2386,45 @@ done:
 }
 
 static struct kcm_op kcm_optable[] = {
-    { "NOOP",                NULL, NULL },
-    { "GET_NAME",            NULL, NULL },
-    { "RESOLVE",             NULL, NULL },
-    { "GEN_NEW",             kcm_op_gen_new_send, NULL },
-    { "INITIALIZE",          kcm_op_initialize_send, kcm_op_initialize_recv },
-    { "DESTROY",             kcm_op_destroy_send, NULL },
-    { "STORE",               kcm_op_store_send, kcm_op_store_recv },
-    { "RETRIEVE",            NULL, NULL },
-    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL },
-    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL },
-    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, kcm_op_get_cred_by_uuid_recv },
-    { "REMOVE_CRED",         kcm_op_remove_cred_send, NULL },
-    { "SET_FLAGS",           NULL, NULL },
-    { "CHOWN",               NULL, NULL },
-    { "CHMOD",               NULL, NULL },
-    { "GET_INITIAL_TICKET",  NULL, NULL },
-    { "GET_TICKET",          NULL, NULL },
-    { "MOVE_CACHE",          NULL, NULL },
-    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL },
-    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL },
-    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv },
-    { "SET_DEFAULT_CACHE",   kcm_op_set_default_ccache_send, kcm_op_set_default_ccache_recv },
-    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL },
-    { "SET_KDC_OFFSET",      kcm_op_set_kdc_offset_send, kcm_op_set_kdc_offset_recv },
-    { "ADD_NTLM_CRED",       NULL, NULL },
-    { "HAVE_NTLM_CRED",      NULL, NULL },
-    { "DEL_NTLM_CRED",       NULL, NULL },
-    { "DO_NTLM_AUTH",        NULL, NULL },
-    { "GET_NTLM_USER_LIST",  NULL, NULL },
-
-    { NULL, NULL, NULL }
+    { "NOOP",                NULL, NULL, false },
+    { "GET_NAME",            NULL, NULL, false },
+    { "RESOLVE",             NULL, NULL, false },
+    { "GEN_NEW",             kcm_op_gen_new_send, NULL, false },
+    { "INITIALIZE",          kcm_op_initialize_send, kcm_op_initialize_recv, false },
+    { "DESTROY",             kcm_op_destroy_send, NULL, false },
+    { "STORE",               kcm_op_store_send, kcm_op_store_recv, false },
+    { "RETRIEVE",            NULL, NULL, false },
+    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL, true },
+    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL, true },
+    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, kcm_op_get_cred_by_uuid_recv, true },
+    { "REMOVE_CRED",         kcm_op_remove_cred_send, NULL, false },
+    { "SET_FLAGS",           NULL, NULL, false },
+    { "CHOWN",               NULL, NULL, false },
+    { "CHMOD",               NULL, NULL, false },
+    { "GET_INITIAL_TICKET",  NULL, NULL, false },
+    { "GET_TICKET",          NULL, NULL, false },
+    { "MOVE_CACHE",          NULL, NULL, false },
+    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL, true },
+    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL, true },
+    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv, true },
+    { "SET_DEFAULT_CACHE",   kcm_op_set_default_ccache_send, kcm_op_set_default_ccache_recv, false },
+    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL, true },
+    { "SET_KDC_OFFSET",      kcm_op_set_kdc_offset_send, kcm_op_set_kdc_offset_recv, false },
+    { "ADD_NTLM_CRED",       NULL, NULL, false },
+    { "HAVE_NTLM_CRED",      NULL, NULL, false },
+    { "DEL_NTLM_CRED",       NULL, NULL, false },
+    { "DO_NTLM_AUTH",        NULL, NULL, false },
+    { "GET_NTLM_USER_LIST",  NULL, NULL, false },
+
+    { NULL, NULL, NULL, false }
 };
 
 /* MIT EXTENSIONS, see private header src/include/kcm.h in krb5 sources */
 #define KCM_MIT_OFFSET 13001
 static struct kcm_op kcm_mit_optable[] = {
-    { "GET_CRED_LIST", kcm_op_get_cred_list_send, NULL },
+    { "GET_CRED_LIST", kcm_op_get_cred_list_send, NULL, true },
 
-    { NULL, NULL, NULL }
+    { NULL, NULL, NULL, false }
 };
 
 struct kcm_op *kcm_get_opt(uint16_t opcode)
@@ -105,6 +105,16 @@ static errno_t nss_getby_name(struct cli_ctx *cli_ctx,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Input name: %s\n", rawname);
 
+    if (memcache != SSS_MC_NONE && attrs == NULL && cmd_ctx->flags == 0) {
+        ret = nss_reply_cache_lookup(cmd_ctx->nss_ctx->reply_cache, cmd_ctx,
+                                     rawname, 0);
+        if (ret == EOK) {
+            talloc_free(cmd_ctx);
+            return nss_protocol_done(cli_ctx, EOK);
+        }
+        cmd_ctx->cache_reply = true;
+    }
+
     data = cache_req_data_name_attrs(cmd_ctx, type, rawname, attrs);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
@@ -118,6 +128,11 @@ static errno_t nss_getby_name(struct cli_ctx *cli_ctx,
         goto done;
     }
 
+    if (fill_fn == nss_protocol_fill_initgr) {
+        /* Only the group IDs are put into the reply. */
+        cache_req_data_set_initgr_gids_only(data, true);
+    }
+
     subreq = nss_get_object_send(cmd_ctx, cli_ctx->ev, cli_ctx,
                                  data, memcache, rawname, 0);
     if (subreq == NULL) {
@@ -171,6 +186,17 @@ static errno_t nss_getby_id(struct cli_ctx *cli_ctx,
     DEBUG(SSSDBG_TRACE_FUNC, "Input ID: %u (looking up '%s')\n", id,
           (fill_fn == nss_protocol_fill_sid) ? "SID" : "POSIX data");
 
+    if (memcache != SSS_MC_NONE && attrs == NULL && cmd_ctx->flags == 0) {
+        ret = nss_reply_cache_lookup(cmd_ctx->nss_ctx->reply_cache, cmd_ctx,
+                                     NULL, id);
+        if (ret == EOK) {
+            talloc_free(cmd_ctx);
+            return nss_protocol_done(cli_ctx, EOK);
+        }
+        cmd_ctx->cache_reply = true;
+        cmd_ctx->input_id = id;
+    }
+
     data = cache_req_data_id_attrs(cmd_ctx, type, id, attrs);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
@@ -553,6 +579,8 @@ static errno_t invalidate_cache(struct nss_cmd_ctx *cmd_ctx,
 
     memcache_delete_entry(cmd_ctx->nss_ctx, cmd_ctx->nss_ctx->rctx, NULL,
                           output_name, 0, memcache_type);
+    nss_reply_cache_invalidate(cmd_ctx->nss_ctx->reply_cache, memcache_type,
+                               output_name, 0);
     if (memcache_type == SSS_MC_INITGROUPS) {
         /* Invalidate the passwd data as well */
         memcache_delete_entry(cmd_ctx->nss_ctx, cmd_ctx->nss_ctx->rctx,
@@ -715,30 +743,6 @@ done:
     return ret;
 }
 
-static struct cache_req_result *
-nss_getent_get_result(struct nss_enum_ctx *enum_ctx,
-                      struct nss_enum_index *idx)
-{
-    struct cache_req_result *result;
-
-    if (enum_ctx->result == NULL) {
-        /* Nothing was found. */
-        return NULL;
-    }
-
-    result = enum_ctx->result[idx->domain];
-
-    if (result != NULL && idx->result >= result->count) {
-        /* Switch to next domain. */
-        idx->result = 0;
-        idx->domain++;
-
-        result = enum_ctx->result[idx->domain];
-    }
-
-    return result;
-}
-
 static void nss_getent_done(struct tevent_req *subreq)
 {
     struct cache_req_result *limited;
@@ -754,10 +758,11 @@ static void nss_getent_done(struct tevent_req *subreq)
         goto done;
     }
 
-    result = nss_getent_get_result(cmd_ctx->enum_ctx, cmd_ctx->enum_index);
-    if (result == NULL) {
-        /* No more records to return. */
-        ret = ENOENT;
+    ret = nss_enum_get_result(cmd_ctx->state_ctx, cmd_ctx->nss_ctx,
+                              cmd_ctx->type, cmd_ctx->enum_ctx,
+                              cmd_ctx->enum_index, &result);
+    if (ret != EOK) {
+        /* ENOENT means that there are no more records to return. */
         goto done;
     }
 
@@ -770,11 +775,11 @@ static void nss_getent_done(struct tevent_req *subreq)
         goto done;
     }
 
-    cmd_ctx->enum_index->result += result->count;
+    cmd_ctx->enum_index->result += limited->count;
 
     /* Reply with limited result. */
     nss_protocol_reply(cmd_ctx->cli_ctx, cmd_ctx->nss_ctx, cmd_ctx,
-                       result, cmd_ctx->fill_fn);
+                       limited, cmd_ctx->fill_fn);
 
     ret = EOK;
 
@@ -900,8 +905,7 @@ static errno_t nss_endent(struct cli_ctx *cli_ctx,
 {
     DEBUG(SSSDBG_CONF_SETTINGS, "Resetting enumeration state\n");
 
-    idx->domain = 0;
-    idx->result = 0;
+    nss_enum_index_reset(idx);
 
     nss_protocol_done(cli_ctx, EOK);
 
@@ -938,8 +942,7 @@ static errno_t nss_cmd_setpwent(struct cli_ctx *cli_ctx)
     struct nss_state_ctx *state_ctx;
 
     state_ctx = talloc_get_type(cli_ctx->state_ctx, struct nss_state_ctx);
-    state_ctx->pwent.domain = 0;
-    state_ctx->pwent.result = 0;
+    nss_enum_index_reset(&state_ctx->pwent);
 
     nss_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct nss_ctx);
 
@@ -999,8 +1002,7 @@ static errno_t nss_cmd_setgrent(struct cli_ctx *cli_ctx)
     struct nss_state_ctx *state_ctx;
 
     state_ctx = talloc_get_type(cli_ctx->state_ctx, struct nss_state_ctx);
-    state_ctx->grent.domain = 0;
-    state_ctx->grent.result = 0;
+    nss_enum_index_reset(&state_ctx->grent);
 
     nss_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct nss_ctx);
 
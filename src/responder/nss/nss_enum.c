@@ -25,6 +25,10 @@
 #include "util/sss_ptr_hash.h"
 #include "responder/nss/nss_private.h"
 
+/* Number of users or groups read from the cache at once during
+ * enumeration. */
+#define NSS_ENUM_PAGE_SIZE 4096
+
 typedef errno_t (*nss_setent_set_timeout_fn)(struct tevent_context *ev,
                                              struct nss_ctx *nss_ctx,
                                              struct nss_enum_ctx *enum_ctx);
@@ -35,6 +39,7 @@ struct nss_setent_internal_state {
     struct nss_enum_ctx *enum_ctx;
     nss_setent_set_timeout_fn timeout_handler;
     enum cache_req_type type;
+    uint32_t page_size;
 };
 
 static void nss_setent_internal_done(struct tevent_req *subreq);
@@ -47,6 +52,7 @@ nss_setent_internal_send(TALLOC_CTX *mem_ctx,
                          struct cache_req_data *data,
                          enum cache_req_type type,
                          struct nss_enum_ctx *enum_ctx,
+                         uint32_t page_size,
                          nss_setent_set_timeout_fn timeout_handler)
 {
     struct nss_setent_internal_state *state;
@@ -66,6 +72,7 @@ nss_setent_internal_send(TALLOC_CTX *mem_ctx,
     state->nss_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct nss_ctx);
     state->enum_ctx = enum_ctx;
     state->type = type;
+    state->page_size = page_size;
     state->timeout_handler = timeout_handler;
 
     if (state->enum_ctx->is_ready) {
@@ -140,6 +147,7 @@ static void nss_setent_internal_done(struct tevent_req *subreq)
     case EOK:
         talloc_zfree(state->enum_ctx->result);
         state->enum_ctx->result = talloc_steal(state->enum_ctx, result);
+        state->enum_ctx->page_size = state->page_size;
 
         if (state->type == CACHE_REQ_NETGROUP_BY_NAME) {
             /* We need to expand the netgroup into triples and members. */
@@ -242,6 +250,7 @@ nss_setent_send(TALLOC_CTX *mem_ctx,
                 struct nss_enum_ctx *enum_ctx)
 {
     struct cache_req_data *data;
+    uint32_t page_size = 0;
 
     data = cache_req_data_enum(mem_ctx, type);
     if (data == NULL) {
@@ -249,8 +258,25 @@ nss_setent_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    /* Users and groups are read page by page so the whole enumeration is
+     * never held in memory. Selective session recording needs to process
+     * all users in the cache request so it is not paged. */
+    switch (type) {
+    case CACHE_REQ_ENUM_USERS:
+        if (cli_ctx->rctx->sr_conf.scope != SESSION_RECORDING_SCOPE_NONE) {
+            break;
+        }
+        /* fall through */
+    case CACHE_REQ_ENUM_GROUPS:
+        page_size = NSS_ENUM_PAGE_SIZE;
+        cache_req_data_set_enum_page_size(data, page_size);
+        break;
+    default:
+        break;
+    }
+
     return nss_setent_internal_send(mem_ctx, ev, cli_ctx, data, type, enum_ctx,
-                                    nss_setent_set_timeout);
+                                    page_size, nss_setent_set_timeout);
 }
 
 errno_t nss_setent_recv(struct tevent_req *req)
@@ -258,6 +284,210 @@ errno_t nss_setent_recv(struct tevent_req *req)
     return nss_setent_internal_recv(req);
 }
 
+/* The cache request returns only the first page, the following pages are
+ * read directly from the cache since the cache request would contact the
+ * data provider again for each page. Each page is looked up by the name of
+ * the last entry read so only a single page of names is held at a time.
+ *
+ * @return ENOENT if there are no more pages in the current domain. */
+static errno_t
+nss_enum_read_page(TALLOC_CTX *mem_ctx,
+                   struct nss_ctx *nss_ctx,
+                   enum cache_req_type type,
+                   struct nss_enum_ctx *enum_ctx,
+                   struct nss_enum_index *idx)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct cache_req_result *first;
+    struct cache_req_result *page;
+    struct sss_domain_info *domain;
+    struct ldb_result *names;
+    struct ldb_result *res;
+    const char *after;
+    const char *name;
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    first = enum_ctx->result[idx->domain];
+    domain = first->domain;
+
+    after = idx->after;
+    if (idx->page == NULL && first->count > 0) {
+        /* Continue after the last entry of the first page. */
+        after = ldb_msg_find_attr_as_string(first->msgs[first->count - 1],
+                                            SYSDB_NAME, NULL);
+        if (after == NULL) {
+            return ERR_INTERNAL;
+        }
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    switch (type) {
+    case CACHE_REQ_ENUM_USERS:
+        ret = sysdb_enumpwent_filter_names(tmp_ctx, domain, NULL, after,
+                                           enum_ctx->page_size, &names);
+        break;
+    case CACHE_REQ_ENUM_GROUPS:
+        ret = sysdb_enumgrent_filter_names(tmp_ctx, domain, NULL, after,
+                                           enum_ctx->page_size, &names);
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to list entries of domain %s "
+              "[%d]: %s\n", domain->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (names->count == 0) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    switch (type) {
+    case CACHE_REQ_ENUM_USERS:
+        ret = sysdb_enumpwent_read_with_views(tmp_ctx, domain, names->msgs,
+                                              names->count, &res);
+        break;
+    case CACHE_REQ_ENUM_GROUPS:
+        ret = sysdb_enumgrent_read_with_views(tmp_ctx, domain, names->msgs,
+                                              names->count, &res);
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to read next page of domain %s "
+              "[%d]: %s\n", domain->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* The next page is decided by the names, entries removed in the
+     * meantime only make the page shorter. */
+    name = ldb_msg_find_attr_as_string(names->msgs[names->count - 1],
+                                       SYSDB_NAME, NULL);
+    if (name == NULL) {
+        ret = ERR_INTERNAL;
+        goto done;
+    }
+
+    talloc_free(idx->after);
+    idx->after = talloc_strdup(mem_ctx, name);
+    if (idx->after == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Filter out entries in the negative cache. */
+    count = 0;
+    for (i = 0; i < res->count; i++) {
+        name = sss_get_name_from_msg(domain, res->msgs[i]);
+        if (name == NULL) {
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        if (type == CACHE_REQ_ENUM_USERS) {
+            ret = sss_ncache_check_user(nss_ctx->rctx->ncache, domain, name);
+        } else {
+            ret = sss_ncache_check_group(nss_ctx->rctx->ncache, domain, name);
+        }
+
+        if (ret == EEXIST) {
+            DEBUG(SSSDBG_TRACE_FUNC, "[%s] filtered out! (negative cache)\n",
+                  name);
+            continue;
+        } else if (ret != EOK && ret != ENOENT) {
+            goto done;
+        }
+
+        res->msgs[count] = res->msgs[i];
+        count++;
+    }
+    res->count = count;
+
+    page = talloc_zero(tmp_ctx, struct cache_req_result);
+    if (page == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    page->domain = domain;
+    page->ldb_result = talloc_steal(page, res);
+    page->count = res->count;
+    page->msgs = res->msgs;
+
+    talloc_zfree(idx->page);
+    idx->page = talloc_steal(mem_ctx, page);
+    idx->result = 0;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t
+nss_enum_get_result(TALLOC_CTX *mem_ctx,
+                    struct nss_ctx *nss_ctx,
+                    enum cache_req_type type,
+                    struct nss_enum_ctx *enum_ctx,
+                    struct nss_enum_index *idx,
+                    struct cache_req_result **_result)
+{
+    struct cache_req_result *result;
+    errno_t ret;
+
+    if (enum_ctx->result == NULL) {
+        /* Nothing was found. */
+        return ENOENT;
+    }
+
+    while (enum_ctx->result[idx->domain] != NULL) {
+        result = idx->page != NULL ? idx->page
+                                   : enum_ctx->result[idx->domain];
+        if (idx->result < result->count) {
+            *_result = result;
+            return EOK;
+        }
+
+        if (enum_ctx->page_size > 0) {
+            ret = nss_enum_read_page(mem_ctx, nss_ctx, type, enum_ctx, idx);
+            if (ret == EOK) {
+                continue;
+            } else if (ret != ENOENT) {
+                return ret;
+            }
+        }
+
+        /* Switch to next domain. */
+        talloc_zfree(idx->page);
+        talloc_zfree(idx->after);
+        idx->result = 0;
+        idx->domain++;
+    }
+
+    return ENOENT;
+}
+
+void
+nss_enum_index_reset(struct nss_enum_index *idx)
+{
+    idx->domain = 0;
+    idx->result = 0;
+    talloc_zfree(idx->page);
+    talloc_zfree(idx->after);
+}
+
 static void
 nss_setnetgrent_timeout(struct tevent_context *ev,
                         struct tevent_timer *te,
@@ -357,7 +587,7 @@ nss_setnetgrent_send(TALLOC_CTX *mem_ctx,
     }
 
     return nss_setent_internal_send(mem_ctx, ev, cli_ctx, data, type, enum_ctx,
-                                    nss_setnetgrent_set_timeout);
+                                    0, nss_setnetgrent_set_timeout);
 }
 
 errno_t nss_setnetgrent_recv(struct tevent_req *req)
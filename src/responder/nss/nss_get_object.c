@@ -98,6 +98,11 @@ memcache_delete_entry(struct nss_ctx *nss_ctx,
     struct sized_string *sized_name;
     errno_t ret;
 
+    if (domain == NULL) {
+        /* The object is gone, drop the replies built from it as well. */
+        nss_reply_cache_invalidate(nss_ctx->reply_cache, type, name, id);
+    }
+
     for (dom = rctx->domains;
          dom != NULL;
          dom = get_next_domain(dom, SSS_GND_DESCEND)) {
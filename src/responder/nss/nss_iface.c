@@ -84,6 +84,8 @@ nss_update_initgr_memcache(struct nss_ctx *nctx,
                   "Internal failure in memory cache code: %d [%s]\n",
                   ret, strerror(ret));
         }
+        nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_PASSWD,
+                                   fq_name, 0);
 
         /* Also invalidate his groups */
         changed = true;
@@ -131,6 +133,8 @@ nss_update_initgr_memcache(struct nss_ctx *nctx,
                       "Internal failure in memory cache code: %d [%s]\n",
                       ret, strerror(ret));
             }
+            nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_GROUP,
+                                       NULL, id);
         }
 
         to_sized_string(delete_name, fq_name);
@@ -141,6 +145,8 @@ nss_update_initgr_memcache(struct nss_ctx *nctx,
                   "Internal failure in memory cache code: %d [%s]\n",
                   ret, strerror(ret));
         }
+        nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_INITGROUPS,
+                                   fq_name, 0);
     }
 
 done:
@@ -154,6 +160,7 @@ nss_memorycache_invalidate_users(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all users in memory cache\n");
     sss_mmap_cache_reset(nctx->pwd_mc_ctx);
+    nss_reply_cache_reset(nctx->reply_cache, SSS_MC_PASSWD);
 
     return EOK;
 }
@@ -165,6 +172,7 @@ nss_memorycache_invalidate_groups(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all groups in memory cache\n");
     sss_mmap_cache_reset(nctx->grp_mc_ctx);
+    nss_reply_cache_reset(nctx->reply_cache, SSS_MC_GROUP);
 
     return EOK;
 }
@@ -177,6 +185,7 @@ nss_memorycache_invalidate_initgroups(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_LIBS,
           "Invalidating all initgroup records in memory cache\n");
     sss_mmap_cache_reset(nctx->initgr_mc_ctx);
+    nss_reply_cache_reset(nctx->reply_cache, SSS_MC_INITGROUPS);
 
     return EOK;
 }
@@ -209,6 +218,168 @@ nss_memorycache_invalidate_group_by_id(TALLOC_CTX *mem_ctx,
           "Invalidating group %u from memory cache\n", gid);
 
     sss_mmap_cache_gr_invalidate_gid(nctx->grp_mc_ctx, gid);
+    nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_GROUP, NULL, gid);
+
+    return EOK;
+}
+
+static errno_t
+nss_invalidate_object_by_name(struct nss_ctx *nctx,
+                              enum sss_mc_type type,
+                              const char *fq_name)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom;
+    struct sized_string *delete_name;
+    char *domname;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_parse_internal_fqname(tmp_ctx, fq_name, NULL, &domname);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to parse [%s] [%d]: %s\n",
+              fq_name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    dom = find_domain_by_name(nctx->rctx->domains, domname, true);
+    if (dom == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unknown domain (%s) requested by provider\n", domname);
+        ret = ERR_DOMAIN_NOT_FOUND;
+        goto done;
+    }
+
+    ret = sized_output_name(tmp_ctx, nctx->rctx, fq_name, dom, &delete_name);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "sized_output_name failed for '%s': %d [%s]\n",
+              fq_name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (type == SSS_MC_GROUP) {
+        ret = sss_mmap_cache_gr_invalidate(nctx->grp_mc_ctx, delete_name);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Internal failure in memory cache code: %d [%s]\n",
+                  ret, sss_strerror(ret));
+        }
+
+        nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_GROUP,
+                                   fq_name, 0);
+
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sss_mmap_cache_pw_invalidate(nctx->pwd_mc_ctx, delete_name);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Internal failure in memory cache code: %d [%s]\n",
+              ret, sss_strerror(ret));
+    }
+
+    ret = sss_mmap_cache_initgr_invalidate(nctx->initgr_mc_ctx, delete_name);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Internal failure in memory cache code: %d [%s]\n",
+              ret, sss_strerror(ret));
+    }
+
+    nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_PASSWD, fq_name, 0);
+    nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_INITGROUPS,
+                               fq_name, 0);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t
+nss_memorycache_invalidate_user_by_name(TALLOC_CTX *mem_ctx,
+                                        struct sbus_request *sbus_req,
+                                        struct nss_ctx *nctx,
+                                        const char *fq_name)
+{
+    DEBUG(SSSDBG_TRACE_LIBS,
+          "Invalidating user %s from memory cache\n", fq_name);
+
+    return nss_invalidate_object_by_name(nctx, SSS_MC_PASSWD, fq_name);
+}
+
+static errno_t
+nss_memorycache_invalidate_objects(TALLOC_CTX *mem_ctx,
+                                   struct sbus_request *sbus_req,
+                                   struct nss_ctx *nctx,
+                                   const char **users,
+                                   const char **groups,
+                                   uint32_t *gids)
+{
+    size_t num_gids = talloc_array_length(gids);
+    errno_t ret;
+    size_t i;
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Invalidating a batch of objects from memory "
+          "cache\n");
+
+    /* Objects that cannot be invalidated are skipped, the provider has
+     * nothing better to do with the error than to ignore it either. */
+    for (i = 0; users != NULL && users[i] != NULL; i++) {
+        ret = nss_invalidate_object_by_name(nctx, SSS_MC_PASSWD, users[i]);
+        if (ret == ENOMEM) {
+            return ret;
+        }
+    }
+
+    for (i = 0; groups != NULL && groups[i] != NULL; i++) {
+        ret = nss_invalidate_object_by_name(nctx, SSS_MC_GROUP, groups[i]);
+        if (ret == ENOMEM) {
+            return ret;
+        }
+    }
+
+    for (i = 0; i < num_gids; i++) {
+        sss_mmap_cache_gr_invalidate_gid(nctx->grp_mc_ctx, gids[i]);
+        nss_reply_cache_invalidate(nctx->reply_cache, SSS_MC_GROUP,
+                                   NULL, gids[i]);
+    }
+
+    return EOK;
+}
+
+static errno_t
+nss_memorycache_new_generation(TALLOC_CTX *mem_ctx,
+                               struct sbus_request *sbus_req,
+                               struct nss_ctx *nctx,
+                               bool users,
+                               bool groups,
+                               bool initgroups)
+{
+    DEBUG(SSSDBG_TRACE_LIBS, "Starting new memory cache generation of "
+          "%s%s%s\n", users ? "users " : "", groups ? "groups " : "",
+          initgroups ? "initgroups" : "");
+
+    if (users) {
+        sss_mmap_cache_new_generation(nctx->pwd_mc_ctx);
+        nss_reply_cache_reset(nctx->reply_cache, SSS_MC_PASSWD);
+    }
+
+    if (groups) {
+        sss_mmap_cache_new_generation(nctx->grp_mc_ctx);
+        nss_reply_cache_reset(nctx->reply_cache, SSS_MC_GROUP);
+    }
+
+    if (initgroups) {
+        sss_mmap_cache_new_generation(nctx->initgr_mc_ctx);
+        nss_reply_cache_reset(nctx->reply_cache, SSS_MC_INITGROUPS);
+    }
 
     return EOK;
 }
@@ -226,7 +397,10 @@ nss_register_backend_iface(struct sbus_connection *conn,
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllUsers, nss_memorycache_invalidate_users, nss_ctx),
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllGroups, nss_memorycache_invalidate_groups, nss_ctx),
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllInitgroups, nss_memorycache_invalidate_initgroups, nss_ctx),
-            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateGroupById, nss_memorycache_invalidate_group_by_id, nss_ctx)
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateGroupById, nss_memorycache_invalidate_group_by_id, nss_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateUserByName, nss_memorycache_invalidate_user_by_name, nss_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateObjects, nss_memorycache_invalidate_objects, nss_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, NewGeneration, nss_memorycache_new_generation, nss_ctx)
         ),
         SBUS_SIGNALS(SBUS_NO_SIGNALS),
         SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
@@ -36,6 +36,13 @@
 struct nss_enum_index {
     unsigned int domain;
     unsigned int result;
+
+    /* Page of the current domain read after the first one, NULL while
+     * the first page in nss_enum_ctx is read. */
+    struct cache_req_result *page;
+    /* Name of the last entry of the current domain that was read, the
+     * next page starts after it. */
+    char *after;
 };
 
 struct nss_enum_ctx {
@@ -43,6 +50,10 @@ struct nss_enum_ctx {
     struct sysdb_netgroup_ctx **netgroup;
     size_t netgroup_count;
 
+    /* If not zero, result contains only the first page of each domain
+     * and the rest is read page by page by each client. */
+    uint32_t page_size;
+
     /* Ongoing cache request that is constructing enumeration result. */
     struct tevent_req *ongoing;
 
@@ -93,6 +104,9 @@ struct nss_ctx {
     struct sss_mc_ctx *initgr_mc_ctx;
     uid_t mc_uid;
     gid_t mc_gid;
+
+    /* Cache of ready-made replies, NULL if disabled. */
+    struct nss_reply_cache *reply_cache;
 };
 
 struct sss_cmd_table *get_nss_cmds(void);
@@ -132,6 +146,20 @@ nss_setent_send(TALLOC_CTX *mem_ctx,
 errno_t
 nss_setent_recv(struct tevent_req *req);
 
+/* Return the result that @idx points to, reading the next page of a
+ * paged enumeration if needed. ENOENT means that there are no more
+ * entries. */
+errno_t
+nss_enum_get_result(TALLOC_CTX *mem_ctx,
+                    struct nss_ctx *nss_ctx,
+                    enum cache_req_type type,
+                    struct nss_enum_ctx *enum_ctx,
+                    struct nss_enum_index *idx,
+                    struct cache_req_result **_result);
+
+void
+nss_enum_index_reset(struct nss_enum_index *idx);
+
 struct tevent_req *
 nss_setnetgrent_send(TALLOC_CTX *mem_ctx,
                      struct tevent_context *ev,
@@ -143,6 +171,38 @@ nss_setnetgrent_send(TALLOC_CTX *mem_ctx,
 errno_t
 nss_setnetgrent_recv(struct tevent_req *req);
 
+/* Reply cache. */
+
+struct nss_cmd_ctx;
+struct nss_reply_cache;
+
+errno_t nss_reply_cache_init(TALLOC_CTX *mem_ctx,
+                             unsigned int size,
+                             time_t timeout,
+                             struct nss_reply_cache **_cache);
+
+/* On success the reply packet is prepared and only needs to be sent. */
+errno_t nss_reply_cache_lookup(struct nss_reply_cache *cache,
+                               struct nss_cmd_ctx *cmd_ctx,
+                               const char *name,
+                               uint32_t id);
+
+void nss_reply_cache_store(struct nss_reply_cache *cache,
+                           struct nss_cmd_ctx *cmd_ctx,
+                           const char *name,
+                           uint32_t id,
+                           struct sss_packet *packet,
+                           struct cache_req_result *result);
+
+void nss_reply_cache_invalidate(struct nss_reply_cache *cache,
+                                enum sss_mc_type type,
+                                const char *name,
+                                uint32_t id);
+
+/* Drops all replies of given type, SSS_MC_NONE drops everything. */
+void nss_reply_cache_reset(struct nss_reply_cache *cache,
+                           enum sss_mc_type type);
+
 /* Utils. */
 
 const char *
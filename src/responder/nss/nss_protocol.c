@@ -95,6 +95,11 @@ void nss_protocol_reply(struct cli_ctx *cli_ctx,
 
     sss_packet_set_error(pctx->creq->out, EOK);
 
+    if (cmd_ctx->cache_reply) {
+        nss_reply_cache_store(nss_ctx->reply_cache, cmd_ctx, cmd_ctx->rawname,
+                              cmd_ctx->input_id, pctx->creq->out, result);
+    }
+
 done:
     nss_protocol_done(cli_ctx, ret);
 }
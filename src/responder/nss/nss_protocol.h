@@ -66,6 +66,10 @@ struct nss_cmd_ctx {
 
     /* For SID lookups. */
     enum sss_id_type sid_id_type;
+
+    /* Store the reply in the reply cache. */
+    bool cache_reply;
+    uint32_t input_id;
 };
 
 /**
@@ -0,0 +1,634 @@
+/*
+    SSSD
+
+    NSS Responder - cache of ready-made replies for hot objects
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <time.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "db/sysdb.h"
+#include "responder/nss/nss_private.h"
+#include "responder/nss/nss_protocol.h"
+
+/* Requests that miss the memory cache still cost a search in the cache and
+ * in the timestamp cache followed by marshalling of the reply. This cache
+ * keeps the marshalled reply body of recently requested users and groups
+ * so that repeated requests can be answered without touching sysdb.
+ *
+ * Entries live at most reply_cache_timeout seconds and never past the
+ * midpoint refresh or the expiration of the cached objects, so requests
+ * that should refresh the objects go through cache_req again. Each hit is
+ * validated against lastUpdate of the cached object, which changes whenever
+ * the backend stores it. They are also dropped together with the memory
+ * cache records whenever the data provider or sss_cache invalidate them. */
+
+struct nss_reply_cache_entry;
+
+/* All entries that share a name or an ID, see nss_reply_cache_invalidate(). */
+struct nss_reply_cache_index {
+    struct nss_reply_cache_ref *refs;
+};
+
+struct nss_reply_cache_ref {
+    struct nss_reply_cache_ref *prev;
+    struct nss_reply_cache_ref *next;
+    struct nss_reply_cache_index *index;
+    struct nss_reply_cache_entry *entry;
+};
+
+struct nss_reply_cache_entry {
+    struct nss_reply_cache_entry *prev;
+    struct nss_reply_cache_entry *next;
+    struct nss_reply_cache *cache;
+
+    enum sss_mc_type type;
+    char *key;
+
+    /* The object the reply was built from, used for validation. */
+    char *domain;
+    char *dn;
+    uint64_t last_update;
+
+    time_t expire;
+    uint8_t *body;
+    size_t blen;
+};
+
+struct nss_reply_cache {
+    hash_table_t *table;
+    hash_table_t *index;
+
+    /* Most recently used entry first. */
+    struct nss_reply_cache_entry *lru;
+    struct nss_reply_cache_entry *tail;
+    unsigned int count;
+    unsigned int size;
+    time_t timeout;
+};
+
+static void nss_reply_cache_unlink(struct nss_reply_cache *cache,
+                                   struct nss_reply_cache_entry *entry)
+{
+    if (cache->tail == entry) {
+        cache->tail = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->lru, entry);
+}
+
+static void nss_reply_cache_link(struct nss_reply_cache *cache,
+                                 struct nss_reply_cache_entry *entry)
+{
+    DLIST_ADD(cache->lru, entry);
+
+    if (cache->tail == NULL) {
+        cache->tail = entry;
+    }
+}
+
+static int nss_reply_cache_entry_destructor(struct nss_reply_cache_entry *entry)
+{
+    nss_reply_cache_unlink(entry->cache, entry);
+    entry->cache->count--;
+
+    return 0;
+}
+
+static int nss_reply_cache_ref_destructor(struct nss_reply_cache_ref *ref)
+{
+    DLIST_REMOVE(ref->index->refs, ref);
+    if (ref->index->refs == NULL) {
+        /* This also removes the key from the table. */
+        talloc_free(ref->index);
+    }
+
+    return 0;
+}
+
+static int nss_reply_cache_destructor(struct nss_reply_cache *cache)
+{
+    /* Entries must go first, they reference the index. */
+    nss_reply_cache_reset(cache, SSS_MC_NONE);
+
+    return 0;
+}
+
+errno_t nss_reply_cache_init(TALLOC_CTX *mem_ctx,
+                             unsigned int size,
+                             time_t timeout,
+                             struct nss_reply_cache **_cache)
+{
+    struct nss_reply_cache *cache;
+
+    if (size == 0 || timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "NSS reply cache is disabled\n");
+        *_cache = NULL;
+        return EOK;
+    }
+
+    cache = talloc_zero(mem_ctx, struct nss_reply_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    cache->index = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL || cache->index == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->size = size;
+    cache->timeout = timeout;
+    talloc_set_destructor(cache, nss_reply_cache_destructor);
+
+    *_cache = cache;
+    return EOK;
+}
+
+static char *nss_reply_cache_key(TALLOC_CTX *mem_ctx,
+                                 enum cache_req_type type,
+                                 const char *name,
+                                 uint32_t id)
+{
+    if (name != NULL) {
+        return talloc_asprintf(mem_ctx, "%d:%s", type, name);
+    }
+
+    return talloc_asprintf(mem_ctx, "%d:#%"PRIu32, type, id);
+}
+
+/* Names are matched without regard to case, which may drop an extra entry
+ * that only costs a lookup. */
+static char *nss_reply_cache_index_key(TALLOC_CTX *mem_ctx,
+                                       enum sss_mc_type type,
+                                       const char *name,
+                                       uint32_t id)
+{
+    char *lower;
+    char *key;
+
+    if (name == NULL) {
+        return talloc_asprintf(mem_ctx, "%d:#%"PRIu32, type, id);
+    }
+
+    lower = sss_tc_utf8_str_tolower(mem_ctx, name);
+    if (lower == NULL) {
+        return NULL;
+    }
+
+    key = talloc_asprintf(mem_ctx, "%d:%s", type, lower);
+    talloc_free(lower);
+
+    return key;
+}
+
+/* The reply is still valid if the object was not stored again since. */
+static bool nss_reply_cache_valid(struct nss_reply_cache_entry *entry,
+                                  struct resp_ctx *rctx)
+{
+    const char *attrs[] = { SYSDB_LAST_UPDATE, NULL };
+    struct sss_domain_info *domain;
+    struct ldb_message **msgs;
+    struct ldb_dn *dn;
+    size_t count;
+    bool valid = false;
+    errno_t ret;
+
+    if (entry->expire <= time(NULL)) {
+        return false;
+    }
+
+    domain = find_domain_by_name(rctx->domains, entry->domain, true);
+    if (domain == NULL || domain->sysdb == NULL) {
+        return false;
+    }
+
+    dn = ldb_dn_new(NULL, sysdb_ctx_get_ldb(domain->sysdb), entry->dn);
+    if (dn == NULL) {
+        return false;
+    }
+
+    ret = sysdb_search_entry(dn, domain->sysdb, dn, LDB_SCOPE_BASE, NULL,
+                             attrs, &count, &msgs);
+    if (ret == EOK && count == 1) {
+        valid = ldb_msg_find_attr_as_uint64(msgs[0], SYSDB_LAST_UPDATE, 0)
+                    == entry->last_update;
+    }
+
+    talloc_free(dn);
+    return valid;
+}
+
+errno_t nss_reply_cache_lookup(struct nss_reply_cache *cache,
+                               struct nss_cmd_ctx *cmd_ctx,
+                               const char *name,
+                               uint32_t id)
+{
+    struct nss_reply_cache_entry *entry;
+    struct cli_protocol *pctx;
+    uint8_t *body;
+    size_t blen;
+    char *key;
+    errno_t ret;
+
+    if (cache == NULL) {
+        return ENOENT;
+    }
+
+    key = nss_reply_cache_key(NULL, cmd_ctx->type, name, id);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct nss_reply_cache_entry);
+    talloc_free(key);
+    if (entry == NULL) {
+        return ENOENT;
+    }
+
+    if (!nss_reply_cache_valid(entry, cmd_ctx->nss_ctx->rctx)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Cached reply for [%s] is outdated\n",
+              entry->key);
+        talloc_free(entry);
+        return ENOENT;
+    }
+
+    pctx = talloc_get_type(cmd_ctx->cli_ctx->protocol_ctx,
+                           struct cli_protocol);
+
+    ret = sss_packet_new(pctx->creq, entry->blen,
+                         sss_packet_get_cmd(pctx->creq->in),
+                         &pctx->creq->out);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sss_packet_get_body(pctx->creq->out, &body, &blen);
+    memcpy(body, entry->body, entry->blen);
+    sss_packet_set_error(pctx->creq->out, EOK);
+
+    nss_reply_cache_unlink(cache, entry);
+    nss_reply_cache_link(cache, entry);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Returning cached reply for [%s]\n",
+          entry->key);
+
+    return EOK;
+}
+
+static enum sss_mc_type nss_reply_cache_mc_type(enum cache_req_type type)
+{
+    switch (type) {
+    case CACHE_REQ_USER_BY_NAME:
+    case CACHE_REQ_USER_BY_ID:
+        return SSS_MC_PASSWD;
+    case CACHE_REQ_GROUP_BY_NAME:
+    case CACHE_REQ_GROUP_BY_ID:
+        return SSS_MC_GROUP;
+    case CACHE_REQ_INITGROUPS:
+        return SSS_MC_INITGROUPS;
+    default:
+        return SSS_MC_NONE;
+    }
+}
+
+/* The same point in time as in sss_cmd_check_cache(). */
+static time_t nss_reply_cache_midpoint(struct ldb_message *msg,
+                                       int cache_refresh_percent,
+                                       time_t obj_expire)
+{
+    time_t last_update;
+    time_t midpoint;
+
+    last_update = ldb_msg_find_attr_as_uint64(msg, SYSDB_LAST_UPDATE, 0);
+    midpoint = last_update
+               + (obj_expire - last_update) * cache_refresh_percent / 100.0;
+    if (midpoint - last_update < 10) {
+        midpoint = last_update + 10;
+    }
+
+    return midpoint;
+}
+
+/* The reply must not outlive any of the objects it was built from nor
+ * their midpoint refresh, otherwise the entries would not be refreshed on
+ * time. */
+static time_t nss_reply_cache_expire(struct nss_reply_cache *cache,
+                                     enum sss_mc_type type,
+                                     int cache_refresh_percent,
+                                     struct cache_req_result *result)
+{
+    time_t expire;
+    time_t obj_expire;
+    time_t midpoint;
+    unsigned int i;
+
+    expire = time(NULL) + cache->timeout;
+
+    for (i = 0; i < result->count; i++) {
+        obj_expire = ldb_msg_find_attr_as_uint64(result->msgs[i],
+                                                 SYSDB_CACHE_EXPIRE, 0);
+        if (type == SSS_MC_INITGROUPS && i == 0) {
+            obj_expire = ldb_msg_find_attr_as_uint64(result->msgs[0],
+                                                     SYSDB_INITGR_EXPIRE, 0);
+        }
+
+        if (obj_expire == 0) {
+            continue;
+        }
+
+        if (obj_expire < expire) {
+            expire = obj_expire;
+        }
+
+        if (cache_refresh_percent == 0) {
+            continue;
+        }
+
+        midpoint = nss_reply_cache_midpoint(result->msgs[i],
+                                            cache_refresh_percent,
+                                            obj_expire);
+        if (midpoint < expire) {
+            expire = midpoint;
+        }
+    }
+
+    return expire;
+}
+
+static void nss_reply_cache_evict(struct nss_reply_cache *cache)
+{
+    if (cache->tail != NULL) {
+        talloc_free(cache->tail);
+    }
+}
+
+static errno_t nss_reply_cache_add_ref(struct nss_reply_cache_entry *entry,
+                                       const char *name,
+                                       uint32_t id)
+{
+    struct nss_reply_cache *cache = entry->cache;
+    struct nss_reply_cache_index *index;
+    struct nss_reply_cache_ref *ref;
+    char *key;
+    errno_t ret;
+
+    if (name == NULL && id == 0) {
+        return EOK;
+    }
+
+    key = nss_reply_cache_index_key(entry, entry->type, name, id);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    index = sss_ptr_hash_lookup(cache->index, key,
+                                struct nss_reply_cache_index);
+    if (index != NULL) {
+        /* The same entry may be known under equal names. */
+        DLIST_FOR_EACH(ref, index->refs) {
+            if (ref->entry == entry) {
+                talloc_free(key);
+                return EOK;
+            }
+        }
+    } else {
+        index = talloc_zero(cache, struct nss_reply_cache_index);
+        if (index == NULL) {
+            talloc_free(key);
+            return ENOMEM;
+        }
+
+        ret = sss_ptr_hash_add(cache->index, key, index,
+                               struct nss_reply_cache_index);
+        if (ret != EOK) {
+            talloc_free(index);
+            talloc_free(key);
+            return ret;
+        }
+    }
+    talloc_free(key);
+
+    ref = talloc_zero(entry, struct nss_reply_cache_ref);
+    if (ref == NULL) {
+        if (index->refs == NULL) {
+            talloc_free(index);
+        }
+        return ENOMEM;
+    }
+
+    ref->index = index;
+    ref->entry = entry;
+    DLIST_ADD(index->refs, ref);
+    talloc_set_destructor(ref, nss_reply_cache_ref_destructor);
+
+    return EOK;
+}
+
+void nss_reply_cache_store(struct nss_reply_cache *cache,
+                           struct nss_cmd_ctx *cmd_ctx,
+                           const char *name,
+                           uint32_t id,
+                           struct sss_packet *packet,
+                           struct cache_req_result *result)
+{
+    struct nss_reply_cache_entry *entry;
+    enum sss_mc_type type;
+    const char *fqname;
+    char *output_name;
+    uint32_t obj_id;
+    uint8_t *body;
+    size_t blen;
+    errno_t ret;
+
+    if (cache == NULL || result == NULL || result->count == 0) {
+        return;
+    }
+
+    type = nss_reply_cache_mc_type(cmd_ctx->type);
+    if (type == SSS_MC_NONE) {
+        return;
+    }
+
+    entry = talloc_zero(cache, struct nss_reply_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->cache = cache;
+    entry->type = type;
+    entry->expire = nss_reply_cache_expire(cache, type,
+                                    cmd_ctx->nss_ctx->cache_refresh_percent,
+                                    result);
+    if (entry->expire <= time(NULL)) {
+        /* The objects are about to be refreshed. */
+        goto fail;
+    }
+
+    entry->key = nss_reply_cache_key(entry, cmd_ctx->type, name, id);
+    if (entry->key == NULL) {
+        goto fail;
+    }
+
+    /* Initgroups are validated against the user only, its membership
+     * changes whenever the groups do. */
+    entry->domain = talloc_strdup(entry, result->domain->name);
+    entry->dn = talloc_strdup(entry,
+                              ldb_dn_get_linearized(result->msgs[0]->dn));
+    if (entry->domain == NULL || entry->dn == NULL) {
+        goto fail;
+    }
+    entry->last_update = ldb_msg_find_attr_as_uint64(result->msgs[0],
+                                                     SYSDB_LAST_UPDATE, 0);
+
+    /* Index the entry by all names and the ID it can be invalidated by. */
+    ret = nss_reply_cache_add_ref(entry, name, 0);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    fqname = ldb_msg_find_attr_as_string(result->msgs[0], SYSDB_NAME, NULL);
+    if (fqname != NULL) {
+        ret = nss_reply_cache_add_ref(entry, fqname, 0);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        fqname = sss_get_name_from_msg(result->domain, result->msgs[0]);
+        ret = sss_output_fqname(entry, result->domain, fqname,
+                                cmd_ctx->nss_ctx->rctx->override_space,
+                                &output_name);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        ret = nss_reply_cache_add_ref(entry, output_name, 0);
+        talloc_free(output_name);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    switch (type) {
+    case SSS_MC_PASSWD:
+        obj_id = ldb_msg_find_attr_as_uint(result->msgs[0], SYSDB_UIDNUM, 0);
+        break;
+    case SSS_MC_GROUP:
+        obj_id = ldb_msg_find_attr_as_uint(result->msgs[0], SYSDB_GIDNUM, 0);
+        break;
+    default:
+        obj_id = 0;
+        break;
+    }
+
+    ret = nss_reply_cache_add_ref(entry, NULL, obj_id);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    sss_packet_get_body(packet, &body, &blen);
+    entry->body = talloc_memdup(entry, body, blen);
+    if (entry->body == NULL) {
+        goto fail;
+    }
+    entry->blen = blen;
+
+    /* Replace an older reply, if any. */
+    if (sss_ptr_hash_has_key(cache->table, entry->key)) {
+        sss_ptr_hash_delete(cache->table, entry->key, true);
+    }
+
+    if (cache->count >= cache->size) {
+        nss_reply_cache_evict(cache);
+    }
+
+    ret = sss_ptr_hash_add(cache->table, entry->key, entry,
+                           struct nss_reply_cache_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    nss_reply_cache_link(cache, entry);
+    cache->count++;
+    talloc_set_destructor(entry, nss_reply_cache_entry_destructor);
+
+    return;
+
+fail:
+    talloc_free(entry);
+}
+
+void nss_reply_cache_invalidate(struct nss_reply_cache *cache,
+                                enum sss_mc_type type,
+                                const char *name,
+                                uint32_t id)
+{
+    struct nss_reply_cache_index *index;
+    struct nss_reply_cache_entry *entry;
+    char *key;
+
+    if (cache == NULL || (name == NULL && id == 0)) {
+        return;
+    }
+
+    key = nss_reply_cache_index_key(NULL, type, name, id);
+    if (key == NULL) {
+        /* Rather drop everything than serve a stale reply. */
+        nss_reply_cache_reset(cache, type);
+        return;
+    }
+
+    index = sss_ptr_hash_lookup(cache->index, key,
+                                struct nss_reply_cache_index);
+    talloc_free(key);
+
+    /* The index is freed together with its last reference. */
+    while (index != NULL && index->refs != NULL) {
+        entry = index->refs->entry;
+        if (index->refs->next == NULL) {
+            index = NULL;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Invalidating cached reply [%s]\n",
+              entry->key);
+        talloc_free(entry);
+    }
+}
+
+void nss_reply_cache_reset(struct nss_reply_cache *cache,
+                           enum sss_mc_type type)
+{
+    struct nss_reply_cache_entry *entry;
+    struct nss_reply_cache_entry *next;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    DLIST_FOR_EACH_SAFE(entry, next, cache->lru) {
+        if (type == SSS_MC_NONE || entry->type == type) {
+            talloc_free(entry);
+        }
+    }
+}
@@ -49,6 +49,8 @@
 
 #define DEFAULT_PWFIELD "*"
 #define DEFAULT_NSS_FD_LIMIT 8192
+#define DEFAULT_REPLY_CACHE_TIMEOUT 15
+#define DEFAULT_REPLY_CACHE_SIZE 1000
 
 static errno_t
 nss_clear_memcache(TALLOC_CTX *mem_ctx,
@@ -92,6 +94,8 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
     }
 
     DEBUG(SSSDBG_TRACE_FUNC, "Clearing memory caches.\n");
+    nss_reply_cache_reset(nctx->reply_cache, SSS_MC_NONE);
+
     ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
                                 -1, /* keep current size */
                                 (time_t) memcache_timeout,
@@ -175,6 +179,8 @@ static int nss_get_config(struct nss_ctx *nctx,
 {
     int ret;
     char *tmp_str;
+    int reply_cache_timeout;
+    int reply_cache_size;
 
     ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY,
                          CONFDB_NSS_ENUM_CACHE_TIMEOUT, 120,
@@ -243,11 +249,51 @@ static int nss_get_config(struct nss_ctx *nctx,
         }
     }
 
+    ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_REPLY_CACHE_TIMEOUT,
+                         DEFAULT_REPLY_CACHE_TIMEOUT,
+                         &reply_cache_timeout);
+    if (ret != EOK) goto done;
+
+    ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_REPLY_CACHE_SIZE,
+                         DEFAULT_REPLY_CACHE_SIZE,
+                         &reply_cache_size);
+    if (ret != EOK) goto done;
+
+    ret = nss_reply_cache_init(nctx, MAX(reply_cache_size, 0),
+                               reply_cache_timeout, &nctx->reply_cache);
+    if (ret != EOK) goto done;
+
     ret = 0;
 done:
     return ret;
 }
 
+static int nss_ctx_destructor(struct nss_ctx *nctx)
+{
+    /* Let the next instance continue with the current memory caches. */
+    sss_mmap_cache_save(nctx->pwd_mc_ctx);
+    sss_mmap_cache_save(nctx->grp_mc_ctx);
+    sss_mmap_cache_save(nctx->initgr_mc_ctx);
+
+    return 0;
+}
+
+static bool nss_has_files_domain(struct sss_domain_info *domains)
+{
+    struct sss_domain_info *dom;
+
+    for (dom = domains; dom != NULL;
+            dom = get_next_domain(dom, SSS_GND_DESCEND)) {
+        if (is_files_provider(dom)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static int setup_memcaches(struct nss_ctx *nctx)
 {
     /* Default memcache sizes */
@@ -258,6 +304,7 @@ static int setup_memcaches(struct nss_ctx *nctx)
 
     int ret;
     int memcache_timeout;
+    bool warm_start;
     int mc_size_passwd;
     int mc_size_group;
     int mc_size_initgroups;
@@ -282,6 +329,26 @@ static int setup_memcaches(struct nss_ctx *nctx)
         return ret;
     }
 
+    ret = confdb_get_bool(nctx->rctx->cdb,
+                          CONFDB_NSS_CONF_ENTRY,
+                          CONFDB_NSS_MEMCACHE_WARM_START,
+                          true, &warm_start);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get '"CONFDB_NSS_MEMCACHE_WARM_START
+              "' option from confdb.\n");
+        return ret;
+    }
+
+    /* The files provider only invalidates the changes it sees while it is
+     * running, so an existing cache could keep serving entries that were
+     * changed in the files while SSSD was stopped. */
+    if (warm_start && nss_has_files_domain(nctx->rctx->domains)) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "A files domain is configured, "
+              "starting with empty memory caches\n");
+        warm_start = false;
+    }
+
     /* Get all memcache sizes from confdb (pwd, grp, initgr) */
 
     ret = confdb_get_int(nctx->rctx->cdb,
@@ -327,6 +394,7 @@ static int setup_memcaches(struct nss_ctx *nctx)
                               SSS_MC_PASSWD,
                               mc_size_passwd * SSS_MC_CACHE_SLOTS_PER_MB,
                               (time_t)memcache_timeout,
+                              warm_start,
                               &nctx->pwd_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -339,6 +407,7 @@ static int setup_memcaches(struct nss_ctx *nctx)
                               SSS_MC_GROUP,
                               mc_size_group * SSS_MC_CACHE_SLOTS_PER_MB,
                               (time_t)memcache_timeout,
+                              warm_start,
                               &nctx->grp_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -351,6 +420,7 @@ static int setup_memcaches(struct nss_ctx *nctx)
                               SSS_MC_INITGROUPS,
                               mc_size_initgroups * SSS_MC_CACHE_SLOTS_PER_MB,
                               (time_t)memcache_timeout,
+                              warm_start,
                               &nctx->initgr_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -358,6 +428,10 @@ static int setup_memcaches(struct nss_ctx *nctx)
               sss_strerror(ret));
     }
 
+    if (warm_start) {
+        talloc_set_destructor(nctx, nss_ctx_destructor);
+    }
+
     return EOK;
 }
 
@@ -56,6 +56,7 @@ struct sss_mc_ctx {
 
     uint32_t seed;          /* pseudo-random seed to avoid collision attacks */
     time_t valid_time_slot; /* maximum time the entry is valid in seconds */
+    uint32_t generation;    /* generation of newly stored records */
 
     void *mmap_base;        /* base address of mmap */
     size_t mmap_size;       /* total size of mmap */
@@ -659,7 +660,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     rec->len = rec_len;
     rec->next1 = MC_INVALID_VAL;
     rec->next2 = MC_INVALID_VAL;
-    rec->padding = MC_INVALID_VAL;
+    rec->generation = mcc->generation;
     MC_LOWER_BARRIER(rec);
 
     /* and now mark slots as used */
@@ -679,6 +680,7 @@ static inline void sss_mmap_set_rec_header(struct sss_mc_ctx *mcc,
 {
     rec->len = len;
     rec->expire = time(NULL) + ttl;
+    rec->generation = mcc->generation;
     rec->hash1 = sss_mc_hash(mcc, key1, key1_len);
     rec->hash2 = sss_mc_hash(mcc, key2, key2_len);
 }
@@ -1228,7 +1230,7 @@ static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
         h->major_vno = SSS_MC_MAJOR_VNO;
         h->minor_vno = SSS_MC_MINOR_VNO;
         h->seed = mc_ctx->seed;
-        h->reserved = 0;
+        h->generation = mc_ctx->generation;
     }
     h->status = status;
     MC_LOWER_BARRIER(h);
@@ -1264,12 +1266,290 @@ static int mc_ctx_destructor(struct sss_mc_ctx *mc_ctx)
     return 0;
 }
 
+/* A snapshot is written when the responder shuts down cleanly. It lets the
+ * next instance continue with the memory cache file it left behind instead
+ * of starting with an empty one. Clients keep using the file while the
+ * responder is not running, so reusing it does not make any record live
+ * longer than it would anyway. The snapshot is used only once. */
+#define SSS_MC_SNAPSHOT_SUFFIX ".snapshot"
+#define SSS_MC_SNAPSHOT_MAGIC 0x534d4353
+#define SSS_MC_SNAPSHOT_VERSION 1
+
+struct sss_mc_snapshot {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t type;
+    uint32_t major_vno;
+    uint32_t minor_vno;
+    uint32_t seed;
+    uint32_t barrier;       /* header barrier at shutdown */
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t reserved;
+    uint64_t ino;
+    uint64_t mmap_size;
+    int64_t timeout;
+    int64_t saved;          /* time of the shutdown */
+};
+
+errno_t sss_mmap_cache_save(struct sss_mc_ctx *mcc)
+{
+    struct sss_mc_snapshot snap = { 0 };
+    struct sss_mc_header *h;
+    struct stat st;
+    char *path = NULL;
+    char *tmp_path = NULL;
+    ssize_t written;
+    int fd = -1;
+    errno_t ret;
+
+    if (mcc == NULL || mcc->mmap_base == NULL) {
+        return EOK;
+    }
+
+    h = (struct sss_mc_header *)mcc->mmap_base;
+    if (h->status != SSS_MC_HEADER_ALIVE || h->b1 != h->b2) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Memory cache %s is not consistent, not saving it\n",
+              mcc->name);
+        return EINVAL;
+    }
+
+    ret = fstat(mcc->fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    snap.magic = SSS_MC_SNAPSHOT_MAGIC;
+    snap.version = SSS_MC_SNAPSHOT_VERSION;
+    snap.type = mcc->type;
+    snap.major_vno = SSS_MC_MAJOR_VNO;
+    snap.minor_vno = SSS_MC_MINOR_VNO;
+    snap.seed = mcc->seed;
+    snap.barrier = h->b1;
+    snap.uid = mcc->uid;
+    snap.gid = mcc->gid;
+    snap.ino = st.st_ino;
+    snap.mmap_size = mcc->mmap_size;
+    snap.timeout = mcc->valid_time_slot;
+    snap.saved = time(NULL);
+
+    path = talloc_asprintf(mcc, "%s"SSS_MC_SNAPSHOT_SUFFIX, mcc->file);
+    tmp_path = talloc_asprintf(mcc, "%s.tmp", path);
+    if (path == NULL || tmp_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    fd = open(tmp_path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    errno = 0;
+    written = sss_atomic_write_s(fd, (uint8_t *)&snap, sizeof(snap));
+    if (written != sizeof(snap)) {
+        ret = written == -1 ? errno : EIO;
+        goto done;
+    }
+
+    ret = rename(tmp_path, path);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Saved snapshot of memory cache %s\n",
+          mcc->name);
+    ret = EOK;
+
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to save snapshot of memory cache %s: %d(%s)\n",
+              mcc->name, ret, strerror(ret));
+        if (tmp_path != NULL) {
+            unlink(tmp_path);
+        }
+    }
+    talloc_free(path);
+    talloc_free(tmp_path);
+    return ret;
+}
+
+/* Reads the snapshot and removes it, so that it is never used twice. */
+static errno_t sss_mc_read_snapshot(const char *filename,
+                                    struct sss_mc_snapshot *snap)
+{
+    char *path;
+    ssize_t len;
+    int fd;
+    errno_t ret;
+
+    path = talloc_asprintf(NULL, "%s"SSS_MC_SNAPSHOT_SUFFIX, filename);
+    if (path == NULL) {
+        return ENOMEM;
+    }
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    errno = 0;
+    len = sss_atomic_read_s(fd, (uint8_t *)snap, sizeof(*snap));
+    close(fd);
+    unlink(path);
+    if (len != sizeof(*snap)) {
+        ret = len == -1 ? errno : EINVAL;
+        goto done;
+    }
+
+    if (snap->magic != SSS_MC_SNAPSHOT_MAGIC
+            || snap->version != SSS_MC_SNAPSHOT_VERSION) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(path);
+    return ret;
+}
+
+static void sss_mc_unmap(struct sss_mc_ctx *mc_ctx)
+{
+    if (mc_ctx->mmap_base != NULL && mc_ctx->mmap_base != MAP_FAILED) {
+        munmap(mc_ctx->mmap_base, mc_ctx->mmap_size);
+    }
+    mc_ctx->mmap_base = NULL;
+
+    if (mc_ctx->fd != -1) {
+        close(mc_ctx->fd);
+        mc_ctx->fd = -1;
+    }
+}
+
+/* Continue with the file described by the snapshot if it was not touched
+ * since the shutdown and matches the current configuration. */
+static errno_t sss_mc_reuse_file(struct sss_mc_ctx *mc_ctx,
+                                 struct sss_mc_snapshot *snap)
+{
+    const useconds_t t = 50000;
+    const int retries = 3;
+    struct sss_mc_header *h;
+    struct stat st;
+    time_t now;
+    errno_t ret;
+
+    now = time(NULL);
+
+    if (snap->type != mc_ctx->type
+            || snap->major_vno != SSS_MC_MAJOR_VNO
+            || snap->minor_vno != SSS_MC_MINOR_VNO
+            || snap->uid != mc_ctx->uid
+            || snap->gid != mc_ctx->gid
+            || snap->mmap_size != mc_ctx->mmap_size
+            || snap->timeout != mc_ctx->valid_time_slot) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Configuration of %s has changed\n",
+              mc_ctx->name);
+        return EINVAL;
+    }
+
+    if (snap->saved > now || now - snap->saved >= mc_ctx->valid_time_slot) {
+        DEBUG(SSSDBG_TRACE_FUNC, "All records of %s have expired\n",
+              mc_ctx->name);
+        return EINVAL;
+    }
+
+    mc_ctx->fd = open(mc_ctx->file, O_RDWR | O_CLOEXEC);
+    if (mc_ctx->fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    ret = fstat(mc_ctx->fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    if (st.st_ino != snap->ino
+            || st.st_size != (off_t)mc_ctx->mmap_size
+            || st.st_uid != mc_ctx->uid
+            || st.st_gid != mc_ctx->gid) {
+        DEBUG(SSSDBG_TRACE_FUNC, "File %s was replaced\n", mc_ctx->file);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = sss_br_lock_file(mc_ctx->fd, 0, 1, retries, t);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    mc_ctx->mmap_base = mmap(NULL, mc_ctx->mmap_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED, mc_ctx->fd, 0);
+    if (mc_ctx->mmap_base == MAP_FAILED) {
+        ret = errno;
+        goto done;
+    }
+
+    mc_ctx->data_table = MC_PTR_ADD(mc_ctx->mmap_base, MC_HEADER_SIZE);
+    mc_ctx->free_table = MC_PTR_ADD(mc_ctx->data_table,
+                                    MC_ALIGN64(mc_ctx->dt_size));
+    mc_ctx->hash_table = MC_PTR_ADD(mc_ctx->free_table,
+                                    MC_ALIGN64(mc_ctx->ft_size));
+
+    /* Any change of the barrier means that the file was written to, or
+     * recycled by sss_cache, after the snapshot was taken. */
+    h = (struct sss_mc_header *)mc_ctx->mmap_base;
+    if (h->b1 != snap->barrier
+            || h->b2 != snap->barrier
+            || h->status != SSS_MC_HEADER_ALIVE
+            || h->major_vno != SSS_MC_MAJOR_VNO
+            || h->minor_vno != SSS_MC_MINOR_VNO
+            || h->seed != snap->seed
+            || h->dt_size != mc_ctx->dt_size
+            || h->ft_size != mc_ctx->ft_size
+            || h->ht_size != mc_ctx->ht_size
+            || h->data_table != MC_PTR_DIFF(mc_ctx->data_table,
+                                            mc_ctx->mmap_base)
+            || h->free_table != MC_PTR_DIFF(mc_ctx->free_table,
+                                            mc_ctx->mmap_base)
+            || h->hash_table != MC_PTR_DIFF(mc_ctx->hash_table,
+                                            mc_ctx->mmap_base)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "File %s was modified\n", mc_ctx->file);
+        ret = EINVAL;
+        goto done;
+    }
+
+    mc_ctx->seed = h->seed;
+    mc_ctx->generation = h->generation;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        sss_mc_unmap(mc_ctx);
+    }
+    return ret;
+}
+
 #define POSIX_FALLOCATE_ATTEMPTS 3
 
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             uid_t uid, gid_t gid,
                             enum sss_mc_type type, size_t n_elem,
-                            time_t timeout, struct sss_mc_ctx **mcc)
+                            time_t timeout, bool warm_start,
+                            struct sss_mc_ctx **mcc)
 {
     /* sss_mc_header alone occupies whole slot,
      * so each entry takes 2 slots at the very least
@@ -1277,6 +1557,7 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     static const int PAYLOAD_FACTOR = 2;
 
     struct sss_mc_ctx *mc_ctx = NULL;
+    struct sss_mc_snapshot snap;
     int ret, dret;
     char *filename;
 
@@ -1284,11 +1565,30 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     if (!filename) {
         return ENOMEM;
     }
-    /*
-     * First of all mark the current file as recycled
-     * and unlink so active clients will abandon its use ASAP
-     */
-    sss_mc_destroy_file(filename);
+
+    /* The snapshot is consumed in any case, so that a stale one is never
+     * used later. */
+    ret = sss_mc_read_snapshot(filename, &snap);
+    if (ret != EOK) {
+        if (warm_start) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "No usable snapshot of %s: %d(%s)\n",
+                  filename, ret, strerror(ret));
+        }
+        warm_start = false;
+    }
+
+    if ((timeout == 0) || (n_elem == 0)) {
+        warm_start = false;
+    }
+
+    if (!warm_start) {
+        /*
+         * First of all mark the current file as recycled
+         * and unlink so active clients will abandon its use ASAP
+         */
+        sss_mc_destroy_file(filename);
+    }
 
     if ((timeout == 0) || (n_elem == 0)) {
         DEBUG(SSSDBG_IMPORTANT_INFO,
@@ -1339,6 +1639,20 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                         MC_ALIGN64(mc_ctx->ft_size) +
                         MC_ALIGN64(mc_ctx->ht_size);
 
+    if (warm_start) {
+        ret = sss_mc_reuse_file(mc_ctx, &snap);
+        if (ret == EOK) {
+            DEBUG(SSSDBG_CONF_SETTINGS,
+                  "Fast '%s' mmap cache continues with the existing file\n",
+                  mc_type_to_str(type));
+            goto done;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Cannot reuse %s, starting with an empty cache\n",
+              mc_ctx->file);
+        sss_mc_destroy_file(mc_ctx->file);
+    }
 
     ret = sss_mc_create_file(mc_ctx);
     if (ret) {
@@ -1468,6 +1782,7 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               type,
                               n_elem,
                               timeout,
+                              false,
                               mc_ctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to re-initialize mmap cache.\n");
@@ -1498,3 +1813,26 @@ void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx)
 
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
 }
+
+/* Invalidate all records at once by starting a new generation. Clients
+ * ignore records of older generations, so unlike sss_mmap_cache_reset()
+ * the tables are not touched and the space is reused as new records are
+ * stored. */
+void sss_mmap_cache_new_generation(struct sss_mc_ctx *mc_ctx)
+{
+    if (mc_ctx == NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Fastcache not initialized. Nothing to do.\n");
+        return;
+    }
+
+    if (mc_ctx->generation == MC_INVALID_VAL32) {
+        /* Records of the oldest generations would become valid again. */
+        mc_ctx->generation = 0;
+        sss_mmap_cache_reset(mc_ctx);
+        return;
+    }
+
+    mc_ctx->generation++;
+    sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
+}
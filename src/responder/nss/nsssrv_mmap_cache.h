@@ -31,10 +31,17 @@ enum sss_mc_type {
     SSS_MC_INITGROUPS,
 };
 
+/* If warm_start is true, the file left behind by the previous instance is
+ * reused when it has a valid snapshot, see sss_mmap_cache_save(). */
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             uid_t uid, gid_t gid,
                             enum sss_mc_type type, size_t n_elem,
-                            time_t valid_time, struct sss_mc_ctx **mcc);
+                            time_t valid_time, bool warm_start,
+                            struct sss_mc_ctx **mcc);
+
+/* Save a snapshot of the memory cache file so that the next instance of
+ * the responder can continue with it. To be called on shutdown. */
+errno_t sss_mmap_cache_save(struct sss_mc_ctx *mcc);
 
 errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
                                 struct sized_string *name,
@@ -76,4 +83,6 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
 
 void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx);
 
+void sss_mmap_cache_new_generation(struct sss_mc_ctx *mc_ctx);
+
 #endif /* _NSSSRV_MMAP_CACHE_H_ */
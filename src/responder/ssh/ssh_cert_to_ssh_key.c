@@ -17,11 +17,38 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <sys/stat.h>
+
 #include "util/util.h"
 #include "util/cert.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/child_common.h"
+#include "util/sss_thread_pool.h"
 #include "lib/certmap/sss_certmap.h"
+#include "util/sss_ptr_hash.h"
+#include "responder/ssh/ssh_private.h"
+
+/* The cache is dropped if it grows over this limit and nothing is expired. */
+#define CERT_TO_SSH_KEY_CACHE_MAX 1024
+
+/* A certificate may be found invalid only because e.g. the OCSP responder
+ * was not reachable, so negative results are kept for a short time only. */
+#define CERT_TO_SSH_KEY_CACHE_NEG_TIMEOUT 30
+
+/* Result of a validation by p11_child. The key is empty if the
+ * certificate was not valid. */
+struct cert_to_ssh_key_cache_entry {
+    struct ldb_val key;
+    time_t expire;
+};
+
+struct cert_to_ssh_key_cache {
+    /* struct cert_to_ssh_key_cache_entry keyed by base64 certificate */
+    hash_table_t *entries;
+    /* The validation policy the entries were created with. */
+    char *policy;
+    int timeout;
+};
 
 struct cert_to_ssh_key_state {
     struct tevent_context *ev;
@@ -34,26 +61,344 @@ struct cert_to_ssh_key_state {
     size_t iter;
     size_t valid_keys;
 
+    struct cert_to_ssh_key_cache *cache;
+
     struct sss_child_ctx_old *child_ctx;
     struct tevent_timer *timeout_handler;
     struct child_io_fds *io;
 };
 
+struct cert_to_ssh_key_match {
+    struct sss_certmap_ctx *sss_certmap_ctx;
+    size_t cert_count;
+    struct ldb_val *certs;
+    bool *matched;
+};
+
+errno_t cert_to_ssh_key_cache_create(TALLOC_CTX *mem_ctx,
+                                     int timeout,
+                                     struct cert_to_ssh_key_cache **_cache)
+{
+    struct cert_to_ssh_key_cache *cache;
+
+    cache = talloc_zero(mem_ctx, struct cert_to_ssh_key_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout;
+    cache->entries = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->entries == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    *_cache = cache;
+
+    return EOK;
+}
+
+static char *append_mtime(char *policy, const char *path)
+{
+    struct stat st;
+    int ret;
+
+    ret = stat(path, &st);
+    if (ret != 0) {
+        return talloc_asprintf_append(policy, "|%s:-", path);
+    }
+
+    return talloc_asprintf_append(policy, "|%s:%lld.%ld:%lld", path,
+                                  (long long) st.st_mtim.tv_sec,
+                                  st.st_mtim.tv_nsec,
+                                  (long long) st.st_size);
+}
+
+/* The result of a validation depends on the options, the trusted CAs and
+ * the CRLs. Any change of them invalidates all cached results. */
+static errno_t cert_to_ssh_key_cache_check(struct cert_to_ssh_key_cache *cache,
+                                           const char *ca_db,
+                                           const char *verify_opts)
+{
+    TALLOC_CTX *tmp_ctx;
+    char **opts = NULL;
+    char *policy;
+    int num_opts = 0;
+    errno_t ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    policy = talloc_asprintf(tmp_ctx, "%s", verify_opts == NULL ? ""
+                                                                 : verify_opts);
+    if (policy == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    policy = append_mtime(policy, ca_db);
+    if (policy == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (verify_opts != NULL) {
+        ret = split_on_separator(tmp_ctx, verify_opts, ',', true, true,
+                                 &opts, &num_opts);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (i = 0; i < num_opts; i++) {
+        if (strncasecmp(opts[i], "crl_file=", sizeof("crl_file=") - 1) != 0) {
+            continue;
+        }
+
+        policy = append_mtime(policy, opts[i] + sizeof("crl_file=") - 1);
+        if (policy == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    if (cache->policy == NULL || strcmp(cache->policy, policy) != 0) {
+        if (cache->policy != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Certificate validation policy changed, "
+                  "dropping cached results.\n");
+        }
+
+        sss_ptr_hash_delete_all(cache->entries, true);
+        talloc_free(cache->policy);
+        cache->policy = talloc_steal(cache, policy);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+static void cert_to_ssh_key_cache_purge(struct cert_to_ssh_key_cache *cache,
+                                        time_t now)
+{
+    struct cert_to_ssh_key_cache_entry *entry;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    hret = hash_values(cache->entries, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        sss_ptr_hash_delete_all(cache->entries, true);
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        entry = sss_ptr_get_value(&values[i],
+                                  struct cert_to_ssh_key_cache_entry);
+        if (entry != NULL && entry->expire <= now) {
+            talloc_free(entry);
+        }
+    }
+
+    talloc_free(values);
+
+    if (hash_count(cache->entries) >= CERT_TO_SSH_KEY_CACHE_MAX) {
+        sss_ptr_hash_delete_all(cache->entries, true);
+    }
+}
+
+static void cert_to_ssh_key_cache_add(struct cert_to_ssh_key_cache *cache,
+                                      const char *cert,
+                                      struct ldb_val *key)
+{
+    struct cert_to_ssh_key_cache_entry *entry;
+    time_t now;
+    errno_t ret;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    now = time(NULL);
+
+    entry = sss_ptr_hash_lookup(cache->entries, cert,
+                                struct cert_to_ssh_key_cache_entry);
+    talloc_free(entry);
+
+    if (hash_count(cache->entries) >= CERT_TO_SSH_KEY_CACHE_MAX) {
+        cert_to_ssh_key_cache_purge(cache, now);
+    }
+
+    entry = talloc_zero(cache, struct cert_to_ssh_key_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    if (key->data != NULL) {
+        entry->expire = now + cache->timeout;
+
+        entry->key.data = talloc_memdup(entry, key->data, key->length);
+        if (entry->key.data == NULL) {
+            talloc_free(entry);
+            return;
+        }
+        entry->key.length = key->length;
+    } else {
+        entry->expire = now + MIN(cache->timeout,
+                                  CERT_TO_SSH_KEY_CACHE_NEG_TIMEOUT);
+    }
+
+    ret = sss_ptr_hash_add(cache->entries, cert, entry,
+                           struct cert_to_ssh_key_cache_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache validation result "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        talloc_free(entry);
+    }
+}
+
+/* Fills the key of the current certificate from the cache.
+ *
+ * @return ENOENT if the certificate must be validated by p11_child. */
+static errno_t cert_to_ssh_key_from_cache(struct cert_to_ssh_key_state *state)
+{
+    struct cert_to_ssh_key_cache_entry *entry;
+    struct ldb_val *key = &state->keys[state->iter];
+
+    if (state->cache == NULL) {
+        return ENOENT;
+    }
+
+    entry = sss_ptr_hash_lookup(state->cache->entries,
+                                state->certs[state->iter],
+                                struct cert_to_ssh_key_cache_entry);
+    if (entry == NULL) {
+        return ENOENT;
+    }
+
+    if (entry->expire <= time(NULL)) {
+        talloc_free(entry);
+        return ENOENT;
+    }
+
+    if (entry->key.data == NULL) {
+        DEBUG(SSSDBG_TRACE_LIBS, "Certificate [%s] is not valid (cached).\n",
+                                 state->certs[state->iter]);
+        key->data = NULL;
+        key->length = 0;
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Certificate [%s] is valid (cached).\n",
+                             state->certs[state->iter]);
+
+    key->data = talloc_memdup(state->keys, entry->key.data, entry->key.length);
+    if (key->data == NULL) {
+        return ENOMEM;
+    }
+    key->length = entry->key.length;
+    state->valid_keys++;
+
+    return EOK;
+}
+
 static errno_t cert_to_ssh_key_step(struct tevent_req *req);
+static void cert_to_ssh_key_match_done(struct tevent_req *subreq);
 static void cert_to_ssh_key_done(int child_status,
                                  struct tevent_signal *sige,
                                  void *pvt);
 
+/* Runs in a worker thread, see sss_thread_pool_fn. */
+static errno_t cert_to_ssh_key_match(void *pvt)
+{
+    struct cert_to_ssh_key_match *match = pvt;
+    size_t c;
+
+    for (c = 0; c < match->cert_count; c++) {
+        match->matched[c] = sss_certmap_match_cert(match->sss_certmap_ctx,
+                                                   match->certs[c].data,
+                                                   match->certs[c].length) == 0;
+    }
+
+    return EOK;
+}
+
+static struct tevent_req *
+cert_to_ssh_key_match_send(TALLOC_CTX *mem_ctx,
+                           struct tevent_context *ev,
+                           struct sss_thread_pool *thread_pool,
+                           struct sss_certmap_ctx *sss_certmap_ctx,
+                           size_t cert_count,
+                           struct ldb_val *bin_certs)
+{
+    struct cert_to_ssh_key_match *match;
+    size_t c;
+
+    match = talloc_zero(mem_ctx, struct cert_to_ssh_key_match);
+    if (match == NULL) {
+        return NULL;
+    }
+
+    match->sss_certmap_ctx = sss_certmap_ctx;
+    match->cert_count = cert_count;
+    match->matched = talloc_zero_array(match, bool, cert_count);
+    match->certs = talloc_zero_array(match, struct ldb_val, cert_count);
+    if (match->matched == NULL || match->certs == NULL) {
+        talloc_free(match);
+        return NULL;
+    }
+
+    /* The original values may be freed while the job is running. */
+    for (c = 0; c < cert_count; c++) {
+        match->certs[c].data = talloc_memdup(match->certs, bin_certs[c].data,
+                                             bin_certs[c].length);
+        if (match->certs[c].data == NULL) {
+            talloc_free(match);
+            return NULL;
+        }
+        match->certs[c].length = bin_certs[c].length;
+    }
+
+    return sss_thread_pool_job_send(mem_ctx, ev, thread_pool,
+                                    cert_to_ssh_key_match, match);
+}
+
+static errno_t cert_to_ssh_key_add_cert(struct cert_to_ssh_key_state *state,
+                                        struct ldb_val *bin_cert)
+{
+    state->certs[state->cert_count] = sss_base64_encode(state->certs,
+                                                        bin_cert->data,
+                                                        bin_cert->length);
+    if (state->certs[state->cert_count] == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sss_base64_encode failed.\n");
+        return EINVAL;
+    }
+
+    state->cert_count++;
+
+    return EOK;
+}
+
 struct tevent_req *cert_to_ssh_key_send(TALLOC_CTX *mem_ctx,
                                         struct tevent_context *ev,
                                         const char *logfile, time_t timeout,
                                         const char *ca_db,
                                         struct sss_certmap_ctx *sss_certmap_ctx,
+                                        struct sss_thread_pool *thread_pool,
+                                        struct cert_to_ssh_key_cache *cache,
                                         size_t cert_count,
                                         struct ldb_val *bin_certs,
                                         const char *verify_opts)
 {
     struct tevent_req *req;
+    struct tevent_req *subreq;
     struct cert_to_ssh_key_state *state;
     size_t arg_c;
     size_t c;
@@ -117,6 +462,36 @@ struct tevent_req *cert_to_ssh_key_send(TALLOC_CTX *mem_ctx,
     }
 
     state->cert_count = 0;
+    state->iter = 0;
+
+    if (cache != NULL) {
+        ret = cert_to_ssh_key_cache_check(cache, ca_db, verify_opts);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to check validation policy, "
+                  "certificates will not be cached [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        } else {
+            state->cache = cache;
+        }
+    }
+
+    if (sss_certmap_ctx != NULL && thread_pool != NULL) {
+        /* Matching many certificates is expensive, do not block other
+         * clients meanwhile. */
+        subreq = cert_to_ssh_key_match_send(state, ev, thread_pool,
+                                            sss_certmap_ctx, cert_count,
+                                            bin_certs);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "cert_to_ssh_key_match_send failed.\n");
+            ret = ENOMEM;
+            goto done;
+        }
+        tevent_req_set_callback(subreq, cert_to_ssh_key_match_done, req);
+
+        ret = EAGAIN;
+        goto done;
+    }
+
     for (c = 0; c < cert_count; c++) {
 
         if (sss_certmap_ctx != NULL) {
@@ -128,20 +503,13 @@ struct tevent_req *cert_to_ssh_key_send(TALLOC_CTX *mem_ctx,
                 continue;
             }
         }
-        state->certs[state->cert_count] = sss_base64_encode(state->certs,
-                                                            bin_certs[c].data,
-                                                            bin_certs[c].length);
-        if (state->certs[state->cert_count] == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "sss_base64_encode failed.\n");
-            ret = EINVAL;
+
+        ret = cert_to_ssh_key_add_cert(state, &bin_certs[c]);
+        if (ret != EOK) {
             goto done;
         }
-
-        state->cert_count++;
     }
 
-    state->iter = 0;
-
     ret = cert_to_ssh_key_step(req);
 
 done:
@@ -157,6 +525,51 @@ done:
     return req;
 }
 
+static void cert_to_ssh_key_match_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct cert_to_ssh_key_state *state = tevent_req_data(req,
+                                                  struct cert_to_ssh_key_state);
+    struct cert_to_ssh_key_match *match = NULL;
+    size_t c;
+    errno_t ret;
+
+    ret = sss_thread_pool_job_recv(state, subreq, (void **) &match);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Certificate matching failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (c = 0; c < match->cert_count; c++) {
+        if (!match->matched[c]) {
+            DEBUG(SSSDBG_TRACE_ALL, "Certificate does not match matching "
+                                    "rules and is ignored.\n");
+            continue;
+        }
+
+        ret = cert_to_ssh_key_add_cert(state, &match->certs[c]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = cert_to_ssh_key_step(req);
+
+done:
+    talloc_free(match);
+
+    if (ret != EAGAIN) {
+        if (ret == EOK) {
+            tevent_req_done(req);
+        } else {
+            tevent_req_error(req, ret);
+        }
+    }
+}
+
 static void p11_child_timeout(struct tevent_context *ev,
                               struct tevent_timer *te,
                               struct timeval tv, void *pvt)
@@ -181,6 +594,15 @@ static errno_t cert_to_ssh_key_step(struct tevent_req *req)
     pid_t child_pid;
     struct timeval tv;
 
+    for (; state->iter < state->cert_count; state->iter++) {
+        ret = cert_to_ssh_key_from_cache(state);
+        if (ret == ENOENT) {
+            break;
+        } else if (ret != EOK) {
+            return ret;
+        }
+    }
+
     if (state->iter >= state->cert_count) {
         return EOK;
     }
@@ -266,16 +688,20 @@ static void cert_to_ssh_key_done(int child_status,
                                                   struct cert_to_ssh_key_state);
     int ret;
     bool valid = false;
+    bool cache_result = false;
 
     PIPE_FD_CLOSE(state->io->read_from_child_fd);
     PIPE_FD_CLOSE(state->io->write_to_child_fd);
 
     if (WIFEXITED(child_status)) {
-        if (WEXITSTATUS(child_status) != 0) {
+        if (WEXITSTATUS(child_status) == 0) {
+            valid = true;
+            cache_result = true;
+        } else if (WEXITSTATUS(child_status) == P11_CHILD_EXIT_CERT_INVALID) {
+            cache_result = true;
+        } else {
             DEBUG(SSSDBG_OP_FAILURE,
                   P11_CHILD_PATH " failed with status [%d]\n", child_status);
-        } else {
-            valid = true;
         }
     }
 
@@ -300,6 +726,7 @@ static void cert_to_ssh_key_done(int child_status,
                                      state->certs[state->iter]);
             state->keys[state->iter].data = NULL;
             state->keys[state->iter].length = 0;
+            cache_result = false;
         }
     } else {
         DEBUG(SSSDBG_MINOR_FAILURE, "Certificate [%s] is not valid.\n",
@@ -308,6 +735,12 @@ static void cert_to_ssh_key_done(int child_status,
         state->keys[state->iter].length = 0;
     }
 
+    /* Remember only the verdict of p11_child, not its failures. */
+    if (cache_result) {
+        cert_to_ssh_key_cache_add(state->cache, state->certs[state->iter],
+                                  &state->keys[state->iter]);
+    }
+
     state->iter++;
     ret = cert_to_ssh_key_step(req);
 
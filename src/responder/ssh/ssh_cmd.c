@@ -136,6 +136,11 @@ static void ssh_ext_debug(void *private, const char *file, long line,
     struct priv_sss_debug *data = private;
     int level = SSSDBG_OP_FAILURE;
 
+    if (sss_thread_pool_in_worker()) {
+        /* Debug logging is not thread-safe. */
+        return;
+    }
+
     if (data != NULL) {
         level = data->level;
     }
@@ -181,6 +186,14 @@ static errno_t ssh_cmd_refresh_certmap_ctx(struct ssh_ctx *ssh_ctx,
         return EOK;
     }
 
+    if (ssh_ctx->thread_pool != NULL
+            && sss_thread_pool_busy(ssh_ctx->thread_pool) > 0) {
+        /* The current rules may be in use by a worker thread. */
+        DEBUG(SSSDBG_TRACE_FUNC, "Certificate matching in progress, "
+              "certmap update postponed.\n");
+        return EOK;
+    }
+
     ret = sss_certmap_init(ssh_ctx, ssh_ext_debug, NULL, &sss_certmap_ctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "sss_certmap_init failed.\n");
@@ -372,9 +385,7 @@ static void ssh_cmd_get_host_pubkeys_done(struct tevent_req *subreq)
     if (ret == EOK || ret == ENOENT) {
         domain = ssh_get_result_domain(ssh_ctx->rctx, result, cmd_ctx->domain);
 
-        ssh_update_known_hosts_file(ssh_ctx->rctx->domains, domain,
-                                    cmd_ctx->name, ssh_ctx->hash_known_hosts,
-                                    ssh_ctx->known_hosts_timeout);
+        ssh_update_known_hosts_file(ssh_ctx, domain, cmd_ctx->name);
     }
 
     if (ret != EOK) {
@@ -25,6 +25,7 @@
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/sss_ssh.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb.h"
 #include "db/sysdb_ssh.h"
 #include "responder/ssh/ssh_private.h"
@@ -166,46 +167,199 @@ done:
     return result;
 }
 
-static errno_t
-ssh_write_known_hosts(struct sss_domain_info *domains,
-                      bool hash_known_hosts,
-                      time_t now,
-                      int fd)
+/* The known hosts file is generated from an in-memory copy of its entries.
+ * A lookup only refreshes the entry of the host it was made for and the
+ * file is rewritten only if the set of entries changed. The whole set is
+ * reloaded from the cache once per known hosts timeout to pick up hosts
+ * refreshed by the back ends, the formatted (and hashed) lines of hosts
+ * that did not change are kept. */
+
+struct ssh_known_host {
+    /* Lines in plain format, used to find out if the host changed. */
+    char *plain;
+    /* Lines as they are written to the file. */
+    char *line;
+    time_t expire;
+};
+
+struct ssh_known_hosts {
+    /* struct ssh_known_host keyed by domain and host name */
+    hash_table_t *hosts;
+    time_t loaded;
+    time_t next_expire;
+    bool dirty;
+};
+
+static const char *ssh_known_hosts_attrs[] = {
+    SYSDB_NAME,
+    SYSDB_NAME_ALIAS,
+    SYSDB_SSH_PUBKEY,
+    SYSDB_CACHE_EXPIRE,
+    SYSDB_SSH_KNOWN_HOSTS_EXPIRE,
+    NULL
+};
+
+static char *ssh_known_host_key(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name)
+{
+    return talloc_asprintf(mem_ctx, "%s/%s", domain->name, name);
+}
+
+/* Returns the time when the host drops out of the file, see
+ * sysdb_get_ssh_known_hosts() for the conditions. */
+static time_t ssh_known_host_expire(struct ldb_message *host)
+{
+    time_t cache_expire;
+    time_t expire;
+
+    expire = ldb_msg_find_attr_as_int64(host, SYSDB_SSH_KNOWN_HOSTS_EXPIRE, 0);
+
+    cache_expire = ldb_msg_find_attr_as_int64(host, SYSDB_CACHE_EXPIRE, 0);
+    if (cache_expire != 0 && cache_expire < expire) {
+        expire = cache_expire;
+    }
+
+    return expire;
+}
+
+/* Creates the entry of @host, @old is reused if the host did not change. */
+static errno_t ssh_known_host_new(TALLOC_CTX *mem_ctx,
+                                  struct ldb_message *host,
+                                  bool hash_known_hosts,
+                                  struct ssh_known_host *old,
+                                  struct ssh_known_host **_entry,
+                                  bool *_changed)
+{
+    struct ssh_known_host *entry;
+    struct sss_ssh_ent *ent;
+    errno_t ret;
+
+    entry = talloc_zero(mem_ctx, struct ssh_known_host);
+    if (entry == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_ssh_make_ent(entry, host, &ent);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to get SSH host public keys\n");
+        goto done;
+    }
+
+    entry->expire = ssh_known_host_expire(host);
+
+    entry->plain = ssh_host_pubkeys_format_known_host_plain(entry, ent);
+    if (entry->plain == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to format known_hosts data "
+              "for [%s]\n", ent->name);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (old != NULL && strcmp(old->plain, entry->plain) == 0) {
+        entry->line = talloc_steal(entry, old->line);
+        *_changed = false;
+    } else {
+        if (hash_known_hosts) {
+            entry->line = ssh_host_pubkeys_format_known_host_hashed(entry,
+                                                                    ent);
+        } else {
+            entry->line = entry->plain;
+        }
+
+        if (entry->line == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to format known_hosts data "
+                  "for [%s]\n", ent->name);
+            ret = ENOMEM;
+            goto done;
+        }
+
+        *_changed = true;
+    }
+
+    talloc_free(ent);
+
+    *_entry = entry;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(entry);
+    }
+
+    return ret;
+}
+
+/* Adds @entry under @key, replacing @old if there is one. */
+static errno_t ssh_known_hosts_add(struct ssh_known_hosts *kh,
+                                   const char *key,
+                                   struct ssh_known_host *entry,
+                                   struct ssh_known_host *old)
+{
+    errno_t ret;
+
+    /* Freeing the old value removes it from the table. */
+    talloc_free(old);
+
+    ret = sss_ptr_hash_add(kh->hosts, key, entry, struct ssh_known_host);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (kh->next_expire == 0 || entry->expire < kh->next_expire) {
+        kh->next_expire = entry->expire;
+    }
+
+    return EOK;
+}
+
+/* Reloads all entries from the cache. */
+static errno_t ssh_known_hosts_load(struct ssh_ctx *ssh_ctx,
+                                    struct ssh_known_hosts *kh,
+                                    time_t now)
 {
     TALLOC_CTX *tmp_ctx;
     struct sss_domain_info *dom;
+    struct ssh_known_host *entry;
+    struct ssh_known_host *old;
     struct ldb_message **hosts;
-    struct sysdb_ctx *sysdb;
-    struct sss_ssh_ent *ent;
-    char *entstr;
+    hash_table_t *old_hosts;
+    const char *name;
     size_t num_hosts;
+    size_t count = 0;
+    bool changed;
+    char *key;
     size_t i;
-    ssize_t wret;
     errno_t ret;
 
-    static const char *attrs[] = {
-        SYSDB_NAME,
-        SYSDB_NAME_ALIAS,
-        SYSDB_SSH_PUBKEY,
-        NULL
-    };
-
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
         return ENOMEM;
     }
 
-    for (dom = domains; dom != NULL; dom = get_next_domain(dom, false)) {
-        sysdb = dom->sysdb;
-        if (sysdb == NULL) {
+    old_hosts = talloc_steal(tmp_ctx, kh->hosts);
+
+    kh->hosts = sss_ptr_hash_create(kh, NULL, NULL);
+    if (kh->hosts == NULL) {
+        kh->hosts = talloc_steal(kh, old_hosts);
+        ret = ENOMEM;
+        goto done;
+    }
+    kh->next_expire = 0;
+
+    for (dom = ssh_ctx->rctx->domains;
+         dom != NULL;
+         dom = get_next_domain(dom, false)) {
+        if (dom->sysdb == NULL) {
             DEBUG(SSSDBG_FATAL_FAILURE,
                   "Fatal: Sysdb CTX not found for this domain!\n");
             ret = EFAULT;
             goto done;
         }
 
-        ret = sysdb_get_ssh_known_hosts(tmp_ctx, dom, now, attrs,
+        ret = sysdb_get_ssh_known_hosts(tmp_ctx, dom, now,
+                                        ssh_known_hosts_attrs,
                                         &hosts, &num_hosts);
         if (ret == ENOENT) {
             continue;
@@ -216,37 +370,52 @@ ssh_write_known_hosts(struct sss_domain_info *domains,
         }
 
         for (i = 0; i < num_hosts; i++) {
-            ret = sss_ssh_make_ent(tmp_ctx, hosts[i], &ent);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Failed to get SSH host public keys\n");
+            name = ldb_msg_find_attr_as_string(hosts[i], SYSDB_NAME, NULL);
+            if (name == NULL) {
                 continue;
             }
 
-            if (hash_known_hosts) {
-                entstr = ssh_host_pubkeys_format_known_host_hashed(ent, ent);
-            } else {
-                entstr = ssh_host_pubkeys_format_known_host_plain(ent, ent);
+            key = ssh_known_host_key(tmp_ctx, dom, name);
+            if (key == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            old = NULL;
+            if (old_hosts != NULL) {
+                old = sss_ptr_hash_lookup(old_hosts, key,
+                                          struct ssh_known_host);
             }
 
-            if (entstr == NULL) {
-                DEBUG(SSSDBG_OP_FAILURE, "Failed to format known_hosts data "
-                      "for [%s]\n", ent->name);
+            ret = ssh_known_host_new(kh->hosts, hosts[i],
+                                     ssh_ctx->hash_known_hosts,
+                                     old, &entry, &changed);
+            if (ret != EOK) {
+                talloc_free(key);
                 continue;
             }
 
-            wret = sss_atomic_write_s(fd, entstr, strlen(entstr));
-            if (wret == -1) {
-                ret = errno;
+            ret = ssh_known_hosts_add(kh, key, entry, NULL);
+            if (ret != EOK) {
                 goto done;
             }
 
-            talloc_free(ent);
+            if (changed || old == NULL) {
+                kh->dirty = true;
+            }
+            count++;
+
+            talloc_free(key);
         }
 
         talloc_free(hosts);
     }
 
+    if (old_hosts == NULL || count != hash_count(old_hosts)) {
+        kh->dirty = true;
+    }
+
+    kh->loaded = now;
     ret = EOK;
 
 done:
@@ -255,18 +424,21 @@ done:
     return ret;
 }
 
-errno_t
-ssh_update_known_hosts_file(struct sss_domain_info *domains,
-                            struct sss_domain_info *domain,
-                            const char *name,
-                            bool hash_known_hosts,
-                            int known_hosts_timeout)
+/* Refreshes the entry of the host @name after its expiration was updated. */
+static errno_t ssh_known_hosts_refresh(struct ssh_ctx *ssh_ctx,
+                                       struct ssh_known_hosts *kh,
+                                       struct sss_domain_info *domain,
+                                       const char *name,
+                                       time_t now)
 {
     TALLOC_CTX *tmp_ctx;
-    char *filename;
+    struct ssh_known_host *entry;
+    struct ssh_known_host *old;
+    struct ldb_message *host;
+    const char *cached_name;
+    bool changed;
+    char *key;
     errno_t ret;
-    time_t now;
-    int fd = -1;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -274,17 +446,172 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
         return ENOMEM;
     }
 
-    now = time(NULL);
+    ret = sysdb_get_ssh_host(tmp_ctx, domain, name, ssh_known_hosts_attrs,
+                             &host);
+    if (ret == ENOENT) {
+        key = ssh_known_host_key(tmp_ctx, domain, name);
+        if (key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
 
-    /* Update host's expiration time. */
-    if (domain != NULL) {
-        ret = sysdb_update_ssh_known_host_expire(domain, name, now,
-                                                 known_hosts_timeout);
-        if (ret != EOK && ret != ENOENT) {
+        old = sss_ptr_hash_lookup(kh->hosts, key, struct ssh_known_host);
+        if (old != NULL) {
+            talloc_free(old);
+            kh->dirty = true;
+        }
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    /* Entries are keyed by the name stored in the cache, the same way
+     * ssh_known_hosts_load() does, which might differ from the name the
+     * lookup was made for. */
+    cached_name = ldb_msg_find_attr_as_string(host, SYSDB_NAME, NULL);
+    if (cached_name == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Host [%s] has no name\n", name);
+        ret = EINVAL;
+        goto done;
+    }
+
+    key = ssh_known_host_key(tmp_ctx, domain, cached_name);
+    if (key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    old = sss_ptr_hash_lookup(kh->hosts, key, struct ssh_known_host);
+
+    ret = ssh_known_host_new(kh->hosts, host, ssh_ctx->hash_known_hosts,
+                             old, &entry, &changed);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (entry->expire <= now) {
+        talloc_free(entry);
+        if (old != NULL) {
+            talloc_free(old);
+            kh->dirty = true;
+        }
+        ret = EOK;
+        goto done;
+    }
+
+    if (changed || old == NULL) {
+        kh->dirty = true;
+    }
+
+    ret = ssh_known_hosts_add(kh, key, entry, old);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+/* Drops the entries that expired since the last update. */
+static errno_t ssh_known_hosts_expire(struct ssh_known_hosts *kh, time_t now)
+{
+    struct ssh_known_host *entry;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    if (kh->next_expire == 0 || kh->next_expire > now) {
+        return EOK;
+    }
+
+    hret = hash_values(kh->hosts, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    kh->next_expire = 0;
+    for (i = 0; i < count; i++) {
+        entry = sss_ptr_get_value(&values[i], struct ssh_known_host);
+        if (entry->expire <= now) {
+            talloc_free(entry);
+            kh->dirty = true;
+        } else if (kh->next_expire == 0 || entry->expire < kh->next_expire) {
+            kh->next_expire = entry->expire;
+        }
+    }
+
+    talloc_free(values);
+
+    return EOK;
+}
+
+static int ssh_known_host_cmp(const void *a, const void *b)
+{
+    const hash_entry_t *ea = a;
+    const hash_entry_t *eb = b;
+
+    return strcmp(ea->key.str, eb->key.str);
+}
+
+/* Entries are written sorted by domain and host name so that the file does
+ * not change with the layout of the hash table. */
+static errno_t
+ssh_write_known_hosts(struct ssh_known_hosts *kh, int fd)
+{
+    struct ssh_known_host *entry;
+    hash_entry_t *entries;
+    unsigned long count;
+    unsigned long i;
+    ssize_t wret;
+    errno_t ret;
+    int hret;
+
+    hret = hash_entries(kh->hosts, &count, &entries);
+    if (hret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    qsort(entries, count, sizeof(hash_entry_t), ssh_known_host_cmp);
+
+    for (i = 0; i < count; i++) {
+        entry = sss_ptr_get_value(&entries[i].value, struct ssh_known_host);
+
+        wret = sss_atomic_write_s(fd, entry->line, strlen(entry->line));
+        if (wret == -1) {
+            ret = errno;
             goto done;
         }
     }
 
+    ret = EOK;
+
+done:
+    talloc_free(entries);
+
+    return ret;
+}
+
+static errno_t
+ssh_known_hosts_flush(struct ssh_known_hosts *kh)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *filename;
+    errno_t ret;
+    int fd = -1;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
     /* Create temporary known hosts file. */
     filename = talloc_strdup(tmp_ctx, SSS_SSH_KNOWN_HOSTS_TEMP_TMPL);
     if (filename == NULL) {
@@ -299,14 +626,13 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
     }
 
     /* Write contents. */
-    ret = ssh_write_known_hosts(domains, hash_known_hosts, now, fd);
+    ret = ssh_write_known_hosts(kh, fd);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to write known hosts file "
               "[%d]: %s\n", ret, sss_strerror(ret));
         goto done;
     }
 
-
     /* Rename to SSH known hosts file. */
     ret = fchmod(fd, 0644);
     if (ret == -1) {
@@ -320,6 +646,7 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
         goto done;
     }
 
+    kh->dirty = false;
     ret = EOK;
 
 done:
@@ -331,3 +658,59 @@ done:
 
     return ret;
 }
+
+errno_t
+ssh_update_known_hosts_file(struct ssh_ctx *ssh_ctx,
+                            struct sss_domain_info *domain,
+                            const char *name)
+{
+    struct ssh_known_hosts *kh;
+    errno_t ret;
+    time_t now;
+
+    now = time(NULL);
+
+    if (ssh_ctx->known_hosts == NULL) {
+        kh = talloc_zero(ssh_ctx, struct ssh_known_hosts);
+        if (kh == NULL) {
+            return ENOMEM;
+        }
+
+        ssh_ctx->known_hosts = kh;
+    }
+    kh = ssh_ctx->known_hosts;
+
+    /* Update host's expiration time. */
+    if (domain != NULL) {
+        ret = sysdb_update_ssh_known_host_expire(domain, name, now,
+                                                 ssh_ctx->known_hosts_timeout);
+        if (ret != EOK && ret != ENOENT) {
+            return ret;
+        }
+    }
+
+    if (kh->hosts == NULL
+            || now - kh->loaded >= ssh_ctx->known_hosts_timeout) {
+        ret = ssh_known_hosts_load(ssh_ctx, kh, now);
+    } else if (domain != NULL) {
+        ret = ssh_known_hosts_refresh(ssh_ctx, kh, domain, name, now);
+    } else {
+        ret = EOK;
+    }
+    if (ret != EOK) {
+        /* Start from scratch next time. */
+        talloc_zfree(kh->hosts);
+        return ret;
+    }
+
+    ret = ssh_known_hosts_expire(kh, now);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (!kh->dirty) {
+        return EOK;
+    }
+
+    return ssh_known_hosts_flush(kh);
+}
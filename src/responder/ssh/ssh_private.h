@@ -23,9 +23,11 @@
 
 #include "responder/common/responder.h"
 #include "responder/common/cache_req/cache_req.h"
+#include "util/sss_thread_pool.h"
 
 #define SSS_SSH_KNOWN_HOSTS_PATH PUBCONF_PATH"/known_hosts"
 #define SSS_SSH_KNOWN_HOSTS_TEMP_TMPL PUBCONF_PATH"/.known_hosts.XXXXXX"
+#define SSS_SSH_THREAD_POOL_SIZE 2
 
 struct ssh_ctx {
     struct resp_ctx *rctx;
@@ -33,6 +35,8 @@ struct ssh_ctx {
 
     bool hash_known_hosts;
     int known_hosts_timeout;
+    /* In-memory copy of the known hosts file, see ssh_known_hosts.c */
+    struct ssh_known_hosts *known_hosts;
     char *ca_db;
     bool use_cert_keys;
 
@@ -40,6 +44,11 @@ struct ssh_ctx {
     struct sss_certmap_ctx *sss_certmap_ctx;
     char **cert_rules;
     bool cert_rules_error;
+
+    /* Certificate matching runs here, see cert_to_ssh_key_send() */
+    struct sss_thread_pool *thread_pool;
+    /* Results of certificate validation, NULL if disabled */
+    struct cert_to_ssh_key_cache *cert_cache;
 };
 
 struct sss_cmd_table *get_ssh_cmds(void);
@@ -80,17 +89,25 @@ ssh_protocol_build_reply(struct sss_packet *packet,
                          uint32_t num_keys);
 
 errno_t
-ssh_update_known_hosts_file(struct sss_domain_info *domains,
+ssh_update_known_hosts_file(struct ssh_ctx *ssh_ctx,
                             struct sss_domain_info *domain,
-                            const char *name,
-                            bool hash_known_hosts,
-                            int known_hosts_timeout);
+                            const char *name);
+
+struct cert_to_ssh_key_cache;
+
+/* Create a cache of certificate validation results which are kept for
+ * @timeout seconds. */
+errno_t cert_to_ssh_key_cache_create(TALLOC_CTX *mem_ctx,
+                                     int timeout,
+                                     struct cert_to_ssh_key_cache **_cache);
 
 struct tevent_req *cert_to_ssh_key_send(TALLOC_CTX *mem_ctx,
                                         struct tevent_context *ev,
                                         const char *logfile, time_t timeout,
                                         const char *ca_db,
                                         struct sss_certmap_ctx *sss_certmap_ctx,
+                                        struct sss_thread_pool *thread_pool,
+                                        struct cert_to_ssh_key_cache *cache,
                                         size_t cert_count,
                                         struct ldb_val *bin_certs,
                                         const char *verify_opts);
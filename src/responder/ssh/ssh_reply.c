@@ -253,6 +253,8 @@ struct tevent_req *ssh_get_output_keys_send(TALLOC_CTX *mem_ctx,
                                   state->p11_child_timeout,
                                   state->ssh_ctx->ca_db,
                                   state->ssh_ctx->sss_certmap_ctx,
+                                  state->ssh_ctx->thread_pool,
+                                  state->ssh_ctx->cert_cache,
                                   state->current_cert->num_values,
                                   state->current_cert->values,
                                   state->cert_verification_opts);
@@ -339,6 +341,8 @@ void ssh_get_output_keys_done(struct tevent_req *subreq)
                                   state->p11_child_timeout,
                                   state->ssh_ctx->ca_db,
                                   state->ssh_ctx->sss_certmap_ctx,
+                                  state->ssh_ctx->thread_pool,
+                                  state->ssh_ctx->cert_cache,
                                   state->current_cert->num_values,
                                   state->current_cert->values,
                                   state->cert_verification_opts);
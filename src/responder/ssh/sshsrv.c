@@ -28,6 +28,14 @@
 #include "providers/data_provider.h"
 #include "sss_iface/sss_iface_async.h"
 
+static int ssh_ctx_destructor(struct ssh_ctx *ssh_ctx)
+{
+    /* Wait for the workers before the certificate mapping rules are freed. */
+    talloc_zfree(ssh_ctx->thread_pool);
+
+    return 0;
+}
+
 int ssh_process_init(TALLOC_CTX *mem_ctx,
                      struct tevent_context *ev,
                      struct confdb_ctx *cdb)
@@ -35,6 +43,7 @@ int ssh_process_init(TALLOC_CTX *mem_ctx,
     struct resp_ctx *rctx;
     struct sss_cmd_table *ssh_cmds;
     struct ssh_ctx *ssh_ctx;
+    int cert_cache_timeout;
     int ret;
 
     ssh_cmds = get_ssh_cmds();
@@ -57,6 +66,8 @@ int ssh_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    talloc_set_destructor(ssh_ctx, ssh_ctx_destructor);
+
     ssh_ctx->rctx = rctx;
     ssh_ctx->rctx->pvt_ctx = ssh_ctx;
 
@@ -126,6 +137,39 @@ int ssh_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = confdb_get_int(ssh_ctx->rctx->cdb, CONFDB_SSH_CONF_ENTRY,
+                         CONFDB_SSH_CERT_CACHE_TIMEOUT,
+                         CONFDB_DEFAULT_SSH_CERT_CACHE_TIMEOUT,
+                         &cert_cache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Error reading " CONFDB_SSH_CERT_CACHE_TIMEOUT
+              " from confdb (%d) [%s].\n", ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    if (ssh_ctx->use_cert_keys && cert_cache_timeout > 0) {
+        ret = cert_to_ssh_key_cache_create(ssh_ctx, cert_cache_timeout,
+                                           &ssh_ctx->cert_cache);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Unable to create certificate cache "
+                  "(%d) [%s].\n", ret, sss_strerror(ret));
+            goto fail;
+        }
+    }
+
+    if (ssh_ctx->use_cert_keys) {
+        ret = sss_thread_pool_create(ssh_ctx, rctx->ev,
+                                     SSS_SSH_THREAD_POOL_SIZE,
+                                     &ssh_ctx->thread_pool);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to start worker threads, "
+                  "certificates will be matched in the main thread [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            ssh_ctx->thread_pool = NULL;
+        }
+    }
+
     ret = schedule_get_domains_task(rctx, rctx->ev, rctx, NULL, NULL, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "schedule_get_domains_tasks failed.\n");
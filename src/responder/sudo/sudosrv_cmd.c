@@ -100,42 +100,11 @@ static errno_t sudosrv_cmd_send_error(TALLOC_CTX *mem_ctx,
 
 errno_t sudosrv_cmd_reply(struct sudo_cmd_ctx *cmd_ctx, int ret)
 {
-    uint8_t *response_body = NULL;
-    size_t response_len = 0;
-    uint32_t num_rules = cmd_ctx->num_rules;
-    struct sysdb_attrs **rules = cmd_ctx->rules;
-
     switch (ret) {
     case EOK:
-        /*
-         * Parent of cmd_ctx->rules is in-memory cache, we must not talloc_free it!
-         */
-        if (cmd_ctx->sudo_ctx->timed) {
-            /* filter rules by time */
-
-            DEBUG(SSSDBG_TRACE_FUNC, "Applying time restrictions on"
-                                      "%u rules\n", cmd_ctx->num_rules);
-
-            ret = sysdb_sudo_filter_rules_by_time(cmd_ctx, cmd_ctx->num_rules,
-                                                  cmd_ctx->rules, 0,
-                                                  &num_rules, &rules);
-            if (ret != EOK) {
-                return EFAULT;
-            }
-
-            DEBUG(SSSDBG_TRACE_FUNC, "Got %u rules after time filter\n",
-                                      num_rules);
-        }
-
         /* send result */
-        ret = sudosrv_build_response(cmd_ctx, SSS_SUDO_ERROR_OK,
-                                     num_rules, rules,
-                                     &response_body, &response_len);
-        if (ret != EOK) {
-            return EFAULT;
-        }
-
-        ret = sudosrv_cmd_send_reply(cmd_ctx, response_body, response_len);
+        ret = sudosrv_cmd_send_reply(cmd_ctx, cmd_ctx->response,
+                                     cmd_ctx->response_len);
         break;
 
     case EAGAIN:
@@ -257,8 +226,8 @@ static void sudosrv_cmd_done(struct tevent_req *req)
 
     cmd_ctx = tevent_req_callback_data(req, struct sudo_cmd_ctx);
 
-    ret = sudosrv_get_rules_recv(cmd_ctx, req, &cmd_ctx->rules,
-                                 &cmd_ctx->num_rules);
+    ret = sudosrv_get_rules_recv(cmd_ctx, req, &cmd_ctx->response,
+                                 &cmd_ctx->response_len);
     talloc_zfree(req);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to obtain cached rules [%d]: %s\n",
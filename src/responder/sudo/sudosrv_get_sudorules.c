@@ -27,6 +27,7 @@
 #include <tevent.h>
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb_sudo.h"
 #include "responder/common/cache_req/cache_req.h"
 #include "responder/sudo/sudosrv_private.h"
@@ -257,7 +258,75 @@ done:
     return ret;
 }
 
+static errno_t sudosrv_query_cache_by_name(TALLOC_CTX *mem_ctx,
+                                           struct sss_domain_info *domain,
+                                           const char **attrs,
+                                           char **names,
+                                           size_t num_names,
+                                           struct sysdb_attrs ***_rules,
+                                           uint32_t *_count)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs **rules;
+    struct sysdb_attrs **msgs_attrs;
+    struct ldb_message **msgs;
+    uint32_t count = 0;
+    size_t num_msgs;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (IS_SUBDOMAIN(domain)) {
+        /* rules are stored inside parent domain tree */
+        domain = domain->parent;
+    }
+
+    rules = talloc_zero_array(tmp_ctx, struct sysdb_attrs *, num_names + 1);
+    if (rules == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_names; i++) {
+        ret = sysdb_search_custom_by_name(tmp_ctx, domain, names[i],
+                                          SUDORULE_SUBDIR, attrs,
+                                          &num_msgs, &msgs);
+        if (ret == ENOENT) {
+            /* Removed since the index was updated. */
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Error looking up SUDO rule %s\n",
+                  names[i]);
+            goto done;
+        }
+
+        ret = sysdb_msg2attrs(rules, 1, msgs, &msgs_attrs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Could not convert ldb message to sysdb_attrs\n");
+            goto done;
+        }
+
+        rules[count] = talloc_steal(rules, msgs_attrs[0]);
+        count++;
+    }
+
+    *_rules = talloc_steal(mem_ctx, rules);
+    *_count = count;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static errno_t sudosrv_expired_rules(TALLOC_CTX *mem_ctx,
+                                     struct sudo_ctx *sudo_ctx,
                                      struct sss_domain_info *domain,
                                      uid_t uid,
                                      const char *username,
@@ -269,6 +338,15 @@ static errno_t sudosrv_expired_rules(TALLOC_CTX *mem_ctx,
     char *filter;
     errno_t ret;
 
+    ret = sudosrv_index_expired(mem_ctx, sudo_ctx, domain, username, uid,
+                                groups, _rules, _num_rules);
+    if (ret == EOK) {
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "Sudo rules index is not available, "
+          "searching the cache\n");
+
     filter = sysdb_sudo_filter_expired(NULL, username, groups, uid);
     if (filter == NULL) {
         return ENOMEM;
@@ -281,12 +359,16 @@ static errno_t sudosrv_expired_rules(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+/* Rules are read by name if @names is set, otherwise they are searched
+ * with a filter built from the user information. */
 static errno_t sudosrv_cached_rules_by_user(TALLOC_CTX *mem_ctx,
                                             struct sss_domain_info *domain,
                                             uid_t cli_uid,
                                             uid_t orig_uid,
                                             const char *username,
                                             char **groupnames,
+                                            char **names,
+                                            size_t num_names,
                                             struct sysdb_attrs ***_rules,
                                             uint32_t *_num_rules)
 {
@@ -315,14 +397,21 @@ static errno_t sudosrv_cached_rules_by_user(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
-    filter = sysdb_sudo_filter_user(tmp_ctx, username, groupnames, orig_uid);
-    if (filter == NULL) {
-        ret = ENOMEM;
-        goto done;
-    }
+    if (names != NULL) {
+        ret = sudosrv_query_cache_by_name(tmp_ctx, domain, attrs,
+                                          names, num_names,
+                                          &rules, &num_rules);
+    } else {
+        filter = sysdb_sudo_filter_user(tmp_ctx, username, groupnames,
+                                        orig_uid);
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
 
-    ret = sudosrv_query_cache(tmp_ctx, domain, attrs, filter,
-                              &rules, &num_rules);
+        ret = sudosrv_query_cache(tmp_ctx, domain, attrs, filter,
+                                  &rules, &num_rules);
+    }
     if (ret != EOK) {
         goto done;
     }
@@ -359,6 +448,8 @@ static errno_t sudosrv_cached_rules_by_ng(TALLOC_CTX *mem_ctx,
                                           uid_t uid,
                                           const char *username,
                                           char **groupnames,
+                                          char **names,
+                                          size_t num_names,
                                           struct sysdb_attrs ***_rules,
                                           uint32_t *_num_rules)
 {
@@ -378,6 +469,12 @@ static errno_t sudosrv_cached_rules_by_ng(TALLOC_CTX *mem_ctx,
                             SYSDB_SUDO_CACHE_AT_ORDER,
                             NULL };
 
+    if (names != NULL) {
+        return sudosrv_query_cache_by_name(mem_ctx, domain, attrs,
+                                           names, num_names,
+                                           _rules, _num_rules);
+    }
+
     filter = sysdb_sudo_filter_netgroups(NULL, username, groupnames, uid);
     if (filter == NULL) {
         return ENOMEM;
@@ -405,10 +502,15 @@ static errno_t sudosrv_cached_rules(TALLOC_CTX *mem_ctx,
     struct sysdb_attrs **user_rules;
     struct sysdb_attrs **ng_rules;
     struct sysdb_attrs **rules;
+    struct sudo_ctx *sudo_ctx;
     uint32_t num_user_rules;
     uint32_t num_ng_rules;
     uint32_t num_rules;
     uint32_t rule_iter, i;
+    char **user_names = NULL;
+    char **ng_names = NULL;
+    size_t num_user_names = 0;
+    size_t num_ng_names = 0;
     errno_t ret;
 
     tmp_ctx = talloc_new(NULL);
@@ -416,8 +518,20 @@ static errno_t sudosrv_cached_rules(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
+    sudo_ctx = talloc_get_type(rctx->pvt_ctx, struct sudo_ctx);
+    ret = sudosrv_index_lookup(tmp_ctx, sudo_ctx, domain, username, orig_uid,
+                               groups, &user_names, &num_user_names,
+                               &ng_names, &num_ng_names);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Sudo rules index is not available, "
+              "searching the cache\n");
+        user_names = NULL;
+        ng_names = NULL;
+    }
+
     ret = sudosrv_cached_rules_by_user(tmp_ctx, domain,
                                        cli_uid, orig_uid, username, groups,
+                                       user_names, num_user_names,
                                        &user_rules, &num_user_rules);
     if (ret != EOK) {
         goto done;
@@ -425,6 +539,7 @@ static errno_t sudosrv_cached_rules(TALLOC_CTX *mem_ctx,
 
     ret = sudosrv_cached_rules_by_ng(tmp_ctx, domain,
                                      orig_uid, username, groups,
+                                     ng_names, num_ng_names,
                                      &ng_rules, &num_ng_rules);
     if (ret != EOK) {
         goto done;
@@ -591,6 +706,7 @@ sudosrv_refresh_rules_send(TALLOC_CTX *mem_ctx,
     struct sudosrv_refresh_rules_state *state;
     struct tevent_req *req;
     struct tevent_req *subreq;
+    struct sudo_ctx *sudo_ctx;
     struct sysdb_attrs **rules;
     uint32_t num_rules;
     errno_t ret;
@@ -606,7 +722,8 @@ sudosrv_refresh_rules_send(TALLOC_CTX *mem_ctx,
     state->domain = domain;
     state->username = username;
 
-    ret = sudosrv_expired_rules(state, domain, uid, username, groups,
+    sudo_ctx = talloc_get_type(rctx->pvt_ctx, struct sudo_ctx);
+    ret = sudosrv_expired_rules(state, sudo_ctx, domain, uid, username, groups,
                                 &rules, &num_rules);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -724,6 +841,7 @@ static errno_t sudosrv_refresh_rules_recv(struct tevent_req *req)
 struct sudosrv_get_rules_state {
     struct tevent_context *ev;
     struct resp_ctx *rctx;
+    struct sudo_ctx *sudo_ctx;
     enum sss_sudo_type type;
     uid_t cli_uid;
     const char *username;
@@ -735,8 +853,8 @@ struct sudosrv_get_rules_state {
     uid_t orig_uid;
     const char *orig_username;
 
-    struct sysdb_attrs **rules;
-    uint32_t num_rules;
+    uint8_t *response;
+    size_t response_len;
 };
 
 static void sudosrv_get_rules_initgr_done(struct tevent_req *subreq);
@@ -762,6 +880,7 @@ struct tevent_req *sudosrv_get_rules_send(TALLOC_CTX *mem_ctx,
 
     state->ev = ev;
     state->rctx = sudo_ctx->rctx;
+    state->sudo_ctx = sudo_ctx;
     state->type = type;
     state->cli_uid = cli_uid;
     state->inverse_order = sudo_ctx->inverse_order;
@@ -849,7 +968,14 @@ done:
 static void sudosrv_get_rules_done(struct tevent_req *subreq)
 {
     struct sudosrv_get_rules_state *state = NULL;
+    struct sudosrv_reply *reply;
+    struct sysdb_attrs **rules;
+    struct sysdb_attrs **filtered;
+    uint32_t num_rules;
+    uint32_t num_filtered;
     struct tevent_req *req = NULL;
+    char *version = NULL;
+    char *key = NULL;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
@@ -863,34 +989,95 @@ static void sudosrv_get_rules_done(struct tevent_req *subreq)
               "in cache.\n");
     }
 
+    /* With sudo_timed the reply depends on the current time. */
+    if (!state->sudo_ctx->timed) {
+        ret = sudosrv_reply_cache_key(state, state->type, state->cli_uid,
+                                      state->domain, state->username,
+                                      state->orig_uid, state->groups,
+                                      &key, &version);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to compute reply cache key "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            key = NULL;
+        }
+    }
+
+    if (key != NULL) {
+        reply = sudosrv_reply_lookup(state->sudo_ctx, key, version);
+        if (reply != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Returning cached reply for [%s@%s]\n",
+                  state->orig_username, state->domain->name);
+
+            state->response = talloc_memdup(state, reply->body, reply->len);
+            if (state->response == NULL) {
+                tevent_req_error(req, ENOMEM);
+                return;
+            }
+            state->response_len = reply->len;
+
+            tevent_req_done(req);
+            return;
+        }
+    }
+
     ret = sudosrv_fetch_rules(state, state->rctx, state->type, state->domain,
                               state->cli_uid,
                               state->orig_uid,
                               state->orig_username,
                               state->groups,
                               state->inverse_order,
-                              &state->rules, &state->num_rules);
+                              &rules, &num_rules);
 
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
+    if (state->sudo_ctx->timed) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Applying time restrictions on "
+                                  "%u rules\n", num_rules);
+
+        ret = sysdb_sudo_filter_rules_by_time(state, num_rules, rules, 0,
+                                              &num_filtered, &filtered);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Got %u rules after time filter\n",
+                                  num_filtered);
+
+        rules = filtered;
+        num_rules = num_filtered;
+    }
+
+    ret = sudosrv_build_response(state, SSS_SUDO_ERROR_OK, num_rules, rules,
+                                 &state->response, &state->response_len);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    if (key != NULL) {
+        sudosrv_reply_store(state->sudo_ctx, key, version,
+                            state->response, state->response_len);
+    }
+
     tevent_req_done(req);
 }
 
 errno_t sudosrv_get_rules_recv(TALLOC_CTX *mem_ctx,
                                struct tevent_req *req,
-                               struct sysdb_attrs ***_rules,
-                               uint32_t *_num_rules)
+                               uint8_t **_response_body,
+                               size_t *_response_len)
 {
     struct sudosrv_get_rules_state *state = NULL;
     state = tevent_req_data(req, struct sudosrv_get_rules_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
-    *_rules = talloc_steal(mem_ctx, state->rules);
-    *_num_rules = state->num_rules;
+    *_response_body = talloc_steal(mem_ctx, state->response);
+    *_response_len = state->response_len;
 
     return EOK;
 }
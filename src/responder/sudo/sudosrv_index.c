@@ -0,0 +1,632 @@
+/*
+    SSSD
+
+    Sudo responder: in-memory index of cached sudo rules
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "db/sysdb_sudo.h"
+#include "responder/sudo/sudosrv_private.h"
+
+/* The index maps every sudoUser value (user, #uid, %group, +netgroup, ALL)
+ * to the rules that contain it, so the rules of a user are found by a few
+ * hash lookups instead of an ldb search with a filter that has one term
+ * per group of the user.
+ *
+ * The back end changes the rules generation stored in the sysdb whenever
+ * it stores or removes rules. If it differs from the one the index was
+ * built from, the names and sudoUser values of all rules are read again
+ * and only rules that were added, removed or whose sudoUser values changed
+ * are updated in the index. */
+
+struct sudosrv_index_rule {
+    char *name;
+    /* NULL terminated */
+    char **users;
+    time_t expire;
+    bool netgroup;
+
+    /* Used to find out if the rule was already selected or seen. */
+    uint64_t mark;
+};
+
+struct sudosrv_index_posting {
+    struct sudosrv_index_rule **rules;
+    size_t count;
+};
+
+struct sudosrv_index {
+    uint64_t generation;
+    bool valid;
+    uint64_t mark;
+
+    /* struct sudosrv_index_rule keyed by rule name */
+    hash_table_t *rules;
+    /* struct sudosrv_index_posting keyed by sudoUser value */
+    hash_table_t *users;
+};
+
+static void sudosrv_index_unlink(struct sudosrv_index *index,
+                                 struct sudosrv_index_rule *rule)
+{
+    struct sudosrv_index_posting *posting;
+    size_t i;
+    size_t j;
+
+    for (i = 0; rule->users[i] != NULL; i++) {
+        posting = sss_ptr_hash_lookup(index->users, rule->users[i],
+                                      struct sudosrv_index_posting);
+        if (posting == NULL) {
+            continue;
+        }
+
+        for (j = 0; j < posting->count; j++) {
+            if (posting->rules[j] == rule) {
+                posting->rules[j] = posting->rules[posting->count - 1];
+                posting->count--;
+                break;
+            }
+        }
+
+        if (posting->count == 0) {
+            /* Freeing the value removes it from the table. */
+            talloc_free(posting);
+        }
+    }
+
+    talloc_free(rule);
+}
+
+static errno_t sudosrv_index_link(struct sudosrv_index *index,
+                                  struct sudosrv_index_rule *rule)
+{
+    struct sudosrv_index_posting *posting;
+    struct sudosrv_index_rule **rules;
+    errno_t ret;
+    size_t i;
+
+    ret = sss_ptr_hash_add(index->rules, rule->name, rule,
+                           struct sudosrv_index_rule);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; rule->users[i] != NULL; i++) {
+        posting = sss_ptr_hash_lookup(index->users, rule->users[i],
+                                      struct sudosrv_index_posting);
+        if (posting == NULL) {
+            posting = talloc_zero(index, struct sudosrv_index_posting);
+            if (posting == NULL) {
+                return ENOMEM;
+            }
+
+            ret = sss_ptr_hash_add(index->users, rule->users[i], posting,
+                                   struct sudosrv_index_posting);
+            if (ret != EOK) {
+                talloc_free(posting);
+                return ret;
+            }
+        }
+
+        /* The same value may be present twice in one rule. */
+        if (posting->count > 0
+                && posting->rules[posting->count - 1] == rule) {
+            continue;
+        }
+
+        rules = talloc_realloc(posting, posting->rules,
+                               struct sudosrv_index_rule *,
+                               posting->count + 1);
+        if (rules == NULL) {
+            return ENOMEM;
+        }
+
+        posting->rules = rules;
+        posting->rules[posting->count] = rule;
+        posting->count++;
+    }
+
+    return EOK;
+}
+
+static bool sudosrv_index_same_users(char **a, struct ldb_message_element *el)
+{
+    unsigned int i;
+
+    for (i = 0; el != NULL && i < el->num_values; i++) {
+        if (a[i] == NULL
+                || strcmp(a[i], (const char *)el->values[i].data) != 0) {
+            return false;
+        }
+    }
+
+    return a[i] == NULL;
+}
+
+static errno_t sudosrv_index_update_rule(struct sudosrv_index *index,
+                                         struct ldb_message *msg)
+{
+    struct sudosrv_index_rule *rule;
+    struct ldb_message_element *el;
+    const char *name;
+    unsigned int i;
+    errno_t ret;
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        return EOK;
+    }
+
+    el = ldb_msg_find_element(msg, SYSDB_SUDO_CACHE_AT_USER);
+
+    rule = sss_ptr_hash_lookup(index->rules, name, struct sudosrv_index_rule);
+    if (rule != NULL && sudosrv_index_same_users(rule->users, el)) {
+        rule->expire = ldb_msg_find_attr_as_int64(msg, SYSDB_CACHE_EXPIRE, 0);
+        rule->mark = index->mark;
+        return EOK;
+    }
+
+    if (rule != NULL) {
+        sudosrv_index_unlink(index, rule);
+    }
+
+    rule = talloc_zero(index, struct sudosrv_index_rule);
+    if (rule == NULL) {
+        return ENOMEM;
+    }
+
+    rule->name = talloc_strdup(rule, name);
+    rule->users = talloc_zero_array(rule, char *,
+                                    (el == NULL ? 0 : el->num_values) + 1);
+    if (rule->name == NULL || rule->users == NULL) {
+        talloc_free(rule);
+        return ENOMEM;
+    }
+
+    for (i = 0; el != NULL && i < el->num_values; i++) {
+        rule->users[i] = talloc_strndup(rule->users,
+                                        (const char *)el->values[i].data,
+                                        el->values[i].length);
+        if (rule->users[i] == NULL) {
+            talloc_free(rule);
+            return ENOMEM;
+        }
+
+        if (rule->users[i][0] == '+') {
+            rule->netgroup = true;
+        }
+    }
+
+    rule->expire = ldb_msg_find_attr_as_int64(msg, SYSDB_CACHE_EXPIRE, 0);
+    rule->mark = index->mark;
+
+    ret = sudosrv_index_link(index, rule);
+    if (ret != EOK) {
+        sudosrv_index_unlink(index, rule);
+        return ret;
+    }
+
+    return EOK;
+}
+
+static errno_t sudosrv_index_update(struct sudosrv_index *index,
+                                    struct sss_domain_info *domain,
+                                    uint64_t generation)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sudosrv_index_rule *rule;
+    struct ldb_message **msgs;
+    hash_value_t *values;
+    unsigned long count;
+    size_t num_msgs;
+    unsigned long i;
+    errno_t ret;
+    int hret;
+    const char *attrs[] = { SYSDB_NAME,
+                            SYSDB_SUDO_CACHE_AT_USER,
+                            SYSDB_CACHE_EXPIRE,
+                            NULL };
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* The index is inconsistent until the update finishes. */
+    index->valid = false;
+    index->mark++;
+
+    ret = sysdb_search_custom(tmp_ctx, domain,
+                              "(" SYSDB_OBJECTCLASS "=" SYSDB_SUDO_CACHE_OC ")",
+                              SUDORULE_SUBDIR, attrs, &num_msgs, &msgs);
+    if (ret == ENOENT) {
+        num_msgs = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < num_msgs; i++) {
+        ret = sudosrv_index_update_rule(index, msgs[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    /* Remove rules that are gone from the cache. */
+    hret = hash_values(index->rules, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        rule = sss_ptr_get_value(&values[i], struct sudosrv_index_rule);
+        if (rule != NULL && rule->mark != index->mark) {
+            sudosrv_index_unlink(index, rule);
+        }
+    }
+    talloc_free(values);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Indexed %lu sudo rules of domain %s\n",
+          hash_count(index->rules), domain->name);
+
+    index->generation = generation;
+    index->valid = true;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+static errno_t sudosrv_index_get(struct sudo_ctx *sudo_ctx,
+                                 struct sss_domain_info *domain,
+                                 struct sudosrv_index **_index)
+{
+    struct sudosrv_index *index;
+    uint64_t generation;
+    errno_t ret;
+
+    if (sudo_ctx->indexes == NULL) {
+        sudo_ctx->indexes = sss_ptr_hash_create(sudo_ctx, NULL, NULL);
+        if (sudo_ctx->indexes == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    ret = sysdb_sudo_get_generation(domain, &generation);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to read sudo rules generation "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    index = sss_ptr_hash_lookup(sudo_ctx->indexes, domain->name,
+                                struct sudosrv_index);
+    if (index == NULL) {
+        index = talloc_zero(sudo_ctx, struct sudosrv_index);
+        if (index == NULL) {
+            return ENOMEM;
+        }
+
+        index->rules = sss_ptr_hash_create(index, NULL, NULL);
+        index->users = sss_ptr_hash_create(index, NULL, NULL);
+        if (index->rules == NULL || index->users == NULL) {
+            talloc_free(index);
+            return ENOMEM;
+        }
+
+        ret = sss_ptr_hash_add(sudo_ctx->indexes, domain->name, index,
+                               struct sudosrv_index);
+        if (ret != EOK) {
+            talloc_free(index);
+            return ret;
+        }
+    }
+
+    if (!index->valid || index->generation != generation) {
+        ret = sudosrv_index_update(index, domain, generation);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to update sudo rules index "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            return ret;
+        }
+    }
+
+    *_index = index;
+
+    return EOK;
+}
+
+static errno_t sudosrv_index_select(struct sudosrv_index *index,
+                                    const char *key,
+                                    const char ***_names,
+                                    size_t *_count)
+{
+    struct sudosrv_index_posting *posting;
+    const char **names = *_names;
+    size_t count = *_count;
+    size_t i;
+
+    posting = sss_ptr_hash_lookup(index->users, key,
+                                  struct sudosrv_index_posting);
+    if (posting == NULL) {
+        return EOK;
+    }
+
+    for (i = 0; i < posting->count; i++) {
+        if (posting->rules[i]->mark == index->mark) {
+            continue;
+        }
+        posting->rules[i]->mark = index->mark;
+
+        names[count] = posting->rules[i]->name;
+        count++;
+    }
+
+    *_count = count;
+
+    return EOK;
+}
+
+errno_t sudosrv_index_lookup(TALLOC_CTX *mem_ctx,
+                             struct sudo_ctx *sudo_ctx,
+                             struct sss_domain_info *domain,
+                             const char *username,
+                             uid_t uid,
+                             char **groupnames,
+                             char ***_user_rules,
+                             size_t *_num_user_rules,
+                             char ***_ng_rules,
+                             size_t *_num_ng_rules)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sudosrv_index *index;
+    struct sudosrv_index_rule *rule;
+    const char **names;
+    char **user_rules;
+    char **ng_rules;
+    size_t num_user_rules = 0;
+    size_t num_ng_rules = 0;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    char *key;
+    errno_t ret;
+    int hret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (IS_SUBDOMAIN(domain)) {
+        /* rules are stored inside parent domain tree */
+        domain = domain->parent;
+    }
+
+    ret = sudosrv_index_get(sudo_ctx, domain, &index);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* A rule can not be selected more often than it exists. */
+    names = talloc_zero_array(tmp_ctx, const char *,
+                              hash_count(index->rules) + 1);
+    if (names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Same values as in sysdb_sudo_filter_userinfo(). */
+    index->mark++;
+
+    ret = sudosrv_index_select(index, "ALL", &names, &num_user_rules);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sudosrv_index_select(index, username, &names, &num_user_rules);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (uid != 0) {
+        key = talloc_asprintf(tmp_ctx, "#%"SPRIuid, uid);
+        if (key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sudosrv_index_select(index, key, &names, &num_user_rules);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (i = 0; groupnames != NULL && groupnames[i] != NULL; i++) {
+        key = talloc_asprintf(tmp_ctx, "%%%s", groupnames[i]);
+        if (key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sudosrv_index_select(index, key, &names, &num_user_rules);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        talloc_free(key);
+    }
+
+    user_rules = talloc_zero_array(tmp_ctx, char *, num_user_rules + 1);
+    if (user_rules == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_user_rules; i++) {
+        user_rules[i] = talloc_strdup(user_rules, names[i]);
+        if (user_rules[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    /* Rules with a netgroup which were not selected above, the netgroup
+     * membership is evaluated by sudo itself. */
+    hret = hash_values(index->rules, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+    talloc_steal(tmp_ctx, values);
+
+    ng_rules = talloc_zero_array(tmp_ctx, char *, count + 1);
+    if (ng_rules == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        rule = sss_ptr_get_value(&values[i], struct sudosrv_index_rule);
+        if (rule == NULL || !rule->netgroup || rule->mark == index->mark) {
+            continue;
+        }
+
+        ng_rules[num_ng_rules] = talloc_strdup(ng_rules, rule->name);
+        if (ng_rules[num_ng_rules] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        num_ng_rules++;
+    }
+
+    *_user_rules = talloc_steal(mem_ctx, user_rules);
+    *_num_user_rules = num_user_rules;
+    *_ng_rules = talloc_steal(mem_ctx, ng_rules);
+    *_num_ng_rules = num_ng_rules;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+errno_t sudosrv_index_expired(TALLOC_CTX *mem_ctx,
+                              struct sudo_ctx *sudo_ctx,
+                              struct sss_domain_info *domain,
+                              const char *username,
+                              uid_t uid,
+                              char **groupnames,
+                              struct sysdb_attrs ***_rules,
+                              uint32_t *_num_rules)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sudosrv_index *index;
+    struct sudosrv_index_rule *rule;
+    struct sysdb_attrs **rules;
+    char **user_rules;
+    char **ng_rules;
+    size_t num_user_rules;
+    size_t num_ng_rules;
+    uint32_t num_rules = 0;
+    char *names[2] = { discard_const("defaults"), NULL };
+    char **lists[3];
+    time_t now;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sudosrv_index_lookup(tmp_ctx, sudo_ctx, domain, username, uid,
+                               groupnames, &user_rules, &num_user_rules,
+                               &ng_rules, &num_ng_rules);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (IS_SUBDOMAIN(domain)) {
+        domain = domain->parent;
+    }
+
+    index = sss_ptr_hash_lookup(sudo_ctx->indexes, domain->name,
+                                struct sudosrv_index);
+    if (index == NULL) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    rules = talloc_zero_array(tmp_ctx, struct sysdb_attrs *,
+                              num_user_rules + num_ng_rules + 1);
+    if (rules == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Same rules as in sysdb_sudo_filter_expired(). */
+    lists[0] = names;
+    lists[1] = user_rules;
+    lists[2] = ng_rules;
+
+    now = time(NULL);
+    index->mark++;
+    for (i = 0; i < 3; i++) {
+        for (j = 0; lists[i][j] != NULL; j++) {
+            rule = sss_ptr_hash_lookup(index->rules, lists[i][j],
+                                       struct sudosrv_index_rule);
+            if (rule == NULL || rule->mark == index->mark
+                    || rule->expire > now) {
+                continue;
+            }
+            rule->mark = index->mark;
+
+            rules[num_rules] = sysdb_new_attrs(rules);
+            if (rules[num_rules] == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sysdb_attrs_add_string(rules[num_rules], SYSDB_NAME,
+                                         rule->name);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            num_rules++;
+        }
+    }
+
+    *_rules = talloc_steal(mem_ctx, rules);
+    *_num_rules = num_rules;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
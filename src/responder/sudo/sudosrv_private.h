@@ -49,6 +49,12 @@ struct sudo_ctx {
     bool timed;
     bool inverse_order;
     int threshold;
+
+    /* struct sudosrv_index keyed by domain name, see sudosrv_index.c */
+    hash_table_t *indexes;
+
+    /* already built replies keyed by user, see sudosrv_reply_cache.c */
+    hash_table_t *replies;
 };
 
 struct sudo_cmd_ctx {
@@ -61,8 +67,8 @@ struct sudo_cmd_ctx {
     char *rawname;
 
     /* output data */
-    struct sysdb_attrs **rules;
-    uint32_t num_rules;
+    uint8_t *response;
+    size_t response_len;
 };
 
 struct sss_cmd_table *get_sudo_cmds(void);
@@ -76,8 +82,61 @@ struct tevent_req *sudosrv_get_rules_send(TALLOC_CTX *mem_ctx,
 
 errno_t sudosrv_get_rules_recv(TALLOC_CTX *mem_ctx,
                                struct tevent_req *req,
-                               struct sysdb_attrs ***_rules,
-                               uint32_t *_num_rules);
+                               uint8_t **_response_body,
+                               size_t *_response_len);
+
+/* Names of rules that apply to the user (sudosrv_cached_rules_by_user())
+ * and of the remaining rules with a netgroup (sudosrv_cached_rules_by_ng())
+ * looked up in the in-memory index. */
+errno_t sudosrv_index_lookup(TALLOC_CTX *mem_ctx,
+                             struct sudo_ctx *sudo_ctx,
+                             struct sss_domain_info *domain,
+                             const char *username,
+                             uid_t uid,
+                             char **groupnames,
+                             char ***_user_rules,
+                             size_t *_num_user_rules,
+                             char ***_ng_rules,
+                             size_t *_num_ng_rules);
+
+/* Expired rules of the user, only SYSDB_NAME is set. */
+errno_t sudosrv_index_expired(TALLOC_CTX *mem_ctx,
+                              struct sudo_ctx *sudo_ctx,
+                              struct sss_domain_info *domain,
+                              const char *username,
+                              uid_t uid,
+                              char **groupnames,
+                              struct sysdb_attrs ***_rules,
+                              uint32_t *_num_rules);
+
+struct sudosrv_reply {
+    char *version;
+    uint8_t *body;
+    size_t len;
+};
+
+/* Key of the reply cache entry of the user and the version the cached
+ * reply must match to be used. */
+errno_t sudosrv_reply_cache_key(TALLOC_CTX *mem_ctx,
+                                enum sss_sudo_type type,
+                                uid_t cli_uid,
+                                struct sss_domain_info *domain,
+                                const char *username,
+                                uid_t orig_uid,
+                                char **groups,
+                                char **_key,
+                                char **_version);
+
+/* NULL if there is no reply or if it has a different version. */
+struct sudosrv_reply *sudosrv_reply_lookup(struct sudo_ctx *sudo_ctx,
+                                           const char *key,
+                                           const char *version);
+
+void sudosrv_reply_store(struct sudo_ctx *sudo_ctx,
+                         const char *key,
+                         const char *version,
+                         uint8_t *body,
+                         size_t len);
 
 errno_t sudosrv_parse_query(TALLOC_CTX *mem_ctx,
                             uint8_t *query_body,
@@ -0,0 +1,152 @@
+/*
+    SSSD
+
+    Sudo responder: cache of already built replies
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "db/sysdb_sudo.h"
+#include "responder/sudo/sudosrv_private.h"
+
+/* Replies are cached per user and validated against the generation of the
+ * sudo rules and the groups the user is member of. The whole cache is
+ * dropped when it grows over this limit. */
+#define SUDOSRV_REPLY_CACHE_MAX 256
+
+errno_t sudosrv_reply_cache_key(TALLOC_CTX *mem_ctx,
+                                enum sss_sudo_type type,
+                                uid_t cli_uid,
+                                struct sss_domain_info *domain,
+                                const char *username,
+                                uid_t orig_uid,
+                                char **groups,
+                                char **_key,
+                                char **_version)
+{
+    uint64_t generation;
+    char *version;
+    char *key;
+    errno_t ret;
+    int i;
+
+    /* Rules of subdomain users are stored in the parent domain tree and so
+     * is the generation. */
+    ret = sysdb_sudo_get_generation(IS_SUBDOMAIN(domain) ? domain->parent
+                                                         : domain,
+                                    &generation);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key = talloc_asprintf(mem_ctx, "%d:%"SPRIuid":%s:%s",
+                          type, cli_uid, domain->name, username);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    version = talloc_asprintf(mem_ctx, "%"PRIu64":%"SPRIuid,
+                              generation, orig_uid);
+    for (i = 0; version != NULL && groups != NULL && groups[i] != NULL; i++) {
+        version = talloc_asprintf_append(version, "\n%s", groups[i]);
+    }
+
+    if (version == NULL) {
+        talloc_free(key);
+        return ENOMEM;
+    }
+
+    *_key = key;
+    *_version = version;
+
+    return EOK;
+}
+
+struct sudosrv_reply *sudosrv_reply_lookup(struct sudo_ctx *sudo_ctx,
+                                           const char *key,
+                                           const char *version)
+{
+    struct sudosrv_reply *reply;
+
+    if (sudo_ctx->replies == NULL) {
+        return NULL;
+    }
+
+    reply = sss_ptr_hash_lookup(sudo_ctx->replies, key, struct sudosrv_reply);
+    if (reply == NULL) {
+        return NULL;
+    }
+
+    if (strcmp(reply->version, version) != 0) {
+        /* Rules or group membership have changed. */
+        talloc_free(reply);
+        return NULL;
+    }
+
+    return reply;
+}
+
+void sudosrv_reply_store(struct sudo_ctx *sudo_ctx,
+                         const char *key,
+                         const char *version,
+                         uint8_t *body,
+                         size_t len)
+{
+    struct sudosrv_reply *reply;
+    errno_t ret;
+
+    if (sudo_ctx->replies != NULL
+            && hash_count(sudo_ctx->replies) >= SUDOSRV_REPLY_CACHE_MAX) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Too many cached replies, flushing\n");
+        talloc_zfree(sudo_ctx->replies);
+    }
+
+    if (sudo_ctx->replies == NULL) {
+        sudo_ctx->replies = sss_ptr_hash_create(sudo_ctx, NULL, NULL);
+        if (sudo_ctx->replies == NULL) {
+            return;
+        }
+    }
+
+    reply = talloc_zero(sudo_ctx->replies, struct sudosrv_reply);
+    if (reply == NULL) {
+        return;
+    }
+
+    reply->version = talloc_strdup(reply, version);
+    reply->body = talloc_memdup(reply, body, len);
+    reply->len = len;
+    if (reply->version == NULL || reply->body == NULL) {
+        talloc_free(reply);
+        return;
+    }
+
+    talloc_free(sss_ptr_hash_lookup(sudo_ctx->replies, key,
+                                    struct sudosrv_reply));
+
+    ret = sss_ptr_hash_add(sudo_ctx->replies, key, reply,
+                           struct sudosrv_reply);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(reply);
+        return;
+    }
+}
@@ -66,6 +66,11 @@ sbus_connection_destructor(struct sbus_connection *conn)
     sbus_reconnect_disable(conn);
     sbus_connection_tevent_disable(conn);
 
+    if (conn->local_server != NULL) {
+        conn->local_server->local = NULL;
+        conn->local_server = NULL;
+    }
+
     /* Remove router data. */
     talloc_zfree(conn->router);
 
@@ -87,6 +87,10 @@ static void sbus_connect_init_hello_done(struct tevent_req *subreq)
         return;
     }
 
+    /* Remember the name so the server can recognize this connection. */
+    talloc_free(discard_const(state->conn->unique_name));
+    state->conn->unique_name = talloc_steal(state->conn, unique_name);
+
     if (state->name == NULL) {
         tevent_req_done(req);
         return;
@@ -407,6 +411,9 @@ static void sbus_server_create_and_connect_done(struct tevent_req *subreq)
         return;
     }
 
+    state->server->local = state->conn;
+    state->conn->local_server = state->server;
+
     tevent_req_done(req);
     return;
 }
@@ -213,7 +213,10 @@ void sbus_reply(struct sbus_connection *conn,
         return;
     }
 
-    dbus_connection_send(conn->connection, reply, NULL);
+    if (!sbus_server_reply_local(conn, reply)) {
+        dbus_connection_send(conn->connection, reply, NULL);
+    }
+
     dbus_message_unref(reply);
 }
 
@@ -108,6 +108,10 @@ struct sbus_connection {
     /* Pointer to a caller's last activity variable. The time is updated
      * each time the bus is active (when a method arrives). */
     time_t *last_activity;
+
+    /* Server running in this process that this connection is connected
+     * to, see sbus_server_create_and_connect_send(). */
+    struct sbus_server *local_server;
 };
 
 struct sbus_server {
@@ -127,6 +131,11 @@ struct sbus_server {
     struct sbus_server_on_connection *on_connection;
     bool disconnecting;
 
+    /* Connection to this server that was made from this process. Method
+     * calls and replies between this connection and the server are passed
+     * directly instead of through the socket. */
+    struct sbus_connection *local;
+
     /* Last generated unique name information. */
     struct {
         uint32_t major;
@@ -425,6 +434,12 @@ sbus_server_filter(DBusConnection *dbus_conn,
                    DBusMessage *message,
                    void *handler_data);
 
+/* Route @reply sent by the in-process connection @conn directly through
+ * its server. Returns false if the reply must be sent through the socket. */
+bool
+sbus_server_reply_local(struct sbus_connection *conn,
+                        DBusMessage *reply);
+
 /* Spy that ensures that the request list item is invalidated when the
  * request or connection is freed. */
 struct sbus_request_spy;
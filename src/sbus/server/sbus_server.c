@@ -614,6 +614,11 @@ static int sbus_server_destructor(struct sbus_server *server)
 
     server->disconnecting = true;
 
+    if (server->local != NULL) {
+        server->local->local_server = NULL;
+        server->local = NULL;
+    }
+
     /* Remove tevent integration first. */
     sbus_server_tevent_disable(server);
 
@@ -22,6 +22,7 @@
 
 #include <errno.h>
 #include <string.h>
+#include <poll.h>
 #include <tevent.h>
 #include <talloc.h>
 #include <dbus/dbus.h>
@@ -30,6 +31,145 @@
 #include "util/sss_ptr_hash.h"
 #include "sbus/sbus_private.h"
 
+static bool
+sbus_server_is_local(struct sbus_server *server,
+                     struct sbus_connection *conn)
+{
+    struct sbus_connection *local = server->local;
+
+    if (local == NULL || local->disconnecting || local->router == NULL) {
+        return false;
+    }
+
+    if (local->unique_name == NULL || conn->unique_name == NULL) {
+        return false;
+    }
+
+    return strcmp(local->unique_name, conn->unique_name) == 0;
+}
+
+/* Check that no message is on its way through @conn. libdbus only knows
+ * about messages that were not yet written or that were already read, so
+ * the socket itself is polled for data that the peer has written but this
+ * side has not read yet. */
+static bool
+sbus_server_connection_idle(struct sbus_connection *conn)
+{
+    DBusDispatchStatus status;
+    struct pollfd pfd;
+    int fd;
+    int ret;
+
+    if (dbus_connection_has_messages_to_send(conn->connection)) {
+        return false;
+    }
+
+    status = dbus_connection_get_dispatch_status(conn->connection);
+    if (status != DBUS_DISPATCH_COMPLETE) {
+        return false;
+    }
+
+    if (!dbus_connection_get_socket(conn->connection, &fd)) {
+        return false;
+    }
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    ret = poll(&pfd, 1, 0);
+    if (ret != 0) {
+        /* Either there is unread data or we can not tell. */
+        return false;
+    }
+
+    return true;
+}
+
+/* Both ends of the in-process connection live in this process, so the
+ * message can skip the socket only if there is nothing in flight between
+ * them in either direction. Otherwise it would overtake messages that were
+ * already sent through the socket. */
+static bool
+sbus_server_local_idle(struct sbus_connection *server_side,
+                       struct sbus_connection *client_side)
+{
+    return sbus_server_connection_idle(server_side)
+        && sbus_server_connection_idle(client_side);
+}
+
+/* Pass a method call directly to the router of the connection that was
+ * made from this process, so it does not need to be marshalled to and
+ * parsed from the socket again. If any message is still in flight between
+ * the server and this connection, the message is sent through the socket
+ * as well to keep ordering. */
+static bool
+sbus_server_deliver_local(struct sbus_server *server,
+                          struct sbus_connection *destconn,
+                          DBusMessage *message)
+{
+    struct sbus_connection *local = server->local;
+    DBusHandlerResult result;
+    const char *interface;
+
+    if (dbus_message_get_type(message) != DBUS_MESSAGE_TYPE_METHOD_CALL) {
+        return false;
+    }
+
+    if (!sbus_server_is_local(server, destconn)) {
+        return false;
+    }
+
+    /* org.freedesktop.DBus.Peer is implemented by libdbus itself. */
+    interface = dbus_message_get_interface(message);
+    if (interface == NULL || strcmp(interface, DBUS_INTERFACE_PEER) == 0) {
+        return false;
+    }
+
+    if (!sbus_server_local_idle(destconn, local)) {
+        return false;
+    }
+
+    result = sbus_router_filter(local, local->router, message);
+
+    return result == DBUS_HANDLER_RESULT_HANDLED;
+}
+
+bool
+sbus_server_reply_local(struct sbus_connection *conn,
+                        DBusMessage *reply)
+{
+    struct sbus_connection *peer;
+    struct sbus_server *server;
+    DBusHandlerResult result;
+    int type;
+
+    server = conn->local_server;
+    if (server == NULL || server->disconnecting || conn->unique_name == NULL) {
+        return false;
+    }
+
+    /* Signals and method calls keep their ordering through the socket. */
+    type = dbus_message_get_type(reply);
+    if (type != DBUS_MESSAGE_TYPE_METHOD_RETURN
+            && type != DBUS_MESSAGE_TYPE_ERROR) {
+        return false;
+    }
+
+    peer = sbus_server_find_connection(server, conn->unique_name);
+    if (peer == NULL || peer->disconnecting) {
+        return false;
+    }
+
+    if (!sbus_server_local_idle(peer, conn)) {
+        return false;
+    }
+
+    result = sbus_server_filter(peer->connection, reply, server);
+
+    return result == DBUS_HANDLER_RESULT_HANDLED;
+}
+
 static DBusHandlerResult
 sbus_server_resend_message(struct sbus_server *server,
                            struct sbus_connection *conn,
@@ -46,6 +186,10 @@ sbus_server_resend_message(struct sbus_server *server,
         return DBUS_HANDLER_RESULT_HANDLED;
     }
 
+    if (sbus_server_deliver_local(server, destconn, message)) {
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
     /* Message is unreferenced by libdbus. */
     dbus_connection_send(destconn->connection, message, NULL);
     return DBUS_HANDLER_RESULT_HANDLED;
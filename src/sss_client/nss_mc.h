@@ -45,6 +45,7 @@ struct sss_cli_mc_ctx {
     int fd;
 
     uint32_t seed;          /* seed from the tables header */
+    uint32_t generation;    /* generation from the tables header */
 
     void *mmap_base;        /* base address of mmap */
     size_t mmap_size;       /* total size of mmap */
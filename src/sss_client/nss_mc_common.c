@@ -101,6 +101,9 @@ errno_t sss_nss_check_header(struct sss_cli_mc_ctx *ctx)
         }
     }
 
+    /* a new generation invalidates all records stored before it */
+    ctx->generation = h.generation;
+
     ret = fstat(ctx->fd, &fdstat);
     if (ret == -1) {
         return EIO;
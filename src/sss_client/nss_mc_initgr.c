@@ -32,8 +32,8 @@
 #include "nss_mc.h"
 #include "shared/safealign.h"
 
-static struct sss_cli_mc_ctx initgr_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
-                                               NULL, 0, 0 };
+static struct sss_cli_mc_ctx initgr_mc_ctx = { UNINITIALIZED, -1, 0, 0, NULL, 0,
+                                               NULL, 0, NULL, 0, 0 };
 
 static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
                                        long int *start, long int *size,
@@ -47,7 +47,7 @@ static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
 
     /* additional checks before filling result*/
     expire = rec->expire;
-    if (expire < time(NULL)) {
+    if (expire < time(NULL) || rec->generation < initgr_mc_ctx.generation) {
         /* entry is now invalid */
         return EINVAL;
     }
@@ -28,8 +28,8 @@
 #include <time.h>
 #include "nss_mc.h"
 
-static struct sss_cli_mc_ctx pw_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
-                                           NULL, 0, 0 };
+static struct sss_cli_mc_ctx pw_mc_ctx = { UNINITIALIZED, -1, 0, 0, NULL, 0,
+                                           NULL, 0, NULL, 0, 0 };
 
 static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
                                        struct passwd *result,
@@ -42,7 +42,7 @@ static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
 
     /* additional checks before filling result*/
     expire = rec->expire;
-    if (expire < time(NULL)) {
+    if (expire < time(NULL) || rec->generation < pw_mc_ctx.generation) {
         /* entry is now invalid */
         return EINVAL;
     }
@@ -43,6 +43,41 @@ _sbus_sss_invoker_write_as
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_as *args);
 
+struct _sbus_sss_invoker_args_asasau {
+    const char ** arg0;
+    const char ** arg1;
+    uint32_t * arg2;
+};
+
+errno_t
+_sbus_sss_invoker_read_asasau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asasau *args);
+
+errno_t
+_sbus_sss_invoker_write_asasau
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asasau *args);
+
+struct _sbus_sss_invoker_args_asauauau {
+    const char ** arg0;
+    uint32_t * arg1;
+    uint32_t * arg2;
+    uint32_t * arg3;
+};
+
+errno_t
+_sbus_sss_invoker_read_asauauau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asauauau *args);
+
+errno_t
+_sbus_sss_invoker_write_asauauau
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asauauau *args);
+
 struct _sbus_sss_invoker_args_b {
     bool arg0;
 };
@@ -58,6 +93,23 @@ _sbus_sss_invoker_write_b
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_b *args);
 
+struct _sbus_sss_invoker_args_bbb {
+    bool arg0;
+    bool arg1;
+    bool arg2;
+};
+
+errno_t
+_sbus_sss_invoker_read_bbb
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_bbb *args);
+
+errno_t
+_sbus_sss_invoker_write_bbb
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_bbb *args);
+
 struct _sbus_sss_invoker_args_o {
     const char * arg0;
 };
@@ -135,6 +187,24 @@ _sbus_sss_invoker_write_qus
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_qus *args);
 
+struct _sbus_sss_invoker_args_qusau {
+    uint16_t arg0;
+    uint32_t arg1;
+    const char * arg2;
+    uint32_t * arg3;
+};
+
+errno_t
+_sbus_sss_invoker_read_qusau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_qusau *args);
+
+errno_t
+_sbus_sss_invoker_write_qusau
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_qusau *args);
+
 struct _sbus_sss_invoker_args_s {
     const char * arg0;
 };
@@ -267,6 +337,26 @@ _sbus_sss_invoker_write_usu
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_usu *args);
 
+struct _sbus_sss_invoker_args_uuasssu {
+    uint32_t arg0;
+    uint32_t arg1;
+    const char ** arg2;
+    const char * arg3;
+    const char * arg4;
+    uint32_t arg5;
+};
+
+errno_t
+_sbus_sss_invoker_read_uuasssu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uuasssu *args);
+
+errno_t
+_sbus_sss_invoker_write_uuasssu
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uuasssu *args);
+
 struct _sbus_sss_invoker_args_uusssu {
     uint32_t arg0;
     uint32_t arg1;
@@ -108,6 +108,178 @@ sbus_method_in__out__recv
     return EOK;
 }
 
+struct sbus_method_in_asasau_out__state {
+    struct _sbus_sss_invoker_args_asasau in;
+};
+
+static void sbus_method_in_asasau_out__done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_asasau_out__send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char ** arg0,
+     const char ** arg1,
+     uint32_t * arg2)
+{
+    struct sbus_method_in_asasau_out__state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_asasau_out__state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->in.arg0 = arg0;
+    state->in.arg1 = arg1;
+    state->in.arg2 = arg2;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_asasau,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_asasau_out__done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_asasau_out__done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_asasau_out__state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_asasau_out__state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_asasau_out__recv
+    (struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct sbus_method_in_bbb_out__state {
+    struct _sbus_sss_invoker_args_bbb in;
+};
+
+static void sbus_method_in_bbb_out__done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_bbb_out__send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     bool arg0,
+     bool arg1,
+     bool arg2)
+{
+    struct sbus_method_in_bbb_out__state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_bbb_out__state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->in.arg0 = arg0;
+    state->in.arg1 = arg1;
+    state->in.arg2 = arg2;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_bbb,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_bbb_out__done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_bbb_out__done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_bbb_out__state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_bbb_out__state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_bbb_out__recv
+    (struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
 struct sbus_method_in_pam_data_out_pam_response_state {
     struct _sbus_sss_invoker_args_pam_data in;
     struct _sbus_sss_invoker_args_pam_response *out;
@@ -1464,6 +1636,126 @@ sbus_method_in_usu_out__recv
     return EOK;
 }
 
+struct sbus_method_in_uuasssu_out_qusau_state {
+    struct _sbus_sss_invoker_args_uuasssu in;
+    struct _sbus_sss_invoker_args_qusau *out;
+};
+
+static void sbus_method_in_uuasssu_out_qusau_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_uuasssu_out_qusau_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     uint32_t arg0,
+     uint32_t arg1,
+     const char ** arg2,
+     const char * arg3,
+     const char * arg4,
+     uint32_t arg5)
+{
+    struct sbus_method_in_uuasssu_out_qusau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_uuasssu_out_qusau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_qusau);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->in.arg0 = arg0;
+    state->in.arg1 = arg1;
+    state->in.arg2 = arg2;
+    state->in.arg3 = arg3;
+    state->in.arg4 = arg4;
+    state->in.arg5 = arg5;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_uuasssu,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_uuasssu_out_qusau_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_uuasssu_out_qusau_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_uuasssu_out_qusau_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_uuasssu_out_qusau_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_qusau, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_uuasssu_out_qusau_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t* _arg0,
+     uint32_t* _arg1,
+     const char ** _arg2,
+     uint32_t ** _arg3)
+{
+    struct sbus_method_in_uuasssu_out_qusau_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_uuasssu_out_qusau_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = state->out->arg0;
+    *_arg1 = state->out->arg1;
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, state->out->arg3);
+
+    return EOK;
+}
+
 struct sbus_method_in_uusssu_out_qus_state {
     struct _sbus_sss_invoker_args_uusssu in;
     struct _sbus_sss_invoker_args_qus *out;
@@ -2185,6 +2477,35 @@ sbus_call_dp_dp_getAccountInfo_recv
     return sbus_method_in_uusssu_out_qus_recv(mem_ctx, req, _dp_error, _error, _error_message);
 }
 
+struct tevent_req *
+sbus_call_dp_dp_getAccountInfoList_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t arg_dp_flags,
+     uint32_t arg_entry_type,
+     const char ** arg_filters,
+     const char * arg_domain,
+     const char * arg_extra,
+     uint32_t arg_cli_id)
+{
+    return sbus_method_in_uuasssu_out_qusau_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.dataprovider", "getAccountInfoList", arg_dp_flags, arg_entry_type, arg_filters, arg_domain, arg_extra, arg_cli_id);
+}
+
+errno_t
+sbus_call_dp_dp_getAccountInfoList_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t* _dp_error,
+     uint32_t* _error,
+     const char ** _error_message,
+     uint32_t ** _errors)
+{
+    return sbus_method_in_uuasssu_out_qusau_recv(mem_ctx, req, _dp_error, _error, _error_message, _errors);
+}
+
 struct tevent_req *
 sbus_call_dp_dp_getDomains_send
     (TALLOC_CTX *mem_ctx,
@@ -2397,6 +2718,67 @@ sbus_call_nss_memcache_InvalidateGroupById_recv
     return sbus_method_in_u_out__recv(req);
 }
 
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateObjects_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_users,
+     const char ** arg_groups,
+     uint32_t * arg_gids)
+{
+    return sbus_method_in_asasau_out__send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.nss.MemoryCache", "InvalidateObjects", arg_users, arg_groups, arg_gids);
+}
+
+errno_t
+sbus_call_nss_memcache_InvalidateObjects_recv
+    (struct tevent_req *req)
+{
+    return sbus_method_in_asasau_out__recv(req);
+}
+
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateUserByName_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name)
+{
+    return sbus_method_in_s_out__send(mem_ctx, conn, _sbus_sss_key_s_0,
+        busname, object_path, "sssd.nss.MemoryCache", "InvalidateUserByName", arg_name);
+}
+
+errno_t
+sbus_call_nss_memcache_InvalidateUserByName_recv
+    (struct tevent_req *req)
+{
+    return sbus_method_in_s_out__recv(req);
+}
+
+struct tevent_req *
+sbus_call_nss_memcache_NewGeneration_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     bool arg_users,
+     bool arg_groups,
+     bool arg_initgroups)
+{
+    return sbus_method_in_bbb_out__send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.nss.MemoryCache", "NewGeneration", arg_users, arg_groups, arg_initgroups);
+}
+
+errno_t
+sbus_call_nss_memcache_NewGeneration_recv
+    (struct tevent_req *req)
+{
+    return sbus_method_in_bbb_out__recv(req);
+}
+
 struct tevent_req *
 sbus_call_nss_memcache_UpdateInitgroups_send
     (TALLOC_CTX *mem_ctx,
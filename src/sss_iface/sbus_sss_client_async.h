@@ -275,6 +275,28 @@ sbus_call_dp_dp_getAccountInfo_recv
      uint32_t* _error,
      const char ** _error_message);
 
+struct tevent_req *
+sbus_call_dp_dp_getAccountInfoList_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t arg_dp_flags,
+     uint32_t arg_entry_type,
+     const char ** arg_filters,
+     const char * arg_domain,
+     const char * arg_extra,
+     uint32_t arg_cli_id);
+
+errno_t
+sbus_call_dp_dp_getAccountInfoList_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t* _dp_error,
+     uint32_t* _error,
+     const char ** _error_message,
+     uint32_t ** _errors);
+
 struct tevent_req *
 sbus_call_dp_dp_getDomains_send
     (TALLOC_CTX *mem_ctx,
@@ -418,6 +440,46 @@ errno_t
 sbus_call_nss_memcache_InvalidateGroupById_recv
     (struct tevent_req *req);
 
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateObjects_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_users,
+     const char ** arg_groups,
+     uint32_t * arg_gids);
+
+errno_t
+sbus_call_nss_memcache_InvalidateObjects_recv
+    (struct tevent_req *req);
+
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateUserByName_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name);
+
+errno_t
+sbus_call_nss_memcache_InvalidateUserByName_recv
+    (struct tevent_req *req);
+
+struct tevent_req *
+sbus_call_nss_memcache_NewGeneration_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     bool arg_users,
+     bool arg_groups,
+     bool arg_initgroups);
+
+errno_t
+sbus_call_nss_memcache_NewGeneration_recv
+    (struct tevent_req *req);
+
 struct tevent_req *
 sbus_call_nss_memcache_UpdateInitgroups_send
     (TALLOC_CTX *mem_ctx,
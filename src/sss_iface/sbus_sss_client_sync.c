@@ -29,6 +29,63 @@
 #include "sss_iface/sbus_sss_arguments.h"
 #include "sss_iface/sbus_sss_client_properties.h"
 
+static errno_t
+sbus_method_in__out_asauauau
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char *** _arg0,
+     uint32_t ** _arg1,
+     uint32_t ** _arg2,
+     uint32_t ** _arg3)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_sss_invoker_args_asauauau *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_sss_invoker_args_asauauau);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL, NULL,
+                                bus, path, iface, method, NULL, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_asauauau, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, out->arg3);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_ss_out_o
     (TALLOC_CTX *mem_ctx,
@@ -131,3 +188,22 @@ sbus_call_systemd_StopUnit
           _arg_job);
 }
 
+errno_t
+sbus_call_monitor_GetStartupTimes
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char *** _arg_names,
+     uint32_t ** _arg_pids,
+     uint32_t ** _arg_launched,
+     uint32_t ** _arg_ready)
+{
+     return sbus_method_in__out_asauauau(mem_ctx, conn,
+          busname, object_path, "sssd.monitor", "GetStartupTimes",
+          _arg_names,
+          _arg_pids,
+          _arg_launched,
+          _arg_ready);
+}
+
@@ -58,4 +58,15 @@ sbus_call_systemd_StopUnit
      const char * arg_mode,
      const char ** _arg_job);
 
+errno_t
+sbus_call_monitor_GetStartupTimes
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char *** _arg_names,
+     uint32_t ** _arg_pids,
+     uint32_t ** _arg_launched,
+     uint32_t ** _arg_ready);
+
 #endif /* _SBUS_SSS_CLIENT_SYNC_H_ */
@@ -559,6 +559,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: sssd.dataprovider.getAccountInfoList */
+#define SBUS_METHOD_SYNC_sssd_dataprovider_getAccountInfoList(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t, uint32_t, const char **, const char *, const char *, uint32_t, uint16_t*, uint32_t*, const char **, uint32_t **); \
+    sbus_method_sync("getAccountInfoList", \
+        &_sbus_sss_args_sssd_dataprovider_getAccountInfoList, \
+        NULL, \
+        _sbus_sss_invoke_in_uuasssu_out_qusau_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_dataprovider_getAccountInfoList(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), uint32_t, uint32_t, const char **, const char *, const char *, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), uint16_t*, uint32_t*, const char **, uint32_t **); \
+    sbus_method_async("getAccountInfoList", \
+        &_sbus_sss_args_sssd_dataprovider_getAccountInfoList, \
+        NULL, \
+        _sbus_sss_invoke_in_uuasssu_out_qusau_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: sssd.dataprovider.getDomains */
 #define SBUS_METHOD_SYNC_sssd_dataprovider_getDomains(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint16_t*, uint32_t*, const char **); \
@@ -675,6 +697,28 @@
         (methods), (signals), (properties)); \
 })
 
+/* Method: sssd.monitor.GetStartupTimes */
+#define SBUS_METHOD_SYNC_sssd_monitor_GetStartupTimes(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char ***, uint32_t **, uint32_t **, uint32_t **); \
+    sbus_method_sync("GetStartupTimes", \
+        &_sbus_sss_args_sssd_monitor_GetStartupTimes, \
+        NULL, \
+        _sbus_sss_invoke_in__out_asauauau_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_monitor_GetStartupTimes(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data)); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, uint32_t **, uint32_t **, uint32_t **); \
+    sbus_method_async("GetStartupTimes", \
+        &_sbus_sss_args_sssd_monitor_GetStartupTimes, \
+        NULL, \
+        _sbus_sss_invoke_in__out_asauauau_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: sssd.monitor.RegisterService */
 #define SBUS_METHOD_SYNC_sssd_monitor_RegisterService(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint16_t, uint16_t, uint16_t*); \
@@ -791,6 +835,72 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: sssd.nss.MemoryCache.InvalidateObjects */
+#define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_InvalidateObjects(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char **, const char **, uint32_t *); \
+    sbus_method_sync("InvalidateObjects", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateObjects, \
+        NULL, \
+        _sbus_sss_invoke_in_asasau_out__send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_nss_MemoryCache_InvalidateObjects(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char **, const char **, uint32_t *); \
+    SBUS_CHECK_RECV((handler_recv)); \
+    sbus_method_async("InvalidateObjects", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateObjects, \
+        NULL, \
+        _sbus_sss_invoke_in_asasau_out__send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
+/* Method: sssd.nss.MemoryCache.InvalidateUserByName */
+#define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_InvalidateUserByName(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *); \
+    sbus_method_sync("InvalidateUserByName", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateUserByName, \
+        NULL, \
+        _sbus_sss_invoke_in_s_out__send, \
+        _sbus_sss_key_s_0, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_nss_MemoryCache_InvalidateUserByName(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *); \
+    SBUS_CHECK_RECV((handler_recv)); \
+    sbus_method_async("InvalidateUserByName", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateUserByName, \
+        NULL, \
+        _sbus_sss_invoke_in_s_out__send, \
+        _sbus_sss_key_s_0, \
+        (handler_send), (handler_recv), (data)); \
+})
+
+/* Method: sssd.nss.MemoryCache.NewGeneration */
+#define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_NewGeneration(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), bool, bool, bool); \
+    sbus_method_sync("NewGeneration", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_NewGeneration, \
+        NULL, \
+        _sbus_sss_invoke_in_bbb_out__send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_nss_MemoryCache_NewGeneration(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), bool, bool, bool); \
+    SBUS_CHECK_RECV((handler_recv)); \
+    sbus_method_async("NewGeneration", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_NewGeneration, \
+        NULL, \
+        _sbus_sss_invoke_in_bbb_out__send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: sssd.nss.MemoryCache.UpdateInitgroups */
 #define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_UpdateInitgroups(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, const char *, uint32_t *); \
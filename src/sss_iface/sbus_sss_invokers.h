@@ -40,6 +40,9 @@
          const char **_key)
 
 _sbus_sss_declare_invoker(, );
+_sbus_sss_declare_invoker(, asauauau);
+_sbus_sss_declare_invoker(asasau, );
+_sbus_sss_declare_invoker(bbb, );
 _sbus_sss_declare_invoker(pam_data, pam_response);
 _sbus_sss_declare_invoker(raw, qus);
 _sbus_sss_declare_invoker(s, );
@@ -55,6 +58,7 @@ _sbus_sss_declare_invoker(usq, );
 _sbus_sss_declare_invoker(ussu, );
 _sbus_sss_declare_invoker(ussu, qus);
 _sbus_sss_declare_invoker(usu, );
+_sbus_sss_declare_invoker(uuasssu, qusau);
 _sbus_sss_declare_invoker(uusssu, qus);
 _sbus_sss_declare_invoker(uusu, qus);
 _sbus_sss_declare_invoker(uuusu, qus);
@@ -282,6 +282,26 @@ _sbus_sss_args_sssd_dataprovider_getAccountInfo = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_dataprovider_getAccountInfoList = {
+    .input = (const struct sbus_argument[]){
+        {.type = "u", .name = "dp_flags"},
+        {.type = "u", .name = "entry_type"},
+        {.type = "as", .name = "filters"},
+        {.type = "s", .name = "domain"},
+        {.type = "s", .name = "extra"},
+        {.type = "u", .name = "cli_id"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "q", .name = "dp_error"},
+        {.type = "u", .name = "error"},
+        {.type = "s", .name = "error_message"},
+        {.type = "au", .name = "errors"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getDomains = {
     .input = (const struct sbus_argument[]){
@@ -356,6 +376,20 @@ _sbus_sss_args_sssd_dataprovider_sudoHandler = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_monitor_GetStartupTimes = {
+    .input = (const struct sbus_argument[]){
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "as", .name = "names"},
+        {.type = "au", .name = "pids"},
+        {.type = "au", .name = "launched"},
+        {.type = "au", .name = "ready"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_monitor_RegisterService = {
     .input = (const struct sbus_argument[]){
@@ -411,6 +445,43 @@ _sbus_sss_args_sssd_nss_MemoryCache_InvalidateGroupById = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateObjects = {
+    .input = (const struct sbus_argument[]){
+        {.type = "as", .name = "users"},
+        {.type = "as", .name = "groups"},
+        {.type = "au", .name = "gids"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {NULL}
+    }
+};
+
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateUserByName = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {NULL}
+    }
+};
+
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_NewGeneration = {
+    .input = (const struct sbus_argument[]){
+        {.type = "b", .name = "users"},
+        {.type = "b", .name = "groups"},
+        {.type = "b", .name = "initgroups"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_UpdateInitgroups = {
     .input = (const struct sbus_argument[]){
@@ -85,6 +85,9 @@ _sbus_sss_args_sssd_dataprovider_getAccountDomain;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getAccountInfo;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_dataprovider_getAccountInfoList;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getDomains;
 
@@ -100,6 +103,9 @@ _sbus_sss_args_sssd_dataprovider_resolverHandler;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_sudoHandler;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_monitor_GetStartupTimes;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_monitor_RegisterService;
 
@@ -115,6 +121,15 @@ _sbus_sss_args_sssd_nss_MemoryCache_InvalidateAllUsers;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_InvalidateGroupById;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateObjects;
+
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateUserByName;
+
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_NewGeneration;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_UpdateInitgroups;
 
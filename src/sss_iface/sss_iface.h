@@ -44,6 +44,10 @@
 
 #define SSS_BUS_PATH        "/sssd"
 
+/* Ready time returned by sssd.monitor.GetStartupTimes for a service that
+ * has not registered yet. */
+#define SSS_STARTUP_NOT_READY UINT32_MAX
+
 /* From responder_sbus.h, we will eventually get rid of it. */
 #define NSS_SBUS_SERVICE_NAME "nss"
 #define NSS_SBUS_SERVICE_VERSION 0x0001
@@ -30,6 +30,7 @@
 
 
 #include "confdb/confdb.c"
+#include "confdb/confdb_snapshot.h"
 
 #define TESTS_PATH "confdb_" BASE_FILE_STEM
 #define TEST_CONF_DB "test_confdb.ldb"
@@ -251,6 +252,94 @@ static void test_confdb_get_enabled_domain_list(void **state)
 }
 
 
+static void test_confdb_snapshot(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct confdb_ctx *cdb;
+    char *conf_db;
+    char **list;
+    char *str;
+    const char *val[2] = { "false", NULL };
+    int ret;
+
+    ret = confdb_snapshot_publish(test_ctx->confdb, geteuid(), getegid());
+    assert_int_equal(ret, EOK);
+    assert_non_null(test_ctx->confdb->snapshot);
+
+    conf_db = talloc_asprintf(test_ctx, "%s/%s", TESTS_PATH, TEST_CONF_DB);
+    assert_non_null(conf_db);
+
+    ret = confdb_init(test_ctx, &cdb, conf_db);
+    assert_int_equal(ret, EOK);
+    talloc_free(conf_db);
+    assert_non_null(cdb->snapshot);
+
+    /* Case of the section and attribute names does not matter. */
+    ret = confdb_get_string(cdb, test_ctx,
+                            "config/domain/" TEST_DOMAIN_ENABLED_2,
+                            "ENABLED", NULL, &str);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(str, "true");
+    talloc_free(str);
+
+    ret = confdb_get_string(cdb, test_ctx, "config/domain/Enabled_3",
+                            "id_provider", NULL, &str);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(str, "local");
+    talloc_free(str);
+
+    ret = confdb_get_string(cdb, test_ctx,
+                            "config/domain/" TEST_DOMAIN_ENABLED_2,
+                            "unknown_option", "default", &str);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(str, "default");
+    talloc_free(str);
+
+    ret = confdb_get_string(cdb, test_ctx, "config/domain/unknown",
+                            "enabled", NULL, &str);
+    assert_int_equal(ret, EOK);
+    assert_null(str);
+
+    ret = confdb_get_string_as_list(cdb, test_ctx, "config/sssd", "domains",
+                                    &list);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(list[0], TEST_DOMAIN_ENABLED_1);
+    assert_string_equal(list[1], TEST_DOMAIN_ENABLED_3);
+    assert_string_equal(list[2], TEST_DOMAIN_DISABLED_3);
+    assert_null(list[3]);
+    talloc_free(list);
+
+    /* A modification publishes a new snapshot which replaces the old one
+     * in the other process. */
+    ret = confdb_add_param(test_ctx->confdb, true,
+                           "config/domain/" TEST_DOMAIN_ENABLED_2,
+                           "enabled", val);
+    assert_int_equal(ret, EOK);
+
+    ret = confdb_get_string(cdb, test_ctx,
+                            "config/domain/" TEST_DOMAIN_ENABLED_2,
+                            "enabled", NULL, &str);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(str, "false");
+    talloc_free(str);
+    assert_non_null(cdb->snapshot);
+
+    /* Removed snapshot is not used anymore. */
+    ret = confdb_snapshot_remove(test_ctx->confdb);
+    assert_int_equal(ret, EOK);
+
+    ret = confdb_get_string(cdb, test_ctx,
+                            "config/domain/" TEST_DOMAIN_ENABLED_2,
+                            "enabled", NULL, &str);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(str, "false");
+    talloc_free(str);
+    assert_null(cdb->snapshot);
+
+    talloc_free(cdb);
+}
+
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -272,6 +361,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_confdb_get_enabled_domain_list,
                                         confdb_test_setup,
                                         confdb_test_teardown),
+        cmocka_unit_test_setup_teardown(test_confdb_snapshot,
+                                        confdb_test_setup,
+                                        confdb_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
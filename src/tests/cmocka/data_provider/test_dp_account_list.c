@@ -0,0 +1,559 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Data Provider account list requests
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/common.h"
+#include "tests/cmocka/common_mock_be.h"
+#include "tests/cmocka/data_provider/mock_dp.h"
+
+/* Include the source file to reach DP_ACCOUNT_LIST_PARALLEL. */
+#include "providers/data_provider/dp_target_id.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_dp_account_list.ldb"
+#define TEST_DOM_NAME "dp_account_list_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define CID 1
+#define SENDER_NAME "sssd.test"
+#define NUM_VALUES 20
+
+struct test_ctx {
+    struct sss_test_ctx *tctx;
+    struct be_ctx *be_ctx;
+    struct data_provider *provider;
+    struct dp_method *dp_methods;
+    struct sbus_request *sbus_req;
+
+    /* Per-item handler statistics. */
+    size_t calls;
+    size_t active;
+    size_t max_active;
+    const char *values[NUM_VALUES];
+
+    /* List handler statistics. */
+    size_t list_calls;
+    size_t list_values;
+};
+
+static int test_setup(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct sbus_sender *sender;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER, NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    test_ctx->provider = mock_dp(test_ctx, test_ctx->be_ctx);
+    test_ctx->dp_methods = mock_dp_get_methods(test_ctx->provider, DPT_ID);
+
+    test_ctx->sbus_req = talloc_zero(test_ctx, struct sbus_request);
+    assert_non_null(test_ctx->sbus_req);
+
+    sender = talloc_zero(test_ctx->sbus_req, struct sbus_sender);
+    assert_non_null(sender);
+    sender->name = SENDER_NAME;
+    test_ctx->sbus_req->sender = sender;
+
+    check_leaks_push(test_ctx);
+
+    *state = test_ctx;
+
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    struct test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_zfree(test_ctx);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+bool __wrap_be_is_offline(struct be_ctx *ctx)
+{
+    return false;
+}
+
+/* Per-item account handler. Values starting with "fail" fail with EIO. */
+
+struct account_state {
+    struct test_ctx *test_ctx;
+    struct dp_reply_std reply;
+};
+
+static void account_handler_done(struct tevent_context *ev,
+                                 struct tevent_timer *tt,
+                                 struct timeval tv,
+                                 void *pvt);
+
+static struct tevent_req *
+account_handler_send(TALLOC_CTX *mem_ctx,
+                     struct test_ctx *test_ctx,
+                     struct dp_id_data *data,
+                     struct dp_req_params *params)
+{
+    struct account_state *state;
+    struct tevent_req *req;
+    struct tevent_timer *tt;
+
+    req = tevent_req_create(mem_ctx, &state, struct account_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->test_ctx = test_ctx;
+    if (strncmp(data->filter_value, "fail", 4) == 0) {
+        dp_reply_std_set(&state->reply, DP_ERR_FATAL, EIO, NULL);
+    } else {
+        dp_reply_std_set(&state->reply, DP_ERR_OK, EOK, NULL);
+    }
+
+    assert_true(test_ctx->calls < NUM_VALUES);
+    test_ctx->values[test_ctx->calls] = data->filter_value;
+    test_ctx->calls++;
+    test_ctx->active++;
+    if (test_ctx->active > test_ctx->max_active) {
+        test_ctx->max_active = test_ctx->active;
+    }
+
+    /* Finish asynchronously so that the requests overlap. */
+    tt = tevent_add_timer(params->ev, req, tevent_timeval_current_ofs(0, 0),
+                          account_handler_done, req);
+    if (tt == NULL) {
+        return NULL;
+    }
+
+    return req;
+}
+
+static void account_handler_done(struct tevent_context *ev,
+                                 struct tevent_timer *tt,
+                                 struct timeval tv,
+                                 void *pvt)
+{
+    struct account_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct account_state);
+
+    state->test_ctx->active--;
+    tevent_req_done(req);
+}
+
+static errno_t
+account_handler_recv(TALLOC_CTX *mem_ctx,
+                     struct tevent_req *req,
+                     struct dp_reply_std *data)
+{
+    struct account_state *state;
+
+    state = tevent_req_data(req, struct account_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *data = state->reply;
+
+    return EOK;
+}
+
+/* List handler. Reports ENOENT for values starting with "missing". */
+
+struct account_list_state {
+    struct dp_reply_list reply;
+};
+
+static struct tevent_req *
+account_list_handler_send(TALLOC_CTX *mem_ctx,
+                          struct test_ctx *test_ctx,
+                          struct dp_id_list_data *data,
+                          struct dp_req_params *params)
+{
+    struct account_list_state *state;
+    struct tevent_req *req;
+    size_t count;
+    size_t i;
+
+    req = tevent_req_create(mem_ctx, &state, struct account_list_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    for (count = 0; data->filter_values[count] != NULL; count++);
+
+    test_ctx->list_calls++;
+    test_ctx->list_values += count;
+
+    state->reply.errors = talloc_zero_array(state, uint32_t, count);
+    if (state->reply.errors == NULL) {
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, params->ev);
+        return req;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (strncmp(data->filter_values[i], "missing", 7) == 0) {
+            state->reply.errors[i] = ENOENT;
+        }
+    }
+
+    dp_reply_std_set(&state->reply.std, DP_ERR_OK, EOK, NULL);
+    tevent_req_done(req);
+    tevent_req_post(req, params->ev);
+
+    return req;
+}
+
+static errno_t
+account_list_handler_recv(TALLOC_CTX *mem_ctx,
+                          struct tevent_req *req,
+                          struct dp_reply_list *data)
+{
+    struct account_list_state *state;
+
+    state = tevent_req_data(req, struct account_list_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    data->std = state->reply.std;
+    data->errors = talloc_steal(mem_ctx, state->reply.errors);
+
+    return EOK;
+}
+
+static void set_account_handler(struct test_ctx *test_ctx)
+{
+    dp_set_method(test_ctx->dp_methods, DPM_ACCOUNT_HANDLER,
+                  account_handler_send, account_handler_recv, test_ctx,
+                  struct test_ctx, struct dp_id_data, struct dp_reply_std);
+}
+
+static errno_t run_list_request(struct test_ctx *test_ctx,
+                                uint32_t entry_type,
+                                const char **filters,
+                                uint16_t *_dp_error,
+                                uint32_t *_error,
+                                uint32_t **_errors)
+{
+    struct tevent_req *req;
+    const char *err_msg;
+    errno_t ret;
+
+    req = dp_get_account_info_list_send(test_ctx, test_ctx->tctx->ev,
+                                        test_ctx->sbus_req,
+                                        test_ctx->provider, 0, entry_type,
+                                        filters, TEST_DOM_NAME, NULL, CID);
+    assert_non_null(req);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    ret = dp_get_account_info_list_recv(test_ctx, req, _dp_error, _error,
+                                        &err_msg, _errors);
+    talloc_free(req);
+
+    return ret;
+}
+
+static const char **make_filters(TALLOC_CTX *mem_ctx,
+                                 const char *prefix,
+                                 const char *fail_prefix,
+                                 size_t count)
+{
+    const char **filters;
+    size_t i;
+
+    filters = talloc_zero_array(mem_ctx, const char *, count + 1);
+    assert_non_null(filters);
+
+    for (i = 0; i < count; i++) {
+        /* Every seventh value fails. */
+        filters[i] = talloc_asprintf(filters, "%s%s%zu", prefix,
+                                     i % 7 == 3 ? fail_prefix : "user", i);
+        assert_non_null(filters[i]);
+    }
+
+    return filters;
+}
+
+static void test_fallback_parallel(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char **filters;
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+    size_t i;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+
+    filters = make_filters(test_ctx, "name=", "user", NUM_VALUES);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, filters,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_error, DP_ERR_OK);
+    assert_int_equal(error, EOK);
+
+    /* Every value was looked up exactly once and in order... */
+    assert_int_equal(test_ctx->calls, NUM_VALUES);
+    for (i = 0; i < NUM_VALUES; i++) {
+        assert_string_equal(test_ctx->values[i],
+                            filters[i] + sizeof("name=") - 1);
+    }
+
+    /* ...but never more than DP_ACCOUNT_LIST_PARALLEL at once. */
+    assert_int_equal(test_ctx->max_active, DP_ACCOUNT_LIST_PARALLEL);
+    assert_int_equal(test_ctx->active, 0);
+
+    assert_int_equal(talloc_array_length(errors), NUM_VALUES);
+    for (i = 0; i < NUM_VALUES; i++) {
+        assert_int_equal(errors[i], EOK);
+    }
+
+    talloc_free(errors);
+    talloc_free(filters);
+}
+
+static void test_fallback_errors(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char **filters;
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+    size_t i;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+
+    filters = make_filters(test_ctx, "idnumber=", "fail", NUM_VALUES);
+
+    ret = run_list_request(test_ctx, BE_REQ_GROUP, filters,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EOK);
+
+    /* A failed item is reported as the result of the whole request... */
+    assert_int_equal(dp_error, DP_ERR_FATAL);
+    assert_int_equal(error, EIO);
+
+    /* ...and only the failed items carry the error. */
+    assert_int_equal(test_ctx->calls, NUM_VALUES);
+    assert_int_equal(talloc_array_length(errors), NUM_VALUES);
+    for (i = 0; i < NUM_VALUES; i++) {
+        assert_int_equal(errors[i], i % 7 == 3 ? EIO : EOK);
+    }
+
+    talloc_free(errors);
+    talloc_free(filters);
+}
+
+static void test_list_handler(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char **filters;
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+    size_t i;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+    dp_set_method(test_ctx->dp_methods, DPM_ACCOUNT_LIST_HANDLER,
+                  account_list_handler_send, account_list_handler_recv,
+                  test_ctx, struct test_ctx, struct dp_id_list_data,
+                  struct dp_reply_list);
+
+    filters = make_filters(test_ctx, "name=", "missing", NUM_VALUES);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, filters,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_error, DP_ERR_OK);
+    assert_int_equal(error, EOK);
+
+    /* The module got the whole list in a single request. */
+    assert_int_equal(test_ctx->calls, 0);
+    assert_int_equal(test_ctx->list_calls, 1);
+    assert_int_equal(test_ctx->list_values, NUM_VALUES);
+
+    assert_int_equal(talloc_array_length(errors), NUM_VALUES);
+    for (i = 0; i < NUM_VALUES; i++) {
+        assert_int_equal(errors[i], i % 7 == 3 ? ENOENT : EOK);
+    }
+
+    talloc_free(errors);
+    talloc_free(filters);
+}
+
+static void test_mixed_filters(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char *filters[] = { "name=user0", "idnumber=1001", NULL };
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, filters,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EINVAL);
+    assert_int_equal(test_ctx->calls, 0);
+}
+
+static void test_invalid_filters(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char *wildcard[] = { "wildcard=user*", NULL };
+    const char *garbage[] = { "name=user0", "garbage", NULL };
+    const char *valid[] = { "name=user0", NULL };
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, wildcard,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EINVAL);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, garbage,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EINVAL);
+
+    /* Initgroups are not lists of entries. */
+    ret = run_list_request(test_ctx, BE_REQ_INITGROUPS, valid,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EINVAL);
+
+    assert_int_equal(test_ctx->calls, 0);
+}
+
+static void test_empty_list(void **state)
+{
+    struct test_ctx *test_ctx;
+    const char *filters[] = { NULL };
+    uint32_t *errors;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    set_account_handler(test_ctx);
+
+    ret = run_list_request(test_ctx, BE_REQ_USER, filters,
+                           &dp_error, &error, &errors);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_error, DP_ERR_OK);
+    assert_int_equal(talloc_array_length(errors), 0);
+    assert_int_equal(test_ctx->calls, 0);
+
+    talloc_free(errors);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int no_cleanup = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_fallback_parallel,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_fallback_errors,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_list_handler,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_mixed_filters,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_invalid_filters,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_empty_list,
+                                        test_setup,
+                                        test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+
+    return rv;
+}
@@ -0,0 +1,366 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: sbus messages passed to the in-process connection
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/common.h"
+#include "sss_iface/sss_iface_async.h"
+
+/* Include the handler to reach the static functions. */
+#include "sbus/server/sbus_server_handler.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_SOCKET "sbus-test"
+#define TEST_LOCAL_NAME "sssd.test.local"
+#define TEST_CLIENT_NAME "sssd.test.client"
+
+#define LOG_MAX 8
+
+struct test_ctx {
+    struct tevent_context *ev;
+    struct sbus_server *server;
+    struct sbus_connection *local;
+    struct sbus_connection *client;
+
+    /* Server side of the local and the client connection. */
+    struct sbus_connection *local_peer;
+    struct sbus_connection *client_peer;
+
+    const char *log[LOG_MAX];
+    int log_count;
+};
+
+/* Number of method calls that were passed directly to the local router. */
+static int local_deliveries;
+
+DBusHandlerResult
+__real_sbus_router_filter(struct sbus_connection *conn,
+                          struct sbus_router *router,
+                          DBusMessage *message);
+
+DBusHandlerResult
+__wrap_sbus_router_filter(struct sbus_connection *conn,
+                          struct sbus_router *router,
+                          DBusMessage *message)
+{
+    if (conn->local_server != NULL && conn->local_server->local == conn) {
+        local_deliveries++;
+    }
+
+    return __real_sbus_router_filter(conn, router, message);
+}
+
+static void test_log_method(struct test_ctx *test_ctx, const char *method)
+{
+    assert_true(test_ctx->log_count < LOG_MAX);
+    test_ctx->log[test_ctx->log_count] = method;
+    test_ctx->log_count++;
+}
+
+static errno_t
+test_res_init(TALLOC_CTX *mem_ctx,
+              struct sbus_request *sbus_req,
+              struct test_ctx *test_ctx)
+{
+    test_log_method(test_ctx, "resInit");
+    return EOK;
+}
+
+static errno_t
+test_go_offline(TALLOC_CTX *mem_ctx,
+                struct sbus_request *sbus_req,
+                struct test_ctx *test_ctx)
+{
+    test_log_method(test_ctx, "goOffline");
+    return EOK;
+}
+
+static void test_reset(struct test_ctx *test_ctx)
+{
+    test_ctx->log_count = 0;
+    local_deliveries = 0;
+}
+
+/* Process all events until nothing is in flight between the server and
+ * the local connection. */
+static void test_settle(struct test_ctx *test_ctx)
+{
+    while (!sbus_server_local_idle(test_ctx->local_peer, test_ctx->local)) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static void test_call_res_init(struct test_ctx *test_ctx)
+{
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = sbus_call_service_resInit_send(test_ctx, test_ctx->client,
+                                         TEST_LOCAL_NAME, SSS_BUS_PATH);
+    assert_non_null(req);
+
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = sbus_call_service_resInit_recv(req);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+}
+
+static errno_t test_register_iface(struct test_ctx *test_ctx)
+{
+    SBUS_INTERFACE(iface_service,
+        sssd_service,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_service, resInit, test_res_init, test_ctx),
+            SBUS_SYNC(METHOD, sssd_service, goOffline, test_go_offline, test_ctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    struct sbus_path paths[] = {
+        {SSS_BUS_PATH, &iface_service},
+        {NULL, NULL}
+    };
+
+    return sbus_connection_add_path_map(test_ctx->local, paths);
+}
+
+static int test_setup(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct tevent_req *req;
+    const char *address;
+    char *cwd;
+    errno_t ret;
+
+    test_ctx = talloc_zero(NULL, struct test_ctx);
+    assert_non_null(test_ctx);
+    *state = test_ctx;
+
+    ret = mkdir(TESTS_PATH, 0775);
+    assert_true(ret == 0 || errno == EEXIST);
+
+    cwd = getcwd(NULL, 0);
+    assert_non_null(cwd);
+    address = talloc_asprintf(test_ctx, "unix:path=%s/%s/%s",
+                              cwd, TESTS_PATH, TEST_SOCKET);
+    free(cwd);
+    assert_non_null(address);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    req = sbus_server_create_and_connect_send(test_ctx, test_ctx->ev,
+                                              TEST_LOCAL_NAME, NULL, address,
+                                              false, 10, geteuid(), getegid(),
+                                              NULL, NULL);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = sbus_server_create_and_connect_recv(test_ctx, req,
+                                              &test_ctx->server,
+                                              &test_ctx->local);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+
+    ret = test_register_iface(test_ctx);
+    assert_int_equal(ret, EOK);
+
+    req = sbus_connect_private_send(test_ctx, test_ctx->ev, address,
+                                    TEST_CLIENT_NAME, NULL);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+    ret = sbus_connect_private_recv(test_ctx, req, &test_ctx->client);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+
+    test_ctx->local_peer = sbus_server_find_connection(test_ctx->server,
+                                                       TEST_LOCAL_NAME);
+    assert_non_null(test_ctx->local_peer);
+
+    test_ctx->client_peer = sbus_server_find_connection(test_ctx->server,
+                                                        TEST_CLIENT_NAME);
+    assert_non_null(test_ctx->client_peer);
+
+    /* Resolve the client identity on the local connection so the handlers
+     * run in the order in which the calls arrive. */
+    test_call_res_init(test_ctx);
+    test_settle(test_ctx);
+    test_reset(test_ctx);
+
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    struct test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+    talloc_free(test_ctx);
+
+    unlink(TESTS_PATH "/" TEST_SOCKET);
+    rmdir(TESTS_PATH);
+
+    return 0;
+}
+
+void test_sbus_server_local_handled(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+
+    assert_true(test_ctx->server->local == test_ctx->local);
+
+    /* The call is passed directly to the local router. */
+    test_call_res_init(test_ctx);
+
+    assert_int_equal(local_deliveries, 1);
+    assert_int_equal(test_ctx->log_count, 1);
+    assert_string_equal(test_ctx->log[0], "resInit");
+}
+
+void test_sbus_server_local_fallback(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+    DBusMessage *msg;
+
+    /* Signals keep their ordering through the socket. */
+    msg = dbus_message_new_signal(SSS_BUS_PATH, "sssd.service", "resInit");
+    assert_non_null(msg);
+    assert_false(sbus_server_deliver_local(test_ctx->server,
+                                           test_ctx->local_peer, msg));
+    dbus_message_unref(msg);
+
+    /* org.freedesktop.DBus.Peer is answered by libdbus. */
+    msg = dbus_message_new_method_call(TEST_LOCAL_NAME, SSS_BUS_PATH,
+                                       DBUS_INTERFACE_PEER, "Ping");
+    assert_non_null(msg);
+    assert_false(sbus_server_deliver_local(test_ctx->server,
+                                           test_ctx->local_peer, msg));
+    dbus_message_unref(msg);
+
+    /* Only the in-process connection is served directly. */
+    msg = dbus_message_new_method_call(TEST_CLIENT_NAME, SSS_BUS_PATH,
+                                       "sssd.service", "resInit");
+    assert_non_null(msg);
+    assert_false(sbus_server_deliver_local(test_ctx->server,
+                                           test_ctx->client_peer, msg));
+    dbus_message_unref(msg);
+
+    /* Replies from a connection made from another process go through the
+     * socket. */
+    msg = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+    assert_non_null(msg);
+    assert_false(sbus_server_reply_local(test_ctx->client, msg));
+    dbus_message_unref(msg);
+
+    assert_int_equal(local_deliveries, 0);
+    assert_int_equal(test_ctx->log_count, 0);
+}
+
+void test_sbus_server_local_ordering(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+    DBusMessage *msg;
+    dbus_bool_t dbret;
+
+    /* Write a call to the local connection through the socket but do not
+     * let the local connection read it yet. */
+    msg = dbus_message_new_method_call(TEST_LOCAL_NAME, SSS_BUS_PATH,
+                                       "sssd.service", "goOffline");
+    assert_non_null(msg);
+    dbus_message_set_no_reply(msg, TRUE);
+    dbret = dbus_message_set_sender(msg, TEST_CLIENT_NAME);
+    assert_true(dbret);
+
+    dbret = dbus_connection_send(test_ctx->local_peer->connection, msg, NULL);
+    assert_true(dbret);
+    dbus_connection_flush(test_ctx->local_peer->connection);
+    dbus_message_unref(msg);
+
+    assert_false(dbus_connection_has_messages_to_send(
+                     test_ctx->local_peer->connection));
+    assert_false(sbus_server_local_idle(test_ctx->local_peer,
+                                        test_ctx->local));
+
+    /* The next call must not overtake the one in the socket. */
+    test_call_res_init(test_ctx);
+
+    assert_int_equal(local_deliveries, 0);
+    assert_int_equal(test_ctx->log_count, 2);
+    assert_string_equal(test_ctx->log[0], "goOffline");
+    assert_string_equal(test_ctx->log[1], "resInit");
+
+    /* Once nothing is in flight the direct path is used again. */
+    test_settle(test_ctx);
+    test_reset(test_ctx);
+
+    test_call_res_init(test_ctx);
+
+    assert_int_equal(local_deliveries, 1);
+    assert_int_equal(test_ctx->log_count, 1);
+    assert_string_equal(test_ctx->log[0], "resInit");
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sbus_server_local_handled,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_sbus_server_local_fallback,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_sbus_server_local_ordering,
+                                        test_setup, test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -395,7 +395,7 @@ void test_pss_cert_to_ssh_key_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            NULL, 1, &val[0], NULL);
+                            NULL, NULL, NULL, 1, &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_pss_cert_to_ssh_key_done, ts);
@@ -453,7 +453,57 @@ void test_cert_to_ssh_key_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            NULL, 1, &val[0], NULL);
+                            NULL, NULL, NULL, 1, &val[0], NULL);
+    assert_non_null(req);
+
+    tevent_req_set_callback(req, test_cert_to_ssh_key_done, ts);
+
+    while (!ts->done) {
+        tevent_loop_once(ev);
+    }
+
+    talloc_free(val[0].data);
+    talloc_free(ev);
+}
+
+void test_cert_to_ssh_key_cached_send(void **state)
+{
+    struct cert_to_ssh_key_cache *cache;
+    struct tevent_context *ev;
+    struct tevent_req *req;
+    struct ldb_val val[1];
+    int ret;
+
+    struct test_state *ts = talloc_get_type_abort(*state, struct test_state);
+    assert_non_null(ts);
+    ts->done = false;
+
+    val[0].data = sss_base64_decode(ts, SSSD_TEST_CERT_0001, &val[0].length);
+    assert_non_null(val[0].data);
+
+    ev = tevent_context_init(ts);
+    assert_non_null(ev);
+
+    ret = cert_to_ssh_key_cache_create(ev, 60, &cache);
+    assert_int_equal(ret, EOK);
+
+    req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
+                            ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
+                            NULL, NULL, cache, 1, &val[0], NULL);
+    assert_non_null(req);
+
+    tevent_req_set_callback(req, test_cert_to_ssh_key_done, ts);
+
+    while (!ts->done) {
+        tevent_loop_once(ev);
+    }
+
+    /* The result is cached now, p11_child would time out immediately. */
+    ts->done = false;
+
+    req = cert_to_ssh_key_send(ts, ev, NULL, 0,
+                            ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
+                            NULL, NULL, cache, 1, &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_cert_to_ssh_key_done, ts);
@@ -523,7 +573,7 @@ void test_cert_to_ssh_2keys_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            NULL, 2, &val[0], NULL);
+                            NULL, NULL, NULL, 2, &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_cert_to_ssh_2keys_done, ts);
@@ -602,7 +652,7 @@ void test_cert_to_ssh_2keys_invalid_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            NULL, 3, &val[0], NULL);
+                            NULL, NULL, NULL, 3, &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_cert_to_ssh_2keys_invalid_done, ts);
@@ -664,7 +714,7 @@ void test_ec_cert_to_ssh_key_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                     ABS_BUILD_DIR "/src/tests/test_ECC_CA/SSSD_test_ECC_CA.pem",
-                    NULL, 1, &val[0], NULL);
+                    NULL, NULL, NULL, 1, &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_ec_cert_to_ssh_key_done, ts);
@@ -737,7 +787,8 @@ void test_cert_to_ssh_2keys_with_certmap_send(void **state)
 
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            ts->sss_certmap_ctx, 2, &val[0], NULL);
+                            ts->sss_certmap_ctx, NULL, NULL, 2, &val[0],
+                            NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_cert_to_ssh_2keys_with_certmap_done, ts);
@@ -784,6 +835,7 @@ void test_cert_to_ssh_2keys_with_certmap_2_send(void **state)
     int ret;
     struct tevent_context *ev;
     struct tevent_req *req;
+    struct sss_thread_pool *thread_pool;
     struct ldb_val val[2];
 
     struct test_state *ts = talloc_get_type_abort(*state, struct test_state);
@@ -809,9 +861,14 @@ void test_cert_to_ssh_2keys_with_certmap_2_send(void **state)
     ev = tevent_context_init(ts);
     assert_non_null(ev);
 
+    /* Match the certificates in a worker thread. */
+    ret = sss_thread_pool_create(ev, ev, 1, &thread_pool);
+    assert_int_equal(ret, EOK);
+
     req = cert_to_ssh_key_send(ts, ev, NULL, P11_CHILD_TIMEOUT,
                             ABS_BUILD_DIR "/src/tests/test_CA/SSSD_test_CA.pem",
-                            ts->sss_certmap_ctx, 2, &val[0], NULL);
+                            ts->sss_certmap_ctx, thread_pool, NULL, 2,
+                            &val[0], NULL);
     assert_non_null(req);
 
     tevent_req_set_callback(req, test_cert_to_ssh_2keys_with_certmap_2_done, ts);
@@ -852,6 +909,8 @@ int main(int argc, const char *argv[])
 #ifdef HAVE_TEST_CA
         cmocka_unit_test_setup_teardown(test_cert_to_ssh_key_send,
                                         setup, teardown),
+        cmocka_unit_test_setup_teardown(test_cert_to_ssh_key_cached_send,
+                                        setup, teardown),
         cmocka_unit_test_setup_teardown(test_cert_to_ssh_2keys_send,
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_cert_to_ssh_2keys_invalid_send,
@@ -0,0 +1,561 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Files provider updates of the cache
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <stdio.h>
+
+#include "tests/cmocka/common_mock.h"
+
+/* Include the source file to reach the static functions. */
+#include "providers/files/files_ops.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_files_ops_conf.ldb"
+#define TEST_DOM_NAME "files_ops_test"
+#define TEST_ID_PROVIDER "files"
+
+#define TEST_PASSWD_FILE TESTS_PATH "/passwd"
+#define TEST_GROUP_FILE TESTS_PATH "/group"
+
+struct test_files_ops_ctx {
+    struct sss_test_ctx *tctx;
+    struct files_id_ctx *id_ctx;
+};
+
+/* ====================== Mocks =============================== */
+
+/* The tests call sf_enum_files() directly, the notifications and the
+ * responders are not involved. */
+struct snotify_ctx *_snotify_create(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    uint16_t snotify_flags,
+                                    const char *filename,
+                                    struct timeval *delay,
+                                    uint32_t mask,
+                                    snotify_cb_fn fn,
+                                    const char *fn_name,
+                                    void *pvt)
+{
+    return NULL;
+}
+
+errno_t dp_add_sr_attribute(struct be_ctx *be_ctx)
+{
+    return EOK;
+}
+
+void dp_sbus_domain_active(struct data_provider *provider,
+                           struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_domain_inconsistent(struct data_provider *provider,
+                                 struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_reset_users_ncache(struct data_provider *provider,
+                                struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_reset_groups_ncache(struct data_provider *provider,
+                                 struct sss_domain_info *dom)
+{
+}
+
+void dp_sbus_invalidate_memcache(struct data_provider *provider,
+                                 const char **users,
+                                 const char **groups,
+                                 uint32_t *gids)
+{
+}
+
+void dp_sbus_new_memcache_generation(struct data_provider *provider,
+                                     bool users,
+                                     bool groups,
+                                     bool initgroups)
+{
+}
+
+void files_account_info_finished(struct files_id_ctx *id_ctx,
+                                 int req_type,
+                                 errno_t ret)
+{
+}
+
+/* ====================== Setup =============================== */
+
+static void write_file(const char *path, const char *content)
+{
+    FILE *f;
+
+    f = fopen(path, "w");
+    assert_non_null(f);
+    assert_true(fputs(content, f) >= 0);
+    assert_int_equal(fclose(f), 0);
+}
+
+static int test_files_ops_setup(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+    struct files_id_ctx *id_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_files_ops_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    id_ctx = talloc_zero(test_ctx, struct files_id_ctx);
+    assert_non_null(id_ctx);
+    id_ctx->domain = test_ctx->tctx->dom;
+
+    id_ctx->passwd_files = talloc_zero_array(id_ctx, const char *, 2);
+    assert_non_null(id_ctx->passwd_files);
+    id_ctx->passwd_files[0] = TEST_PASSWD_FILE;
+
+    id_ctx->group_files = talloc_zero_array(id_ctx, const char *, 2);
+    assert_non_null(id_ctx->group_files);
+    id_ctx->group_files[0] = TEST_GROUP_FILE;
+
+    id_ctx->fctx = talloc_zero(id_ctx, struct files_ctx);
+    assert_non_null(id_ctx->fctx);
+    test_ctx->id_ctx = id_ctx;
+
+    write_file(TEST_PASSWD_FILE, "");
+    write_file(TEST_GROUP_FILE, "");
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_files_ops_teardown(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_files_ops_ctx);
+
+    /* The snapshots are kept between the updates. */
+    talloc_zfree(test_ctx->id_ctx->fctx->users);
+    talloc_zfree(test_ctx->id_ctx->fctx->groups);
+
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_free(test_ctx);
+
+    unlink(TEST_PASSWD_FILE);
+    unlink(TEST_GROUP_FILE);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Utilities =============================== */
+
+static struct sf_changes *run_update(struct test_files_ops_ctx *test_ctx,
+                                     uint8_t flags)
+{
+    struct sf_changes *changes;
+    errno_t ret;
+
+    changes = talloc_zero(test_ctx, struct sf_changes);
+    assert_non_null(changes);
+
+    ret = sf_enum_files(test_ctx->id_ctx, flags, changes);
+    assert_int_equal(ret, EOK);
+
+    return changes;
+}
+
+static char *fqname(TALLOC_CTX *mem_ctx,
+                    struct test_files_ops_ctx *test_ctx,
+                    const char *name)
+{
+    char *fqname;
+
+    fqname = sss_create_internal_fqname(mem_ctx, name,
+                                        test_ctx->tctx->dom->name);
+    assert_non_null(fqname);
+
+    return fqname;
+}
+
+static struct ldb_message *get_user(TALLOC_CTX *mem_ctx,
+                                    struct test_files_ops_ctx *test_ctx,
+                                    const char *name,
+                                    errno_t expected)
+{
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GECOS, SYSDB_SHELL, NULL };
+    struct ldb_message *msg = NULL;
+    TALLOC_CTX *tmp_ctx;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = sysdb_search_user_by_name(tmp_ctx, test_ctx->tctx->dom,
+                                    fqname(tmp_ctx, test_ctx, name),
+                                    attrs, &msg);
+    assert_int_equal(ret, expected);
+
+    msg = talloc_steal(mem_ctx, msg);
+    talloc_free(tmp_ctx);
+    return msg;
+}
+
+/* Checks that the group has exactly the given members and ghost members,
+ * both lists are NULL terminated. */
+static void assert_group(struct test_files_ops_ctx *test_ctx,
+                         const char *name,
+                         const char **members,
+                         const char **ghosts)
+{
+    const char *attrs[] = { SYSDB_MEMBER, SYSDB_GHOST, NULL };
+    struct sss_domain_info *dom = test_ctx->tctx->dom;
+    struct ldb_context *ldb = sysdb_ctx_get_ldb(dom->sysdb);
+    struct ldb_message_element *el;
+    struct ldb_message *msg;
+    struct ldb_dn *dn;
+    TALLOC_CTX *tmp_ctx;
+    unsigned int count;
+    unsigned int i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = sysdb_search_group_by_name(tmp_ctx, dom,
+                                     fqname(tmp_ctx, test_ctx, name),
+                                     attrs, &msg);
+    assert_int_equal(ret, EOK);
+
+    el = ldb_msg_find_element(msg, SYSDB_MEMBER);
+    for (count = 0; members[count] != NULL; count++) {
+        assert_non_null(el);
+
+        dn = sysdb_user_dn(tmp_ctx, dom,
+                           fqname(tmp_ctx, test_ctx, members[count]));
+        assert_non_null(dn);
+
+        for (i = 0; i < el->num_values; i++) {
+            if (ldb_dn_compare(dn, ldb_dn_from_ldb_val(tmp_ctx, ldb,
+                                                       &el->values[i])) == 0) {
+                break;
+            }
+        }
+        assert_true(i < el->num_values);
+    }
+    assert_int_equal(el == NULL ? 0 : el->num_values, count);
+
+    el = ldb_msg_find_element(msg, SYSDB_GHOST);
+    for (count = 0; ghosts[count] != NULL; count++) {
+        assert_true(ldb_msg_check_string_attribute(msg, SYSDB_GHOST,
+                                                   fqname(tmp_ctx, test_ctx,
+                                                          ghosts[count])));
+    }
+    assert_int_equal(el == NULL ? 0 : el->num_values, count);
+
+    talloc_free(tmp_ctx);
+}
+
+static bool changes_has_user(struct test_files_ops_ctx *test_ctx,
+                             struct sf_changes *changes,
+                             const char *name)
+{
+    char *fq = fqname(test_ctx, test_ctx, name);
+    bool found = false;
+
+    for (size_t i = 0; i < changes->num_users; i++) {
+        if (strcmp(changes->users[i], fq) == 0) {
+            found = true;
+            break;
+        }
+    }
+
+    talloc_free(fq);
+    return found;
+}
+
+static bool changes_has_gid(struct sf_changes *changes, uint32_t gid)
+{
+    for (size_t i = 0; i < changes->num_gids; i++) {
+        if (changes->gids[i] == gid) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* ====================== The tests =============================== */
+
+static void test_files_ops_removed_member_ghost(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+    struct sf_changes *changes;
+    const char *both[] = { "user1", "user2", NULL };
+    const char *user1[] = { "user1", NULL };
+    const char *ghost2[] = { "user2", NULL };
+    const char *none[] = { NULL };
+
+    test_ctx = talloc_get_type_abort(*state, struct test_files_ops_ctx);
+
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001::/home/user1:/bin/sh\n"
+               "user2:x:1002:1002::/home/user2:/bin/sh\n");
+    write_file(TEST_GROUP_FILE,
+               "group1:x:2001:user1,user2\n"
+               "group2:x:2002:user1\n");
+
+    /* Nothing is known about the cache on the first update. */
+    changes = run_update(test_ctx, SF_UPDATE_BOTH);
+    assert_true(changes->reset);
+    talloc_free(changes);
+
+    assert_group(test_ctx, "group1", both, none);
+    assert_group(test_ctx, "group2", user1, none);
+
+    /* The removed user stays in the group file, it becomes a ghost member
+     * as if the files were loaded from scratch. */
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001::/home/user1:/bin/sh\n");
+
+    changes = run_update(test_ctx, SF_UPDATE_BOTH);
+    assert_false(changes->reset);
+
+    talloc_free(get_user(test_ctx, test_ctx, "user2", ENOENT));
+    assert_group(test_ctx, "group1", user1, ghost2);
+    assert_group(test_ctx, "group2", user1, none);
+
+    /* Only the removed user and the group it was a member of changed. */
+    assert_true(changes_has_user(test_ctx, changes, "user2"));
+    assert_true(changes_has_gid(changes, 2001));
+    assert_false(changes_has_gid(changes, 2002));
+    talloc_free(changes);
+}
+
+static void test_files_ops_emptied_gecos_shell(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+    struct sf_changes *changes;
+    struct ldb_message *msg;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_files_ops_ctx);
+
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001:User One:/home/user1:/bin/sh\n"
+               "user2:x:1002:1002:User Two:/home/user2:/bin/sh\n");
+
+    talloc_free(run_update(test_ctx, SF_UPDATE_BOTH));
+
+    msg = get_user(test_ctx, test_ctx, "user1", EOK);
+    assert_string_equal(ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL),
+                        "User One");
+    assert_string_equal(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL),
+                        "/bin/sh");
+    talloc_free(msg);
+
+    /* The modified user is stored over the cached entry, the emptied
+     * attributes must not keep their former values. */
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001::/home/user1:\n"
+               "user2:x:1002:1002:User Two:/home/user2:/bin/sh\n");
+
+    changes = run_update(test_ctx, SF_UPDATE_BOTH);
+    assert_false(changes->reset);
+    assert_int_equal(changes->num_users, 1);
+    assert_true(changes_has_user(test_ctx, changes, "user1"));
+    assert_int_equal(changes->num_gids, 0);
+    talloc_free(changes);
+
+    msg = get_user(test_ctx, test_ctx, "user1", EOK);
+    assert_null(ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL));
+    assert_null(ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL));
+    talloc_free(msg);
+
+    msg = get_user(test_ctx, test_ctx, "user2", EOK);
+    assert_string_equal(ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL),
+                        "User Two");
+    talloc_free(msg);
+}
+
+static void test_files_ops_modified_group(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+    struct sf_changes *changes;
+    const char *both[] = { "user1", "user2", NULL };
+    const char *user1[] = { "user1", NULL };
+    const char *user2[] = { "user2", NULL };
+    const char *ghost1[] = { "ghost1", NULL };
+    const char *ghost2[] = { "ghost2", NULL };
+    const char *none[] = { NULL };
+
+    test_ctx = talloc_get_type_abort(*state, struct test_files_ops_ctx);
+
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001::/home/user1:/bin/sh\n"
+               "user2:x:1002:1002::/home/user2:/bin/sh\n");
+    write_file(TEST_GROUP_FILE,
+               "group1:x:2001:user1,user2\n"
+               "group2:x:2002:user1,ghost1\n"
+               "group3:x:2003:user2\n");
+
+    talloc_free(run_update(test_ctx, SF_UPDATE_BOTH));
+
+    assert_group(test_ctx, "group1", both, none);
+    assert_group(test_ctx, "group2", user1, ghost1);
+    assert_group(test_ctx, "group3", user2, none);
+
+    /* The modified groups are stored again without the former members. */
+    write_file(TEST_GROUP_FILE,
+               "group1:x:2001:user1\n"
+               "group2:x:2002:ghost2\n"
+               "group3:x:2003:user2\n");
+
+    changes = run_update(test_ctx, SF_UPDATE_GROUP);
+    assert_false(changes->reset);
+
+    assert_group(test_ctx, "group1", user1, none);
+    assert_group(test_ctx, "group2", none, ghost2);
+    assert_group(test_ctx, "group3", user2, none);
+
+    /* Initgroups of the former members changed as well. */
+    assert_true(changes_has_gid(changes, 2001));
+    assert_true(changes_has_gid(changes, 2002));
+    assert_false(changes_has_gid(changes, 2003));
+    assert_true(changes_has_user(test_ctx, changes, "user1"));
+    assert_true(changes_has_user(test_ctx, changes, "user2"));
+    talloc_free(changes);
+}
+
+static void test_files_ops_reset_threshold(void **state)
+{
+    struct test_files_ops_ctx *test_ctx;
+    struct sf_changes *changes;
+    struct group grp = { 0 };
+    char *name;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_files_ops_ctx);
+
+    changes = talloc_zero(test_ctx, struct sf_changes);
+    assert_non_null(changes);
+
+    for (size_t i = 0; i < SF_INVALIDATE_MAX; i++) {
+        name = talloc_asprintf(changes, "user%zu", i);
+        assert_non_null(name);
+
+        sf_changes_add_user(changes, test_ctx->tctx->dom, name);
+        talloc_free(name);
+    }
+
+    assert_false(changes->reset);
+    assert_int_equal(changes->num_users, SF_INVALIDATE_MAX);
+    assert_null(changes->users[changes->num_users]);
+
+    /* Past the threshold the memory cache is reset as a whole. */
+    grp.gr_name = discard_const("group1");
+    grp.gr_gid = 2001;
+    sf_changes_add_group(changes, test_ctx->tctx->dom, &grp);
+
+    assert_true(changes->reset);
+    assert_int_equal(changes->num_gids, 0);
+    talloc_free(changes);
+
+    /* An update without any change does not invalidate anything. */
+    write_file(TEST_PASSWD_FILE,
+               "user1:x:1001:1001::/home/user1:/bin/sh\n");
+    write_file(TEST_GROUP_FILE,
+               "group1:x:2001:user1\n");
+
+    talloc_free(run_update(test_ctx, SF_UPDATE_BOTH));
+
+    changes = run_update(test_ctx, SF_UPDATE_BOTH);
+    assert_false(changes->reset);
+    assert_int_equal(changes->num_users, 0);
+    assert_int_equal(changes->num_gids, 0);
+    talloc_free(changes);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int no_cleanup = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_files_ops_removed_member_ghost,
+                                        test_files_ops_setup,
+                                        test_files_ops_teardown),
+        cmocka_unit_test_setup_teardown(test_files_ops_emptied_gecos_shell,
+                                        test_files_ops_setup,
+                                        test_files_ops_teardown),
+        cmocka_unit_test_setup_teardown(test_files_ops_modified_group,
+                                        test_files_ops_setup,
+                                        test_files_ops_teardown),
+        cmocka_unit_test_setup_teardown(test_files_ops_reset_threshold,
+                                        test_files_ops_setup,
+                                        test_files_ops_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+
+    return rv;
+}
@@ -0,0 +1,335 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: InfoPipe paged lists of users and groups
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_resp.h"
+#include "responder/ifp/ifp_paged.h"
+#include "responder/ifp/ifp_users.h"
+#include "responder/ifp/ifp_groups.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ifp_paged_conf.ldb"
+#define TEST_DOM_NAME "ifp_paged_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define NUM_OBJECTS 10
+#define BASE_ID 20000
+
+struct test_ifp_paged_ctx {
+    struct sss_test_ctx *tctx;
+    struct ifp_ctx *ifp_ctx;
+
+    const char **paths;
+    const char *next_cursor;
+};
+
+/* ====================== Mocks =============================== */
+
+/* The path is the name of the object so the tests can read it. */
+char *ifp_users_build_path_from_msg(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message *msg)
+{
+    return talloc_strdup(mem_ctx,
+                         ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL));
+}
+
+char *ifp_groups_build_path_from_msg(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     struct ldb_message *msg)
+{
+    return talloc_strdup(mem_ctx,
+                         ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL));
+}
+
+/* ====================== Setup =============================== */
+
+static char *object_name(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *dom,
+                         const char *prefix,
+                         int i)
+{
+    char *name;
+    char *fqname;
+
+    name = talloc_asprintf(mem_ctx, "%s%02d", prefix, i);
+    assert_non_null(name);
+
+    fqname = sss_create_internal_fqname(mem_ctx, name, dom->name);
+    assert_non_null(fqname);
+    talloc_free(name);
+
+    return fqname;
+}
+
+static int test_ifp_paged_setup(void **state)
+{
+    struct test_ifp_paged_ctx *test_ctx;
+    struct sss_domain_info *dom;
+    struct resp_ctx *rctx;
+    char *name;
+    errno_t ret;
+    int i;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ifp_paged_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+    dom = test_ctx->tctx->dom;
+
+    rctx = mock_rctx(test_ctx, test_ctx->tctx->ev, dom, NULL);
+    assert_non_null(rctx);
+
+    ret = sss_ncache_init(rctx, 10, 0, &rctx->ncache);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->ifp_ctx = talloc_zero(test_ctx, struct ifp_ctx);
+    assert_non_null(test_ctx->ifp_ctx);
+    test_ctx->ifp_ctx->rctx = rctx;
+
+    for (i = 1; i <= NUM_OBJECTS; i++) {
+        name = object_name(test_ctx, dom, "user", i);
+        ret = sysdb_store_user(dom, name, NULL, BASE_ID + i, BASE_ID + i,
+                               NULL, "/home/user", "/bin/sh", NULL, NULL,
+                               NULL, 300, 0);
+        assert_int_equal(ret, EOK);
+        talloc_free(name);
+
+        name = object_name(test_ctx, dom, "group", i);
+        ret = sysdb_store_group(dom, name, BASE_ID + i, NULL, 300, 0);
+        assert_int_equal(ret, EOK);
+        talloc_free(name);
+    }
+
+    /* Every fourth object starting with the third one is in the negative
+     * cache. */
+    for (i = 3; i <= NUM_OBJECTS; i += 4) {
+        name = object_name(test_ctx, dom, "user", i);
+        ret = sss_ncache_set_user(rctx->ncache, false, dom, name);
+        assert_int_equal(ret, EOK);
+        talloc_free(name);
+
+        name = object_name(test_ctx, dom, "group", i);
+        ret = sss_ncache_set_group(rctx->ncache, false, dom, name);
+        assert_int_equal(ret, EOK);
+        talloc_free(name);
+    }
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_ifp_paged_teardown(void **state)
+{
+    struct test_ifp_paged_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ifp_paged_ctx);
+
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Utilities =============================== */
+
+static void test_ifp_paged_done(struct tevent_req *req)
+{
+    struct test_ifp_paged_ctx *test_ctx;
+
+    test_ctx = tevent_req_callback_data(req, struct test_ifp_paged_ctx);
+
+    test_ctx->tctx->error = ifp_paged_list_recv(test_ctx, req,
+                                                &test_ctx->paths,
+                                                &test_ctx->next_cursor);
+    talloc_free(req);
+
+    test_ctx->tctx->done = true;
+}
+
+static void run_paged_list(struct test_ifp_paged_ctx *test_ctx,
+                           enum ifp_paged_type type,
+                           const char *cursor,
+                           uint32_t limit)
+{
+    struct tevent_req *req;
+    errno_t ret;
+
+    talloc_zfree(test_ctx->paths);
+    talloc_free(discard_const(test_ctx->next_cursor));
+    test_ctx->next_cursor = NULL;
+    test_ctx->tctx->done = false;
+
+    if (cursor == NULL || cursor[0] == '\0') {
+        /* The first page of the domain refreshes it. */
+        mock_account_recv_simple();
+    }
+
+    req = ifp_paged_list_send(test_ctx, test_ctx->tctx->ev,
+                              test_ctx->ifp_ctx, type, NULL, "*",
+                              cursor, limit);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_ifp_paged_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
+static void assert_page(struct test_ifp_paged_ctx *test_ctx,
+                        const char *prefix,
+                        const int *expected)
+{
+    char *name;
+    int i;
+
+    for (i = 0; expected[i] != 0; i++) {
+        assert_non_null(test_ctx->paths[i]);
+
+        name = object_name(test_ctx, test_ctx->tctx->dom, prefix,
+                           expected[i]);
+        assert_string_equal(test_ctx->paths[i], name);
+        talloc_free(name);
+    }
+
+    assert_null(test_ctx->paths[i]);
+}
+
+static void test_paged_list_ncache(struct test_ifp_paged_ctx *test_ctx,
+                                   enum ifp_paged_type type,
+                                   const char *prefix)
+{
+    struct sss_domain_info *dom = test_ctx->tctx->dom;
+    const int page1[] = { 1, 2, 4, 0 };
+    const int page2[] = { 5, 6, 8, 0 };
+    const int page3[] = { 9, 10, 0 };
+    char *cursor;
+    char *name;
+
+    /* Objects in the negative cache are not returned but they still count
+     * towards the end of the page, the cursor points to the last name
+     * read. */
+    run_paged_list(test_ctx, type, NULL, 4);
+    assert_page(test_ctx, prefix, page1);
+
+    name = object_name(test_ctx, dom, prefix, 4);
+    cursor = talloc_asprintf(test_ctx, "%s:%s", dom->name, name);
+    assert_string_equal(test_ctx->next_cursor, cursor);
+    talloc_free(name);
+
+    run_paged_list(test_ctx, type, cursor, 4);
+    talloc_free(cursor);
+    assert_page(test_ctx, prefix, page2);
+
+    name = object_name(test_ctx, dom, prefix, 8);
+    cursor = talloc_asprintf(test_ctx, "%s:%s", dom->name, name);
+    assert_string_equal(test_ctx->next_cursor, cursor);
+    talloc_free(name);
+
+    run_paged_list(test_ctx, type, cursor, 4);
+    talloc_free(cursor);
+    assert_page(test_ctx, prefix, page3);
+    assert_string_equal(test_ctx->next_cursor, "");
+
+    talloc_zfree(test_ctx->paths);
+    talloc_free(discard_const(test_ctx->next_cursor));
+    test_ctx->next_cursor = NULL;
+}
+
+/* ====================== The tests =============================== */
+
+static void test_paged_users_ncache(void **state)
+{
+    struct test_ifp_paged_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ifp_paged_ctx);
+    test_paged_list_ncache(test_ctx, IFP_PAGED_USER, "user");
+}
+
+static void test_paged_groups_ncache(void **state)
+{
+    struct test_ifp_paged_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ifp_paged_ctx);
+    test_paged_list_ncache(test_ctx, IFP_PAGED_GROUP, "group");
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int no_cleanup = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_paged_users_ncache,
+                                        test_ifp_paged_setup,
+                                        test_ifp_paged_teardown),
+        cmocka_unit_test_setup_teardown(test_paged_groups_ncache,
+                                        test_ifp_paged_setup,
+                                        test_ifp_paged_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+
+    return rv;
+}
@@ -307,6 +307,78 @@ static void test_kcm_ccache_marshall_unmarshall_binary(void **state)
     assert_int_equal(ret, EINVAL);
 }
 
+static void test_kcm_ccache_header_binary(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct kcm_cred *crd;
+    struct kcm_cred *crd2;
+    struct sss_iobuf *cred_blob;
+    struct sss_iobuf *payload;
+    const char *name;
+    const char *key;
+    uuid_t uuid;
+    uuid_t uuid2;
+    int i;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     test_ctx->princ,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; i < 3; i++) {
+        cred_blob = sss_iobuf_init_readonly(cc, (const uint8_t *) TEST_CREDS,
+                                            sizeof(TEST_CREDS));
+        assert_non_null(cred_blob);
+
+        ret = kcm_cc_store_cred_blob(cc, cred_blob);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = kcm_ccache_to_sec_header_binary(test_ctx, cc, &payload);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    sss_iobuf_cursor_reset(payload);
+    ret = sec_header_to_ccache_binary(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+
+    /* The header lists the credentials in their original order and does not
+     * carry their content. */
+    for (crd = kcm_cc_get_cred(cc), crd2 = kcm_cc_get_cred(cc2);
+         crd != NULL && crd2 != NULL;
+         crd = kcm_cc_next_cred(crd), crd2 = kcm_cc_next_cred(crd2)) {
+        ret = kcm_cred_get_uuid(crd, uuid);
+        assert_int_equal(ret, EOK);
+        ret = kcm_cred_get_uuid(crd2, uuid2);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(uuid_compare(uuid, uuid2), 0);
+
+        assert_null(kcm_cred_get_creds(crd2));
+    }
+    assert_null(crd);
+    assert_null(crd2);
+}
+
 static void test_kcm_ccache_no_princ_binary(void **state)
 {
     struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
@@ -433,6 +505,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_kcm_ccache_no_princ_binary,
                                         setup_kcm_marshalling,
                                         teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_header_binary,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
         cmocka_unit_test_setup_teardown(test_kcm_ccache_marshall_unmarshall_json,
                                         setup_kcm_marshalling,
                                         teardown_kcm_marshalling),
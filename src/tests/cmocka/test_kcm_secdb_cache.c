@@ -0,0 +1,658 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Test the in-memory cache of the KCM secdb back end
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "util/util_creds.h"
+#include "tests/cmocka/common_mock.h"
+#include "responder/kcm/kcmsrv_ccache.h"
+#include "responder/kcm/kcmsrv_ccache_be.h"
+#include "responder/kcm/kcmsrv_ccache_pvt.h"
+#include "responder/kcm/kcmsrv_ccache_secdb.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_DB_FULL_PATH  TESTS_PATH "/secrets.ldb"
+#define TEST_MKEY_FULL_PATH  TESTS_PATH "/.secrets.mkey"
+
+#define TEST_REALM                "TESTREALM"
+#define TEST_PRINC_COMPONENT      "PRINC_NAME"
+#define TEST_UID                  1000
+#define TEST_CACHE_SIZE           64 * 1024
+#define TEST_PAYLOAD_LEN          64
+#define TEST_CRED                 "TEST_CRED"
+
+const struct kcm_ccdb_ops ccdb_mem_ops;
+const struct kcm_ccdb_ops ccdb_sec_ops;
+
+struct test_ctx {
+    struct tevent_context *ev;
+    struct kcm_ccdb *db;
+    struct ccdb_secdb *secdb;
+    struct cli_creds client;
+
+    krb5_context kctx;
+    krb5_principal princ;
+};
+
+/* The KCM hive can only be accessed by root, pretend to be one. */
+uid_t __wrap_geteuid(void)
+{
+    return 0;
+}
+
+/* Wrap fstat() to ignore ownership check failure
+ * from lcl_read_mkey() -> check_and_open_readonly()
+ */
+int __real_fstat(int fd, struct stat *statbuf);
+
+int __wrap_fstat(int fd, struct stat *statbuf)
+{
+    int ret;
+
+    ret = __real_fstat(fd, statbuf);
+    if (ret == 0) {
+        statbuf->st_uid = 0;
+        statbuf->st_gid = 0;
+    }
+
+    return ret;
+}
+
+/* Override perform_checks and check_fd so that fstat wrap is called */
+static errno_t perform_checks(struct stat *stat_buf,
+                              uid_t uid, gid_t gid,
+                              mode_t mode, mode_t mask)
+{
+    mode_t st_mode;
+
+    if (mask) {
+        st_mode = stat_buf->st_mode & mask;
+    } else {
+        st_mode = stat_buf->st_mode & (S_IFMT|ALLPERMS);
+    }
+
+    if ((mode & S_IFMT) != (st_mode & S_IFMT)) {
+        DEBUG(SSSDBG_TRACE_LIBS, "File is not the right type.\n");
+        return EINVAL;
+    }
+
+    if ((st_mode & ALLPERMS) != (mode & ALLPERMS)) {
+        DEBUG(SSSDBG_TRACE_LIBS,
+              "File has the wrong (bit masked) mode [%.7o], "
+              "expected [%.7o].\n",
+              (st_mode & ALLPERMS), (mode & ALLPERMS));
+        return EINVAL;
+    }
+
+    if (uid != (uid_t)(-1) && stat_buf->st_uid != uid) {
+        DEBUG(SSSDBG_TRACE_LIBS, "File must be owned by uid [%d].\n", uid);
+        return EINVAL;
+    }
+
+    if (gid != (gid_t)(-1) && stat_buf->st_gid != gid) {
+        DEBUG(SSSDBG_TRACE_LIBS, "File must be owned by gid [%d].\n", gid);
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
+errno_t check_fd(int fd, uid_t uid, gid_t gid,
+                 mode_t mode, mode_t mask,
+                 struct stat *caller_stat_buf)
+{
+    int ret;
+    struct stat local_stat_buf;
+    struct stat *stat_buf;
+
+    if (caller_stat_buf == NULL) {
+        stat_buf = &local_stat_buf;
+    } else {
+        stat_buf = caller_stat_buf;
+    }
+
+    ret = fstat(fd, stat_buf);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "fstat for [%d] failed: [%d][%s].\n", fd, ret,
+                                                        strerror(ret));
+        return ret;
+    }
+
+    return perform_checks(stat_buf, uid, gid, mode, mask);
+}
+
+/* ====================== Cache only =============================== */
+
+struct wipe_check {
+    uint8_t *data;
+    size_t len;
+    bool *wiped;
+};
+
+/* Runs when the payload the check is attached to is freed, at that point
+ * the memory of the payload is still valid. */
+static int wipe_check_destructor(struct wipe_check *check)
+{
+    size_t i;
+
+    *check->wiped = true;
+    for (i = 0; i < check->len; i++) {
+        if (check->data[i] != 0) {
+            *check->wiped = false;
+        }
+    }
+
+    return 0;
+}
+
+static void watch_wipe(struct secdb_cache_entry *entry, bool *wiped)
+{
+    struct wipe_check *check;
+
+    check = talloc_zero(entry->data, struct wipe_check);
+    assert_non_null(check);
+
+    check->data = entry->data;
+    check->len = entry->len;
+    check->wiped = wiped;
+    *wiped = false;
+    talloc_set_destructor(check, wipe_check_destructor);
+}
+
+static void store_payload(struct secdb_cache *cache,
+                          const char *secdb_key,
+                          size_t len)
+{
+    struct sss_iobuf *payload;
+    uint8_t *data;
+
+    data = talloc_size(cache, len);
+    assert_non_null(data);
+    memset(data, 'x', len);
+
+    payload = sss_iobuf_init_readonly(data, data, len);
+    assert_non_null(payload);
+
+    secdb_cache_store_cc(cache, TEST_UID, secdb_key, payload, true);
+    talloc_free(data);
+}
+
+static size_t entry_size(const char *secdb_key, size_t len)
+{
+    char *key;
+    size_t size;
+
+    key = secdb_cache_key(NULL, TEST_UID, secdb_key);
+    assert_non_null(key);
+
+    size = sizeof(struct secdb_cache_entry) + strlen(key) + 1 + len;
+    talloc_free(key);
+
+    return size;
+}
+
+static int setup_cache(void **state)
+{
+    assert_true(leak_check_setup());
+    check_leaks_push(global_talloc_context);
+    return 0;
+}
+
+static int teardown_cache(void **state)
+{
+    assert_true(check_leaks_pop(global_talloc_context));
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_cache_disabled(void **state)
+{
+    struct secdb_cache *cache;
+    errno_t ret;
+
+    ret = secdb_cache_init(global_talloc_context, 0, &cache);
+    assert_int_equal(ret, EOK);
+    assert_null(cache);
+
+    /* All operations are no-ops without the cache. */
+    store_payload(NULL, "a", TEST_PAYLOAD_LEN);
+    assert_null(secdb_cache_get(NULL, TEST_UID, "a"));
+    secdb_cache_drop(NULL, TEST_UID, "a");
+}
+
+static void test_cache_lru_eviction(void **state)
+{
+    struct secdb_cache *cache;
+    size_t size;
+    errno_t ret;
+
+    size = entry_size("a", TEST_PAYLOAD_LEN);
+
+    /* Room for exactly two entries. */
+    ret = secdb_cache_init(global_talloc_context, 2 * size, &cache);
+    assert_int_equal(ret, EOK);
+    assert_non_null(cache);
+
+    store_payload(cache, "a", TEST_PAYLOAD_LEN);
+    store_payload(cache, "b", TEST_PAYLOAD_LEN);
+    assert_int_equal(cache->size, 2 * size);
+
+    /* Replacing an entry does not count it twice. */
+    store_payload(cache, "b", TEST_PAYLOAD_LEN);
+    assert_int_equal(cache->size, 2 * size);
+
+    /* Reading "a" made "b" the least recently used entry. */
+    assert_non_null(secdb_cache_get(cache, TEST_UID, "a"));
+    store_payload(cache, "c", TEST_PAYLOAD_LEN);
+    assert_int_equal(cache->size, 2 * size);
+    assert_null(secdb_cache_get(cache, TEST_UID, "b"));
+    assert_non_null(secdb_cache_get(cache, TEST_UID, "a"));
+    assert_non_null(secdb_cache_get(cache, TEST_UID, "c"));
+
+    /* An entry larger than the whole cache is not stored and does not
+     * evict anything. */
+    store_payload(cache, "d", 2 * size);
+    assert_null(secdb_cache_get(cache, TEST_UID, "d"));
+    assert_non_null(secdb_cache_get(cache, TEST_UID, "a"));
+    assert_non_null(secdb_cache_get(cache, TEST_UID, "c"));
+    assert_int_equal(cache->size, 2 * size);
+
+    secdb_cache_drop(cache, TEST_UID, "a");
+    assert_null(secdb_cache_get(cache, TEST_UID, "a"));
+    assert_int_equal(cache->size, size);
+
+    talloc_free(cache);
+}
+
+static void test_cache_wipe(void **state)
+{
+    struct secdb_cache_entry *entry;
+    struct secdb_cache *cache;
+    bool evicted_wiped;
+    bool dropped_wiped;
+    errno_t ret;
+
+    ret = secdb_cache_init(global_talloc_context,
+                           2 * entry_size("a", TEST_PAYLOAD_LEN), &cache);
+    assert_int_equal(ret, EOK);
+
+    store_payload(cache, "a", TEST_PAYLOAD_LEN);
+    entry = secdb_cache_get(cache, TEST_UID, "a");
+    assert_non_null(entry);
+    watch_wipe(entry, &evicted_wiped);
+
+    store_payload(cache, "b", TEST_PAYLOAD_LEN);
+    entry = secdb_cache_get(cache, TEST_UID, "b");
+    assert_non_null(entry);
+    watch_wipe(entry, &dropped_wiped);
+
+    /* "a" is the least recently used entry. */
+    store_payload(cache, "c", TEST_PAYLOAD_LEN);
+    assert_null(secdb_cache_get(cache, TEST_UID, "a"));
+    assert_true(evicted_wiped);
+
+    secdb_cache_drop(cache, TEST_UID, "b");
+    assert_true(dropped_wiped);
+
+    talloc_free(cache);
+}
+
+/* ====================== With the database =============================== */
+
+static int setup_secdb(void **state)
+{
+    struct test_ctx *test_ctx;
+    krb5_error_code kerr;
+    errno_t ret;
+
+    test_ctx = talloc_zero(NULL, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    ret = mkdir(TESTS_PATH, 0700);
+    assert_int_equal(ret, 0);
+
+    test_ctx->secdb = talloc_zero(test_ctx, struct ccdb_secdb);
+    assert_non_null(test_ctx->secdb);
+
+    ret = sss_sec_init_with_path(test_ctx->secdb, NULL, TEST_DB_FULL_PATH,
+                                 TEST_MKEY_FULL_PATH,
+                                 &test_ctx->secdb->sctx);
+    assert_int_equal(ret, EOK);
+
+    ret = secdb_cache_init(test_ctx->secdb, TEST_CACHE_SIZE,
+                           &test_ctx->secdb->cache);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->db = talloc_zero(test_ctx, struct kcm_ccdb);
+    assert_non_null(test_ctx->db);
+    test_ctx->db->ev = test_ctx->ev;
+    test_ctx->db->ops = &ccdb_secdb_ops;
+    test_ctx->db->db_handle = test_ctx->secdb;
+
+    test_ctx->client.ucred.uid = TEST_UID;
+    test_ctx->client.ucred.gid = TEST_UID;
+
+    kerr = krb5_init_context(&test_ctx->kctx);
+    assert_int_equal(kerr, 0);
+
+    kerr = krb5_build_principal(test_ctx->kctx,
+                                &test_ctx->princ,
+                                sizeof(TEST_REALM)-1, TEST_REALM,
+                                TEST_PRINC_COMPONENT, NULL);
+    assert_int_equal(kerr, 0);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int teardown_secdb(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    krb5_free_principal(test_ctx->kctx, test_ctx->princ);
+    krb5_free_context(test_ctx->kctx);
+    talloc_free(test_ctx);
+
+    unlink(TEST_DB_FULL_PATH);
+    unlink(TEST_MKEY_FULL_PATH);
+    rmdir(TESTS_PATH);
+    return 0;
+}
+
+static struct kcm_ccache *create_cc(struct test_ctx *test_ctx,
+                                    const char *name)
+{
+    struct kcm_ccache *cc;
+    struct tevent_req *req;
+    errno_t ret;
+
+    ret = kcm_cc_new(test_ctx, test_ctx->kctx, &test_ctx->client, name,
+                     test_ctx->princ, &cc);
+    assert_int_equal(ret, EOK);
+
+    req = ccdb_secdb_create_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                 &test_ctx->client, cc);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+
+    ret = ccdb_secdb_create_recv(req);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+
+    return cc;
+}
+
+static struct kcm_ccache *get_cc(struct test_ctx *test_ctx,
+                                 struct kcm_ccache *cc)
+{
+    struct kcm_ccache *fetched;
+    struct tevent_req *req;
+    uuid_t uuid;
+    errno_t ret;
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+
+    req = ccdb_secdb_getbyuuid_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                    &test_ctx->client, uuid);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+
+    ret = ccdb_secdb_getbyuuid_recv(req, test_ctx, &fetched);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+
+    return fetched;
+}
+
+static void store_cred(struct test_ctx *test_ctx,
+                       struct kcm_ccache *cc,
+                       const char *cred)
+{
+    struct sss_iobuf *cred_blob;
+    struct tevent_req *req;
+    uuid_t uuid;
+    errno_t ret;
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+
+    cred_blob = sss_iobuf_init_readonly(test_ctx, (const uint8_t *)cred,
+                                        strlen(cred) + 1);
+    assert_non_null(cred_blob);
+
+    req = ccdb_secdb_store_cred_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                     &test_ctx->client, uuid, cred_blob);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+
+    ret = ccdb_secdb_store_cred_recv(req);
+    assert_int_equal(ret, EOK);
+    /* The blob was stolen by the request. */
+    talloc_free(req);
+}
+
+static void delete_cc(struct test_ctx *test_ctx, struct kcm_ccache *cc)
+{
+    struct tevent_req *req;
+    uuid_t uuid;
+    errno_t ret;
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+
+    req = ccdb_secdb_delete_send(test_ctx, test_ctx->ev, test_ctx->db,
+                                 &test_ctx->client, uuid);
+    assert_non_null(req);
+    assert_true(tevent_req_poll(req, test_ctx->ev));
+
+    ret = ccdb_secdb_delete_recv(req);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+}
+
+static const char *cc_secdb_key(struct test_ctx *test_ctx,
+                                struct kcm_ccache *cc)
+{
+    const char *key;
+    uuid_t uuid;
+    errno_t ret;
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+
+    key = sec_key_create(test_ctx, kcm_cc_get_name(cc), uuid);
+    assert_non_null(key);
+
+    return key;
+}
+
+static void test_secdb_write_through(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct sss_sec_req *sreq;
+    struct sss_iobuf *cred_blob;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *fetched;
+    const char *key;
+    errno_t ret;
+
+    cc = create_cc(test_ctx, "1000:1");
+    key = cc_secdb_key(test_ctx, cc);
+
+    /* The payload is cached once it is read. */
+    assert_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, key));
+    fetched = get_cc(test_ctx, cc);
+    assert_non_null(fetched);
+    assert_null(kcm_cc_get_cred(fetched));
+    assert_non_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, key));
+    assert_non_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL));
+
+    /* Storing a credential updates the cached payload as well. */
+    store_cred(test_ctx, cc, TEST_CRED);
+
+    /* Remove the ccache from the database behind the back of the cache, it
+     * is still served from the cache. */
+    ret = secdb_cc_key_req(test_ctx, test_ctx->secdb->sctx, &test_ctx->client,
+                           key, &sreq);
+    assert_int_equal(ret, EOK);
+    ret = sss_sec_delete(sreq);
+    assert_int_equal(ret, EOK);
+    talloc_free(sreq);
+
+    fetched = get_cc(test_ctx, cc);
+    assert_non_null(fetched);
+    assert_non_null(kcm_cc_get_cred(fetched));
+
+    cred_blob = kcm_cred_get_creds(kcm_cc_get_cred(fetched));
+    assert_non_null(cred_blob);
+    assert_int_equal(sss_iobuf_get_size(cred_blob), sizeof(TEST_CRED));
+    assert_memory_equal(sss_iobuf_get_data(cred_blob), TEST_CRED,
+                        sizeof(TEST_CRED));
+
+    /* Once it is dropped the ccache is read from the database again. */
+    secdb_cache_drop(test_ctx->secdb->cache, TEST_UID, key);
+    secdb_cache_drop(test_ctx->secdb->cache, TEST_UID, NULL);
+    fetched = get_cc(test_ctx, cc);
+    assert_null(fetched);
+}
+
+static void test_secdb_drop_on_create(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct secdb_cache_entry *entry;
+    struct kcm_ccache *cc;
+
+    cc = create_cc(test_ctx, "1000:1");
+    assert_non_null(get_cc(test_ctx, cc));
+
+    entry = secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL);
+    assert_non_null(entry);
+    assert_int_equal(entry->nkeys, 1);
+
+    /* The list of keys of the owner is dropped... */
+    cc = create_cc(test_ctx, "1000:2");
+    assert_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL));
+
+    /* ...so the new ccache is found. */
+    assert_non_null(get_cc(test_ctx, cc));
+
+    entry = secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL);
+    assert_non_null(entry);
+    assert_int_equal(entry->nkeys, 2);
+}
+
+static void test_secdb_drop_on_delete(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct secdb_cache_entry *entry;
+    struct kcm_ccache *cc1;
+    struct kcm_ccache *cc2;
+    const char *key;
+
+    cc1 = create_cc(test_ctx, "1000:1");
+    cc2 = create_cc(test_ctx, "1000:2");
+    key = cc_secdb_key(test_ctx, cc2);
+
+    assert_non_null(get_cc(test_ctx, cc2));
+    assert_non_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, key));
+
+    delete_cc(test_ctx, cc2);
+    assert_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, key));
+    assert_null(secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL));
+
+    assert_null(get_cc(test_ctx, cc2));
+    assert_non_null(get_cc(test_ctx, cc1));
+
+    entry = secdb_cache_get(test_ctx->secdb->cache, TEST_UID, NULL);
+    assert_non_null(entry);
+    assert_int_equal(entry->nkeys, 1);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_cache_disabled,
+                                        setup_cache,
+                                        teardown_cache),
+        cmocka_unit_test_setup_teardown(test_cache_lru_eviction,
+                                        setup_cache,
+                                        teardown_cache),
+        cmocka_unit_test_setup_teardown(test_cache_wipe,
+                                        setup_cache,
+                                        teardown_cache),
+        cmocka_unit_test_setup_teardown(test_secdb_write_through,
+                                        setup_secdb,
+                                        teardown_secdb),
+        cmocka_unit_test_setup_teardown(test_secdb_drop_on_create,
+                                        setup_secdb,
+                                        teardown_secdb),
+        cmocka_unit_test_setup_teardown(test_secdb_drop_on_delete,
+                                        setup_secdb,
+                                        teardown_secdb),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure
+     */
+    tests_set_cwd();
+    unlink(TEST_DB_FULL_PATH);
+    unlink(TEST_MKEY_FULL_PATH);
+    rmdir(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
@@ -0,0 +1,571 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: LDAP lists of entries
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_be.h"
+#include "tests/cmocka/common_mock_sdap.h"
+
+#include "providers/ldap/ldap_id_list.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ldap_id_list_conf.ldb"
+#define TEST_DOM_NAME "ldap_id_list_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define NUM_USERS 120
+#define BASE_UID 10000
+#define MAX_SEARCHES 10
+
+struct test_ldap_id_list_ctx {
+    struct sss_test_ctx *tctx;
+    struct be_ctx *be_ctx;
+    struct sdap_id_ctx *id_ctx;
+    struct dp_req_params *params;
+
+    /* Users that exist in the directory. */
+    bool in_directory[NUM_USERS];
+    errno_t search_error;
+
+    /* Number of values of each search. */
+    size_t num_searches;
+    size_t search_values[MAX_SEARCHES];
+};
+
+static struct test_ldap_id_list_ctx *test_ctx;
+
+/* ====================== Mocks =============================== */
+
+bool sdap_idmap_domain_has_algorithmic_mapping(struct sdap_idmap_ctx *ctx,
+                                               const char *name,
+                                               const char *dom_sid)
+{
+    return false;
+}
+
+struct sdap_id_op *sdap_id_op_create(TALLOC_CTX *memctx,
+                                     struct sdap_id_conn_cache *cache)
+{
+    /* Only used as a handle by the code under test. */
+    return (struct sdap_id_op *) talloc_new(memctx);
+}
+
+struct tevent_req *sdap_id_op_connect_send(struct sdap_id_op *op,
+                                           TALLOC_CTX *memctx,
+                                           int *ret_out)
+{
+    struct tevent_req *req;
+
+    req = test_req_succeed_send(memctx, test_ctx->tctx->ev);
+    if (req == NULL) {
+        *ret_out = ENOMEM;
+    }
+
+    return req;
+}
+
+int sdap_id_op_connect_recv(struct tevent_req *req, int *dp_error)
+{
+    *dp_error = DP_ERR_OK;
+    return test_request_recv(req);
+}
+
+int sdap_id_op_done(struct sdap_id_op *op, int ret, int *dp_error)
+{
+    *dp_error = ret == EOK ? DP_ERR_OK : DP_ERR_FATAL;
+    return ret;
+}
+
+struct sdap_handle *sdap_id_op_handle(struct sdap_id_op *op)
+{
+    return NULL;
+}
+
+struct search_user_state {
+    struct sysdb_attrs **users;
+    size_t count;
+};
+
+static size_t count_values(const char *filter, const char *attr)
+{
+    const char *p;
+    size_t len;
+    size_t count = 0;
+
+    len = strlen(attr);
+    for (p = strstr(filter, attr); p != NULL; p = strstr(p + len, attr)) {
+        /* Skip the presence and the non-zero checks. */
+        if (p[len] != '*' && strncmp(p + len, "0)", 2) != 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+struct tevent_req *sdap_search_user_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sss_domain_info *dom,
+                                         struct sdap_options *opts,
+                                         struct sdap_search_base **search_bases,
+                                         struct sdap_handle *sh,
+                                         const char **attrs,
+                                         const char *filter,
+                                         int timeout,
+                                         enum sdap_entry_lookup_type lookup_type)
+{
+    struct search_user_state *state;
+    struct tevent_req *req;
+    char *name_filter;
+    char *uid_filter;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_create(memctx, &state, struct search_user_state);
+    assert_non_null(req);
+
+    assert_true(test_ctx->num_searches < MAX_SEARCHES);
+    test_ctx->search_values[test_ctx->num_searches] =
+                                count_values(filter, "(uid=")
+                                + count_values(filter, "(uidNumber=");
+    test_ctx->num_searches++;
+
+    if (test_ctx->search_error != EOK) {
+        tevent_req_error(req, test_ctx->search_error);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    state->users = talloc_zero_array(state, struct sysdb_attrs *, NUM_USERS);
+    assert_non_null(state->users);
+
+    for (i = 0; i < NUM_USERS; i++) {
+        if (!test_ctx->in_directory[i]) {
+            continue;
+        }
+
+        name_filter = talloc_asprintf(state, "(uid=user%zu)", i);
+        uid_filter = talloc_asprintf(state, "(uidNumber=%zu)", BASE_UID + i);
+        assert_non_null(name_filter);
+        assert_non_null(uid_filter);
+
+        if (strstr(filter, name_filter) != NULL
+                || strstr(filter, uid_filter) != NULL) {
+            state->users[state->count] = sysdb_new_attrs(state->users);
+            assert_non_null(state->users[state->count]);
+
+            /* The server returns the name in different case. */
+            ret = sysdb_attrs_add_string(state->users[state->count],
+                                         SYSDB_NAME,
+                                         talloc_asprintf(state, "User%zu", i));
+            assert_int_equal(ret, EOK);
+
+            ret = sysdb_attrs_add_uint32(state->users[state->count],
+                                         SYSDB_UIDNUM, BASE_UID + i);
+            assert_int_equal(ret, EOK);
+
+            state->count++;
+        }
+
+        talloc_free(name_filter);
+        talloc_free(uid_filter);
+    }
+
+    if (state->count == 0) {
+        tevent_req_error(req, ENOENT);
+    } else {
+        tevent_req_done(req);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+int sdap_search_user_recv(TALLOC_CTX *memctx, struct tevent_req *req,
+                          char **higher_usn, struct sysdb_attrs ***users,
+                          size_t *count)
+{
+    struct search_user_state *state;
+
+    state = tevent_req_data(req, struct search_user_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *users = talloc_steal(memctx, state->users);
+    *count = state->count;
+
+    return EOK;
+}
+
+static char *user_fqname(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *dom,
+                         size_t i)
+{
+    char *name;
+    char *fqname;
+
+    name = talloc_asprintf(mem_ctx, "user%zu", i);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    fqname = sss_create_internal_fqname(mem_ctx, name, dom->name);
+    talloc_free(name);
+
+    return fqname;
+}
+
+static errno_t store_user(struct sss_domain_info *dom, size_t i)
+{
+    char *fqname;
+    errno_t ret;
+
+    fqname = user_fqname(NULL, dom, i);
+    if (fqname == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_store_user(dom, fqname, NULL, BASE_UID + i, BASE_UID + i,
+                           NULL, "/home/user", "/bin/sh", NULL, NULL, NULL,
+                           300, time(NULL));
+    talloc_free(fqname);
+
+    return ret;
+}
+
+int sdap_save_users(TALLOC_CTX *memctx,
+                    struct sysdb_ctx *sysdb,
+                    struct sss_domain_info *dom,
+                    struct sdap_options *opts,
+                    struct sysdb_attrs **users,
+                    int num_users,
+                    struct sysdb_attrs *mapped_attrs,
+                    char **_usn_value)
+{
+    uint32_t uid;
+    int i;
+    errno_t ret;
+
+    for (i = 0; i < num_users; i++) {
+        ret = sysdb_attrs_get_uint32_t(users[i], SYSDB_UIDNUM, &uid);
+        assert_int_equal(ret, EOK);
+
+        /* The same attributes as in the cache, only the timestamp cache
+         * is updated. */
+        ret = store_user(dom, uid - BASE_UID);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+/* ====================== Setup =============================== */
+
+static int test_ldap_id_list_setup(void **state)
+{
+    struct sdap_options *opts;
+    size_t i;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct test_ldap_id_list_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    assert_non_null(test_ctx->be_ctx);
+
+    opts = mock_sdap_options_ldap(test_ctx, test_ctx->tctx->dom,
+                                  test_ctx->tctx->confdb,
+                                  test_ctx->tctx->conf_dom_path);
+    assert_non_null(opts);
+
+    test_ctx->id_ctx = mock_sdap_id_ctx(test_ctx, test_ctx->be_ctx, opts);
+    test_ctx->id_ctx->conn = talloc_zero(test_ctx->id_ctx,
+                                         struct sdap_id_conn_ctx);
+    assert_non_null(test_ctx->id_ctx->conn);
+
+    test_ctx->params = talloc_zero(test_ctx, struct dp_req_params);
+    assert_non_null(test_ctx->params);
+    test_ctx->params->ev = test_ctx->tctx->ev;
+    test_ctx->params->be_ctx = test_ctx->be_ctx;
+    test_ctx->params->domain = test_ctx->tctx->dom;
+
+    /* Every user is cached, every other one was removed from the
+     * directory since. */
+    for (i = 0; i < NUM_USERS; i++) {
+        ret = store_user(test_ctx->tctx->dom, i);
+        assert_int_equal(ret, EOK);
+        test_ctx->in_directory[i] = (i % 2 == 0);
+    }
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_ldap_id_list_teardown(void **state)
+{
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Utilities =============================== */
+
+static const char **make_values(TALLOC_CTX *mem_ctx, int filter_type)
+{
+    const char **values;
+    size_t i;
+
+    values = talloc_zero_array(mem_ctx, const char *, NUM_USERS + 1);
+    assert_non_null(values);
+
+    for (i = 0; i < NUM_USERS; i++) {
+        if (filter_type == BE_FILTER_NAME) {
+            values[i] = talloc_asprintf(values, "user%zu@%s", i,
+                                        test_ctx->tctx->dom->name);
+        } else {
+            values[i] = talloc_asprintf(values, "%zu", BASE_UID + i);
+        }
+        assert_non_null(values[i]);
+    }
+
+    return values;
+}
+
+static void run_list(int filter_type, struct dp_reply_list *reply)
+{
+    struct dp_id_list_data *data;
+    struct tevent_req *req;
+    errno_t ret;
+
+    data = talloc_zero(test_ctx, struct dp_id_list_data);
+    assert_non_null(data);
+    data->entry_type = BE_REQ_USER;
+    data->filter_type = filter_type;
+    data->filter_values = make_values(data, filter_type);
+    data->domain = test_ctx->tctx->dom->name;
+
+    req = sdap_account_list_handler_send(test_ctx, test_ctx->id_ctx, data,
+                                         test_ctx->params);
+    assert_non_null(req);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    ret = sdap_account_list_handler_recv(test_ctx, req, reply);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(req);
+    talloc_free(data);
+}
+
+static void assert_chunks(void)
+{
+    /* 120 values are looked up with searches of at most 50 values. */
+    assert_int_equal(test_ctx->num_searches, 3);
+    assert_int_equal(test_ctx->search_values[0], SDAP_ACCOUNT_LIST_CHUNK);
+    assert_int_equal(test_ctx->search_values[1], SDAP_ACCOUNT_LIST_CHUNK);
+    assert_int_equal(test_ctx->search_values[2],
+                     NUM_USERS - 2 * SDAP_ACCOUNT_LIST_CHUNK);
+}
+
+static void assert_cached(size_t i, bool expected)
+{
+    struct ldb_result *res;
+    char *fqname;
+    errno_t ret;
+
+    fqname = user_fqname(test_ctx, test_ctx->tctx->dom, i);
+    assert_non_null(fqname);
+
+    ret = sysdb_getpwnam(test_ctx, test_ctx->tctx->dom, fqname, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, expected ? 1 : 0);
+    talloc_free(res);
+
+    ret = sysdb_getpwuid(test_ctx, test_ctx->tctx->dom, BASE_UID + i, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, expected ? 1 : 0);
+    talloc_free(res);
+
+    talloc_free(fqname);
+}
+
+/* ====================== The tests =============================== */
+
+static void test_list_by_name(void **state)
+{
+    struct dp_reply_list reply;
+    size_t i;
+
+    run_list(BE_FILTER_NAME, &reply);
+
+    assert_int_equal(reply.std.dp_error, DP_ERR_OK);
+    assert_int_equal(reply.std.error, EOK);
+    assert_int_equal(talloc_array_length(reply.errors), NUM_USERS);
+    assert_chunks();
+
+    /* Unchanged users are kept, users missing from the directory are
+     * removed from the cache. */
+    for (i = 0; i < NUM_USERS; i++) {
+        assert_int_equal(reply.errors[i], EOK);
+        assert_cached(i, test_ctx->in_directory[i]);
+    }
+
+    talloc_free(reply.errors);
+}
+
+static void test_list_by_id(void **state)
+{
+    struct dp_reply_list reply;
+    size_t i;
+
+    run_list(BE_FILTER_IDNUM, &reply);
+
+    assert_int_equal(reply.std.dp_error, DP_ERR_OK);
+    assert_int_equal(reply.std.error, EOK);
+    assert_int_equal(talloc_array_length(reply.errors), NUM_USERS);
+    assert_chunks();
+
+    for (i = 0; i < NUM_USERS; i++) {
+        assert_int_equal(reply.errors[i], EOK);
+        assert_cached(i, test_ctx->in_directory[i]);
+    }
+
+    talloc_free(reply.errors);
+}
+
+static void test_list_none_found(void **state)
+{
+    struct dp_reply_list reply;
+    size_t i;
+
+    for (i = 0; i < NUM_USERS; i++) {
+        test_ctx->in_directory[i] = false;
+    }
+
+    run_list(BE_FILTER_NAME, &reply);
+
+    assert_int_equal(reply.std.dp_error, DP_ERR_OK);
+    assert_chunks();
+
+    for (i = 0; i < NUM_USERS; i++) {
+        assert_int_equal(reply.errors[i], EOK);
+        assert_cached(i, false);
+    }
+
+    talloc_free(reply.errors);
+}
+
+static void test_list_search_error(void **state)
+{
+    struct dp_reply_list reply;
+    size_t i;
+
+    test_ctx->search_error = EIO;
+
+    run_list(BE_FILTER_IDNUM, &reply);
+
+    /* The first search fails, the rest is not attempted and nothing is
+     * removed from the cache. */
+    assert_int_equal(reply.std.dp_error, DP_ERR_FATAL);
+    assert_int_equal(reply.std.error, EIO);
+    assert_int_equal(test_ctx->num_searches, 1);
+
+    for (i = 0; i < NUM_USERS; i++) {
+        assert_int_equal(reply.errors[i], EIO);
+        assert_cached(i, true);
+    }
+
+    talloc_free(reply.errors);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int no_cleanup = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_list_by_name,
+                                        test_ldap_id_list_setup,
+                                        test_ldap_id_list_teardown),
+        cmocka_unit_test_setup_teardown(test_list_by_id,
+                                        test_ldap_id_list_setup,
+                                        test_ldap_id_list_teardown),
+        cmocka_unit_test_setup_teardown(test_list_none_found,
+                                        test_ldap_id_list_setup,
+                                        test_ldap_id_list_teardown),
+        cmocka_unit_test_setup_teardown(test_list_search_error,
+                                        test_ldap_id_list_setup,
+                                        test_ldap_id_list_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+
+    return rv;
+}
@@ -0,0 +1,482 @@
+/*
+    SSSD
+
+    NSS responder: memory cache generation and invalidation tests
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_resp.h"
+#include "sss_client/nss_mc.h"
+
+/* Access the static sbus handlers. */
+#include "responder/nss/nss_iface.c"
+
+/* SSS_NSS_MCACHE_DIR points to this directory, see Makefile.am. */
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_nss_mmap_cache_conf.ldb"
+#define TEST_DOM_NAME "nss_mmap_cache_test"
+
+#define TEST_MC_ELEMS 1000
+#define TEST_MC_TIMEOUT 300
+
+/* The client library serializes access to the memory cache with a mutex
+ * from the socket code, a single threaded test does not need it. */
+void sss_nss_mc_lock(void)
+{
+    return;
+}
+
+void sss_nss_mc_unlock(void)
+{
+    return;
+}
+
+struct nss_mc_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct nss_ctx *nctx;
+};
+
+/* The memory cache files are created once for all tests. The client keeps
+ * the files mapped and would fail the first lookups after they are
+ * replaced, so the tests only ever continue with the same files. */
+static int test_nss_mc_group_setup(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct nss_mc_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, "ipa", NULL);
+    assert_non_null(test_ctx->tctx);
+
+    nctx = talloc_zero(test_ctx, struct nss_ctx);
+    assert_non_null(nctx);
+
+    nctx->rctx = mock_rctx(nctx, test_ctx->tctx->ev, test_ctx->tctx->dom,
+                           nctx);
+    assert_non_null(nctx->rctx);
+
+    ret = sss_mmap_cache_init(nctx, "passwd", geteuid(), getegid(),
+                              SSS_MC_PASSWD, TEST_MC_ELEMS, TEST_MC_TIMEOUT,
+                              false, &nctx->pwd_mc_ctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_mmap_cache_init(nctx, "group", geteuid(), getegid(),
+                              SSS_MC_GROUP, TEST_MC_ELEMS, TEST_MC_TIMEOUT,
+                              false, &nctx->grp_mc_ctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_mmap_cache_init(nctx, "initgroups", geteuid(), getegid(),
+                              SSS_MC_INITGROUPS, TEST_MC_ELEMS,
+                              TEST_MC_TIMEOUT, false, &nctx->initgr_mc_ctx);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->nctx = nctx;
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_nss_mc_group_teardown(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+
+    talloc_zfree(test_ctx);
+
+    unlink(TESTS_PATH "/passwd");
+    unlink(TESTS_PATH "/group");
+    unlink(TESTS_PATH "/initgroups");
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void store_user(struct nss_ctx *nctx, const char *name, uid_t uid)
+{
+    struct sized_string _name;
+    struct sized_string pw;
+    struct sized_string gecos;
+    struct sized_string homedir;
+    struct sized_string shell;
+    errno_t ret;
+
+    to_sized_string(&_name, name);
+    to_sized_string(&pw, "*");
+    to_sized_string(&gecos, name);
+    to_sized_string(&homedir, "/home/test");
+    to_sized_string(&shell, "/bin/sh");
+
+    ret = sss_mmap_cache_pw_store(&nctx->pwd_mc_ctx, &_name, &pw, uid, uid,
+                                  &gecos, &homedir, &shell);
+    assert_int_equal(ret, EOK);
+}
+
+static void store_group(struct nss_ctx *nctx, const char *name, gid_t gid)
+{
+    struct sized_string _name;
+    struct sized_string pw;
+    char membuf[1] = { '\0' };
+    errno_t ret;
+
+    to_sized_string(&_name, name);
+    to_sized_string(&pw, "*");
+
+    ret = sss_mmap_cache_gr_store(&nctx->grp_mc_ctx, &_name, &pw, gid,
+                                  0, membuf, 0);
+    assert_int_equal(ret, EOK);
+}
+
+/* Look the user up the way the client library does. */
+static errno_t client_getpwnam(const char *name)
+{
+    struct passwd pwd;
+    char buf[1024];
+
+    return sss_nss_mc_getpwnam(name, strlen(name), &pwd, buf, sizeof(buf));
+}
+
+static errno_t client_getgrgid(gid_t gid)
+{
+    struct group grp;
+    char buf[1024];
+
+    return sss_nss_mc_getgrgid(gid, &grp, buf, sizeof(buf));
+}
+
+static uint32_t read_generation(const char *name)
+{
+    struct sss_mc_header h;
+    char *path;
+    ssize_t len;
+    int fd;
+
+    path = talloc_asprintf(NULL, "%s/%s", SSS_NSS_MCACHE_DIR, name);
+    assert_non_null(path);
+
+    fd = open(path, O_RDONLY);
+    assert_int_not_equal(fd, -1);
+    talloc_free(path);
+
+    len = pread(fd, &h, sizeof(h), 0);
+    assert_int_equal(len, sizeof(h));
+    close(fd);
+
+    return h.generation;
+}
+
+/* Change the generation in the header behind the back of the barriers,
+ * so that a snapshot of the file remains valid. */
+static void write_generation(const char *name, uint32_t generation)
+{
+    char *path;
+    ssize_t len;
+    int fd;
+
+    path = talloc_asprintf(NULL, "%s/%s", SSS_NSS_MCACHE_DIR, name);
+    assert_non_null(path);
+
+    fd = open(path, O_WRONLY);
+    assert_int_not_equal(fd, -1);
+    talloc_free(path);
+
+    len = pwrite(fd, &generation, sizeof(generation),
+                 offsetof(struct sss_mc_header, generation));
+    assert_int_equal(len, sizeof(generation));
+    close(fd);
+}
+
+/* Stop the passwd cache the way the responder does on shutdown and start
+ * it again with the file left behind. */
+static void restart_passwd_cache(struct nss_ctx *nctx)
+{
+    errno_t ret;
+
+    ret = sss_mmap_cache_save(nctx->pwd_mc_ctx);
+    assert_int_equal(ret, EOK);
+    talloc_zfree(nctx->pwd_mc_ctx);
+}
+
+static void start_passwd_cache(struct nss_ctx *nctx)
+{
+    errno_t ret;
+
+    ret = sss_mmap_cache_init(nctx, "passwd", geteuid(), getegid(),
+                              SSS_MC_PASSWD, TEST_MC_ELEMS, TEST_MC_TIMEOUT,
+                              true, &nctx->pwd_mc_ctx);
+    assert_int_equal(ret, EOK);
+}
+
+static void test_nss_mc_new_generation(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    uint32_t generation;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    store_user(nctx, "gen-user1", 10001);
+    store_group(nctx, "gen-group1", 20001);
+    assert_int_equal(client_getpwnam("gen-user1"), EOK);
+    assert_int_equal(client_getgrgid(20001), EOK);
+
+    generation = read_generation("passwd");
+
+    ret = nss_memorycache_new_generation(test_ctx, NULL, nctx,
+                                         true, false, false);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(read_generation("passwd"), generation + 1);
+
+    /* Records stored before the new generation are rejected... */
+    assert_int_equal(client_getpwnam("gen-user1"), EINVAL);
+
+    /* ...but only in the selected maps. */
+    assert_int_equal(client_getgrgid(20001), EOK);
+
+    /* Records stored after it are accepted. */
+    store_user(nctx, "gen-user2", 10002);
+    assert_int_equal(client_getpwnam("gen-user2"), EOK);
+
+    store_user(nctx, "gen-user1", 10001);
+    assert_int_equal(client_getpwnam("gen-user1"), EOK);
+}
+
+static void test_nss_mc_warm_start_generation(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    uint32_t generation;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    sss_mmap_cache_new_generation(nctx->pwd_mc_ctx);
+    store_user(nctx, "warm-user1", 10011);
+    generation = read_generation("passwd");
+    assert_int_not_equal(generation, 0);
+
+    restart_passwd_cache(nctx);
+    start_passwd_cache(nctx);
+
+    /* The file was reused with its generation and records. */
+    assert_int_equal(read_generation("passwd"), generation);
+    assert_int_equal(client_getpwnam("warm-user1"), EOK);
+
+    /* The next generation continues from the restored one, a restarted
+     * counter would make the old records valid again. */
+    sss_mmap_cache_new_generation(nctx->pwd_mc_ctx);
+    assert_int_equal(read_generation("passwd"), generation + 1);
+    assert_int_equal(client_getpwnam("warm-user1"), EINVAL);
+
+    store_user(nctx, "warm-user2", 10012);
+    assert_int_equal(client_getpwnam("warm-user2"), EOK);
+}
+
+static void test_nss_mc_new_generation_wrap(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    /* Move the counter to its last value. */
+    restart_passwd_cache(nctx);
+    write_generation("passwd", MC_INVALID_VAL32);
+    start_passwd_cache(nctx);
+    assert_int_equal(read_generation("passwd"), MC_INVALID_VAL32);
+
+    store_user(nctx, "wrap-user1", 10021);
+    assert_int_equal(client_getpwnam("wrap-user1"), EOK);
+
+    /* The counter cannot grow, the cache is reset instead. */
+    sss_mmap_cache_new_generation(nctx->pwd_mc_ctx);
+    assert_int_equal(read_generation("passwd"), 0);
+
+    /* The records are gone rather than just stale. */
+    assert_int_equal(client_getpwnam("wrap-user1"), ENOENT);
+    assert_int_equal(client_getpwnam("warm-user2"), ENOENT);
+
+    store_user(nctx, "wrap-user2", 10022);
+    assert_int_equal(client_getpwnam("wrap-user2"), EOK);
+}
+
+static const char *fqname(struct nss_mc_test_ctx *test_ctx, const char *name)
+{
+    const char *fq;
+
+    fq = sss_create_internal_fqname(test_ctx, name,
+                                    test_ctx->tctx->dom->name);
+    assert_non_null(fq);
+
+    return fq;
+}
+
+static void test_nss_mc_invalidate_objects_users(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    const char *users[3];
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    store_user(nctx, "inv-user1", 10031);
+    store_user(nctx, "inv-user2", 10032);
+    store_user(nctx, "inv-user3", 10033);
+    store_group(nctx, "inv-group1", 20031);
+
+    users[0] = fqname(test_ctx, "inv-user1");
+    users[1] = fqname(test_ctx, "inv-user2");
+    users[2] = NULL;
+
+    ret = nss_memorycache_invalidate_objects(test_ctx, NULL, nctx,
+                                             users, NULL, NULL);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(client_getpwnam("inv-user1"), ENOENT);
+    assert_int_equal(client_getpwnam("inv-user2"), ENOENT);
+    assert_int_equal(client_getpwnam("inv-user3"), EOK);
+    assert_int_equal(client_getgrgid(20031), EOK);
+}
+
+static void test_nss_mc_invalidate_objects_gids(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    uint32_t *gids;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    store_user(nctx, "inv-user4", 10034);
+    store_group(nctx, "inv-group2", 20032);
+    store_group(nctx, "inv-group3", 20033);
+    store_group(nctx, "inv-group4", 20034);
+
+    gids = talloc_array(test_ctx, uint32_t, 2);
+    assert_non_null(gids);
+    gids[0] = 20032;
+    gids[1] = 20033;
+
+    ret = nss_memorycache_invalidate_objects(test_ctx, NULL, nctx,
+                                             NULL, NULL, gids);
+    assert_int_equal(ret, EOK);
+    talloc_free(gids);
+
+    assert_int_equal(client_getgrgid(20032), ENOENT);
+    assert_int_equal(client_getgrgid(20033), ENOENT);
+    assert_int_equal(client_getgrgid(20034), EOK);
+    assert_int_equal(client_getpwnam("inv-user4"), EOK);
+}
+
+static void test_nss_mc_invalidate_objects_empty(void **state)
+{
+    struct nss_mc_test_ctx *test_ctx;
+    struct nss_ctx *nctx;
+    const char *users[] = { NULL };
+    const char *groups[] = { NULL };
+    uint32_t *gids;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct nss_mc_test_ctx);
+    nctx = test_ctx->nctx;
+
+    store_user(nctx, "inv-user5", 10035);
+    store_group(nctx, "inv-group5", 20035);
+
+    gids = talloc_zero_array(test_ctx, uint32_t, 0);
+
+    ret = nss_memorycache_invalidate_objects(test_ctx, NULL, nctx,
+                                             users, groups, gids);
+    assert_int_equal(ret, EOK);
+    talloc_free(gids);
+
+    ret = nss_memorycache_invalidate_objects(test_ctx, NULL, nctx,
+                                             NULL, NULL, NULL);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(client_getpwnam("inv-user5"), EOK);
+    assert_int_equal(client_getgrgid(20035), EOK);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    /* The tests depend on each other's memory cache state and must run in
+     * this order. */
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_nss_mc_new_generation),
+        cmocka_unit_test(test_nss_mc_warm_start_generation),
+        cmocka_unit_test(test_nss_mc_new_generation_wrap),
+        cmocka_unit_test(test_nss_mc_invalidate_objects_users),
+        cmocka_unit_test(test_nss_mc_invalidate_objects_gids),
+        cmocka_unit_test(test_nss_mc_invalidate_objects_empty),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    rv = cmocka_run_group_tests(tests, test_nss_mc_group_setup,
+                                test_nss_mc_group_teardown);
+
+    return rv;
+}
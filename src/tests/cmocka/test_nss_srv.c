@@ -750,6 +750,120 @@ void test_nss_getpwnam(void **state)
     assert_int_equal(ret, EOK);
 }
 
+/* Test that a repeated request is answered from the reply cache and that
+ * the reply is dropped once the user is stored again or removed.
+ */
+struct passwd reply_cache_usr_mod = {
+    .pw_name = discard_const("testuser"),
+    .pw_uid = 123,
+    .pw_gid = 456,
+    .pw_dir = discard_const("/home/testuser"),
+    .pw_gecos = discard_const("modified test user"),
+    .pw_shell = discard_const("/bin/sh"),
+    .pw_passwd = discard_const("*"),
+};
+
+static int test_nss_getpwnam_mod_check(uint32_t status,
+                                       uint8_t *body, size_t blen)
+{
+    struct passwd pwd;
+    errno_t ret;
+
+    assert_int_equal(status, EOK);
+
+    ret = parse_user_packet(body, blen, &pwd);
+    assert_int_equal(ret, EOK);
+
+    assert_users_equal(&pwd, &reply_cache_usr_mod);
+    return EOK;
+}
+
+void test_nss_getpwnam_reply_cache(void **state)
+{
+    errno_t ret;
+
+    ret = nss_reply_cache_init(nss_test_ctx->nctx, 10, 60,
+                               &nss_test_ctx->nctx->reply_cache);
+    assert_int_equal(ret, EOK);
+
+    /* Stored in the past so that storing it again changes lastUpdate */
+    ret = store_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                     &getpwnam_usr, NULL, time(NULL) - 5);
+    assert_int_equal(ret, EOK);
+
+    mock_input_user_or_group("testuser");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETPWNAM);
+    mock_fill_user();
+    /* The reply is copied into the reply cache */
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getpwnam_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    /* The user did not change, the reply is copied from the reply cache
+     * without filling it again */
+    nss_test_ctx->tctx->done = false;
+
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_WRAPPER);
+    will_return(__wrap_sss_packet_get_body, "testuser");
+    will_return(__wrap_sss_packet_get_body, 0);
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETPWNAM);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getpwnam_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    /* The backend stored a modified user, the cached reply is outdated */
+    ret = store_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                     &reply_cache_usr_mod, NULL, 0);
+    assert_int_equal(ret, EOK);
+
+    nss_test_ctx->tctx->done = false;
+
+    mock_input_user_or_group("testuser");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETPWNAM);
+    mock_fill_user();
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getpwnam_mod_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    /* The user was removed, the request goes to the cache again */
+    ret = delete_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                      &reply_cache_usr_mod);
+    assert_int_equal(ret, EOK);
+
+    nss_test_ctx->tctx->done = false;
+
+    mock_input_user_or_group("testuser");
+    mock_account_recv_simple();
+
+    set_cmd_cb(NULL);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, ENOENT);
+
+    talloc_zfree(nss_test_ctx->nctx->reply_cache);
+}
+
 /* Test that searching for a nonexistent user yields ENOENT.
  * Account callback will be called
  */
@@ -5640,6 +5754,8 @@ int main(int argc, const char *argv[])
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nss_getpwnam,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getpwnam_reply_cache,
+                                        nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwuid,
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwnam_neg,
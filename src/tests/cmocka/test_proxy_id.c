@@ -0,0 +1,425 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Proxy provider lookups in worker threads
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_be.h"
+
+/* Include the source file to reach the static functions. */
+#include "providers/proxy/proxy_id.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_proxy_id_conf.ldb"
+#define TEST_DOM_NAME "proxy_id_test"
+#define TEST_ID_PROVIDER "proxy"
+
+#define TEST_USER "user1"
+#define TEST_UID 1001
+
+struct test_proxy_id_ctx {
+    struct sss_test_ctx *tctx;
+    struct be_ctx *be_ctx;
+    struct proxy_id_ctx *id_ctx;
+
+    struct dp_reply_std reply;
+};
+
+/* ====================== NSS module =============================== */
+
+/* Shared with the worker threads, the main thread reads it only once the
+ * calls are finished. */
+static struct {
+    /* getpwnam_r() waits for a byte from this pipe if block is set. */
+    int pipe[2];
+    bool block;
+
+    unsigned int getpwnam_calls;
+    unsigned int getpwuid_calls;
+    bool in_worker;
+} test_nss;
+
+static enum nss_status test_fill_user(struct passwd *result,
+                                      char *buffer,
+                                      size_t buflen)
+{
+    int len;
+
+    len = snprintf(buffer, buflen, "%s%cx%c%c/home/%s%c/bin/sh",
+                   TEST_USER, '\0', '\0', '\0', TEST_USER, '\0');
+    if (len < 0 || (size_t) len >= buflen) {
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    result->pw_name = buffer;
+    result->pw_passwd = result->pw_name + strlen(result->pw_name) + 1;
+    result->pw_gecos = result->pw_passwd + strlen(result->pw_passwd) + 1;
+    result->pw_dir = result->pw_gecos + strlen(result->pw_gecos) + 1;
+    result->pw_shell = result->pw_dir + strlen(result->pw_dir) + 1;
+    result->pw_uid = TEST_UID;
+    result->pw_gid = TEST_UID;
+
+    return NSS_STATUS_SUCCESS;
+}
+
+static enum nss_status test_getpwnam_r(const char *name,
+                                       struct passwd *result,
+                                       char *buffer,
+                                       size_t buflen,
+                                       int *errnop)
+{
+    char c;
+
+    test_nss.getpwnam_calls++;
+    test_nss.in_worker = sss_thread_pool_in_worker();
+
+    if (test_nss.block) {
+        /* Returns 0 once the pipe is closed by the teardown. */
+        if (read(test_nss.pipe[0], &c, 1) == -1) {
+            *errnop = errno;
+            return NSS_STATUS_UNAVAIL;
+        }
+    }
+
+    if (strcmp(name, TEST_USER) != 0) {
+        return NSS_STATUS_NOTFOUND;
+    }
+
+    return test_fill_user(result, buffer, buflen);
+}
+
+static enum nss_status test_getpwuid_r(uid_t uid,
+                                       struct passwd *result,
+                                       char *buffer,
+                                       size_t buflen,
+                                       int *errnop)
+{
+    test_nss.getpwuid_calls++;
+    test_nss.in_worker = sss_thread_pool_in_worker();
+
+    if (uid != TEST_UID) {
+        return NSS_STATUS_NOTFOUND;
+    }
+
+    return test_fill_user(result, buffer, buflen);
+}
+
+static void test_nss_release(void)
+{
+    char c = 0;
+
+    assert_int_equal(write(test_nss.pipe[1], &c, 1), 1);
+}
+
+/* ====================== Setup =============================== */
+
+static int test_proxy_id_setup(void **state)
+{
+    struct test_proxy_id_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_proxy_id_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    assert_non_null(test_ctx->be_ctx);
+
+    test_ctx->id_ctx = talloc_zero(test_ctx, struct proxy_id_ctx);
+    assert_non_null(test_ctx->id_ctx);
+    test_ctx->id_ctx->be = test_ctx->be_ctx;
+    test_ctx->id_ctx->ops.getpwnam_r = test_getpwnam_r;
+    test_ctx->id_ctx->ops.getpwuid_r = test_getpwuid_r;
+
+    memset(&test_nss, 0, sizeof(test_nss));
+    assert_int_equal(pipe(test_nss.pipe), 0);
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_proxy_id_teardown(void **state)
+{
+    struct test_proxy_id_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_proxy_id_ctx);
+
+    assert_true(check_leaks_pop(test_ctx));
+
+    /* Unblock a call that is still running so the pool can be freed. */
+    close(test_nss.pipe[1]);
+    talloc_free(test_ctx);
+    close(test_nss.pipe[0]);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== Utilities =============================== */
+
+static void test_proxy_id_start_pool(struct test_proxy_id_ctx *test_ctx,
+                                     unsigned int num_threads,
+                                     int timeout)
+{
+    errno_t ret;
+
+    ret = sss_thread_pool_create(test_ctx->id_ctx, test_ctx->tctx->ev,
+                                 num_threads, &test_ctx->id_ctx->thread_pool);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->id_ctx->timeout = timeout;
+}
+
+static void test_proxy_id_stop_pool(struct test_proxy_id_ctx *test_ctx)
+{
+    struct sss_thread_pool *pool = test_ctx->id_ctx->thread_pool;
+
+    /* Jobs whose request is gone are freed once they finish. */
+    while (sss_thread_pool_busy(pool) > 0) {
+        assert_int_equal(tevent_loop_once(test_ctx->tctx->ev), 0);
+    }
+
+    talloc_zfree(test_ctx->id_ctx->thread_pool);
+}
+
+static void test_proxy_id_done(struct tevent_req *req)
+{
+    struct test_proxy_id_ctx *test_ctx;
+
+    test_ctx = tevent_req_callback_data(req, struct test_proxy_id_ctx);
+
+    test_ctx->tctx->error = proxy_account_info_handler_recv(test_ctx, req,
+                                                            &test_ctx->reply);
+    talloc_free(req);
+
+    test_ctx->tctx->done = true;
+}
+
+static struct tevent_req *
+test_proxy_id_send(struct test_proxy_id_ctx *test_ctx,
+                   const char *name)
+{
+    struct dp_req_params params = { 0 };
+    struct dp_id_data *data;
+    struct tevent_req *req;
+
+    data = talloc_zero(test_ctx, struct dp_id_data);
+    assert_non_null(data);
+
+    data->entry_type = BE_REQ_USER;
+    data->filter_type = BE_FILTER_NAME;
+    data->filter_value = sss_create_internal_fqname(data, name,
+                                                    TEST_DOM_NAME);
+    assert_non_null(data->filter_value);
+    data->domain = TEST_DOM_NAME;
+
+    params.ev = test_ctx->tctx->ev;
+    params.be_ctx = test_ctx->be_ctx;
+    params.domain = test_ctx->tctx->dom;
+
+    req = proxy_account_info_handler_send(test_ctx, test_ctx->id_ctx, data,
+                                          &params);
+    assert_non_null(req);
+
+    /* The request keeps its own copy of the name. */
+    talloc_steal(req, data);
+
+    return req;
+}
+
+static void test_proxy_id_run(struct test_proxy_id_ctx *test_ctx,
+                              struct tevent_req *req)
+{
+    errno_t ret;
+
+    test_ctx->tctx->done = false;
+    tevent_req_set_callback(req, test_proxy_id_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
+static void assert_user_cached(struct test_proxy_id_ctx *test_ctx,
+                               bool cached)
+{
+    struct ldb_result *res;
+    char *name;
+    errno_t ret;
+
+    name = sss_create_internal_fqname(test_ctx, TEST_USER, TEST_DOM_NAME);
+    assert_non_null(name);
+
+    ret = sysdb_getpwnam(test_ctx, test_ctx->tctx->dom, name, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, cached ? 1 : 0);
+
+    talloc_free(res);
+    talloc_free(name);
+}
+
+/* ====================== The tests =============================== */
+
+static void test_proxy_id_timeout(void **state)
+{
+    struct test_proxy_id_ctx *test_ctx;
+    struct tevent_req *req;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_proxy_id_ctx);
+    test_proxy_id_start_pool(test_ctx, 1, 1);
+
+    /* The module does not return before proxy_id_timeout elapses. */
+    test_nss.block = true;
+
+    req = test_proxy_id_send(test_ctx, TEST_USER);
+    test_proxy_id_run(test_ctx, req);
+
+    assert_int_equal(test_ctx->reply.dp_error, DP_ERR_FATAL);
+    assert_int_equal(test_ctx->reply.error, ETIMEDOUT);
+    assert_int_equal(test_nss.getpwnam_calls, 1);
+
+    /* The result of the call that was still running is thrown away. */
+    test_nss_release();
+    test_proxy_id_stop_pool(test_ctx);
+
+    assert_int_equal(test_nss.getpwuid_calls, 0);
+    assert_user_cached(test_ctx, false);
+}
+
+static void test_proxy_id_freed_before_start(void **state)
+{
+    struct test_proxy_id_ctx *test_ctx;
+    struct tevent_req *req1;
+    struct tevent_req *req2;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_proxy_id_ctx);
+    test_proxy_id_start_pool(test_ctx, 1, 0);
+
+    /* The only thread is busy with the first request so the job of
+     * the second one stays queued until it is freed. */
+    test_nss.block = true;
+
+    req1 = test_proxy_id_send(test_ctx, TEST_USER);
+    req2 = test_proxy_id_send(test_ctx, "user2");
+    talloc_free(req2);
+
+    test_nss_release();
+    test_proxy_id_run(test_ctx, req1);
+
+    assert_int_equal(test_ctx->reply.dp_error, DP_ERR_OK);
+    assert_int_equal(test_ctx->reply.error, EOK);
+    assert_true(test_nss.in_worker);
+
+    test_proxy_id_stop_pool(test_ctx);
+
+    /* Only the first request called the module. */
+    assert_int_equal(test_nss.getpwnam_calls, 1);
+    assert_int_equal(test_nss.getpwuid_calls, 1);
+    assert_user_cached(test_ctx, true);
+}
+
+static void test_proxy_id_no_threads(void **state)
+{
+    struct test_proxy_id_ctx *test_ctx;
+    struct tevent_req *req;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_proxy_id_ctx);
+
+    /* proxy_max_id_threads = 0 does not create any pool, the module is
+     * called in the main thread before the request is even sent. */
+    assert_null(test_ctx->id_ctx->thread_pool);
+
+    req = test_proxy_id_send(test_ctx, TEST_USER);
+    assert_int_equal(test_nss.getpwnam_calls, 1);
+    assert_false(test_nss.in_worker);
+
+    test_proxy_id_run(test_ctx, req);
+
+    assert_int_equal(test_ctx->reply.dp_error, DP_ERR_OK);
+    assert_int_equal(test_ctx->reply.error, EOK);
+    assert_int_equal(test_nss.getpwuid_calls, 1);
+    assert_false(test_nss.in_worker);
+    assert_user_cached(test_ctx, true);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int no_cleanup = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_proxy_id_timeout,
+                                        test_proxy_id_setup,
+                                        test_proxy_id_teardown),
+        cmocka_unit_test_setup_teardown(test_proxy_id_freed_before_start,
+                                        test_proxy_id_setup,
+                                        test_proxy_id_teardown),
+        cmocka_unit_test_setup_teardown(test_proxy_id_no_threads,
+                                        test_proxy_id_setup,
+                                        test_proxy_id_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    }
+
+    return rv;
+}
@@ -334,6 +334,101 @@ void test_resolv_fake_srv(void **state)
     assert_int_equal(ret, ERR_OK);
 }
 
+static void test_resolv_fake_srv_cached_done(struct tevent_req *req)
+{
+    errno_t ret;
+    int status;
+    uint32_t ttl;
+    struct ares_srv_reply *srv_replies = NULL;
+    struct resolv_fake_ctx *test_ctx =
+        tevent_req_callback_data(req, struct resolv_fake_ctx);
+
+    ret = resolv_getsrv_recv(test_ctx, req, &status, NULL,
+                             &srv_replies, &ttl);
+    talloc_zfree(req);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(status, ARES_SUCCESS);
+
+    assert_non_null(srv_replies);
+    assert_string_equal(srv_replies->host, "ldap.sssd.com");
+    assert_null(srv_replies->next);
+
+    /* The TTL is clamped to the maximum cache TTL */
+    assert_true(ttl <= 100);
+    talloc_free(srv_replies);
+
+    test_ev_done(test_ctx->ctx, EOK);
+}
+
+static void test_resolv_fake_srv_negative_done(struct tevent_req *req)
+{
+    errno_t ret;
+    int status;
+    struct resolv_fake_ctx *test_ctx =
+        tevent_req_callback_data(req, struct resolv_fake_ctx);
+
+    ret = resolv_getsrv_recv(test_ctx, req, &status, NULL, NULL, NULL);
+    talloc_zfree(req);
+    assert_int_not_equal(ret, EOK);
+    assert_int_equal(status, ARES_ENOTFOUND);
+
+    test_ev_done(test_ctx->ctx, EOK);
+}
+
+static void test_resolv_fake_srv_run(struct resolv_fake_ctx *test_ctx,
+                                     tevent_req_fn done_fn)
+{
+    struct tevent_req *req;
+    int ret;
+
+    test_ctx->ctx->done = false;
+
+    req = resolv_getsrv_send(test_ctx, test_ctx->ctx->ev,
+                             test_ctx->resolv, TEST_SRV_QUERY);
+    assert_non_null(req);
+    tevent_req_set_callback(req, done_fn, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+}
+
+void test_resolv_fake_srv_cached(void **state)
+{
+    errno_t ret;
+    struct resolv_fake_ctx *test_ctx =
+        talloc_get_type(*state, struct resolv_fake_ctx);
+
+    unsigned char *buf;
+    size_t buflen;
+
+    struct srv_rrdata rr;
+
+    rr.prio = 1;
+    rr.port = 389;
+    rr.weight = 100;
+    rr.ttl = 600;
+    rr.hostname = "ldap.sssd.com";
+
+    ret = resolv_cache_init(test_ctx->resolv, 5, 100, 30);
+    assert_int_equal(ret, EOK);
+
+    buf = create_srv_buffer(test_ctx, TEST_SRV_QUERY, &rr, 1, &buflen);
+    assert_non_null(buf);
+
+    /* Only the first lookup reaches c-ares, the second one must be answered
+     * from the cache. */
+    mock_ares_query(0, 0, buf, buflen);
+    test_resolv_fake_srv_run(test_ctx, test_resolv_fake_srv_cached_done);
+    test_resolv_fake_srv_run(test_ctx, test_resolv_fake_srv_cached_done);
+
+    /* After a flush the resolver asks again and remembers that the name
+     * does not exist. */
+    resolv_cache_flush(test_ctx->resolv);
+    mock_ares_query(ARES_ENOTFOUND, 0, NULL, 0);
+    test_resolv_fake_srv_run(test_ctx, test_resolv_fake_srv_negative_done);
+    test_resolv_fake_srv_run(test_ctx, test_resolv_fake_srv_negative_done);
+}
+
 void test_resolv_is_address(void **state)
 {
     bool ret;
@@ -372,6 +467,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_resolv_fake_srv,
                                         test_resolv_fake_setup,
                                         test_resolv_fake_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_fake_srv_cached,
+                                        test_resolv_fake_setup,
+                                        test_resolv_fake_teardown),
         cmocka_unit_test(test_resolv_is_address),
     };
 
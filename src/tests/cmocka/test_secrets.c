@@ -0,0 +1,559 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Local secrets database
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <ldb.h>
+
+#include "util/util.h"
+#include "util/secrets/secrets.h"
+#include "util/secrets/sec_pvt.h"
+#include "tests/cmocka/common_mock.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_DB_FULL_PATH  TESTS_PATH "/secrets.ldb"
+#define TEST_MKEY_FULL_PATH  TESTS_PATH "/.secrets.mkey"
+
+#define TEST_MAX_SECRETS 10
+#define TEST_MAX_UID_SECRETS 3
+
+struct test_ctx {
+    struct sss_sec_ctx *sctx;
+    struct sss_sec_hive_config hive;
+    struct sss_sec_hive_config *config_list[2];
+};
+
+/* ====================== Utilities =============================== */
+
+static errno_t secret_put(struct test_ctx *test_ctx, const char *path)
+{
+    struct sss_sec_req *req;
+    char *url;
+    errno_t ret;
+
+    url = talloc_asprintf(test_ctx, "/secrets/%s", path);
+    assert_non_null(url);
+
+    ret = sss_sec_new_req(test_ctx, test_ctx->sctx, url, geteuid(), &req);
+    talloc_free(url);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_sec_put(req, discard_const("value"), sizeof("value") - 1,
+                      SSS_SEC_PLAINTEXT, "simple");
+    talloc_free(req);
+
+    return ret;
+}
+
+static errno_t secret_delete(struct test_ctx *test_ctx, const char *path)
+{
+    struct sss_sec_req *req;
+    char *url;
+    errno_t ret;
+
+    url = talloc_asprintf(test_ctx, "/secrets/%s", path);
+    assert_non_null(url);
+
+    ret = sss_sec_new_req(test_ctx, test_ctx->sctx, url, geteuid(), &req);
+    talloc_free(url);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_sec_delete(req);
+    talloc_free(req);
+
+    return ret;
+}
+
+static void container_create(struct test_ctx *test_ctx, const char *path)
+{
+    struct sss_sec_req *req;
+    char *url;
+    errno_t ret;
+
+    url = talloc_asprintf(test_ctx, "/secrets/%s/", path);
+    assert_non_null(url);
+
+    ret = sss_sec_new_req(test_ctx, test_ctx->sctx, url, geteuid(), &req);
+    talloc_free(url);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_sec_create_container(req);
+    assert_int_equal(ret, EOK);
+    talloc_free(req);
+}
+
+/* Write a secret to the database behind the back of the counters. */
+static void external_put(struct test_ctx *test_ctx, uid_t uid, const char *name)
+{
+    struct ldb_message *msg;
+    int ret;
+
+    msg = ldb_msg_new(test_ctx);
+    assert_non_null(msg);
+
+    msg->dn = ldb_dn_new_fmt(msg, test_ctx->sctx->ldb,
+                             "cn=%s,cn=%"SPRIuid",cn=users,cn=secrets",
+                             name, uid);
+    assert_non_null(msg->dn);
+
+    ret = ldb_msg_add_string(msg, "type", "simple");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    ret = ldb_msg_add_string(msg, "enctype", "plaintext");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    ret = ldb_msg_add_string(msg, "secret", "value");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    ret = ldb_add(test_ctx->sctx->ldb, msg);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    talloc_free(msg);
+}
+
+static uint64_t db_seq(struct ldb_context *ldb)
+{
+    uint64_t seq;
+    int ret;
+
+    ret = ldb_sequence_number(ldb, LDB_SEQ_HIGHEST_SEQ, &seq);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    return seq;
+}
+
+static unsigned long uid_count(struct test_ctx *test_ctx, uid_t uid)
+{
+    struct sss_sec_counters *counters = &test_ctx->sctx->counters_secrets;
+    hash_key_t key;
+    hash_value_t value;
+    char *dn;
+    int hret;
+
+    dn = talloc_asprintf(test_ctx, "cn=%"SPRIuid",cn=users,cn=secrets", uid);
+    assert_non_null(dn);
+
+    key.type = HASH_KEY_STRING;
+    key.str = dn;
+
+    hret = hash_lookup(counters->uids, &key, &value);
+    talloc_free(dn);
+    if (hret == HASH_ERROR_KEY_NOT_FOUND) {
+        return 0;
+    }
+    assert_int_equal(hret, HASH_SUCCESS);
+
+    return value.ul;
+}
+
+static void assert_counters(struct test_ctx *test_ctx,
+                            unsigned long total,
+                            unsigned long per_uid)
+{
+    struct sss_sec_counters *counters = &test_ctx->sctx->counters_secrets;
+
+    assert_true(counters->valid);
+    assert_true(counters->seq == db_seq(test_ctx->sctx->ldb));
+    assert_int_equal(counters->total, total);
+    assert_int_equal(uid_count(test_ctx, geteuid()), per_uid);
+}
+
+static bool index_list_has(struct ldb_context *ldb,
+                           const char *attr,
+                           const char *value)
+{
+    static const char *attrs[] = { "@IDXATTR", "@IDXONE", NULL };
+    struct ldb_message_element *el;
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    bool found = false;
+    int ret;
+
+    dn = ldb_dn_new(ldb, ldb, "@INDEXLIST");
+    assert_non_null(dn);
+
+    ret = ldb_search(ldb, dn, &res, dn, LDB_SCOPE_BASE, attrs, NULL);
+    assert_int_equal(ret, LDB_SUCCESS);
+    assert_int_equal(res->count, 1);
+
+    el = ldb_msg_find_element(res->msgs[0], attr);
+    for (unsigned int i = 0; el != NULL && i < el->num_values; i++) {
+        if (strcmp((const char *) el->values[i].data, value) == 0) {
+            found = true;
+        }
+    }
+
+    talloc_free(dn);
+    return found;
+}
+
+/* ====================== Setup =============================== */
+
+static struct test_ctx *test_ctx_new(void)
+{
+    struct test_ctx *test_ctx;
+    int ret;
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->hive.hive_name = "secrets";
+    test_ctx->hive.quota.max_secrets = TEST_MAX_SECRETS;
+    test_ctx->hive.quota.max_uid_secrets = TEST_MAX_UID_SECRETS;
+    test_ctx->hive.quota.max_payload_size = DEFAULT_SEC_MAX_PAYLOAD_SIZE;
+    test_ctx->hive.quota.containers_nest_level =
+                                        DEFAULT_SEC_CONTAINERS_NEST_LEVEL;
+    test_ctx->config_list[0] = &test_ctx->hive;
+    test_ctx->config_list[1] = NULL;
+
+    ret = mkdir(TESTS_PATH, 0700);
+    assert_int_equal(ret, 0);
+
+    return test_ctx;
+}
+
+static int setup_secrets(void **state)
+{
+    struct test_ctx *test_ctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = test_ctx_new();
+
+    ret = sss_sec_init_with_path(test_ctx, test_ctx->config_list,
+                                 TEST_DB_FULL_PATH, TEST_MKEY_FULL_PATH,
+                                 &test_ctx->sctx);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int setup_secrets_nodb(void **state)
+{
+    assert_true(leak_check_setup());
+
+    *state = test_ctx_new();
+    return 0;
+}
+
+static int teardown_secrets(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+
+    talloc_free(test_ctx);
+
+    unlink(TEST_DB_FULL_PATH);
+    unlink(TEST_MKEY_FULL_PATH);
+    rmdir(TESTS_PATH);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+/* ====================== The tests =============================== */
+
+static void test_sec_counters_put_delete(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    /* The counters are computed on the first quota check. */
+    assert_false(test_ctx->sctx->counters_secrets.valid);
+
+    ret = secret_put(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 1, 1);
+
+    ret = secret_put(test_ctx, "b");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 2, 2);
+
+    /* Containers are not counted, secrets inside them are. */
+    container_create(test_ctx, "c");
+    assert_counters(test_ctx, 2, 2);
+
+    ret = secret_put(test_ctx, "c/d");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 3, 3);
+
+    ret = secret_delete(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 2, 2);
+
+    ret = secret_delete(test_ctx, "c/d");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 1, 1);
+
+    ret = secret_delete(test_ctx, "c");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 1, 1);
+
+    ret = secret_delete(test_ctx, "b");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 0, 0);
+}
+
+static void test_sec_counters_external_write(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    struct sss_sec_counters *counters = &test_ctx->sctx->counters_secrets;
+    errno_t ret;
+
+    ret = secret_put(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 1, 1);
+
+    /* Another writer moves the sequence number by more than our own write,
+     * so the counters are dropped after the delete... */
+    external_put(test_ctx, geteuid(), "ext");
+
+    ret = secret_delete(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    assert_false(counters->valid);
+
+    /* ...and recomputed on the next check, including the foreign secret. */
+    ret = secret_put(test_ctx, "b");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 2, 2);
+
+    /* A foreign write right before a check is noticed as well. */
+    external_put(test_ctx, geteuid(), "ext2");
+
+    ret = secret_put(test_ctx, "c");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 4, 4);
+}
+
+static void test_sec_uid_quota(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    /* Secrets of another UID count into the total but not into ours. */
+    external_put(test_ctx, geteuid() + 1, "other");
+
+    ret = secret_put(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    ret = secret_put(test_ctx, "b");
+    assert_int_equal(ret, EOK);
+    ret = secret_put(test_ctx, "c");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, TEST_MAX_UID_SECRETS + 1, TEST_MAX_UID_SECRETS);
+    assert_int_equal(uid_count(test_ctx, geteuid() + 1), 1);
+
+    ret = secret_put(test_ctx, "d");
+    assert_int_equal(ret, ERR_SEC_INVALID_TOO_MANY_SECRETS);
+    assert_counters(test_ctx, TEST_MAX_UID_SECRETS + 1, TEST_MAX_UID_SECRETS);
+
+    /* Deleting a secret makes room for a new one. */
+    ret = secret_delete(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+
+    ret = secret_put(test_ctx, "d");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, TEST_MAX_UID_SECRETS + 1, TEST_MAX_UID_SECRETS);
+}
+
+static void test_sec_delete_enoent(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    uint64_t seq;
+    errno_t ret;
+
+    ret = secret_put(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    seq = db_seq(test_ctx->sctx->ldb);
+
+    /* A missing entry is reported as ENOENT and does not touch the
+     * database or the counters. */
+    ret = secret_delete(test_ctx, "missing");
+    assert_int_equal(ret, ENOENT);
+    ret = secret_delete(test_ctx, "missing/child");
+    assert_int_equal(ret, ENOENT);
+    assert_true(db_seq(test_ctx->sctx->ldb) == seq);
+    assert_counters(test_ctx, 1, 1);
+
+    /* Deleting the same entry twice. */
+    ret = secret_delete(test_ctx, "a");
+    assert_int_equal(ret, EOK);
+    ret = secret_delete(test_ctx, "a");
+    assert_int_equal(ret, ENOENT);
+    assert_counters(test_ctx, 0, 0);
+
+    /* Containers must be empty. */
+    container_create(test_ctx, "c");
+    ret = secret_put(test_ctx, "c/d");
+    assert_int_equal(ret, EOK);
+
+    ret = secret_delete(test_ctx, "c");
+    assert_int_equal(ret, EEXIST);
+    assert_counters(test_ctx, 1, 1);
+}
+
+static void test_sec_indexes_existing_db(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    struct ldb_context *ldb;
+    struct ldb_message *msg;
+    struct sss_sec_req *req;
+    uint8_t *secret;
+    size_t secret_len;
+    char *datatype;
+    uint64_t seq;
+    int ret;
+
+    /* Create a database the way older versions did, with an unrelated
+     * index and a stored secret. */
+    ldb = ldb_init(test_ctx, NULL);
+    assert_non_null(ldb);
+    ret = ldb_connect(ldb, TEST_DB_FULL_PATH, 0, NULL);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    msg = ldb_msg_new(ldb);
+    assert_non_null(msg);
+    msg->dn = ldb_dn_new(msg, ldb, "@INDEXLIST");
+    assert_non_null(msg->dn);
+    ret = ldb_msg_add_string(msg, "@IDXATTR", "cn");
+    assert_int_equal(ret, LDB_SUCCESS);
+    ret = ldb_add(ldb, msg);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    msg = ldb_msg_new(ldb);
+    assert_non_null(msg);
+    msg->dn = ldb_dn_new_fmt(msg, ldb,
+                             "cn=old,cn=%"SPRIuid",cn=users,cn=secrets",
+                             geteuid());
+    assert_non_null(msg->dn);
+    ret = ldb_msg_add_string(msg, "type", "simple");
+    assert_int_equal(ret, LDB_SUCCESS);
+    ret = ldb_msg_add_string(msg, "enctype", "plaintext");
+    assert_int_equal(ret, LDB_SUCCESS);
+    ret = ldb_msg_add_string(msg, "secret", "old");
+    assert_int_equal(ret, LDB_SUCCESS);
+    ret = ldb_add(ldb, msg);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    talloc_free(ldb);
+
+    /* The indexes are added and the existing ones are kept. */
+    ret = sss_sec_init_with_path(test_ctx, test_ctx->config_list,
+                                 TEST_DB_FULL_PATH, TEST_MKEY_FULL_PATH,
+                                 &test_ctx->sctx);
+    assert_int_equal(ret, EOK);
+
+    assert_true(index_list_has(test_ctx->sctx->ldb, "@IDXATTR", "type"));
+    assert_true(index_list_has(test_ctx->sctx->ldb, "@IDXATTR", "cn"));
+    assert_true(index_list_has(test_ctx->sctx->ldb, "@IDXONE", "1"));
+
+    /* The old secret is found through the index. */
+    ret = sss_sec_new_req(test_ctx, test_ctx->sctx, "/secrets/old",
+                          geteuid(), &req);
+    assert_int_equal(ret, EOK);
+    ret = sss_sec_get(test_ctx, req, &secret, &secret_len, &datatype);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(secret_len, sizeof("old") - 1);
+    assert_memory_equal(secret, "old", secret_len);
+    assert_string_equal(datatype, "simple");
+    talloc_free(secret);
+    talloc_free(datatype);
+    talloc_free(req);
+
+    ret = secret_put(test_ctx, "new");
+    assert_int_equal(ret, EOK);
+    assert_counters(test_ctx, 2, 2);
+
+    /* Opening the database again does not modify it. */
+    seq = db_seq(test_ctx->sctx->ldb);
+    talloc_zfree(test_ctx->sctx);
+
+    ret = sss_sec_init_with_path(test_ctx, test_ctx->config_list,
+                                 TEST_DB_FULL_PATH, TEST_MKEY_FULL_PATH,
+                                 &test_ctx->sctx);
+    assert_int_equal(ret, EOK);
+    assert_true(db_seq(test_ctx->sctx->ldb) == seq);
+
+    talloc_zfree(test_ctx->sctx);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sec_counters_put_delete,
+                                        setup_secrets,
+                                        teardown_secrets),
+        cmocka_unit_test_setup_teardown(test_sec_counters_external_write,
+                                        setup_secrets,
+                                        teardown_secrets),
+        cmocka_unit_test_setup_teardown(test_sec_uid_quota,
+                                        setup_secrets,
+                                        teardown_secrets),
+        cmocka_unit_test_setup_teardown(test_sec_delete_enoent,
+                                        setup_secrets,
+                                        teardown_secrets),
+        cmocka_unit_test_setup_teardown(test_sec_indexes_existing_db,
+                                        setup_secrets_nodb,
+                                        teardown_secrets),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    unlink(TEST_DB_FULL_PATH);
+    unlink(TEST_MKEY_FULL_PATH);
+    rmdir(TESTS_PATH);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -21,6 +21,7 @@
 */
 
 #include <popt.h>
+#include <fcntl.h>
 
 #include "tests/cmocka/common_mock.h"
 #include "tests/cmocka/common_mock_resp.h"
@@ -28,6 +29,7 @@
 #include "responder/common/negcache.h"
 #include "responder/ssh/ssh_private.h"
 #include "confdb/confdb.h"
+#include "db/sysdb_ssh.h"
 
 #include "util/crypto/sss_crypto.h"
 
@@ -53,6 +55,10 @@
 #define TEST_SUBDOM_NAME "test.subdomain"
 #define TEST_ID_PROVIDER "ldap"
 
+#define TEST_KNOWN_HOSTS_FILE TESTS_PATH "/known_hosts"
+#define TEST_KNOWN_HOSTS_TIMEOUT 600
+#define TEST_HOST_CACHE_TIMEOUT 300
+
 #define TEST_SSH_PUBKEY \
 "AAAAB3NzaC1yc2EAAAADAQABAAABAQC1" \
 "OlYGkYw8JyhKQrlNBGbZC2az9TJhUWNn" \
@@ -67,6 +73,8 @@
 "UE1U9Rxi6xvPt7s3h9NbZiaLRPJU6due" \
 "+nqwn8En7mesd7LnRQST"
 
+#define TEST_KNOWN_HOST_KEY "ssh-rsa " TEST_SSH_PUBKEY
+
 struct ssh_test_ctx {
     struct sss_test_ctx *tctx;
     struct sss_domain_info *subdom;
@@ -86,6 +94,9 @@ struct ssh_test_ctx {
 /* Must be global because it is needed in some wrappers */
 struct ssh_test_ctx *ssh_test_ctx;
 
+/* The in-memory copy of the known hosts file is private to the module. */
+#include "responder/ssh/ssh_known_hosts.c"
+
 struct ssh_ctx *mock_ssh_ctx(TALLOC_CTX *mem_ctx)
 {
     struct ssh_ctx *ssh_ctx;
@@ -1056,6 +1067,193 @@ void test_ssh_user_pubkey_cert_with_rule_1(void **state)
     assert_int_equal(ret, EOK);
 }
 
+static void store_ssh_host(const char *name, const char *alias, time_t now)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(ssh_test_ctx);
+    assert_non_null(attrs);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SSH_PUBKEY, TEST_SSH_PUBKEY);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_ssh_host(ssh_test_ctx->tctx->dom, name, alias,
+                               TEST_HOST_CACHE_TIMEOUT, now, attrs);
+    talloc_free(attrs);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_update_ssh_known_host_expire(ssh_test_ctx->tctx->dom, name,
+                                             now, TEST_KNOWN_HOSTS_TIMEOUT);
+    assert_int_equal(ret, EOK);
+}
+
+static void delete_ssh_host(const char *name)
+{
+    errno_t ret;
+
+    ret = sysdb_delete_ssh_host(ssh_test_ctx->tctx->dom, name);
+    assert_int_equal(ret, EOK);
+}
+
+static struct ssh_known_hosts *known_hosts_load(time_t now)
+{
+    struct ssh_known_hosts *kh;
+    errno_t ret;
+
+    ssh_test_ctx->ssh_ctx->known_hosts_timeout = TEST_KNOWN_HOSTS_TIMEOUT;
+    ssh_test_ctx->ssh_ctx->hash_known_hosts = false;
+
+    kh = talloc_zero(ssh_test_ctx->ssh_ctx, struct ssh_known_hosts);
+    assert_non_null(kh);
+    ssh_test_ctx->ssh_ctx->known_hosts = kh;
+
+    ret = ssh_known_hosts_load(ssh_test_ctx->ssh_ctx, kh, now);
+    assert_int_equal(ret, EOK);
+
+    return kh;
+}
+
+static void known_hosts_refresh(struct ssh_known_hosts *kh,
+                                const char *name,
+                                time_t now)
+{
+    errno_t ret;
+
+    ret = ssh_known_hosts_refresh(ssh_test_ctx->ssh_ctx, kh,
+                                  ssh_test_ctx->tctx->dom, name, now);
+    assert_int_equal(ret, EOK);
+}
+
+/* Writes the known hosts file the way ssh_known_hosts_flush() does and
+ * checks its content. */
+static void assert_known_hosts_file(struct ssh_known_hosts *kh,
+                                    const char *expected)
+{
+    char buf[4096];
+    ssize_t len;
+    errno_t ret;
+    int fd;
+
+    fd = open(TEST_KNOWN_HOSTS_FILE, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    assert_true(fd != -1);
+
+    ret = ssh_write_known_hosts(kh, fd);
+    assert_int_equal(ret, EOK);
+
+    len = pread(fd, buf, sizeof(buf) - 1, 0);
+    close(fd);
+    unlink(TEST_KNOWN_HOSTS_FILE);
+    assert_true(len >= 0);
+    buf[len] = '\0';
+
+    assert_string_equal(buf, expected);
+}
+
+void test_ssh_known_hosts_load(void **state)
+{
+    struct ssh_known_hosts *kh;
+    time_t now = time(NULL);
+
+    store_ssh_host("host2", NULL, now);
+    store_ssh_host("host1", NULL, now);
+
+    kh = known_hosts_load(now);
+    assert_int_equal(hash_count(kh->hosts), 2);
+    assert_true(kh->dirty);
+
+    /* The entries are written sorted by name. */
+    assert_known_hosts_file(kh, "host1 " TEST_KNOWN_HOST_KEY "\n"
+                                "host2 " TEST_KNOWN_HOST_KEY "\n");
+
+    /* Reloading the same hosts does not require a rewrite... */
+    kh->dirty = false;
+    assert_int_equal(ssh_known_hosts_load(ssh_test_ctx->ssh_ctx, kh, now),
+                     EOK);
+    assert_int_equal(hash_count(kh->hosts), 2);
+    assert_false(kh->dirty);
+
+    /* ...a host that is gone from the cache does. */
+    delete_ssh_host("host2");
+    assert_int_equal(ssh_known_hosts_load(ssh_test_ctx->ssh_ctx, kh, now),
+                     EOK);
+    assert_int_equal(hash_count(kh->hosts), 1);
+    assert_true(kh->dirty);
+    assert_known_hosts_file(kh, "host1 " TEST_KNOWN_HOST_KEY "\n");
+
+    delete_ssh_host("host1");
+}
+
+void test_ssh_known_hosts_refresh(void **state)
+{
+    struct ssh_known_hosts *kh;
+    time_t now = time(NULL);
+
+    store_ssh_host("host2", NULL, now);
+    kh = known_hosts_load(now);
+    assert_int_equal(hash_count(kh->hosts), 1);
+
+    /* Refreshing an unchanged host does not require a rewrite. */
+    kh->dirty = false;
+    known_hosts_refresh(kh, "host2", now);
+    assert_int_equal(hash_count(kh->hosts), 1);
+    assert_false(kh->dirty);
+
+    /* A new host is added to the file. */
+    store_ssh_host("host1", NULL, now);
+    known_hosts_refresh(kh, "host1", now);
+    assert_int_equal(hash_count(kh->hosts), 2);
+    assert_true(kh->dirty);
+    assert_known_hosts_file(kh, "host1 " TEST_KNOWN_HOST_KEY "\n"
+                                "host2 " TEST_KNOWN_HOST_KEY "\n");
+
+    /* A modified host replaces its old entry. */
+    kh->dirty = false;
+    store_ssh_host("host2", "alias2", now);
+    known_hosts_refresh(kh, "host2", now);
+    assert_int_equal(hash_count(kh->hosts), 2);
+    assert_true(kh->dirty);
+    assert_known_hosts_file(kh, "host1 " TEST_KNOWN_HOST_KEY "\n"
+                                "host2,alias2 " TEST_KNOWN_HOST_KEY "\n");
+
+    delete_ssh_host("host1");
+    delete_ssh_host("host2");
+}
+
+void test_ssh_known_hosts_remove(void **state)
+{
+    struct ssh_known_hosts *kh;
+    time_t now = time(NULL);
+    errno_t ret;
+
+    store_ssh_host("host1", NULL, now);
+    store_ssh_host("host2", NULL, now);
+    kh = known_hosts_load(now);
+    assert_int_equal(hash_count(kh->hosts), 2);
+
+    /* A host removed from the cache is removed from the file. */
+    kh->dirty = false;
+    delete_ssh_host("host2");
+    known_hosts_refresh(kh, "host2", now);
+    assert_int_equal(hash_count(kh->hosts), 1);
+    assert_true(kh->dirty);
+    assert_known_hosts_file(kh, "host1 " TEST_KNOWN_HOST_KEY "\n");
+
+    /* Expired hosts are dropped as well. */
+    kh->dirty = false;
+    ret = ssh_known_hosts_expire(kh, now + TEST_HOST_CACHE_TIMEOUT - 1);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hash_count(kh->hosts), 1);
+    assert_false(kh->dirty);
+
+    ret = ssh_known_hosts_expire(kh, now + TEST_HOST_CACHE_TIMEOUT);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hash_count(kh->hosts), 0);
+    assert_true(kh->dirty);
+    assert_known_hosts_file(kh, "");
+
+    delete_ssh_host("host1");
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -1075,6 +1273,12 @@ int main(int argc, const char *argv[])
                                         ssh_test_setup, ssh_test_teardown),
         cmocka_unit_test_setup_teardown(test_ssh_user_pubkey,
                                         ssh_test_setup, ssh_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ssh_known_hosts_load,
+                                        ssh_test_setup, ssh_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ssh_known_hosts_refresh,
+                                        ssh_test_setup, ssh_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ssh_known_hosts_remove,
+                                        ssh_test_setup, ssh_test_teardown),
 #ifdef HAVE_TEST_CA
         cmocka_unit_test_setup_teardown(test_ssh_user_pubkey_cert_disabled,
                                         ssh_test_setup, ssh_test_teardown),
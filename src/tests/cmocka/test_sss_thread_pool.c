@@ -0,0 +1,147 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_thread_pool.h"
+
+#define NUM_JOBS 16
+
+struct sum_job {
+    unsigned int n;
+    uint64_t sum;
+    bool in_worker;
+    char *str;
+};
+
+static errno_t sum_job_fn(void *pvt)
+{
+    struct sum_job *job = talloc_get_type(pvt, struct sum_job);
+    unsigned int i;
+
+    job->in_worker = sss_thread_pool_in_worker();
+
+    for (i = 1; i <= job->n; i++) {
+        job->sum += i;
+    }
+
+    /* Allocations under pvt are allowed. */
+    job->str = talloc_asprintf(job, "%"PRIu64, job->sum);
+    if (job->str == NULL) {
+        return ENOMEM;
+    }
+
+    return job->n % 2 == 0 ? EOK : ERANGE;
+}
+
+struct sum_test_ctx {
+    unsigned int done;
+    struct sum_job *jobs[NUM_JOBS];
+};
+
+static void sum_job_done(struct tevent_req *req)
+{
+    struct sum_test_ctx *ctx = tevent_req_callback_data(req,
+                                                        struct sum_test_ctx);
+    struct sum_job *job;
+    errno_t ret;
+
+    ret = sss_thread_pool_job_recv(ctx, req, (void **) &job);
+    talloc_free(req);
+
+    assert_non_null(job);
+    assert_int_equal(ret, job->n % 2 == 0 ? EOK : ERANGE);
+    assert_true(job->in_worker);
+    assert_int_equal(job->sum, (uint64_t) job->n * (job->n + 1) / 2);
+    assert_int_equal(strtoull(job->str, NULL, 10), job->sum);
+    assert_ptr_equal(talloc_parent(job), ctx);
+
+    ctx->jobs[ctx->done] = job;
+    ctx->done++;
+}
+
+void test_sss_thread_pool_jobs(void **state)
+{
+    struct tevent_context *ev;
+    struct sss_thread_pool *pool;
+    struct sum_test_ctx *ctx;
+    struct sum_job *job;
+    struct tevent_req *req;
+    unsigned int i;
+    errno_t ret;
+
+    ev = tevent_context_init(global_talloc_context);
+    assert_non_null(ev);
+
+    ctx = talloc_zero(global_talloc_context, struct sum_test_ctx);
+    assert_non_null(ctx);
+
+    ret = sss_thread_pool_create(ev, ev, 3, &pool);
+    assert_int_equal(ret, EOK);
+
+    assert_false(sss_thread_pool_in_worker());
+
+    for (i = 0; i < NUM_JOBS; i++) {
+        job = talloc_zero(ctx, struct sum_job);
+        assert_non_null(job);
+        job->n = 1000 * (i + 1);
+
+        req = sss_thread_pool_job_send(ctx, ev, pool, sum_job_fn, job);
+        assert_non_null(req);
+        tevent_req_set_callback(req, sum_job_done, ctx);
+    }
+
+    while (ctx->done < NUM_JOBS) {
+        assert_int_equal(tevent_loop_once(ev), 0);
+    }
+
+    assert_int_equal(sss_thread_pool_busy(pool), 0);
+
+    talloc_free(ctx);
+    talloc_free(ev);
+}
+
+void test_sss_thread_pool_cancel(void **state)
+{
+    struct tevent_context *ev;
+    struct sss_thread_pool *pool;
+    struct sum_job *job;
+    struct tevent_req *req;
+    unsigned int i;
+    errno_t ret;
+
+    ev = tevent_context_init(global_talloc_context);
+    assert_non_null(ev);
+
+    ret = sss_thread_pool_create(ev, ev, 1, &pool);
+    assert_int_equal(ret, EOK);
+
+    /* Requests freed while their job is queued or running must not leak
+     * nor finish. */
+    for (i = 0; i < NUM_JOBS; i++) {
+        job = talloc_zero(ev, struct sum_job);
+        assert_non_null(job);
+        job->n = 100000;
+
+        req = sss_thread_pool_job_send(ev, ev, pool, sum_job_fn, job);
+        assert_non_null(req);
+        talloc_free(req);
+    }
+
+    while (sss_thread_pool_busy(pool) > 0) {
+        assert_int_equal(tevent_loop_once(ev), 0);
+    }
+
+    talloc_free(ev);
+}
@@ -0,0 +1,427 @@
+/*
+    SSSD
+
+    Sudo responder: in-memory rules index tests
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "db/sysdb_sudo.h"
+#include "responder/sudo/sudosrv_private.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_sudo_index_conf.ldb"
+#define TEST_DOM_NAME "test_domain.test"
+
+#define TEST_SUDO_TIMEOUT 300
+
+struct sudo_index_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sudo_ctx *sudo_ctx;
+};
+
+/* Names of the rules and their sudoUser values, NULL terminated. */
+static const char *test_rules[][5] = {
+    { "r_all", "ALL", NULL },
+    { "r_user1", "user1", NULL },
+    { "r_user2", "user2", NULL },
+    { "r_uid", "#1001", NULL },
+    { "r_uid0", "#0", NULL },
+    { "r_group1", "%group1", NULL },
+    { "r_group2", "%group2", NULL },
+    { "r_ng", "+ng1", NULL },
+    { "r_ng_user1", "+ng1", "user1", NULL },
+    { "r_multi", "user2", "%group1", "+ng2" },
+};
+
+static int test_sudo_index_setup(void **state)
+{
+    struct sudo_index_test_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct sudo_index_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, "ipa", NULL);
+    assert_non_null(test_ctx->tctx);
+    test_ctx->tctx->dom->sudo_timeout = TEST_SUDO_TIMEOUT;
+
+    test_ctx->sudo_ctx = talloc_zero(test_ctx, struct sudo_ctx);
+    assert_non_null(test_ctx->sudo_ctx);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_sudo_index_teardown(void **state)
+{
+    struct sudo_index_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct sudo_index_test_ctx);
+
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void store_rule(struct sss_domain_info *domain,
+                       const char *name,
+                       const char *const *users)
+{
+    struct sysdb_attrs *rule;
+    errno_t ret;
+    size_t i;
+
+    rule = sysdb_new_attrs(NULL);
+    assert_non_null(rule);
+
+    ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_CN, name);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; users[i] != NULL; i++) {
+        ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_USER, users[i]);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_sudo_store(domain, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(rule);
+}
+
+static void store_test_rules(struct sss_domain_info *domain)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(test_rules) / sizeof(test_rules[0]); i++) {
+        store_rule(domain, test_rules[i][0], &test_rules[i][1]);
+    }
+}
+
+static void remove_rule(struct sss_domain_info *domain, const char *name)
+{
+    struct sysdb_attrs *rule;
+    errno_t ret;
+
+    rule = sysdb_new_attrs(NULL);
+    assert_non_null(rule);
+
+    ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_CN, name);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_purge(domain, NULL, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(rule);
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* Names of the rules matching @filter, sorted. */
+static char **search_rules(TALLOC_CTX *mem_ctx,
+                           struct sss_domain_info *domain,
+                           const char *filter,
+                           size_t *_count)
+{
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    struct ldb_message **msgs;
+    char **names;
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    ret = sysdb_search_sudo_rules(mem_ctx, domain, filter, attrs,
+                                  &count, &msgs);
+    if (ret == ENOENT) {
+        count = 0;
+        msgs = NULL;
+    } else {
+        assert_int_equal(ret, EOK);
+    }
+
+    names = talloc_zero_array(mem_ctx, char *, count + 1);
+    assert_non_null(names);
+
+    for (i = 0; i < count; i++) {
+        names[i] = talloc_strdup(names,
+                                 ldb_msg_find_attr_as_string(msgs[i],
+                                                             SYSDB_NAME,
+                                                             NULL));
+        assert_non_null(names[i]);
+    }
+    talloc_free(msgs);
+
+    qsort(names, count, sizeof(char *), compare_names);
+
+    *_count = count;
+    return names;
+}
+
+static void assert_names_equal(char **names,
+                               size_t count,
+                               char **expected,
+                               size_t expected_count)
+{
+    size_t i;
+
+    assert_int_equal(count, expected_count);
+
+    qsort(names, count, sizeof(char *), compare_names);
+    for (i = 0; i < count; i++) {
+        assert_string_equal(names[i], expected[i]);
+    }
+}
+
+/* Checks that the index selects the same rules as the sysdb filters, the
+ * expected numbers make sure the filters select what the test expects. */
+static void assert_index_lookup(struct sudo_index_test_ctx *test_ctx,
+                                const char *username,
+                                uid_t uid,
+                                const char **groupnames,
+                                size_t num_user_expected,
+                                size_t num_ng_expected)
+{
+    struct sss_domain_info *dom = test_ctx->tctx->dom;
+    TALLOC_CTX *tmp_ctx;
+    char **user_rules;
+    char **ng_rules;
+    size_t num_user_rules;
+    size_t num_ng_rules;
+    char **expected;
+    size_t num_expected;
+    char *filter;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = sudosrv_index_lookup(tmp_ctx, test_ctx->sudo_ctx, dom, username,
+                               uid, discard_const(groupnames),
+                               &user_rules, &num_user_rules,
+                               &ng_rules, &num_ng_rules);
+    assert_int_equal(ret, EOK);
+
+    filter = sysdb_sudo_filter_user(tmp_ctx, username,
+                                    discard_const(groupnames), uid);
+    assert_non_null(filter);
+    expected = search_rules(tmp_ctx, dom, filter, &num_expected);
+    assert_int_equal(num_expected, num_user_expected);
+    assert_names_equal(user_rules, num_user_rules, expected, num_expected);
+
+    filter = sysdb_sudo_filter_netgroups(tmp_ctx, username,
+                                         discard_const(groupnames), uid);
+    assert_non_null(filter);
+    expected = search_rules(tmp_ctx, dom, filter, &num_expected);
+    assert_int_equal(num_expected, num_ng_expected);
+    assert_names_equal(ng_rules, num_ng_rules, expected, num_expected);
+
+    talloc_free(tmp_ctx);
+}
+
+static void assert_index_expired(struct sudo_index_test_ctx *test_ctx,
+                                 const char *username,
+                                 uid_t uid,
+                                 const char **groupnames,
+                                 size_t num_expected_rules)
+{
+    struct sss_domain_info *dom = test_ctx->tctx->dom;
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs **rules;
+    uint32_t num_rules;
+    const char *name;
+    char **names;
+    char **expected;
+    size_t num_expected;
+    char *filter;
+    uint32_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = sudosrv_index_expired(tmp_ctx, test_ctx->sudo_ctx, dom, username,
+                                uid, discard_const(groupnames),
+                                &rules, &num_rules);
+    assert_int_equal(ret, EOK);
+
+    names = talloc_zero_array(tmp_ctx, char *, num_rules + 1);
+    assert_non_null(names);
+    for (i = 0; i < num_rules; i++) {
+        ret = sysdb_attrs_get_string(rules[i], SYSDB_NAME, &name);
+        assert_int_equal(ret, EOK);
+        names[i] = discard_const(name);
+    }
+
+    filter = sysdb_sudo_filter_expired(tmp_ctx, username,
+                                       discard_const(groupnames), uid);
+    assert_non_null(filter);
+    expected = search_rules(tmp_ctx, dom, filter, &num_expected);
+    assert_int_equal(num_expected, num_expected_rules);
+    assert_names_equal(names, num_rules, expected, num_expected);
+
+    talloc_free(tmp_ctx);
+}
+
+static void test_sudo_index_lookup(void **state)
+{
+    struct sudo_index_test_ctx *test_ctx;
+    const char *groups1[] = { "group1", NULL };
+    const char *groups21[] = { "group2", "group1", NULL };
+
+    test_ctx = talloc_get_type_abort(*state, struct sudo_index_test_ctx);
+
+    store_test_rules(test_ctx->tctx->dom);
+
+    /* r_all, r_user1, r_uid, r_group1, r_ng_user1, r_multi; r_ng */
+    assert_index_lookup(test_ctx, "user1", 1001, groups1, 6, 1);
+
+    /* uid 0 does not select #0: r_all, r_user2, r_multi; r_ng, r_ng_user1 */
+    assert_index_lookup(test_ctx, "user2", 0, NULL, 3, 2);
+
+    /* r_all, r_group1, r_group2, r_multi; r_ng, r_ng_user1 */
+    assert_index_lookup(test_ctx, "user3", 1003, groups21, 4, 2);
+
+    /* Only ALL, all netgroup rules are left to sudo. */
+    assert_index_lookup(test_ctx, "user4", 1004, NULL, 1, 3);
+}
+
+static void test_sudo_index_update(void **state)
+{
+    struct sudo_index_test_ctx *test_ctx;
+    struct sss_domain_info *dom;
+    const char *groups1[] = { "group1", NULL };
+    const char *r_user2_users[] = { "user1", NULL };
+    const char *r_new_users[] = { "user4", "+ng3", NULL };
+
+    test_ctx = talloc_get_type_abort(*state, struct sudo_index_test_ctx);
+    dom = test_ctx->tctx->dom;
+
+    store_test_rules(dom);
+    assert_index_lookup(test_ctx, "user1", 1001, groups1, 6, 1);
+    assert_index_lookup(test_ctx, "user4", 1004, NULL, 1, 3);
+
+    /* A new rule is picked up. */
+    store_rule(dom, "r_new", r_new_users);
+    assert_index_lookup(test_ctx, "user4", 1004, NULL, 2, 3);
+    assert_index_lookup(test_ctx, "user1", 1001, groups1, 6, 2);
+
+    /* A removed rule is gone from all values it was indexed under. */
+    remove_rule(dom, "r_ng_user1");
+    assert_index_lookup(test_ctx, "user1", 1001, groups1, 5, 2);
+    assert_index_lookup(test_ctx, "user4", 1004, NULL, 2, 2);
+
+    /* A rule whose sudoUser changed moves to the new values. */
+    store_rule(dom, "r_user2", r_user2_users);
+    assert_index_lookup(test_ctx, "user1", 1001, groups1, 6, 2);
+    assert_index_lookup(test_ctx, "user2", 1002, NULL, 2, 2);
+}
+
+static void test_sudo_index_expired(void **state)
+{
+    struct sudo_index_test_ctx *test_ctx;
+    struct sss_domain_info *dom;
+    const char *groups1[] = { "group1", NULL };
+    const char *expired_users[] = { "user1", NULL };
+    const char *expired_ng_users[] = { "+ng3", NULL };
+
+    test_ctx = talloc_get_type_abort(*state, struct sudo_index_test_ctx);
+    dom = test_ctx->tctx->dom;
+
+    store_test_rules(dom);
+
+    /* Rules stored without a timeout are expired. */
+    dom->sudo_timeout = 0;
+    store_rule(dom, "r_user1", expired_users);
+    store_rule(dom, "r_expired_ng", expired_ng_users);
+    dom->sudo_timeout = TEST_SUDO_TIMEOUT;
+
+    /* r_user1; r_expired_ng */
+    assert_index_expired(test_ctx, "user1", 1001, groups1, 2);
+
+    /* r_expired_ng */
+    assert_index_expired(test_ctx, "user2", 1002, NULL, 1);
+
+    /* Refreshed rules are not expired anymore. */
+    store_rule(dom, "r_user1", expired_users);
+    store_rule(dom, "r_expired_ng", expired_ng_users);
+    assert_index_expired(test_ctx, "user1", 1001, groups1, 0);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sudo_index_lookup,
+                                        test_sudo_index_setup,
+                                        test_sudo_index_teardown),
+        cmocka_unit_test_setup_teardown(test_sudo_index_update,
+                                        test_sudo_index_setup,
+                                        test_sudo_index_teardown),
+        cmocka_unit_test_setup_teardown(test_sudo_index_expired,
+                                        test_sudo_index_setup,
+                                        test_sudo_index_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
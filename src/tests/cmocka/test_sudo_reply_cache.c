@@ -0,0 +1,245 @@
+/*
+    SSSD
+
+    Sudo responder: reply cache tests
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "db/sysdb_sudo.h"
+#include "responder/sudo/sudosrv_private.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_sudo_reply_cache_conf.ldb"
+#define TEST_DOM_NAME "test_domain.test"
+
+#define TEST_SUBDOM_NAME "sub.test"
+#define TEST_SUBDOM_REALM "SUB.TEST"
+#define TEST_SUBDOM_FLAT "SUB"
+#define TEST_SUBDOM_SID "S-1-5-21-1-2-3"
+
+#define TEST_CLI_UID 0
+#define TEST_UID 1001
+
+struct sudo_reply_cache_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sss_domain_info *subdom;
+    struct sudo_ctx *sudo_ctx;
+};
+
+static int test_sudo_reply_cache_setup(void **state)
+{
+    struct sudo_reply_cache_test_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct sudo_reply_cache_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, "ipa", NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->subdom = new_subdomain(test_ctx, test_ctx->tctx->dom,
+                                     TEST_SUBDOM_NAME, TEST_SUBDOM_REALM,
+                                     TEST_SUBDOM_FLAT, TEST_SUBDOM_SID,
+                                     MPG_DISABLED, false, NULL, NULL, 0,
+                                     test_ctx->tctx->confdb, true);
+    assert_non_null(test_ctx->subdom);
+
+    test_ctx->sudo_ctx = talloc_zero(test_ctx, struct sudo_ctx);
+    assert_non_null(test_ctx->sudo_ctx);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_sudo_reply_cache_teardown(void **state)
+{
+    struct sudo_reply_cache_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state,
+                                     struct sudo_reply_cache_test_ctx);
+
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void store_rule(struct sss_domain_info *domain)
+{
+    struct sysdb_attrs *rule;
+    errno_t ret;
+
+    rule = sysdb_new_attrs(NULL);
+    assert_non_null(rule);
+
+    ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_CN, "test_rule");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_USER, "ALL");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_store(domain, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(rule);
+}
+
+static void store_reply(struct sudo_reply_cache_test_ctx *test_ctx,
+                        struct sss_domain_info *domain,
+                        const char *username)
+{
+    uint8_t body[] = { 0, 1, 2, 3 };
+    char *version;
+    char *key;
+    errno_t ret;
+
+    ret = sudosrv_reply_cache_key(test_ctx, SSS_SUDO_USER, TEST_CLI_UID,
+                                  domain, username, TEST_UID, NULL,
+                                  &key, &version);
+    assert_int_equal(ret, EOK);
+
+    sudosrv_reply_store(test_ctx->sudo_ctx, key, version, body, sizeof(body));
+
+    talloc_free(key);
+    talloc_free(version);
+}
+
+static struct sudosrv_reply *
+lookup_reply(struct sudo_reply_cache_test_ctx *test_ctx,
+             struct sss_domain_info *domain,
+             const char *username)
+{
+    struct sudosrv_reply *reply;
+    char *version;
+    char *key;
+    errno_t ret;
+
+    ret = sudosrv_reply_cache_key(test_ctx, SSS_SUDO_USER, TEST_CLI_UID,
+                                  domain, username, TEST_UID, NULL,
+                                  &key, &version);
+    assert_int_equal(ret, EOK);
+
+    reply = sudosrv_reply_lookup(test_ctx->sudo_ctx, key, version);
+
+    talloc_free(key);
+    talloc_free(version);
+
+    return reply;
+}
+
+static void test_sudo_reply_cache_hit(void **state)
+{
+    struct sudo_reply_cache_test_ctx *test_ctx;
+    struct sudosrv_reply *reply;
+
+    test_ctx = talloc_get_type_abort(*state,
+                                     struct sudo_reply_cache_test_ctx);
+
+    store_rule(test_ctx->tctx->dom);
+    store_reply(test_ctx, test_ctx->tctx->dom, "user1@" TEST_DOM_NAME);
+
+    reply = lookup_reply(test_ctx, test_ctx->tctx->dom,
+                         "user1@" TEST_DOM_NAME);
+    assert_non_null(reply);
+    assert_int_equal(reply->len, 4);
+
+    /* Changed rules invalidate the reply. */
+    store_rule(test_ctx->tctx->dom);
+
+    reply = lookup_reply(test_ctx, test_ctx->tctx->dom,
+                         "user1@" TEST_DOM_NAME);
+    assert_null(reply);
+}
+
+static void test_sudo_reply_cache_subdomain(void **state)
+{
+    struct sudo_reply_cache_test_ctx *test_ctx;
+    struct sudosrv_reply *reply;
+
+    test_ctx = talloc_get_type_abort(*state,
+                                     struct sudo_reply_cache_test_ctx);
+
+    store_rule(test_ctx->tctx->dom);
+    store_reply(test_ctx, test_ctx->subdom, "user1@" TEST_SUBDOM_NAME);
+
+    reply = lookup_reply(test_ctx, test_ctx->subdom,
+                         "user1@" TEST_SUBDOM_NAME);
+    assert_non_null(reply);
+
+    /* Rules of subdomain users are stored in the parent domain. */
+    store_rule(test_ctx->tctx->dom);
+
+    reply = lookup_reply(test_ctx, test_ctx->subdom,
+                         "user1@" TEST_SUBDOM_NAME);
+    assert_null(reply);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sudo_reply_cache_hit,
+                                        test_sudo_reply_cache_setup,
+                                        test_sudo_reply_cache_teardown),
+        cmocka_unit_test_setup_teardown(test_sudo_reply_cache_subdomain,
+                                        test_sudo_reply_cache_setup,
+                                        test_sudo_reply_cache_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
@@ -0,0 +1,359 @@
+/*
+    SSSD
+
+    sysdb_backend - Tests for the cache backend detection and conversion
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "db/sysdb_private.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_sysdb_backend_conf.ldb"
+#define TEST_DOM_NAME "test_sysdb_backend"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_NUM_USERS 50
+#define TEST_USER_UID_BASE 10000
+
+/* Too small to hold the test users, the conversion must fail on it. */
+#define TEST_TINY_MAP_SIZE (16 * 1024)
+
+struct sysdb_backend_test_ctx {
+    struct sss_test_ctx *tctx;
+    char *ldb_file;
+    char *ldb_ts_file;
+};
+
+static int test_sysdb_backend_setup(void **state)
+{
+    struct sysdb_backend_test_ctx *test_ctx;
+    const char *gecos;
+    char *name;
+    errno_t ret;
+    int i;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct sysdb_backend_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    /* The cache is created with the default TDB backend */
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->ldb_file = talloc_strdup(test_ctx,
+                                       test_ctx->tctx->sysdb->ldb_file);
+    assert_non_null(test_ctx->ldb_file);
+
+    test_ctx->ldb_ts_file = talloc_strdup(test_ctx,
+                                          test_ctx->tctx->sysdb->ldb_ts_file);
+    assert_non_null(test_ctx->ldb_ts_file);
+
+    gecos = talloc_asprintf(test_ctx, "%0512d", 0);
+    assert_non_null(gecos);
+
+    for (i = 0; i < TEST_NUM_USERS; i++) {
+        name = talloc_asprintf(test_ctx, "user%d@%s", i, TEST_DOM_NAME);
+        assert_non_null(name);
+
+        ret = sysdb_store_user(test_ctx->tctx->dom, name, NULL,
+                               TEST_USER_UID_BASE + i, TEST_USER_UID_BASE + i,
+                               gecos, "/home/user", "/bin/sh",
+                               NULL, NULL, NULL, 0, 0);
+        assert_int_equal(ret, EOK);
+        talloc_free(name);
+    }
+
+    *state = test_ctx;
+    return 0;
+}
+
+static void unlink_test_file(const char *ldb_file, const char *suffix)
+{
+    char *path;
+
+    path = talloc_asprintf(NULL, "%s%s", ldb_file, suffix);
+    assert_non_null(path);
+
+    unlink(path);
+    talloc_free(path);
+}
+
+static int test_sysdb_backend_teardown(void **state)
+{
+    struct sysdb_backend_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct sysdb_backend_test_ctx);
+
+    talloc_zfree(test_ctx->tctx);
+
+    unlink_test_file(test_ctx->ldb_file, ".bak");
+    unlink_test_file(test_ctx->ldb_file, ".bak1");
+    unlink_test_file(test_ctx->ldb_file, SYSDB_LMDB_LOCK_SUFFIX);
+    unlink_test_file(test_ctx->ldb_file, ".convert");
+    unlink_test_file(test_ctx->ldb_file, ".convert" SYSDB_LMDB_LOCK_SUFFIX);
+    unlink_test_file(test_ctx->ldb_file, ".lmdb");
+    unlink_test_file(test_ctx->ldb_file, ".lmdb" SYSDB_LMDB_LOCK_SUFFIX);
+    unlink_test_file(test_ctx->ldb_file, ".empty");
+    unlink_test_file(test_ctx->ldb_file, ".garbage");
+    unlink_test_file(test_ctx->ldb_ts_file, SYSDB_LMDB_LOCK_SUFFIX);
+
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static bool test_file_exists(const char *ldb_file, const char *suffix)
+{
+    char *path;
+    int ret;
+
+    path = talloc_asprintf(NULL, "%s%s", ldb_file, suffix);
+    assert_non_null(path);
+
+    ret = access(path, F_OK);
+    talloc_free(path);
+
+    return ret == 0;
+}
+
+static void write_test_file(const char *path, const char *data, size_t len)
+{
+    ssize_t written;
+    int fd;
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    assert_int_not_equal(fd, -1);
+
+    written = sss_atomic_write_s(fd, discard_const(data), len);
+    assert_int_equal(written, len);
+    close(fd);
+}
+
+static void assert_backend(const char *ldb_file,
+                           enum sss_cache_backend expected)
+{
+    enum sss_cache_backend backend;
+    errno_t ret;
+
+    ret = sysdb_get_db_backend(ldb_file, &backend);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(backend, expected);
+}
+
+static void assert_users(struct sss_domain_info *dom)
+{
+    struct ldb_result *res;
+    char *name;
+    errno_t ret;
+    int i;
+
+    for (i = 0; i < TEST_NUM_USERS; i++) {
+        name = talloc_asprintf(NULL, "user%d@%s", i, TEST_DOM_NAME);
+        assert_non_null(name);
+
+        ret = sysdb_getpwnam(name, dom, name, &res);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(res->count, 1);
+        assert_int_equal(ldb_msg_find_attr_as_uint(res->msgs[0],
+                                                   SYSDB_UIDNUM, 0),
+                         TEST_USER_UID_BASE + i);
+        talloc_free(name);
+    }
+}
+
+static void test_sysdb_get_db_backend(void **state)
+{
+    struct sysdb_backend_test_ctx *test_ctx;
+    enum sss_cache_backend backend;
+    struct ldb_context *ldb;
+    char *path;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct sysdb_backend_test_ctx);
+
+    assert_backend(test_ctx->ldb_file, SSS_CACHE_BACKEND_TDB);
+
+    path = talloc_asprintf(test_ctx, "%s.lmdb", test_ctx->ldb_file);
+    assert_non_null(path);
+
+    ret = sysdb_ldb_connect_ext(test_ctx, path, SSS_CACHE_BACKEND_LMDB,
+                                0, 0, &ldb);
+    assert_int_equal(ret, EOK);
+    talloc_free(ldb);
+
+    assert_backend(path, SSS_CACHE_BACKEND_LMDB);
+    talloc_free(path);
+
+    /* A cache that does not exist yet */
+    path = talloc_asprintf(test_ctx, "%s.missing", test_ctx->ldb_file);
+    assert_non_null(path);
+
+    ret = sysdb_get_db_backend(path, &backend);
+    assert_int_equal(ret, ENOENT);
+    talloc_free(path);
+
+    /* Files that are neither */
+    path = talloc_asprintf(test_ctx, "%s.empty", test_ctx->ldb_file);
+    assert_non_null(path);
+
+    write_test_file(path, "", 0);
+    ret = sysdb_get_db_backend(path, &backend);
+    assert_int_equal(ret, EINVAL);
+    talloc_free(path);
+
+    path = talloc_asprintf(test_ctx, "%s.garbage", test_ctx->ldb_file);
+    assert_non_null(path);
+
+    write_test_file(path, "this is not a database file", 27);
+    ret = sysdb_get_db_backend(path, &backend);
+    assert_int_equal(ret, EINVAL);
+    talloc_free(path);
+}
+
+static void test_sysdb_upgrade_backend(void **state)
+{
+    struct sysdb_backend_test_ctx *test_ctx;
+    struct sss_test_conf_param params[] = {
+        { CONFDB_DOMAIN_CACHE_BACKEND, CONFDB_DOMAIN_CACHE_BACKEND_LMDB },
+        { NULL, NULL },
+    };
+
+    test_ctx = talloc_get_type_abort(*state, struct sysdb_backend_test_ctx);
+
+    /* Opening the cache with the other backend configured converts it */
+    talloc_zfree(test_ctx->tctx);
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         params);
+    assert_non_null(test_ctx->tctx);
+    assert_int_equal(test_ctx->tctx->sysdb->backend, SSS_CACHE_BACKEND_LMDB);
+
+    assert_backend(test_ctx->ldb_file, SSS_CACHE_BACKEND_LMDB);
+    assert_users(test_ctx->tctx->dom);
+
+    /* The original cache is kept as a backup */
+    assert_true(test_file_exists(test_ctx->ldb_file, ".bak"));
+    assert_false(test_file_exists(test_ctx->ldb_file, ".convert"));
+    assert_false(test_file_exists(test_ctx->ldb_file,
+                                  ".convert" SYSDB_LMDB_LOCK_SUFFIX));
+
+    /* And back, the entries survive the round trip */
+    talloc_zfree(test_ctx->tctx);
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    assert_backend(test_ctx->ldb_file, SSS_CACHE_BACKEND_TDB);
+    assert_users(test_ctx->tctx->dom);
+    assert_true(test_file_exists(test_ctx->ldb_file, ".bak1"));
+}
+
+static void test_sysdb_upgrade_backend_fail(void **state)
+{
+    struct sysdb_backend_test_ctx *test_ctx;
+    struct sysdb_ctx *sysdb;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct sysdb_backend_test_ctx);
+    sysdb = test_ctx->tctx->sysdb;
+
+    sysdb->backend = SSS_CACHE_BACKEND_LMDB;
+    ret = sysdb_upgrade_backend(sysdb, test_ctx->ldb_file,
+                                SSS_CACHE_BACKEND_TDB, TEST_TINY_MAP_SIZE);
+    sysdb->backend = SSS_CACHE_BACKEND_TDB;
+    assert_int_not_equal(ret, EOK);
+
+    /* The original cache is untouched and nothing is left behind */
+    assert_backend(test_ctx->ldb_file, SSS_CACHE_BACKEND_TDB);
+    assert_false(test_file_exists(test_ctx->ldb_file, ".bak"));
+    assert_false(test_file_exists(test_ctx->ldb_file, ".convert"));
+    assert_false(test_file_exists(test_ctx->ldb_file,
+                                  ".convert" SYSDB_LMDB_LOCK_SUFFIX));
+
+    /* The entries are still there, also for a fresh connection */
+    assert_users(test_ctx->tctx->dom);
+
+    talloc_zfree(test_ctx->tctx);
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+    assert_users(test_ctx->tctx->dom);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sysdb_get_db_backend,
+                                        test_sysdb_backend_setup,
+                                        test_sysdb_backend_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_upgrade_backend,
+                                        test_sysdb_backend_setup,
+                                        test_sysdb_backend_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_upgrade_backend_fail,
+                                        test_sysdb_backend_setup,
+                                        test_sysdb_backend_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch (opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
@@ -498,6 +498,44 @@ void test_sudo_set_get_last_full_refresh(void **state)
     assert_int_equal(now, loaded_time);
 }
 
+void test_sudo_generation(void **state)
+{
+    errno_t ret;
+    struct sysdb_attrs *rule;
+    uint64_t generation;
+    uint64_t stored;
+    uint64_t purged;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    ret = sysdb_sudo_get_generation(test_ctx->tctx->dom, &generation);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(generation, 0);
+
+    rule = sysdb_new_attrs(test_ctx);
+    assert_non_null(rule);
+    create_rule_attrs(rule, 0);
+
+    ret = sysdb_sudo_store(test_ctx->tctx->dom, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_get_generation(test_ctx->tctx->dom, &stored);
+    assert_int_equal(ret, EOK);
+    assert_int_not_equal(stored, generation);
+
+    /* Purging all rules removes the rules container as well. */
+    ret = sysdb_sudo_purge(test_ctx->tctx->dom, "(objectClass=sudoRule)",
+                           NULL, 0);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_get_generation(test_ctx->tctx->dom, &purged);
+    assert_int_equal(ret, EOK);
+    assert_int_not_equal(purged, 0);
+    assert_int_not_equal(purged, stored);
+
+    talloc_zfree(rule);
+}
+
 void test_get_sudo_user_info(void **state)
 {
     errno_t ret;
@@ -989,6 +1027,11 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup,
                                         test_sysdb_teardown),
 
+        /* sysdb_sudo_get_generation() */
+        cmocka_unit_test_setup_teardown(test_sudo_generation,
+                                        test_sysdb_setup,
+                                        test_sysdb_teardown),
+
         /* sysdb_get_sudo_user_info() */
         cmocka_unit_test_setup_teardown(test_get_sudo_user_info,
                                         test_sysdb_setup,
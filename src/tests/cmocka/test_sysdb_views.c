@@ -515,6 +515,126 @@ void test_sysdb_invalidate_overrides(void **state)
     assert_int_equal(ret, EOK);
 }
 
+void test_sysdb_merged_overrides(void **state)
+{
+    int ret;
+    struct ldb_message *msg;
+    struct ldb_message_element *el;
+    struct ldb_result *res;
+    struct sysdb_attrs *attrs;
+    char *name;
+    const char *user_attrs[] = { SYSDB_OVERRIDE_DN,
+                                 SYSDB_MERGED_USER_OVERRIDE_ATTRS,
+                                 NULL};
+    const char override_dn_str[] = SYSDB_OVERRIDE_ANCHOR_UUID "=" \
+                       TEST_ANCHOR_PREFIX TEST_USER_SID "," TEST_VIEW_CONTAINER;
+
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    test_ctx->domain->mpg_mode = MPG_DISABLED;
+    test_ctx->domain->view_name = TEST_VIEW_NAME;
+    test_ctx->domain->cache_merged_overrides = true;
+    name = sss_create_internal_fqname(test_ctx, TEST_USER_NAME,
+                                      test_ctx->domain->name);
+    assert_non_null(name);
+
+    ret = sysdb_update_view_name(test_ctx->domain->sysdb, TEST_VIEW_NAME);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_user(test_ctx->domain, name, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_GECOS,
+                           TEST_USER_HOMEDIR, TEST_USER_SHELL, NULL, NULL, NULL,
+                           0,0);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    NULL, &msg);
+    assert_int_equal(ret, EOK);
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_OVERRIDE_ANCHOR_UUID,
+                                 TEST_ANCHOR_PREFIX TEST_USER_SID);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_attrs_add_uint32(attrs, SYSDB_UIDNUM, 1234);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_GECOS, "Override Gecos");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, msg->dn);
+    assert_int_equal(ret, EOK);
+
+    /* The override values are stored in the user object */
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    user_attrs, &msg);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(override_dn_str,
+                        ldb_msg_find_attr_as_string(msg,
+                                                    SYSDB_OVERRIDE_MERGED_DN,
+                                                    NULL));
+    assert_int_equal(ldb_msg_find_attr_as_uint64(msg,
+                                                 OVERRIDE_PREFIX SYSDB_UIDNUM,
+                                                 0), 1234);
+    assert_true(sysdb_has_merged_overrides(msg));
+
+    /* and are not added a second time */
+    ret = sysdb_getpwnam_with_views(test_ctx, test_ctx->domain, name, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    el = ldb_msg_find_element(res->msgs[0], OVERRIDE_PREFIX SYSDB_GECOS);
+    assert_non_null(el);
+    assert_int_equal(el->num_values, 1);
+    assert_string_equal((const char *) el->values[0].data, "Override Gecos");
+
+    /* A view change removes them */
+    ret = sysdb_invalidate_overrides(test_ctx->domain->sysdb);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    user_attrs, &msg);
+    assert_int_equal(ret, EOK);
+    assert_null(ldb_msg_find_element(msg, SYSDB_OVERRIDE_MERGED_DN));
+    assert_null(ldb_msg_find_element(msg, OVERRIDE_PREFIX SYSDB_UIDNUM));
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, msg->dn);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    user_attrs, &msg);
+    assert_int_equal(ret, EOK);
+    assert_true(sysdb_has_merged_overrides(msg));
+
+    /* And so does disabling the option */
+    test_ctx->domain->cache_merged_overrides = false;
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, msg->dn);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    user_attrs, &msg);
+    assert_int_equal(ret, EOK);
+    assert_null(ldb_msg_find_element(msg, SYSDB_OVERRIDE_MERGED_DN));
+    assert_null(ldb_msg_find_element(msg, OVERRIDE_PREFIX SYSDB_GECOS));
+
+    ret = sysdb_getpwnam_with_views(test_ctx, test_ctx->domain, name, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_string_equal(ldb_msg_find_attr_as_string(res->msgs[0],
+                                                    OVERRIDE_PREFIX SYSDB_GECOS,
+                                                    NULL),
+                        "Override Gecos");
+
+    ret = sysdb_delete_user(test_ctx->domain, name, 0);
+    assert_int_equal(ret, EOK);
+}
+
 static const char *users[] = { "alice", "bob", "barney", NULL };
 
 static void enum_test_user_override(struct sysdb_test_ctx *test_ctx,
@@ -715,6 +835,157 @@ static void test_sysdb_enumpwent_views(void **state)
     check_enumpwent(ret, test_ctx->domain, res, true);
 }
 
+static void test_sysdb_enumpwent_paged_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *res;
+    const char *last;
+
+    ret = sysdb_enumpwent_paged_with_views(test_ctx, test_ctx->domain,
+                                           NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "alice", true);
+    assert_user_attrs(res->msgs[1], test_ctx->domain, "barney", true);
+
+    last = ldb_msg_find_attr_as_string(res->msgs[1], SYSDB_NAME, NULL);
+    assert_non_null(last);
+
+    ret = sysdb_enumpwent_paged_with_views(test_ctx, test_ctx->domain,
+                                           last, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "bob", true);
+
+    last = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_NAME, NULL);
+    assert_non_null(last);
+
+    ret = sysdb_enumpwent_paged_with_views(test_ctx, test_ctx->domain,
+                                           last, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 0);
+}
+
+static void test_sysdb_enumpwent_names_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *names;
+    struct ldb_result *res;
+    char *fqname;
+
+    ret = sysdb_enumpwent_names(test_ctx, test_ctx->domain, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, N_ELEMENTS(users) - 1);
+
+    /* A user removed after the names were read is skipped. */
+    fqname = sss_create_internal_fqname(test_ctx, "barney",
+                                        test_ctx->domain->name);
+    assert_non_null(fqname);
+    ret = sysdb_delete_user(test_ctx->domain, fqname, 0);
+    assert_int_equal(ret, EOK);
+    talloc_free(fqname);
+
+    ret = sysdb_enumpwent_read_with_views(test_ctx, test_ctx->domain,
+                                          names->msgs, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "alice", true);
+
+    ret = sysdb_enumpwent_read_with_views(test_ctx, test_ctx->domain,
+                                          &names->msgs[2], 1, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "bob", true);
+}
+
+static void test_sysdb_get_user_attr_by_uid_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GECOS, NULL };
+    struct ldb_result *res;
+
+    /* alice is the first user added by test_enum_users_setup() */
+    ret = sysdb_get_user_attr_by_uid_with_views(test_ctx, test_ctx->domain,
+                                                1234, attrs, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_user_attrs(res->msgs[0], test_ctx->domain, "alice", true);
+
+    /* Only the requested attributes are read. */
+    assert_null(ldb_msg_find_element(res->msgs[0], SYSDB_HOMEDIR));
+    assert_null(ldb_msg_find_element(res->msgs[0], SYSDB_SHELL));
+
+    ret = sysdb_get_user_attr_by_uid_with_views(test_ctx, test_ctx->domain,
+                                                4321, attrs, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 0);
+}
+
+static void assert_enum_name(struct sss_domain_info *dom,
+                             struct ldb_message *msg,
+                             const char *shortname)
+{
+    const char *name;
+    char *fqname;
+
+    fqname = sss_create_internal_fqname(NULL, shortname, dom->name);
+    assert_non_null(fqname);
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    assert_non_null(name);
+    assert_string_equal(name, fqname);
+
+    talloc_free(fqname);
+}
+
+static void test_sysdb_enumpwent_filter_names(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *names;
+    const char *last;
+
+    ret = sysdb_enumpwent_filter_names(test_ctx, test_ctx->domain, "b*",
+                                       NULL, 1, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, 1);
+    assert_enum_name(test_ctx->domain, names->msgs[0], "barney");
+
+    last = ldb_msg_find_attr_as_string(names->msgs[0], SYSDB_NAME, NULL);
+    assert_non_null(last);
+
+    /* A full page even though it holds the last matching user. */
+    ret = sysdb_enumpwent_filter_names(test_ctx, test_ctx->domain, "b*",
+                                       last, 1, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, 1);
+    assert_enum_name(test_ctx->domain, names->msgs[0], "bob");
+
+    last = ldb_msg_find_attr_as_string(names->msgs[0], SYSDB_NAME, NULL);
+    assert_non_null(last);
+
+    ret = sysdb_enumpwent_filter_names(test_ctx, test_ctx->domain, "b*",
+                                       last, 1, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, 0);
+
+    /* A short page means that there are no more users. */
+    ret = sysdb_enumpwent_filter_names(test_ctx, test_ctx->domain, "*",
+                                       NULL, 10, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, N_ELEMENTS(users) - 1);
+    assert_enum_name(test_ctx->domain, names->msgs[0], "alice");
+    assert_enum_name(test_ctx->domain, names->msgs[1], "barney");
+    assert_enum_name(test_ctx->domain, names->msgs[2], "bob");
+}
+
 static void test_sysdb_enumpwent_filter(void **state)
 {
     int ret;
@@ -957,6 +1228,56 @@ static void test_sysdb_enumgrent_views(void **state)
     check_enumgrent(ret, test_ctx->domain, res, true);
 }
 
+static void test_sysdb_enumgrent_paged_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *res;
+    const char *last;
+
+    ret = sysdb_enumgrent_paged_with_views(test_ctx, test_ctx->domain,
+                                           NULL, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_group_attrs(res->msgs[0], test_ctx->domain, "one",
+                       TEST_GID_OVERRIDE_BASE);
+    assert_group_attrs(res->msgs[1], test_ctx->domain, "three",
+                       TEST_GID_OVERRIDE_BASE + 2);
+
+    last = ldb_msg_find_attr_as_string(res->msgs[1], SYSDB_NAME, NULL);
+    assert_non_null(last);
+
+    ret = sysdb_enumgrent_paged_with_views(test_ctx, test_ctx->domain,
+                                           last, 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_group_attrs(res->msgs[0], test_ctx->domain, "two",
+                       TEST_GID_OVERRIDE_BASE + 1);
+}
+
+static void test_sysdb_enumgrent_names_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *names;
+    struct ldb_result *res;
+
+    ret = sysdb_enumgrent_names(test_ctx, test_ctx->domain, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, 3);
+
+    ret = sysdb_enumgrent_read_with_views(test_ctx, test_ctx->domain,
+                                          &names->msgs[1], 2, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+    assert_group_attrs(res->msgs[0], test_ctx->domain, "three",
+                       TEST_GID_OVERRIDE_BASE + 2);
+    assert_group_attrs(res->msgs[1], test_ctx->domain, "two",
+                       TEST_GID_OVERRIDE_BASE + 1);
+}
+
 static void test_sysdb_enumgrent_filter(void **state)
 {
     int ret;
@@ -1046,6 +1367,99 @@ static void test_sysdb_enumgrent_filter_views(void **state)
     check_enumgrent(ret, test_ctx->domain, res, true);
 }
 
+#define TEST_INITGR_NUM_GROUPS 40
+
+static void test_sysdb_initgroups_gids_views(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *res;
+    const char *name;
+    char *user_name;
+    char *gr_name;
+    unsigned int gid;
+    unsigned int num;
+    bool seen[TEST_INITGR_NUM_GROUPS] = { false };
+    size_t c;
+
+    test_ctx->domain->mpg_mode = MPG_DISABLED;
+    test_ctx->domain->view_name = TEST_VIEW_NAME;
+
+    ret = sysdb_update_view_name(test_ctx->domain->sysdb, TEST_VIEW_NAME);
+    assert_int_equal(ret, EOK);
+
+    user_name = sss_create_internal_fqname(test_ctx, TEST_USER_NAME,
+                                           test_ctx->domain->name);
+    assert_non_null(user_name);
+
+    ret = sysdb_store_user(test_ctx->domain, user_name, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_GECOS,
+                           TEST_USER_HOMEDIR, TEST_USER_SHELL, NULL, NULL, NULL,
+                           10, 0);
+    assert_int_equal(ret, EOK);
+
+    /* Enough overridden groups to read all overrides of the view at once */
+    for (c = 0; c < TEST_INITGR_NUM_GROUPS; c++) {
+        gr_name = talloc_asprintf(test_ctx, "initgr_group%zu@%s",
+                                  c, test_ctx->domain->name);
+        assert_non_null(gr_name);
+
+        ret = sysdb_store_group(test_ctx->domain, gr_name, 2000 + c,
+                                NULL, 10, 0);
+        assert_int_equal(ret, EOK);
+
+        enum_test_group_override(test_ctx, gr_name,
+                                 TEST_GID_OVERRIDE_BASE + c);
+
+        ret = sysdb_add_group_member(test_ctx->domain, gr_name, user_name,
+                                     SYSDB_MEMBER_USER, false);
+        assert_int_equal(ret, EOK);
+        talloc_free(gr_name);
+    }
+
+    ret = sysdb_initgroups_gids_with_views(test_ctx, test_ctx->domain,
+                                           user_name, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, TEST_INITGR_NUM_GROUPS + 1);
+
+    for (c = 1; c < res->count; c++) {
+        name = ldb_msg_find_attr_as_string(res->msgs[c], SYSDB_NAME, NULL);
+        assert_non_null(name);
+        assert_int_equal(sscanf(name, "initgr_group%u@", &num), 1);
+        assert_true(num < TEST_INITGR_NUM_GROUPS);
+        seen[num] = true;
+
+        gid = ldb_msg_find_attr_as_uint64(res->msgs[c],
+                                          OVERRIDE_PREFIX SYSDB_GIDNUM, 0);
+        assert_int_equal(gid, TEST_GID_OVERRIDE_BASE + num);
+
+        gid = ldb_msg_find_attr_as_uint64(res->msgs[c], SYSDB_GIDNUM, 0);
+        assert_int_equal(gid, 2000 + num);
+
+        /* Only the attributes needed for the list of GIDs are read */
+        assert_null(ldb_msg_find_element(res->msgs[c], SYSDB_ORIG_DN));
+    }
+
+    for (c = 0; c < TEST_INITGR_NUM_GROUPS; c++) {
+        assert_true(seen[c]);
+    }
+
+    talloc_free(res);
+
+    for (c = 0; c < TEST_INITGR_NUM_GROUPS; c++) {
+        gr_name = talloc_asprintf(test_ctx, "initgr_group%zu@%s",
+                                  c, test_ctx->domain->name);
+        assert_non_null(gr_name);
+        ret = sysdb_delete_group(test_ctx->domain, gr_name, 0);
+        assert_int_equal(ret, EOK);
+        talloc_free(gr_name);
+    }
+
+    ret = sysdb_delete_user(test_ctx->domain, user_name, 0);
+    assert_int_equal(ret, EOK);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -1075,12 +1489,26 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_invalidate_overrides,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_merged_overrides,
+                                        test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_views,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_paged_views,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_names_views,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_get_user_attr_by_uid_views,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_filter_names,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_filter,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
@@ -1093,12 +1521,20 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_views,
                                         test_enum_groups_setup,
                                         test_enum_groups_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_paged_views,
+                                        test_enum_groups_setup,
+                                        test_enum_groups_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_names_views,
+                                        test_enum_groups_setup,
+                                        test_enum_groups_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_filter,
                                         test_enum_groups_setup,
                                         test_enum_groups_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumgrent_filter_views,
                                         test_enum_groups_setup,
                                         test_enum_groups_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_initgroups_gids_views,
+                                        test_sysdb_setup, test_sysdb_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -40,5 +40,9 @@ void test_sss_ptr_hash_overwrite_with_free_cb(void **state);
 void test_sss_ptr_hash_with_lookup_cb(void **state);
 void test_sss_ptr_hash_without_cb(void **state);
 
+/* from src/tests/cmocka/test_sss_thread_pool.c */
+void test_sss_thread_pool_jobs(void **state);
+void test_sss_thread_pool_cancel(void **state);
+
 
 #endif /* __TESTS__CMOCKA__TEST_UTILS_H__ */
@@ -662,6 +662,27 @@ def test_mod_user_shell(add_user_with_canary, files_domain_only):
     check_user(moduser)
 
 
+def test_mod_user_shell_while_stopped(add_user_with_canary,
+                                      files_domain_only):
+    """
+    Test that a user modified while SSSD was not running is not returned
+    from the memory cache of the previous instance
+    """
+    res, user = sssd_getpwnam_sync(USER1["name"])
+    assert res == NssReturnCode.SUCCESS
+    assert user == USER1
+
+    stop_sssd()
+
+    moduser = dict(USER1)
+    moduser['shell'] = '/bin/zsh'
+    add_user_with_canary.usermod(**moduser)
+
+    start_sssd()
+
+    check_user(moduser)
+
+
 def incomplete_user_setup(pwd_ops, del_field, exp_field):
     adduser = dict(USER1)
     del adduser[del_field]
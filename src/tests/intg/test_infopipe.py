@@ -607,6 +607,31 @@ def test_get_extra_attributes_empty(dbus_system_bus,
     assert extra_attrs['extraName'][0] == 'user1'
 
 
+def test_list_users_paged(dbus_system_bus, ldap_conn, sanity_rfc2307):
+    users_obj = dbus_system_bus.get_object(
+                                        'org.freedesktop.sssd.infopipe',
+                                        '/org/freedesktop/sssd/infopipe/Users')
+
+    users_iface = dbus.Interface(users_obj,
+                                 "org.freedesktop.sssd.infopipe.Users")
+
+    paths, cursor = users_iface.ListByDomainAndNamePaged('LDAP', 'user*',
+                                                         '', 2)
+    assert len(paths) == 2
+    assert cursor != ''
+
+    more, cursor = users_iface.ListByDomainAndNamePaged('LDAP', 'user*',
+                                                        cursor, 2)
+    assert len(more) == 1
+    assert cursor == ''
+
+    attrs = users_iface.GetAttributes(list(paths) + list(more),
+                                      ['name', 'uidNumber'])
+    assert len(attrs) == 3
+    assert [a['name'][0] for a in attrs] == ['user1', 'user2', 'user3']
+    assert [a['uidNumber'][0] for a in attrs] == ['1001', '1002', '1003']
+
+
 def test_sssctl_domain_list_app_domain(dbus_system_bus,
                                        ldap_conn,
                                        sanity_rfc2307):
@@ -0,0 +1,106 @@
+/*
+    Startup status of SSSD services
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <popt.h>
+#include <stdio.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "tools/common/sss_tools.h"
+#include "tools/sssctl/sssctl.h"
+#include "sss_iface/sss_iface_sync.h"
+
+errno_t sssctl_startup_times(struct sss_cmdline *cmdline,
+                             struct sss_tool_ctx *tool_ctx,
+                             void *pvt)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_sync_connection *conn;
+    const char **names;
+    uint32_t *pids;
+    uint32_t *launched;
+    uint32_t *ready;
+    size_t count;
+    errno_t ret;
+    size_t i;
+
+    ret = sss_tool_popt(cmdline, NULL, SSS_TOOL_OPT_OPTIONAL, NULL, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse command arguments\n");
+        return ret;
+    }
+
+    if (!sssctl_start_sssd(false)) {
+        return ERR_SSSD_NOT_RUNNING;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    conn = sbus_sync_connect_private(tmp_ctx, SSS_MONITOR_ADDRESS, NULL);
+    if (conn == NULL) {
+        ERROR("Unable to connect to the SSSD monitor!\n");
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sbus_call_monitor_GetStartupTimes(tmp_ctx, conn, SSS_BUS_MONITOR,
+                                            SSS_BUS_PATH, &names, &pids,
+                                            &launched, &ready);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to get startup times [%d]: %s\n",
+              ret, sss_strerror(ret));
+        ERROR("Unable to get startup times from the SSSD monitor!\n");
+        goto done;
+    }
+
+    for (count = 0; names[count] != NULL; count++);
+
+    if (talloc_array_length(pids) != count
+            || talloc_array_length(launched) != count
+            || talloc_array_length(ready) != count) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid reply from the monitor\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    printf(_("%-30s %10s %14s %14s\n"),
+           _("Service"), _("PID"), _("Launched [ms]"), _("Ready [ms]"));
+
+    for (i = 0; i < count; i++) {
+        if (ready[i] == SSS_STARTUP_NOT_READY) {
+            printf("%-30s %10"PRIu32" %14"PRIu32" %14s\n",
+                   names[i], pids[i], launched[i], _("not ready"));
+            continue;
+        }
+
+        printf("%-30s %10"PRIu32" %14"PRIu32" %14"PRIu32"\n",
+               names[i], pids[i], launched[i], ready[i]);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
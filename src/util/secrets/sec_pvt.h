@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <dhash.h>
 
 #include "util/secrets/secrets.h"
 
@@ -37,12 +38,28 @@ struct sss_sec_data {
     size_t length;
 };
 
+/* Number of secrets in a hive, so that quotas can be checked without
+ * searching the whole hive. The counters are valid as long as the database
+ * sequence number matches seq, otherwise somebody else wrote to the
+ * database and they are recomputed. */
+struct sss_sec_counters {
+    bool valid;
+    uint64_t seq;
+
+    unsigned long total;
+    /* Linearized per-UID container DN -> number of secrets */
+    hash_table_t *uids;
+};
+
 struct sss_sec_ctx {
     struct ldb_context *ldb;
     struct sss_sec_data master_key;
 
     struct sss_sec_quota *quota_secrets;
     struct sss_sec_quota *quota_kcm;
+
+    struct sss_sec_counters counters_secrets;
+    struct sss_sec_counters counters_kcm;
 };
 
 struct sss_sec_req {
@@ -52,6 +69,7 @@ struct sss_sec_req {
     const char *basedn;
     struct ldb_dn *req_dn;
     struct sss_sec_quota *quota;
+    struct sss_sec_counters *counters;
 
     struct sss_sec_ctx *sctx;
 };
@@ -38,7 +38,9 @@
 #define SECRETS_BASEDN  "cn=secrets"
 #define KCM_BASEDN      "cn=kcm"
 
-#define LOCAL_SIMPLE_FILTER "(|(type=simple)(type=binary))"
+#define LOCAL_SIMPLE_FILTER "(|(type=simple)(type=binary)(type="SSS_SEC_TYPE_HEADER"))"
+#define LOCAL_ANY_FILTER "(|(type=simple)(type=binary)(type="SSS_SEC_TYPE_HEADER")" \
+                         "(type="SSS_SEC_TYPE_PART"))"
 #define LOCAL_CONTAINER_FILTER "(type=container)"
 
 #define SEC_ATTR_SECRET  "secret"
@@ -255,44 +257,175 @@ done:
     return ret;
 }
 
-static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
-                                            struct sss_sec_req *req)
+static struct ldb_dn *per_uid_container(TALLOC_CTX *mem_ctx,
+                                        struct ldb_dn *req_dn)
+{
+    int user_comp;
+    int num_comp;
+    struct ldb_dn *uid_base_dn;
+
+    uid_base_dn = ldb_dn_copy(mem_ctx, req_dn);
+    if (uid_base_dn == NULL) {
+        return NULL;
+    }
+
+    /* Remove all the components up to the per-user base path which consists
+     * of three components:
+     *  cn=<uidnumber>,cn=users,cn=secrets
+     */
+    user_comp = ldb_dn_get_comp_num(uid_base_dn) - 3;
+
+    if (!ldb_dn_remove_child_components(uid_base_dn, user_comp)) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot remove child components\n");
+        talloc_free(uid_base_dn);
+        return NULL;
+    }
+
+    num_comp = ldb_dn_get_comp_num(uid_base_dn);
+    if (num_comp != 3) {
+        DEBUG(SSSDBG_OP_FAILURE, "Expected 3 components got %d\n", num_comp);
+        talloc_free(uid_base_dn);
+        return NULL;
+    }
+
+    return uid_base_dn;
+}
+
+/* Types matched by LOCAL_SIMPLE_FILTER, i.e. secrets counted into quotas. */
+static bool local_is_counted_type(const char *type)
+{
+    return type != NULL
+           && (strcmp(type, "simple") == 0
+               || strcmp(type, "binary") == 0
+               || strcmp(type, SSS_SEC_TYPE_HEADER) == 0);
+}
+
+static errno_t local_db_seq(struct ldb_context *ldb, uint64_t *_seq)
+{
+    int ret;
+
+    ret = ldb_sequence_number(ldb, LDB_SEQ_HIGHEST_SEQ, _seq);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot read the sequence number [%d]: %s\n",
+              ret, ldb_strerror(ret));
+        return sss_ldb_error_to_errno(ret);
+    }
+
+    return EOK;
+}
+
+static errno_t local_counters_add(struct sss_sec_counters *counters,
+                                  struct ldb_dn *dn,
+                                  long delta)
 {
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *uid_dn;
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+    errno_t ret;
+
+    counters->total += delta;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    uid_dn = per_uid_container(tmp_ctx, dn);
+    if (uid_dn == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(ldb_dn_get_linearized(uid_dn));
+
+    hret = hash_lookup(counters->uids, &key, &value);
+    if (hret == HASH_ERROR_KEY_NOT_FOUND) {
+        value.type = HASH_VALUE_ULONG;
+        value.ul = 0;
+    } else if (hret != HASH_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    value.ul += delta;
+    if (value.ul == 0) {
+        hret = hash_delete(counters->uids, &key);
+        if (hret == HASH_ERROR_KEY_NOT_FOUND) {
+            hret = HASH_SUCCESS;
+        }
+    } else {
+        hret = hash_enter(counters->uids, &key, &value);
+    }
+    if (hret != HASH_SUCCESS) {
+        ret = hret == HASH_ERROR_NO_MEMORY ? ENOMEM : EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t local_counters_rebuild(struct sss_sec_req *req,
+                                      uint64_t seq)
+{
+    struct sss_sec_counters *counters = req->counters;
     TALLOC_CTX *tmp_ctx;
     static const char *attrs[] = { NULL };
     struct ldb_result *res = NULL;
     struct ldb_dn *dn;
     int ret;
 
-    if (req->quota->max_secrets == 0) {
-        return EOK;
+    DEBUG(SSSDBG_TRACE_FUNC, "Counting secrets in [%s]\n", req->basedn);
+
+    counters->valid = false;
+    counters->total = 0;
+    talloc_zfree(counters->uids);
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
     }
 
-    tmp_ctx = talloc_new(mem_ctx);
-    if (!tmp_ctx) return ENOMEM;
+    ret = sss_hash_create(req->sctx, 0, &counters->uids);
+    if (ret != EOK) {
+        goto done;
+    }
 
     dn = ldb_dn_new(tmp_ctx, req->sctx->ldb, req->basedn);
-    if (!dn) {
+    if (dn == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
     ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, dn, LDB_SCOPE_SUBTREE,
                      attrs, LOCAL_SIMPLE_FILTER);
-    if (ret != EOK) {
+    if (ret != LDB_SUCCESS) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
+        ret = sss_ldb_error_to_errno(ret);
         goto done;
     }
 
-    if (res->count >= req->quota->max_secrets) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot store any more secrets as the maximum allowed limit (%d) "
-              "has been reached\n", req->quota->max_secrets);
-        ret = ERR_SEC_INVALID_TOO_MANY_SECRETS;
-        goto done;
+    for (unsigned int i = 0; i < res->count; i++) {
+        ret = local_counters_add(counters, res->msgs[i]->dn, 1);
+        if (ret == EINVAL) {
+            /* Not stored under a per-UID container, counts only
+             * into the total. */
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
     }
 
+    counters->seq = seq;
+    counters->valid = true;
     ret = EOK;
 
 done:
@@ -300,47 +433,89 @@ done:
     return ret;
 }
 
-static struct ldb_dn *per_uid_container(TALLOC_CTX *mem_ctx,
-                                        struct ldb_dn *req_dn)
+static errno_t local_counters_ensure(struct sss_sec_req *req)
 {
-    int user_comp;
-    int num_comp;
-    struct ldb_dn *uid_base_dn;
+    uint64_t seq;
+    errno_t ret;
 
-    uid_base_dn = ldb_dn_copy(mem_ctx, req_dn);
-    if (uid_base_dn == NULL) {
-        return NULL;
+    ret = local_db_seq(req->sctx->ldb, &seq);
+    if (ret != EOK) {
+        return ret;
     }
 
-    /* Remove all the components up to the per-user base path which consists
-     * of three components:
-     *  cn=<uidnumber>,cn=users,cn=secrets
-     */
-    user_comp = ldb_dn_get_comp_num(uid_base_dn) - 3;
+    if (req->counters->valid && req->counters->seq == seq) {
+        return EOK;
+    }
 
-    if (!ldb_dn_remove_child_components(uid_base_dn, user_comp)) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot remove child components\n");
-        talloc_free(uid_base_dn);
-        return NULL;
+    return local_counters_rebuild(req, seq);
+}
+
+/* Must be called after each successful write, @delta is the change
+ * of the number of counted secrets at @dn. */
+static void local_counters_written(struct sss_sec_req *req,
+                                   struct ldb_dn *dn,
+                                   long delta)
+{
+    struct sss_sec_counters *counters = req->counters;
+    uint64_t seq;
+    errno_t ret;
+
+    if (!counters->valid) {
+        return;
     }
 
-    num_comp = ldb_dn_get_comp_num(uid_base_dn);
-    if (num_comp != 3) {
-        DEBUG(SSSDBG_OP_FAILURE, "Expected 3 components got %d\n", num_comp);
-        talloc_free(uid_base_dn);
-        return NULL;
+    /* Each write increases the sequence number by one, anything else means
+     * there was another writer in the meantime. */
+    ret = local_db_seq(req->sctx->ldb, &seq);
+    if (ret != EOK || seq != counters->seq + 1) {
+        counters->valid = false;
+        return;
     }
 
-    return uid_base_dn;
+    if (delta != 0) {
+        ret = local_counters_add(counters, dn, delta);
+        if (ret != EOK && ret != EINVAL) {
+            counters->valid = false;
+            return;
+        }
+    }
+
+    counters->seq = seq;
+}
+
+static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
+                                            struct sss_sec_req *req)
+{
+    int ret;
+
+    if (req->quota->max_secrets == 0) {
+        return EOK;
+    }
+
+    ret = local_counters_ensure(req);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (req->counters->total >= (unsigned long) req->quota->max_secrets) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot store any more secrets as the maximum allowed limit (%d) "
+              "has been reached\n", req->quota->max_secrets);
+        return ERR_SEC_INVALID_TOO_MANY_SECRETS;
+    }
+
+    return EOK;
 }
 
 static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
                                                    struct sss_sec_req *req)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = { NULL };
-    struct ldb_result *res = NULL;
     struct ldb_dn *cli_basedn = NULL;
+    hash_key_t key;
+    hash_value_t value;
+    unsigned long count;
+    int hret;
     int ret;
 
     if (req->quota->max_uid_secrets == 0) {
@@ -358,15 +533,25 @@ static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, cli_basedn, LDB_SCOPE_SUBTREE,
-                     attrs, LOCAL_SIMPLE_FILTER);
+    ret = local_counters_ensure(req);
     if (ret != EOK) {
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
         goto done;
     }
 
-    if (res->count >= req->quota->max_uid_secrets) {
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(ldb_dn_get_linearized(cli_basedn));
+
+    hret = hash_lookup(req->counters->uids, &key, &value);
+    if (hret == HASH_SUCCESS) {
+        count = value.ul;
+    } else if (hret == HASH_ERROR_KEY_NOT_FOUND) {
+        count = 0;
+    } else {
+        ret = EIO;
+        goto done;
+    }
+
+    if (count >= (unsigned long) req->quota->max_uid_secrets) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store any more secrets for this client (basedn %s) "
               "as the maximum allowed limit (%d) has been reached\n",
@@ -487,6 +672,7 @@ static int local_db_create(struct sss_sec_req *req)
         goto done;
     }
 
+    local_counters_written(req, msg->dn, 0);
     ret = EOK;
 
 done:
@@ -675,6 +861,110 @@ static errno_t lcl_read_mkey(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+/* Index the type of the secrets so that the quota and listing searches do
+ * not need to walk containers and parts, and the one-level scope so that
+ * listing a container does not depend on the size of the database. ldb
+ * reindexes the database when the index list changes. */
+static errno_t local_db_check_indexes(struct ldb_context *ldb)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = { "@IDXATTR", "@IDXONE", NULL };
+    struct ldb_message_element *el;
+    struct ldb_message *msg;
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    bool has_type = false;
+    bool has_one = false;
+    int add_flags;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = ldb_dn_new(tmp_ctx, ldb, "@INDEXLIST");
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(ldb, tmp_ctx, &res, dn, LDB_SCOPE_BASE, attrs, NULL);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot read the index list [%d]: %s\n",
+              ret, ldb_strerror(ret));
+        ret = sss_ldb_error_to_errno(ret);
+        goto done;
+    }
+
+    if (res->count == 1) {
+        el = ldb_msg_find_element(res->msgs[0], "@IDXATTR");
+        for (unsigned int i = 0; el != NULL && i < el->num_values; i++) {
+            if (el->values[i].length == sizeof(SEC_ATTR_TYPE) - 1
+                    && memcmp(el->values[i].data, SEC_ATTR_TYPE,
+                              el->values[i].length) == 0) {
+                has_type = true;
+            }
+        }
+
+        has_one = ldb_msg_find_element(res->msgs[0], "@IDXONE") != NULL;
+        if (has_type && has_one) {
+            ret = EOK;
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Adding indexes to the secrets database\n");
+
+    msg = ldb_msg_new(tmp_ctx);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    msg->dn = dn;
+
+    /* Keep the attributes that are already indexed. */
+    add_flags = res->count == 0 ? 0 : LDB_FLAG_MOD_ADD;
+
+    ret = LDB_SUCCESS;
+    if (!has_type) {
+        ret = ldb_msg_add_empty(msg, "@IDXATTR", add_flags, NULL);
+        if (ret == LDB_SUCCESS) {
+            ret = ldb_msg_add_string(msg, "@IDXATTR", SEC_ATTR_TYPE);
+        }
+    }
+    if (ret == LDB_SUCCESS && !has_one) {
+        ret = ldb_msg_add_empty(msg, "@IDXONE", add_flags, NULL);
+        if (ret == LDB_SUCCESS) {
+            ret = ldb_msg_add_string(msg, "@IDXONE", "1");
+        }
+    }
+    if (ret != LDB_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (res->count == 0) {
+        ret = ldb_add(ldb, msg);
+    } else {
+        ret = ldb_modify(ldb, msg);
+    }
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot update the index list [%d]: %s\n",
+              ret, ldb_strerror(ret));
+        ret = sss_ldb_error_to_errno(ret);
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static int set_quotas(struct sss_sec_ctx *sec_ctx,
                       struct sss_sec_hive_config **config_list)
 {
@@ -747,6 +1037,14 @@ errno_t sss_sec_init_with_path(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = local_db_check_indexes(sec_ctx->ldb);
+    if (ret != EOK) {
+        /* Only slower without the indexes. */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot set up indexes of the secrets database [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
     ret = lcl_read_mkey(sec_ctx, mkeypath, &sec_ctx->master_key);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Cannot get the master key\n");
@@ -883,6 +1181,7 @@ errno_t sss_sec_new_req(TALLOC_CTX *mem_ctx,
                                      req->mapped_path + (sizeof(SSS_SEC_BASEPATH) - 1));
         req->basedn = SECRETS_BASEDN;
         req->quota = sec_ctx->quota_secrets;
+        req->counters = &sec_ctx->counters_secrets;
     } else if (strncmp(req->mapped_path,
                        SSS_SEC_KCM_BASEPATH,
                        sizeof(SSS_SEC_KCM_BASEPATH) - 1) == 0) {
@@ -900,6 +1199,7 @@ errno_t sss_sec_new_req(TALLOC_CTX *mem_ctx,
                                   req->mapped_path + (sizeof(SSS_SEC_KCM_BASEPATH) - 1));
         req->basedn = KCM_BASEDN;
         req->quota = sec_ctx->quota_kcm;
+        req->counters = &sec_ctx->counters_kcm;
     } else {
         ret = EINVAL;
         goto done;
@@ -988,7 +1288,7 @@ errno_t sss_sec_list_cc_uuids(TALLOC_CTX *mem_ctx,
     dn = ldb_dn_new(tmp_ctx, sec->ldb, "cn=persistent,cn=kcm");
 
     ret = ldb_search(sec->ldb, tmp_ctx, &res, dn, LDB_SCOPE_SUBTREE,
-           attrs, "%s", "(!(type=container))");
+           attrs, "%s", LOCAL_SIMPLE_FILTER);
     if (ret != EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "ldb_search returned [%d]: %s\n", ret, ldb_strerror(ret));
@@ -1054,8 +1354,9 @@ errno_t sss_sec_list(TALLOC_CTX *mem_ctx,
                      size_t *_num_keys)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = { SEC_ATTR_SECRET, NULL };
+    static const char *attrs[] = { NULL };
     struct ldb_result *res;
+    enum ldb_scope scope;
     char **keys;
     int ret;
 
@@ -1068,12 +1369,21 @@ errno_t sss_sec_list(TALLOC_CTX *mem_ctx,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Listing keys at [%s]\n", req->path);
 
+    /* KCM never stores secrets in nested containers, so the list of direct
+     * children is complete and can be served from the one-level index. */
+    if (strcmp(req->basedn, KCM_BASEDN) == 0) {
+        scope = LDB_SCOPE_ONELEVEL;
+    } else {
+        scope = LDB_SCOPE_SUBTREE;
+    }
+
     DEBUG(SSSDBG_TRACE_INTERNAL,
-          "Searching for [%s] at [%s] with scope=subtree\n",
-          LOCAL_SIMPLE_FILTER, ldb_dn_get_linearized(req->req_dn));
+          "Searching for [%s] at [%s] with scope=%s\n",
+          LOCAL_ANY_FILTER, ldb_dn_get_linearized(req->req_dn),
+          scope == LDB_SCOPE_ONELEVEL ? "onelevel" : "subtree");
 
-    ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, LDB_SCOPE_SUBTREE,
-                     attrs, "%s", LOCAL_SIMPLE_FILTER);
+    ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, scope,
+                     attrs, "%s", LOCAL_ANY_FILTER);
     if (ret != EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "ldb_search returned [%d]: %s\n", ret, ldb_strerror(ret));
@@ -1141,10 +1451,10 @@ errno_t sss_sec_get(TALLOC_CTX *mem_ctx,
 
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "Searching for [%s] at [%s] with scope=base\n",
-          LOCAL_SIMPLE_FILTER, ldb_dn_get_linearized(req->req_dn));
+          LOCAL_ANY_FILTER, ldb_dn_get_linearized(req->req_dn));
 
     ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, LDB_SCOPE_BASE,
-                     attrs, "%s", LOCAL_SIMPLE_FILTER);
+                     attrs, "%s", LOCAL_ANY_FILTER);
     if (ret != EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "ldb_search returned [%d]: %s\n", ret, ldb_strerror(ret));
@@ -1237,20 +1547,23 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_number_of_secrets(msg, req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "local_db_check_number_of_secrets failed [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
-    }
+    /* Parts are accounted into the quota of their header. */
+    if (strcmp(datatype, SSS_SEC_TYPE_PART) != 0) {
+        ret = local_db_check_number_of_secrets(msg, req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "local_db_check_number_of_secrets failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
 
-    ret = local_db_check_peruid_number_of_secrets(msg, req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "local_db_check_number_of_secrets failed [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
+        ret = local_db_check_peruid_number_of_secrets(msg, req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "local_db_check_number_of_secrets failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
     }
 
     ret = local_check_max_payload_size(req, secret_len);
@@ -1316,6 +1629,8 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
+    local_counters_written(req, msg->dn,
+                           local_is_counted_type(datatype) ? 1 : 0);
     ret = EOK;
 done:
     talloc_free(msg);
@@ -1354,20 +1669,22 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
-    ret = local_db_check_number_of_secrets(msg, req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "local_db_check_number_of_secrets failed [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
-    }
+    if (strcmp(datatype, SSS_SEC_TYPE_PART) != 0) {
+        ret = local_db_check_number_of_secrets(msg, req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "local_db_check_number_of_secrets failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
 
-    ret = local_db_check_peruid_number_of_secrets(msg, req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "local_db_check_number_of_secrets failed [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
+        ret = local_db_check_peruid_number_of_secrets(msg, req);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "local_db_check_number_of_secrets failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
     }
 
     ret = local_check_max_payload_size(req, secret_len);
@@ -1449,6 +1766,8 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
+    /* Updates never move a secret between counted and uncounted types. */
+    local_counters_written(req, msg->dn, 0);
     ret = EOK;
 done:
     talloc_free(msg);
@@ -1459,7 +1778,9 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
 {
     TALLOC_CTX *tmp_ctx;
     static const char *attrs[] = { NULL };
+    static const char *type_attrs[] = { SEC_ATTR_TYPE, NULL };
     struct ldb_result *res;
+    const char *type;
     int ret;
 
     if (req == NULL) {
@@ -1472,18 +1793,23 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
     if (!tmp_ctx) return ENOMEM;
 
     DEBUG(SSSDBG_TRACE_INTERNAL,
-          "Searching for [%s] at [%s] with scope=base\n",
-          LOCAL_CONTAINER_FILTER, ldb_dn_get_linearized(req->req_dn));
+          "Searching for [%s] with scope=base\n",
+          ldb_dn_get_linearized(req->req_dn));
 
     ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, LDB_SCOPE_BASE,
-                     attrs, LOCAL_CONTAINER_FILTER);
-    if (ret != EOK) {
+                     type_attrs, NULL);
+    if (ret != EOK && ret != LDB_ERR_NO_SUCH_OBJECT) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
         goto done;
     }
 
-    if (res->count == 1) {
+    type = NULL;
+    if (ret == EOK && res->count == 1) {
+        type = ldb_msg_find_attr_as_string(res->msgs[0], SEC_ATTR_TYPE, NULL);
+    }
+
+    if (type != NULL && strcmp(type, "container") == 0) {
         DEBUG(SSSDBG_TRACE_INTERNAL,
               "Searching for children of [%s]\n", ldb_dn_get_linearized(req->req_dn));
         ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, LDB_SCOPE_ONELEVEL,
@@ -1516,6 +1842,11 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
               "LDB returned unexpected error: [%s]\n",
                ldb_strerror(ret));
     }
+
+    if (ret == LDB_SUCCESS) {
+        local_counters_written(req, req->req_dn,
+                               local_is_counted_type(type) ? -1 : 0);
+    }
     ret = sss_ldb_error_to_errno (ret);
 
 done:
@@ -44,6 +44,12 @@
 #define DEFAULT_SEC_KCM_MAX_UID_SECRETS  64
 #define DEFAULT_SEC_KCM_MAX_PAYLOAD_SIZE 65536
 
+/* Secrets can be split into a header and parts, e.g. a KCM ccache and its
+ * credentials. Only the header is accounted into the number of secrets
+ * quotas, the parts are accessible only by their exact path. */
+#define SSS_SEC_TYPE_HEADER "header"
+#define SSS_SEC_TYPE_PART   "part"
+
 enum sss_sec_enctype {
     SSS_SEC_PLAINTEXT,
     SSS_SEC_MASTERKEY,
@@ -0,0 +1,423 @@
+/*
+    SSSD
+
+    Pool of worker threads integrated with tevent
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_thread_pool.h"
+
+/* Jobs are allocated, stolen and freed only by the main thread. Worker
+ * threads only move them between the lists while holding the pool mutex
+ * and call the job function, which may touch nothing but job->pvt. */
+
+struct sss_thread_pool_job {
+    struct sss_thread_pool_job *prev;
+    struct sss_thread_pool_job *next;
+
+    sss_thread_pool_fn fn;
+    void *pvt;
+    errno_t ret;
+    bool queued;
+
+    /* NULL if the request was freed before the job finished. */
+    struct tevent_req *req;
+};
+
+struct sss_thread_pool {
+    struct tevent_context *ev;
+    struct tevent_fd *fde;
+    int efd;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool stop;
+
+    pthread_t *threads;
+    unsigned int num_threads;
+
+    /* All protected by lock. */
+    struct sss_thread_pool_job *queued;
+    struct sss_thread_pool_job *running;
+    struct sss_thread_pool_job *finished;
+    unsigned int busy;
+};
+
+struct sss_thread_pool_job_state {
+    struct sss_thread_pool *pool;
+    struct sss_thread_pool_job *job;
+    void *pvt;
+    errno_t ret;
+};
+
+static __thread bool sss_thread_pool_worker;
+
+bool sss_thread_pool_in_worker(void)
+{
+    return sss_thread_pool_worker;
+}
+
+static void sss_thread_pool_notify(struct sss_thread_pool *pool)
+{
+    uint64_t one = 1;
+    ssize_t len;
+
+    do {
+        len = write(pool->efd, &one, sizeof(one));
+    } while (len == -1 && errno == EINTR);
+
+    /* EAGAIN means the counter is already huge and the main thread will
+     * be woken up anyway. */
+}
+
+static void *sss_thread_pool_worker_main(void *data)
+{
+    struct sss_thread_pool *pool = data;
+    struct sss_thread_pool_job *job;
+
+    sss_thread_pool_worker = true;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->stop && pool->queued == NULL) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+
+        if (pool->stop) {
+            break;
+        }
+
+        job = pool->queued;
+        DLIST_REMOVE(pool->queued, job);
+        job->queued = false;
+        DLIST_ADD(pool->running, job);
+        pthread_mutex_unlock(&pool->lock);
+
+        job->ret = job->fn(job->pvt);
+
+        pthread_mutex_lock(&pool->lock);
+        DLIST_REMOVE(pool->running, job);
+        DLIST_ADD(pool->finished, job);
+        sss_thread_pool_notify(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void sss_thread_pool_job_finish(struct sss_thread_pool_job *job)
+{
+    struct sss_thread_pool_job_state *state;
+    struct tevent_req *req = job->req;
+
+    if (req == NULL) {
+        /* Nobody is interested in the result anymore. */
+        talloc_free(job);
+        return;
+    }
+
+    state = tevent_req_data(req, struct sss_thread_pool_job_state);
+    state->job = NULL;
+    state->ret = job->ret;
+    state->pvt = talloc_steal(state, job->pvt);
+    talloc_free(job);
+
+    tevent_req_done(req);
+}
+
+static void sss_thread_pool_handler(struct tevent_context *ev,
+                                    struct tevent_fd *fde,
+                                    uint16_t flags,
+                                    void *data)
+{
+    struct sss_thread_pool *pool;
+    struct sss_thread_pool_job *finished;
+    struct sss_thread_pool_job *job;
+    struct sss_thread_pool_job *next;
+    uint64_t count;
+    ssize_t len;
+
+    pool = talloc_get_type(data, struct sss_thread_pool);
+
+    len = read(pool->efd, &count, sizeof(count));
+    if (len == -1 && errno != EAGAIN && errno != EINTR) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read eventfd [%d]: %s\n",
+              errno, sss_strerror(errno));
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    finished = pool->finished;
+    pool->finished = NULL;
+    for (job = finished; job != NULL; job = job->next) {
+        pool->busy--;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    DLIST_FOR_EACH_SAFE(job, next, finished) {
+        DLIST_REMOVE(finished, job);
+        sss_thread_pool_job_finish(job);
+    }
+}
+
+static void sss_thread_pool_detach(struct sss_thread_pool_job *list)
+{
+    struct sss_thread_pool_job_state *state;
+    struct sss_thread_pool_job *job;
+
+    DLIST_FOR_EACH(job, list) {
+        if (job->req != NULL) {
+            state = tevent_req_data(job->req, struct sss_thread_pool_job_state);
+            state->job = NULL;
+            state->pool = NULL;
+        }
+    }
+}
+
+static int sss_thread_pool_destructor(struct sss_thread_pool *pool)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    /* All jobs are freed together with the pool, requests that are still
+     * pending will never be finished. */
+    sss_thread_pool_detach(pool->queued);
+    sss_thread_pool_detach(pool->running);
+    sss_thread_pool_detach(pool->finished);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+
+    talloc_zfree(pool->fde);
+    close(pool->efd);
+
+    return 0;
+}
+
+errno_t sss_thread_pool_create(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               unsigned int num_threads,
+                               struct sss_thread_pool **_pool)
+{
+    struct sss_thread_pool *pool;
+    sigset_t sigmask;
+    sigset_t oldmask;
+    errno_t ret;
+
+    if (num_threads == 0) {
+        return EINVAL;
+    }
+
+    pool = talloc_zero(mem_ctx, struct sss_thread_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    pool->ev = ev;
+
+    pool->threads = talloc_zero_array(pool, pthread_t, num_threads);
+    if (pool->threads == NULL) {
+        talloc_free(pool);
+        return ENOMEM;
+    }
+
+    pool->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (pool->efd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "eventfd() failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(pool);
+        return ret;
+    }
+
+    ret = pthread_mutex_init(&pool->lock, NULL);
+    if (ret != 0) {
+        close(pool->efd);
+        talloc_free(pool);
+        return ret;
+    }
+
+    ret = pthread_cond_init(&pool->cond, NULL);
+    if (ret != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        close(pool->efd);
+        talloc_free(pool);
+        return ret;
+    }
+
+    /* From now on the destructor takes care of the cleanup. */
+    talloc_set_destructor(pool, sss_thread_pool_destructor);
+
+    pool->fde = tevent_add_fd(ev, pool, pool->efd, TEVENT_FD_READ,
+                              sss_thread_pool_handler, pool);
+    if (pool->fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Signals must be handled by the main thread only. */
+    sigfillset(&sigmask);
+    pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
+
+    for (pool->num_threads = 0; pool->num_threads < num_threads;
+         pool->num_threads++) {
+        ret = pthread_create(&pool->threads[pool->num_threads], NULL,
+                             sss_thread_pool_worker_main, pool);
+        if (ret != 0) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "pthread_create() failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            break;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+
+    if (ret != 0) {
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Started %u worker threads\n", num_threads);
+
+    *_pool = pool;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(pool);
+    }
+
+    return ret;
+}
+
+unsigned int sss_thread_pool_busy(struct sss_thread_pool *pool)
+{
+    unsigned int busy;
+
+    pthread_mutex_lock(&pool->lock);
+    busy = pool->busy;
+    pthread_mutex_unlock(&pool->lock);
+
+    return busy;
+}
+
+static int sss_thread_pool_job_state_destructor(
+                                       struct sss_thread_pool_job_state *state)
+{
+    struct sss_thread_pool_job *job = state->job;
+    bool drop = false;
+
+    if (job == NULL) {
+        return 0;
+    }
+
+    job->req = NULL;
+
+    /* A job that has not started yet can be dropped right away, otherwise
+     * it is freed once it is finished. */
+    pthread_mutex_lock(&state->pool->lock);
+    if (job->queued) {
+        DLIST_REMOVE(state->pool->queued, job);
+        state->pool->busy--;
+        drop = true;
+    }
+    pthread_mutex_unlock(&state->pool->lock);
+
+    if (drop) {
+        talloc_free(job);
+    }
+
+    return 0;
+}
+
+struct tevent_req *sss_thread_pool_job_send(TALLOC_CTX *mem_ctx,
+                                            struct tevent_context *ev,
+                                            struct sss_thread_pool *pool,
+                                            sss_thread_pool_fn fn,
+                                            void *pvt)
+{
+    struct sss_thread_pool_job_state *state;
+    struct sss_thread_pool_job *job;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sss_thread_pool_job_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->pool = pool;
+
+    job = talloc_zero(pool, struct sss_thread_pool_job);
+    if (job == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    job->fn = fn;
+    job->pvt = talloc_steal(job, pvt);
+    job->req = req;
+
+    state->job = job;
+    talloc_set_destructor(state, sss_thread_pool_job_state_destructor);
+
+    pthread_mutex_lock(&pool->lock);
+    DLIST_ADD_END(pool->queued, job, struct sss_thread_pool_job *);
+    job->queued = true;
+    pool->busy++;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+errno_t sss_thread_pool_job_recv(TALLOC_CTX *mem_ctx,
+                                 struct tevent_req *req,
+                                 void **_pvt)
+{
+    struct sss_thread_pool_job_state *state;
+
+    state = tevent_req_data(req, struct sss_thread_pool_job_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_pvt != NULL) {
+        *_pvt = talloc_steal(mem_ctx, state->pvt);
+    }
+
+    return state->ret;
+}
@@ -0,0 +1,85 @@
+/*
+    SSSD
+
+    Pool of worker threads integrated with tevent
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_THREAD_POOL_H_
+#define _SSS_THREAD_POOL_H_
+
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+
+struct sss_thread_pool;
+
+/**
+ * Function executed in a worker thread.
+ *
+ * The function may only access memory reachable from @pvt and read-only
+ * data that is guaranteed to outlive the job. It may allocate new talloc
+ * memory under @pvt but it must never touch any other talloc hierarchy,
+ * call DEBUG, use tevent or access sysdb, none of these is thread-safe.
+ *
+ * @return Result of the job which is returned by sss_thread_pool_job_recv().
+ */
+typedef errno_t (*sss_thread_pool_fn)(void *pvt);
+
+/**
+ * Create a new pool with @num_threads worker threads. Completion of the
+ * jobs is delivered to @ev through an eventfd.
+ *
+ * Freeing the pool waits for the running jobs to finish and drops
+ * the queued ones.
+ */
+errno_t sss_thread_pool_create(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               unsigned int num_threads,
+                               struct sss_thread_pool **_pool);
+
+/**
+ * Number of jobs that are queued or running.
+ */
+unsigned int sss_thread_pool_busy(struct sss_thread_pool *pool);
+
+/**
+ * True if called from a worker thread of any pool.
+ */
+bool sss_thread_pool_in_worker(void);
+
+/**
+ * Run @fn(@pvt) in one of the worker threads.
+ *
+ * @pvt is stolen by the pool while the job is queued or running so it stays
+ * valid even if the request is freed meanwhile, in which case it is freed
+ * once the job finishes. It must not be touched by the caller until the
+ * request is finished.
+ */
+struct tevent_req *sss_thread_pool_job_send(TALLOC_CTX *mem_ctx,
+                                            struct tevent_context *ev,
+                                            struct sss_thread_pool *pool,
+                                            sss_thread_pool_fn fn,
+                                            void *pvt);
+
+/**
+ * Return the result of the job and steal @pvt back on @mem_ctx.
+ */
+errno_t sss_thread_pool_job_recv(TALLOC_CTX *mem_ctx,
+                                 struct tevent_req *req,
+                                 void **_pvt);
+
+#endif /* _SSS_THREAD_POOL_H_ */
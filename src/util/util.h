@@ -791,6 +791,10 @@ errno_t sss_cert_derb64_to_ldap_filter(TALLOC_CTX *mem_ctx, const char *derb64,
 /* from util_preauth.c */
 errno_t create_preauth_indicator(void);
 
+/* Exit status of p11_child if the certificate was checked and found to be
+ * invalid, any other non-zero status means that the check did not run. */
+#define P11_CHILD_EXIT_CERT_INVALID 2
+
 #ifdef SSSD_LIBEXEC_PATH
 #define P11_CHILD_LOG_FILE "p11_child"
 #define P11_CHILD_PATH SSSD_LIBEXEC_PATH"/p11_child"